@@ -53,7 +53,7 @@ int main(int    argc,
 l_int32       w, h, d;
 PIX          *pixs, *pixg, *pixim, *pixgm, *pixmi, *pix1, *pix2;
 PIX          *pixmr, *pixmg, *pixmb, *pixmri, *pixmgi, *pixmbi;
-PIXA         *pixa;
+PIXA         *pixa, *pixa2, *pixa3;
 L_REGPARAMS  *rp;
 
     if (regTestSetup(argc, argv, &rp))
@@ -155,6 +155,50 @@ L_REGPARAMS  *rp;
     pixaAddPix(pixa, pix2, L_INSERT);
     pixDestroy(&pixim);
 
+        /* Normalize a sequence of pages, reusing the first map */
+    startTimer();
+    pixa2 = pixaCreate(3);
+    pixaAddPix(pixa2, pixs, L_COPY);
+    pixaAddPix(pixa2, pixs, L_COPY);
+    pix1 = pixScale(pixs, 1.02, 1.02);  /* slightly larger page */
+    pixaAddPix(pixa2, pix1, L_INSERT);
+    pixa3 = pixaBackgroundNorm(pixa2, SIZE_X, SIZE_Y, BINTHRESH, MINCOUNT,
+                               BGVAL, SMOOTH_X, SMOOTH_Y, 0);
+    fprintf(stderr, "Time for 3 page bg normalization: %7.3f\n",
+            stopTimer());
+    pix1 = pixBackgroundNorm(pixs, NULL, NULL, SIZE_X, SIZE_Y, BINTHRESH,
+                             MINCOUNT, BGVAL, SMOOTH_X, SMOOTH_Y);
+    pix2 = pixaGetPix(pixa3, 0, L_CLONE);
+    regTestComparePix(rp, pix1, pix2);  /* 14 */
+    pixDestroy(&pix2);
+    pix2 = pixaGetPix(pixa3, 1, L_CLONE);
+    regTestComparePix(rp, pix1, pix2);  /* 15 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pix1 = pixaGetPix(pixa3, 2, L_CLONE);
+    regTestWritePixAndCheck(rp, pix1, IFF_JFIF_JPEG);  /* 16 */
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pixaDestroy(&pixa3);
+
+        /* With a gray page in between, the color map of the first
+         * page is still used for the third one */
+    pixaReplacePix(pixa2, 1, pixConvertRGBToLuminance(pixs), NULL);
+    pixa3 = pixaBackgroundNorm(pixa2, SIZE_X, SIZE_Y, BINTHRESH, MINCOUNT,
+                               BGVAL, SMOOTH_X, SMOOTH_Y, 0);
+    pix2 = pixaGetPix(pixa3, 2, L_CLONE);
+    regTestComparePix(rp, pix1, pix2);  /* 17 */
+    pixDestroy(&pix2);
+    pix2 = pixaGetPix(pixa2, 1, L_CLONE);
+    pix1 = pixBackgroundNorm(pix2, NULL, NULL, SIZE_X, SIZE_Y, BINTHRESH,
+                             MINCOUNT, BGVAL, SMOOTH_X, SMOOTH_Y);
+    pixDestroy(&pix2);
+    pix2 = pixaGetPix(pixa3, 1, L_CLONE);
+    regTestComparePix(rp, pix1, pix2);  /* 18 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixaDestroy(&pixa2);
+    pixaDestroy(&pixa3);
+
         /* Display results */
     pix1 = pixaDisplayTiledAndScaled(pixa, 32, 400, 4, 0, 20, 2);
     pixWrite("/tmp/junk.jpg", pix1, IFF_JFIF_JPEG);
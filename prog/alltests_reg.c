@@ -115,6 +115,8 @@ static const char *tests[] = {
                               "pageseg_reg",
                               "paint_reg",
                               "paintmask_reg",
+                              "partition_reg",
+                              "pdfio_reg",
                               "pdfseg_reg",
                               "pixa2_reg",
                               "pixadisp_reg",
@@ -133,6 +135,7 @@ static const char *tests[] = {
                               "rotate1_reg",
                               "rotate2_reg",
                               "rotateorth_reg",
+                              "runlength_reg",
                               "scale_reg",
                               "seedspread_reg",
                               "selio_reg",
@@ -34,11 +34,15 @@
  *     separable operation with full resolution intermediate images.
  *     Using 4x reduction on intermediates, this runs at about
  *     3 MPix/sec, with very good quality.
+ *
+ *     Also tests the bilateral grid, and compares it with the
+ *     exact bilateral filter.
  */
 
 #include "allheaders.h"
 
 static void DoTestsOnImage(PIX *pixs, L_REGPARAMS *rp);
+static void DoGridTestsOnImage(PIX *pixs, L_REGPARAMS *rp);
 
 static const l_int32  ncomps = 10;
 
@@ -53,6 +57,7 @@ L_REGPARAMS  *rp;
 
     pixs = pixRead("test24.jpg");
     DoTestsOnImage(pixs, rp);  /* 0 - 7 */
+    DoGridTestsOnImage(pixs, rp);  /* 8 - 11 */
     pixDestroy(&pixs);
 
     return regTestCleanup(rp);
@@ -99,3 +104,42 @@ PIXA  *pixa;
 }
 
 
+
+
+static void
+DoGridTestsOnImage(PIX          *pixs,
+                   L_REGPARAMS  *rp)
+{
+PIX   *pix, *pixg, *pix1, *pix2, *pixd;
+PIXA  *pixa;
+
+    pixa = pixaCreate(0);
+    pix = pixBilateralGrid(pixs, 5.0, 20.0);  /* 8 */
+    regTestWritePixAndCheck(rp, pix, IFF_JFIF_JPEG);
+    pixaAddPix(pixa, pix, L_INSERT);
+    pix = pixBilateralGrid(pixs, 10.0, 40.0);  /* 9 */
+    regTestWritePixAndCheck(rp, pix, IFF_JFIF_JPEG);
+    pixaAddPix(pixa, pix, L_INSERT);
+
+        /* Nearly all pixels are within 8 of the exact filter */
+    pixg = pixConvertTo8(pixs, 0);
+    pix1 = pixBilateralGridGray(pixg, 3.0, 20.0);
+    pix2 = pixBlockBilateralExact(pixg, 3.0, 20.0);
+    regTestCompareSimilarPix(rp, pix1, pix2, 8, 0.01, 0);  /* 10 */
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pixaAddPix(pixa, pix2, L_INSERT);
+    pixDestroy(&pixg);
+
+        /* The grid for this would have more than 2^31 cells */
+    pix1 = pixCreate(5000, 5000, 8);
+    pix2 = pixBilateralGridGray(pix1, 1.0, 2.0);
+    regTestCompareValues(rp, 1, (pix2 == NULL), 0);  /* 11 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+    pixd = pixaDisplayTiledInRows(pixa, 32, 2500, 1.0, 0, 30, 2);
+    pixDisplayWithTitle(pixd, 100, 600, NULL, rp->display);
+    pixDestroy(&pixd);
+    pixaDestroy(&pixa);
+    return;
+}
@@ -41,7 +41,7 @@ void PixTest3(PIX *pixs, l_int32 size, l_float32 factor,
 int main(int    argc,
          char **argv)
 {
-PIX          *pixs, *pixt1, *pixt2;
+PIX          *pixs, *pixt1, *pixt2, *pixt3;
 L_REGPARAMS  *rp;
 
     if (regTestSetup(argc, argv, &rp))
@@ -71,6 +71,27 @@ L_REGPARAMS  *rp;
     pixDestroy(&pixt1);
     pixDestroy(&pixt2);
 
+        /* The fused binarizer gives the same Sauvola result as the
+         * pipeline of intermediate images; then test the variants */
+    pixSauvolaBinarize(pixs, 7, 0.34, 1, NULL, NULL, &pixt3, &pixt1);
+    pixt2 = pixLocalThreshBinarize(pixs, L_SAUVOLA_THRESH, 7, 0.34);
+    regTestComparePix(rp, pixt1, pixt2);
+    pixDestroy(&pixt1);
+    pixDestroy(&pixt2);
+    pixDestroy(&pixt3);
+    pixt1 = pixLocalThreshBinarize(pixs, L_NIBLACK_THRESH, 10, 0.2);
+    regTestWritePixAndCheck(rp, pixt1, IFF_PNG);
+    pixDisplayWithTitle(pixt1, 100, 100, NULL, rp->display);
+    pixDestroy(&pixt1);
+    pixt1 = pixLocalThreshBinarize(pixs, L_WOLF_THRESH, 10, 0.5);
+    regTestWritePixAndCheck(rp, pixt1, IFF_PNG);
+    pixDisplayWithTitle(pixt1, 400, 100, NULL, rp->display);
+    pixDestroy(&pixt1);
+    pixt1 = pixLocalThreshBinarize(pixs, L_BRADLEY_THRESH, 10, 0.15);
+    regTestWritePixAndCheck(rp, pixt1, IFF_PNG);
+    pixDisplayWithTitle(pixt1, 700, 100, NULL, rp->display);
+    pixDestroy(&pixt1);
+
     pixDestroy(&pixs);
     return regTestCleanup(rp);
 }
@@ -39,6 +39,7 @@ int main(int    argc,
 l_int32       i, j, w1, h1, w2, h2, w, h;
 BOX          *box1, *box2;
 PIX          *pixg, *pixs, *pixs1, *pixs2, *pix1, *pix2, *pix3, *pix4, *pix5;
+PIX          *pixrgba;
 PIXA         *pixa;
 L_REGPARAMS  *rp;
 
@@ -138,6 +139,7 @@ L_REGPARAMS  *rp;
     regTestWritePixAndCheck(rp, pix2, IFF_JFIF_JPEG);  /* 13 */
     pixSetRGBComponent(pix2, pixg, L_ALPHA_CHANNEL);
     regTestWritePixAndCheck(rp, pix2, IFF_PNG);  /* 14 */
+    pixrgba = pixClone(pix2);  /* for premultiplied alpha blending */
 
         /* To see the alpha channel, blend with a black image */
     pix3 = pixCreate(660, 500, 32);
@@ -179,5 +181,21 @@ L_REGPARAMS  *rp;
     pixDestroy(&pix1);
     pixaDestroy(&pixa);
 
+        /* Blend an rgba image using premultiplied alpha; compare with
+         * blending through its alpha component */
+    pix2 = pixCreate(700, 540, 32);
+    pixSetAllArbitrary(pix2, 0x40a0e000);
+    pix3 = pixBlendWithGrayMask(pix2, pixrgba, NULL, 20, 20);
+    pix4 = pixPremultiplyAlpha(pixrgba);
+    pix5 = pixBlendPremultAlpha(NULL, pix2, pix4, 20, 20);
+    regTestCompareSimilarPix(rp, pix3, pix5, 2, 0.0, 0);  /* 20 */
+    pixBlendPremultAlpha(pix2, pix2, pix4, 20, 20);  /* in-place */
+    regTestComparePix(rp, pix2, pix5);  /* 21 */
+    pixDestroy(&pixrgba);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    pixDestroy(&pix4);
+    pixDestroy(&pix5);
+
     return regTestCleanup(rp);
 }
@@ -32,6 +32,9 @@
  *   quantization with a colormap in the dest, then adding new
  *   colors, scaling (which removes the colormap), and finally
  *   re-quantizing back to the original colormap.
+ *
+ *   Also tests that nearest color searches on a colormap give the
+ *   same result when accelerated by its inverse colormap.
  */
 
 #include "allheaders.h"
@@ -39,6 +42,8 @@
 #define  LEVEL       3
 #define  MIN_DEPTH   4
 
+static l_int32 CountNearestErrors(PIXCMAP *cmap, l_int32 ntests);
+
 int main(int    argc,
          char **argv)
 {
@@ -126,7 +131,44 @@ L_REGPARAMS  *rp;
     pixDestroy(&pix7);
     pixDestroy(&pix8);
     pixDestroy(&pix9);
+
+        /* Nearest color search with the inverse colormap */
+    cmap = pixcmapCreateRandom(8, 0, 0);
+    regTestCompareValues(rp, 0, CountNearestErrors(cmap, 5000), 0);  /* 9 */
+    pixcmapResetColor(cmap, 17, 128, 128, 128);
+    pixcmapResetColor(cmap, 200, 3, 250, 7);
+    regTestCompareValues(rp, 0, CountNearestErrors(cmap, 5000), 0);  /* 10 */
+    pixcmapDestroy(&cmap);
     return regTestCleanup(rp);
 }
 
 
+    /* Compare pixcmapGetNearestIndex() with an exhaustive search */
+static l_int32
+CountNearestErrors(PIXCMAP  *cmap,
+                   l_int32   ntests)
+{
+l_int32  i, k, n, rval, gval, bval, index, dist, mindist, minindex, nerrors;
+
+    n = pixcmapGetCount(cmap);
+    nerrors = 0;
+    for (i = 0; i < ntests; i++) {
+        genRandomIntegerInRange(256, 0, &rval);
+        genRandomIntegerInRange(256, 0, &gval);
+        genRandomIntegerInRange(256, 0, &bval);
+        pixcmapGetNearestIndex(cmap, rval, gval, bval, &index);
+        mindist = 1000000;
+        minindex = 0;
+        for (k = 0; k < n; k++) {
+            pixcmapGetDistanceToColor(cmap, k, rval, gval, bval, &dist);
+            if (dist < mindist) {
+                mindist = dist;
+                minindex = k;
+            }
+        }
+        if (index != minindex) nerrors++;
+    }
+    return nerrors;
+}
+
+
@@ -46,7 +46,12 @@ static void PixSave32(PIXA *pixa, PIX *pixc, L_REGPARAMS *rp);
 int main(int    argc,
          char **argv)
 {
-l_int32       i;
+l_int32       i, j, w, h, same;
+l_uint32     *rtab, *gtab, *btab, *indexa, *line;
+l_uint32      index;
+l_float32     psnr0, psnr1;
+PIX          *pixs, *pix1, *pix2;
+PIXCMAP      *cmap;
 L_REGPARAMS  *rp;
 
     if (regTestSetup(argc, argv, &rp))
@@ -57,6 +62,60 @@ L_REGPARAMS  *rp;
         TestImage(image[i], i, rp);
     }
 
+        /* Median cut with k-means refinement should not do worse */
+    pixs = pixRead("test24.jpg");
+    pix1 = pixMedianCutQuantKMeans(pixs, 0, 8, 64, 5, 0, 1, 0);
+    pix2 = pixRemoveColormap(pix1, REMOVE_CMAP_TO_FULL_COLOR);
+    pixGetPSNR(pixs, pix2, 1, &psnr0);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pix1 = pixMedianCutQuantKMeans(pixs, 0, 8, 64, 5, 0, 1, 4);
+    cmap = pixGetColormap(pix1);
+    regTestCompareValues(rp, 64, pixcmapGetCount(cmap), 0);  /* 164 */
+    pix2 = pixRemoveColormap(pix1, REMOVE_CMAP_TO_FULL_COLOR);
+    pixGetPSNR(pixs, pix2, 1, &psnr1);
+    if (rp->display)
+        fprintf(stderr, "psnr: median cut = %5.2f, refined = %5.2f\n",
+                psnr0, psnr1);
+    regTestCompareValues(rp, 1, psnr1 >= psnr0, 0);  /* 165 */
+    pixDestroy(&pixs);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+        /* The octcube index of each pixel computed a row at a time
+         * must agree with the single pixel computation */
+    pixs = pixRead("marge.jpg");
+    pixGetDimensions(pixs, &w, &h, NULL);
+    makeRGBToIndexTables(&rtab, &gtab, &btab, 5);
+    indexa = (l_uint32 *)lept_calloc(w, sizeof(l_uint32));
+    same = TRUE;
+    for (i = 0; i < h; i++) {
+        line = pixGetData(pixs) + i * pixGetWpl(pixs);
+        getOctcubeIndexLine(line, w, rtab, gtab, btab, indexa);
+        for (j = 0; j < w; j++) {
+            getOctcubeIndexFromRGB(GET_DATA_BYTE(line + j, COLOR_RED),
+                                   GET_DATA_BYTE(line + j, COLOR_GREEN),
+                                   GET_DATA_BYTE(line + j, COLOR_BLUE),
+                                   rtab, gtab, btab, &index);
+            if (index != indexa[j]) same = FALSE;
+        }
+    }
+    regTestCompareValues(rp, 1, same, 0);  /* 166 */
+    lept_free(rtab);
+    lept_free(gtab);
+    lept_free(btab);
+    lept_free(indexa);
+
+        /* Octree quantization through the color-cell table; the
+         * results are saved losslessly */
+    pix1 = pixOctreeColorQuant(pixs, 200, 0);  /* no dither */
+    regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 167 */
+    pixDestroy(&pix1);
+    pix1 = pixOctreeColorQuant(pixs, 200, 1);  /* dither */
+    regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 168 */
+    pixDestroy(&pix1);
+    pixDestroy(&pixs);
+
     return regTestCleanup(rp);
 }
 
@@ -30,6 +30,8 @@
  *    Tests:
  *       - conversions between HSV and both RGB and colormapped images.
  *       - global linear color mapping and extraction of color magnitude
+ *       - fast row conversions from rgb, compared with single pixel
+ *         conversions
  */
 
 #include "allheaders.h"
@@ -39,7 +41,10 @@ int main(int    argc,
 {
 char          label[512];
 l_int32       rval, gval, bval, w, h, i, j, rwhite, gwhite, bwhite, count;
+l_int32       val1, val2, val3, ndiff, maxdiff;
 l_uint32      pixel;
+l_float32     fval1, fval2, fval3, flval, faval, fbval, fmaxdiff;
+FPIXA        *fpixa;
 GPLOT        *gplot1, *gplot2;
 NUMA         *naseq, *na;
 NUMAA        *naa1, *naa2;
@@ -196,5 +201,52 @@ L_REGPARAMS  *rp;
     }
     pixaDestroy(&pixa);
 
+        /* Fast row conversions from rgb.  Gray with the default weights
+         * and hsv must be identical to the single pixel conversions;
+         * yuv may differ by 1 in a few pixels, and lab must be exact. */
+    pixs = pixRead("wyom.jpg");
+    pixGetDimensions(pixs, &w, &h, NULL);
+    pix1 = pixConvertRGBToLuminance(pixs);
+    pix2 = pixConvertRGBToHSV(NULL, pixs);
+    pix3 = pixConvertRGBToYUV(NULL, pixs);
+    fpixa = pixConvertRGBToLAB(pixs);
+    ndiff = maxdiff = 0;
+    fmaxdiff = 0.0;
+    for (i = 0; i < h; i++) {
+        for (j = 0; j < w; j++) {
+            pixGetRGBPixel(pixs, j, i, &rval, &gval, &bval);
+            val1 = (l_int32)(L_RED_WEIGHT * rval + L_GREEN_WEIGHT * gval +
+                             L_BLUE_WEIGHT * bval + 0.5);
+            pixGetPixel(pix1, j, i, &pixel);
+            if (val1 != pixel) ndiff++;
+            convertRGBToHSV(rval, gval, bval, &val1, &val2, &val3);
+            pixGetPixel(pix2, j, i, &pixel);
+            if (pixel != ((val1 << 24) | (val2 << 16) | (val3 << 8)))
+                ndiff++;
+            convertRGBToYUV(rval, gval, bval, &val1, &val2, &val3);
+            pixGetPixel(pix3, j, i, &pixel);
+            maxdiff = L_MAX(maxdiff, L_ABS(val1 - (l_int32)(pixel >> 24)));
+            maxdiff = L_MAX(maxdiff,
+                            L_ABS(val2 - (l_int32)((pixel >> 16) & 0xff)));
+            maxdiff = L_MAX(maxdiff,
+                            L_ABS(val3 - (l_int32)((pixel >> 8) & 0xff)));
+            convertRGBToLAB(rval, gval, bval, &fval1, &fval2, &fval3);
+            fpixaGetPixel(fpixa, 0, j, i, &flval);
+            fpixaGetPixel(fpixa, 1, j, i, &faval);
+            fpixaGetPixel(fpixa, 2, j, i, &fbval);
+            fmaxdiff = L_MAX(fmaxdiff, L_ABS(fval1 - flval));
+            fmaxdiff = L_MAX(fmaxdiff, L_ABS(fval2 - faval));
+            fmaxdiff = L_MAX(fmaxdiff, L_ABS(fval3 - fbval));
+        }
+    }
+    regTestCompareValues(rp, 0, ndiff, 0.0);  /* 12 */
+    regTestCompareValues(rp, 0, maxdiff, 1.0);  /* 13 */
+    regTestCompareValues(rp, 0.0, fmaxdiff, 0.0);  /* 14 */
+    pixDestroy(&pixs);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    fpixaDestroy(&fpixa);
+
     return regTestCleanup(rp);
 }
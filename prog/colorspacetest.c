@@ -0,0 +1,175 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *  colorspacetest.c
+ *
+ *     colorspacetest [filein]
+ *
+ *  Timing for conversion of an rgb image to gray, hsv, yuv and lab.
+ *  Each conversion is done both with the library function, which
+ *  uses the row kernels in colorspace.c, and with a loop that calls
+ *  the single pixel conversion function on each pixel.
+ *  The default input is wyom.jpg, expanded to about 10 Mpixels.
+ */
+
+#include <math.h>
+#include "allheaders.h"
+
+static const l_int32  NTIMES = 5;
+
+l_int32 main(int    argc,
+             char **argv)
+{
+char        *filein;
+l_int32      i, j, k, w, h, wpl, rval, gval, bval, val1, val2, val3;
+l_uint32    *data, *line;
+l_float32    time1, time2, fval1, fval2, fval3;
+FPIXA       *fpixa;
+PIX         *pix0, *pixs, *pixd;
+static char  mainName[] = "colorspacetest";
+
+    if (argc != 1 && argc != 2)
+        return ERROR_INT(" Syntax: colorspacetest [filein]", mainName, 1);
+    filein = (argc == 2) ? argv[1] : (char *)"wyom.jpg";
+
+    if ((pix0 = pixRead(filein)) == NULL)
+        return ERROR_INT("pix0 not read", mainName, 1);
+    pixs = pixConvertTo32(pix0);
+    pixDestroy(&pix0);
+    pixGetDimensions(pixs, &w, &h, NULL);
+    if (w * h < 10000000) {
+        pix0 = pixScale(pixs, sqrt(1.0e7 / (w * h)), sqrt(1.0e7 / (w * h)));
+        pixDestroy(&pixs);
+        pixs = pix0;
+        pixGetDimensions(pixs, &w, &h, NULL);
+    }
+    data = pixGetData(pixs);
+    wpl = pixGetWpl(pixs);
+    fprintf(stderr, "Image size: %d x %d; %d repetitions\n", w, h, NTIMES);
+
+        /* Gray */
+    startTimer();
+    for (k = 0; k < NTIMES; k++) {
+        pixd = pixConvertRGBToLuminance(pixs);
+        pixDestroy(&pixd);
+    }
+    time1 = stopTimer() / NTIMES;
+    startTimer();
+    for (k = 0; k < NTIMES; k++) {
+        pixd = pixCreate(w, h, 8);
+        for (i = 0; i < h; i++) {
+            line = data + i * wpl;
+            for (j = 0; j < w; j++) {
+                extractRGBValues(line[j], &rval, &gval, &bval);
+                val1 = (l_int32)(L_RED_WEIGHT * rval + L_GREEN_WEIGHT * gval +
+                                 L_BLUE_WEIGHT * bval + 0.5);
+                pixSetPixel(pixd, j, i, val1);
+            }
+        }
+        pixDestroy(&pixd);
+    }
+    time2 = stopTimer() / NTIMES;
+    fprintf(stderr, "gray: rows %7.4f sec; per pixel %7.4f sec\n",
+            time1, time2);
+
+        /* HSV */
+    startTimer();
+    for (k = 0; k < NTIMES; k++) {
+        pixd = pixConvertRGBToHSV(NULL, pixs);
+        pixDestroy(&pixd);
+    }
+    time1 = stopTimer() / NTIMES;
+    startTimer();
+    for (k = 0; k < NTIMES; k++) {
+        pixd = pixCopy(NULL, pixs);
+        for (i = 0; i < h; i++) {
+            line = pixGetData(pixd) + i * wpl;
+            for (j = 0; j < w; j++) {
+                extractRGBValues(line[j], &rval, &gval, &bval);
+                convertRGBToHSV(rval, gval, bval, &val1, &val2, &val3);
+                line[j] = (val1 << 24) | (val2 << 16) | (val3 << 8);
+            }
+        }
+        pixDestroy(&pixd);
+    }
+    time2 = stopTimer() / NTIMES;
+    fprintf(stderr, "hsv:  rows %7.4f sec; per pixel %7.4f sec\n",
+            time1, time2);
+
+        /* YUV */
+    startTimer();
+    for (k = 0; k < NTIMES; k++) {
+        pixd = pixConvertRGBToYUV(NULL, pixs);
+        pixDestroy(&pixd);
+    }
+    time1 = stopTimer() / NTIMES;
+    startTimer();
+    for (k = 0; k < NTIMES; k++) {
+        pixd = pixCopy(NULL, pixs);
+        for (i = 0; i < h; i++) {
+            line = pixGetData(pixd) + i * wpl;
+            for (j = 0; j < w; j++) {
+                extractRGBValues(line[j], &rval, &gval, &bval);
+                convertRGBToYUV(rval, gval, bval, &val1, &val2, &val3);
+                line[j] = (val1 << 24) | (val2 << 16) | (val3 << 8);
+            }
+        }
+        pixDestroy(&pixd);
+    }
+    time2 = stopTimer() / NTIMES;
+    fprintf(stderr, "yuv:  rows %7.4f sec; per pixel %7.4f sec\n",
+            time1, time2);
+
+        /* LAB */
+    startTimer();
+    for (k = 0; k < NTIMES; k++) {
+        fpixa = pixConvertRGBToLAB(pixs);
+        fpixaDestroy(&fpixa);
+    }
+    time1 = stopTimer() / NTIMES;
+    startTimer();
+    for (k = 0; k < NTIMES; k++) {
+        fpixa = pixConvertRGBToLAB(pixs);  /* for allocation only */
+        for (i = 0; i < h; i++) {
+            line = data + i * wpl;
+            for (j = 0; j < w; j++) {
+                extractRGBValues(line[j], &rval, &gval, &bval);
+                convertRGBToLAB(rval, gval, bval, &fval1, &fval2, &fval3);
+                fpixaSetPixel(fpixa, 0, j, i, fval1);
+                fpixaSetPixel(fpixa, 1, j, i, fval2);
+                fpixaSetPixel(fpixa, 2, j, i, fval3);
+            }
+        }
+        fpixaDestroy(&fpixa);
+    }
+    time2 = stopTimer() / NTIMES;
+    fprintf(stderr, "lab:  rows %7.4f sec; per pixel %7.4f sec\n",
+            time1, time2);
+
+    pixDestroy(&pixs);
+    return 0;
+}
@@ -50,7 +50,7 @@ l_uint32      srcval, dstval;
 l_float32     scalefact, sat, fract;
 L_BMF        *bmf8;
 L_KERNEL     *kel;
-NUMA         *na;
+NUMA         *na, *na1, *na2;
 PIX          *pix, *pixs, *pixs1, *pixs2, *pixd;
 PIX          *pixt0, *pixt1, *pixt2, *pixt3, *pixt4;
 PIXA         *pixa, *pixaf;
@@ -225,5 +225,49 @@ L_REGPARAMS  *rp;
     pixDestroy(&pixt2);
     pixDestroy(&pixt3);
     pixDestroy(&pixt4);
+
+    /* -----------------------------------------------*
+     *              Test composed TRC maps            *
+     * -----------------------------------------------*/
+        /* Gamma followed by contrast in one pass */
+    pix = pixRead(filein);
+    pixt1 = pixGammaTRC(NULL, pix, 0.7, 20, 230);
+    pixContrastTRC(pixt1, pixt1, 0.5);
+    na1 = numaGammaTRC(0.7, 20, 230);
+    na2 = numaContrastTRC(0.5);
+    na = numaComposeTRC(na1, na2);
+    pixt2 = pixCopy(NULL, pix);
+    pixTRCMap(pixt2, NULL, na);
+    regTestComparePix(rp, pixt1, pixt2);  /* 14 */
+
+        /* Same map for each component */
+    pixt3 = pixCopy(NULL, pix);
+    pixTRCMapGeneral(pixt3, NULL, na, na, na);
+    regTestComparePix(rp, pixt2, pixt3);  /* 15 */
+    pixDestroy(&pixt1);
+    pixDestroy(&pixt2);
+    pixDestroy(&pixt3);
+
+        /* Masked mapping on 8 bpp, with a mask edge inside a word */
+    pixs = pixConvertRGBToLuminance(pix);
+    pixGetDimensions(pixs, &w, &h, NULL);
+    pixt0 = pixCreate(w, h, 1);
+    pixRasterop(pixt0, 37, 21, w / 2, h / 2, PIX_SET, NULL, 0, 0);
+    pixt1 = pixCopy(NULL, pixs);
+    pixTRCMap(pixt1, pixt0, na);
+    pixt2 = pixCopy(NULL, pixs);
+    pixTRCMap(pixt2, NULL, na);
+    pixt3 = pixCopy(NULL, pixs);
+    pixCombineMasked(pixt3, pixt2, pixt0);
+    regTestComparePix(rp, pixt1, pixt3);  /* 16 */
+    numaDestroy(&na);
+    numaDestroy(&na1);
+    numaDestroy(&na2);
+    pixDestroy(&pix);
+    pixDestroy(&pixs);
+    pixDestroy(&pixt0);
+    pixDestroy(&pixt1);
+    pixDestroy(&pixt2);
+    pixDestroy(&pixt3);
     return regTestCleanup(rp);
 }
@@ -30,7 +30,9 @@
  *   Tests 90 degree orientation of text and whether the text is
  *   mirror reversed.  Compares the rasterop with dwa implementations
  *   for speed.  Shows the typical 'confidence' outputs from the
- *   functions in flipdetect.c.
+ *   functions in flipdetect.c.  Also tests orientation and mirror
+ *   correction of a set of pages in all eight states, and returns
+ *   a nonzero exit status if any page is not corrected.
  */
 
 #include "allheaders.h"
@@ -41,15 +43,18 @@ int main(int    argc,
          char **argv)
 {
 char        *filein;
-l_int32      i, orient;
+l_int32      i, orient, rot, flip, same, failure;
 l_float32    upconf1, upconf2, leftconf1, leftconf2, conf1, conf2;
+NUMA        *narot, *naflip;
 PIX         *pixs, *pixt1, *pixt2;
+PIXA        *pixa1, *pixa2;
 static char  mainName[] = "flipdetect_reg";
 
     if (argc != 2)
         return ERROR_INT(" Syntax: flipdetect_reg filein", mainName, 1);
 
     filein = argv[1];
+    failure = 0;
 
     if ((pixt1 = pixRead(filein)) == NULL)
         return ERROR_INT("pixt1 not made", mainName, 1);
@@ -91,6 +96,38 @@ static char  mainName[] = "flipdetect_reg";
     }
     pixDestroy(&pixt1);
 
+    fprintf(stderr, "\nTest orient and mirror correction for 8 states\n");
+    pixa1 = pixaCreate(8);
+    pixt2 = pixFlipLR(NULL, pixs);
+    for (i = 0; i < 4; i++)
+        pixaAddPix(pixa1, pixRotateOrth(pixs, i), L_INSERT);
+    for (i = 0; i < 4; i++)
+        pixaAddPix(pixa1, pixRotateOrth(pixt2, i), L_INSERT);
+    pixDestroy(&pixt2);
+    startTimer();
+    pixa2 = pixaOrientCorrect(pixa1, 0, 0, 1, &narot, &naflip);
+    fprintf(stderr, "Time for orient correction: %7.3f sec\n", stopTimer());
+    for (i = 0; i < 8; i++) {
+        pixt1 = pixaGetPix(pixa2, i, L_CLONE);
+        numaGetIValue(narot, i, &rot);
+        numaGetIValue(naflip, i, &flip);
+        pixEqual(pixs, pixt1, &same);
+        if (same && rot == (4 - i % 4) % 4 * 90 && flip == i / 4) {
+            fprintf(stderr, "Page rotated %d deg cw, flip %d: corrected\n",
+                    90 * (i % 4), i / 4);
+        } else {
+            fprintf(stderr, "Page rotated %d deg cw, flip %d: error "
+                    "(rotation %d, flip %d)\n", 90 * (i % 4), i / 4,
+                    rot, flip);
+            failure = 1;
+        }
+        pixDestroy(&pixt1);
+    }
+    pixaDestroy(&pixa1);
+    pixaDestroy(&pixa2);
+    numaDestroy(&narot);
+    numaDestroy(&naflip);
+
     fprintf(stderr, "\nTest mirror reverse detection\n");
     startTimer();
     pixMirrorDetect(pixs, &conf1, 0, 1);
@@ -118,7 +155,7 @@ static char  mainName[] = "flipdetect_reg";
         fprintf(stderr, "Confidence results differ\n");
 
     pixDestroy(&pixs);
-    return 0;
+    return failure;
 }
 
 
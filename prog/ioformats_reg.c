@@ -87,6 +87,7 @@ static l_int32 testcomp_mem(PIX *pixs, PIX **ppixt, l_int32 index,
 static l_int32 test_writemem(PIX *pixs, l_int32 format, char *psfile);
 static PIX *make_24_bpp_pix(PIX *pixs);
 static l_int32 get_header_data(const char *filename, l_int32 true_format);
+static l_int32 get_batch_header_data(void);
 static void get_tiff_compression_name(char *buf, l_int32 format);
 
 LEPT_DLL extern const char *ImageFileFormatExtensions[];
@@ -482,6 +483,8 @@ part6:
     if (get_header_data(FILE_16BPP, IFF_TIFF_ZIP)) success = FALSE;
     if (get_header_data(FILE_32BPP, IFF_JFIF_JPEG)) success = FALSE;
     if (get_header_data(FILE_32BPP_ALPHA, IFF_PNG)) success = FALSE;
+    if (get_header_data(BMP_FILE, IFF_BMP)) success = FALSE;
+    if (get_batch_header_data()) success = FALSE;
 
     pix = pixRead(FILE_8BPP_1);
     tempname = l_makeTempFilename();
@@ -504,6 +507,22 @@ part6:
     pixWrite(tempname, pix, IFF_TIFF);
     if (get_header_data(tempname, IFF_TIFF)) success = FALSE;
     pixDestroy(&pix);
+#if HAVE_LIBGIF
+        /* The gif header is read from the file without decoding, and
+         * from memory by decoding the image */
+    pix = pixRead(FILE_1BPP);
+    pixWrite(tempname, pix, IFF_GIF);
+    if (get_header_data(tempname, IFF_GIF)) success = FALSE;
+    pixDestroy(&pix);
+    pix = pixRead(FILE_4BPP_C);
+    pixWrite(tempname, pix, IFF_GIF);
+    if (get_header_data(tempname, IFF_GIF)) success = FALSE;
+    pixDestroy(&pix);
+    pix = pixRead(FILE_8BPP_1);
+    pixWrite(tempname, pix, IFF_GIF);
+    if (get_header_data(tempname, IFF_GIF)) success = FALSE;
+    pixDestroy(&pix);
+#endif  /* HAVE_LIBGIF */
     lept_rmfile(tempname);
     lept_free(tempname);
 
@@ -727,6 +746,10 @@ size_t    size1, size2;
         true_format == IFF_TIFF)
         return 0;
 #endif  /* !HAVE_LIBTIFF */
+#if !HAVE_LIBGIF
+    if (true_format == IFF_GIF)
+        return 0;
+#endif  /* !HAVE_LIBGIF */
 
         /* Read header from file */
     size1 = nbytesInFile(filename);
@@ -779,6 +802,62 @@ size_t    size1, size2;
 }
 
 
+    /* Retrieve header data from a set of files in one call */
+static l_int32
+get_batch_header_data(void)
+{
+char     *fname;
+l_int32   i, n, ret, format, w, h, d, res, npages;
+NUMA     *naformat, *naw, *nah, *nad, *nares, *napages;
+PIX      *pix;
+SARRAY   *sa;
+
+    sa = sarrayCreate(0);
+    sarrayAddString(sa, (char *)FILE_1BPP, L_COPY);
+    sarrayAddString(sa, (char *)FILE_4BPP_C, L_COPY);
+    sarrayAddString(sa, (char *)FILE_8BPP_3, L_COPY);
+    sarrayAddString(sa, (char *)FILE_16BPP, L_COPY);
+    sarrayAddString(sa, (char *)FILE_32BPP, L_COPY);
+    sarrayAddString(sa, (char *)BMP_FILE, L_COPY);
+    pixReadHeadersSA(sa, &naformat, &naw, &nah, &nad, &nares, &napages);
+
+    ret = 0;
+    n = sarrayGetCount(sa);
+    for (i = 0; i < n; i++) {
+        fname = sarrayGetString(sa, i, L_NOCOPY);
+        numaGetIValue(naformat, i, &format);
+        numaGetIValue(naw, i, &w);
+        numaGetIValue(nah, i, &h);
+        numaGetIValue(nad, i, &d);
+        numaGetIValue(nares, i, &res);
+        numaGetIValue(napages, i, &npages);
+        fprintf(stderr, "Batch header data for image %s:\n"
+                "  format = %d, size (w, h, d) = (%d, %d, %d)\n"
+                "  res = %d, npages = %d\n", fname, format, w, h, d,
+                res, npages);
+        if ((pix = pixRead(fname)) == NULL)
+            continue;
+        if (format != pixGetInputFormat(pix) || w != pixGetWidth(pix) ||
+            h != pixGetHeight(pix) || d != pixGetDepth(pix) ||
+            res != pixGetXRes(pix) || npages != 1) {
+            fprintf(stderr, "Inconsistent batch header for image %s\n",
+                    fname);
+            ret = 1;
+        }
+        pixDestroy(&pix);
+    }
+
+    sarrayDestroy(&sa);
+    numaDestroy(&naformat);
+    numaDestroy(&naw);
+    numaDestroy(&nah);
+    numaDestroy(&nad);
+    numaDestroy(&nares);
+    numaDestroy(&napages);
+    return ret;
+}
+
+
 static void
 get_tiff_compression_name(char    *buf,
                           l_int32  format)
@@ -36,7 +36,9 @@
  *
  *    This only tests properly written jpeg files.  To test
  *    reading of corrupted jpeg files to insure that the
- *    reader does not crash, use prog/corrupttest.c.
+ *    reader does not crash, use prog/corrupttest.c.  The one
+ *    exception is a truncated file, where the memory reader
+ *    must give the same result as the file reader.
  *
  *    TODO (5/5/14): Add tests for
  *    (1) different color spaces
@@ -56,6 +58,8 @@ void DoJpegTest1(L_REGPARAMS *rp, const char *fname);
 void DoJpegTest2(L_REGPARAMS *rp, const char *fname);
 void DoJpegTest3(L_REGPARAMS *rp, const char *fname);
 void DoJpegTest4(L_REGPARAMS *rp, const char *fname);
+void DoJpegTest5(L_REGPARAMS *rp, const char *fname);
+void DoJpegTest6(L_REGPARAMS *rp, const char *fname);
 
 
 int main(int    argc,
@@ -86,6 +90,10 @@ L_REGPARAMS  *rp;
     DoJpegTest3(rp, "lucasta.150.jpg");
     DoJpegTest3(rp, "tetons.jpg");
     DoJpegTest4(rp, "karen8.jpg");
+    DoJpegTest5(rp, "marge.jpg");
+    DoJpegTest5(rp, "test8.jpg");
+    DoJpegTest6(rp, "marge.jpg");
+    DoJpegTest6(rp, "test8.jpg");
 
     return regTestCleanup(rp);
 }
@@ -259,4 +267,154 @@ PIX     *pixs;
     return;
 }
 
+void DoJpegTest5(L_REGPARAMS  *rp,
+                 const char   *fname)
+{
+char     buf[256];
+l_int32  w, h;
+BOX     *box1, *box2;
+PIX     *pixs, *pix1, *pix2, *pix3;
+
+        /* Test region reading at full and reduced resolution */
+    pixs = pixRead(fname);
+    box1 = boxCreate(37, 53, 211, 133);
+    pix1 = pixClipRectangle(pixs, box1, NULL);
+    pix2 = pixReadJpegRegion(fname, box1, 1, 0);
+    regTestComparePix(rp, pix1, pix2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pix1 = pixReadJpeg(fname, 0, 2, NULL, 0);
+    box2 = boxTransform(box1, 0, 0, 0.5, 0.5);
+    pix2 = pixClipRectangle(pix1, box2, NULL);
+    pix3 = pixReadJpegRegion(fname, box1, 2, 0);
+    regTestComparePix(rp, pix2, pix3);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    boxDestroy(&box2);
+
+        /* Test the thumbnail */
+    pix1 = pixReadJpeg(fname, 0, 8, NULL, 0);
+    pix2 = pixScaleAreaMap2(pix1);
+    pix3 = pixReadJpegThumbnail(fname, 16);
+    regTestCompareSimilarPix(rp, pix2, pix3, 10, 0.01, 0);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+
+        /* Test lossless rotation; the idct is not exactly symmetric
+         * under transposition, so the results are only similar */
+    snprintf(buf, sizeof(buf), "/tmp/lept/regout/jpegio.%d.jpg", rp->index + 1);
+    jpegTransformLossless(fname, buf, 1, NULL);
+    pix1 = pixRead(buf);
+    pix2 = pixRotateOrth(pixs, 1);
+    pixGetDimensions(pix1, &w, &h, NULL);
+    box2 = boxCreate(pixGetWidth(pix2) - w, 0, w, h);  /* trimmed on left */
+    pix3 = pixClipRectangle(pix2, box2, NULL);
+    regTestCompareSimilarPix(rp, pix1, pix3, 5, 0.01, 0);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    boxDestroy(&box2);
+
+        /* Test that two lossless rotations by 180 restore the image */
+    jpegTransformLossless(fname, buf, 2, box1);
+    jpegTransformLossless(buf, buf, 2, NULL);
+    pix1 = pixRead(buf);
+    pixGetDimensions(pix1, &w, &h, NULL);
+    box2 = boxCreate(32, 48, w, h);  /* box1 aligned to MCU and trimmed */
+    pix2 = pixClipRectangle(pixs, box2, NULL);
+    regTestCompareSimilarPix(rp, pix1, pix2, 20, 0.01, 0);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    boxDestroy(&box2);
+
+        /* Test region reading and lossless cropping with an MCU-aligned
+         * box.  The luminance is not subsampled, so its crop decodes
+         * to exactly the same pixels as in the full image. */
+    box2 = boxCreate(32, 48, 208, 128);
+    pix1 = pixClipRectangle(pixs, box2, NULL);
+    pix2 = pixReadJpegRegion(fname, box2, 1, 0);
+    regTestComparePix(rp, pix1, pix2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    snprintf(buf, sizeof(buf), "/tmp/lept/regout/jpegio.%d.jpg", rp->index + 1);
+    jpegTransformLossless(fname, buf, 0, box2);
+    pix1 = pixReadJpeg(fname, 0, 1, NULL, L_JPEG_READ_LUMINANCE);
+    pix2 = pixClipRectangle(pix1, box2, NULL);
+    pix3 = pixReadJpeg(buf, 0, 1, NULL, L_JPEG_READ_LUMINANCE);
+    regTestComparePix(rp, pix2, pix3);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    boxDestroy(&box1);
+    boxDestroy(&box2);
+    pixDestroy(&pixs);
+    return;
+}
+
+/* Compare the memory read/write functions with the file functions */
+void DoJpegTest6(L_REGPARAMS  *rp,
+                 const char   *fname)
+{
+char      buf1[256], buf2[256];
+l_uint8  *data1, *data2;
+l_int32   i, w1, h1, spp1, w2, h2, spp2, same;
+size_t    size1, size2;
+PIX      *pixs, *pix1, *pix2;
 
+        /* The encoded data is the same */
+    pixs = pixRead(fname);
+    pixSetText(pixs, "jpegio memory test");
+    snprintf(buf1, sizeof(buf1), "/tmp/lept/regout/jpegio.%d.jpg",
+             rp->index + 1);
+    pixWriteJpeg(buf1, pixs, 75, 0);
+    pixWriteMemJpeg(&data1, &size1, pixs, 75, 0);
+    data2 = l_binaryRead(buf1, &size2);
+    regTestCompareStrings(rp, data1, size1, data2, size2);
+    lept_free(data2);
+
+        /* The header and the decoded images at each reduction */
+    readHeaderMemJpeg(data1, size1, &w1, &h1, &spp1, NULL, NULL);
+    readHeaderJpeg(buf1, &w2, &h2, &spp2, NULL, NULL);
+    regTestCompareValues(rp, w2, w1, 0);
+    regTestCompareValues(rp, h2, h1, 0);
+    regTestCompareValues(rp, spp2, spp1, 0);
+    for (i = 1; i <= 8; i *= 2) {
+        pix1 = pixReadMemJpeg(data1, size1, 0, i, NULL, 0);
+        pix2 = pixReadJpeg(buf1, 0, i, NULL, 0);
+        regTestComparePix(rp, pix1, pix2);
+        if (i == 1) {
+            regTestCompareStrings(rp, (l_uint8 *)pixGetText(pix2),
+                                  strlen(pixGetText(pix2)),
+                                  (l_uint8 *)pixGetText(pix1),
+                                  strlen(pixGetText(pix1)));
+        }
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+
+        /* The progressive encoding is the same */
+    pixWriteJpeg(buf1, pixs, 75, 1);
+    pixWriteMemJpeg(&data2, &size2, pixs, 75, 1);
+    lept_free(data1);
+    data1 = l_binaryRead(buf1, &size1);
+    regTestCompareStrings(rp, data1, size1, data2, size2);
+    lept_free(data2);
+
+        /* Truncated data is read the same way */
+    snprintf(buf2, sizeof(buf2), "/tmp/lept/regout/jpegio.%d.jpg",
+             rp->index + 1);
+    l_binaryWrite(buf2, "w", data1, size1 / 2);
+    pix1 = pixReadMemJpeg(data1, size1 / 2, 0, 1, NULL, 0);
+    pix2 = pixReadJpeg(buf2, 0, 1, NULL, 0);
+    same = (pix1 == NULL && pix2 == NULL);
+    if (pix1 && pix2)
+        pixEqual(pix1, pix2, &same);
+    regTestCompareValues(rp, 1, same, 0);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    lept_free(data1);
+    pixDestroy(&pixs);
+    return;
+}
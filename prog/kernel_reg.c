@@ -41,7 +41,7 @@ int main(int    argc,
          char **argv)
 {
 char         *str;
-l_int32       i, j, same, ok;
+l_int32       i, j, same, ok, sep;
 l_float32     sum, avediff, rmsdiff;
 L_KERNEL     *kel1, *kel2, *kel3, *kel4, *kelx, *kely;
 BOX          *box;
@@ -337,6 +337,27 @@ L_REGPARAMS  *rp;
     pixSaveTiled(pixt, pixa, 1.0, 0, 20, 0);
     pixDestroy(&pixt);
     kernelDestroy(&kel1);
+    pixDestroy(&pixs);
+
+        /* Test separability detection.  Convolution with the factors
+         * of the gaussian kernel gives the same result as with the
+         * full kernel, to within rounding.  The DoG is not separable. */
+    pixs = pixRead("test8.jpg");
+    kel1 = makeGaussianKernel(5, 5, 3.0, 5.0);
+    kernelIsSeparable(kel1, &sep, &kelx, &kely);
+    regTestCompareValues(rp, 1, sep, 0.0);  /* 21 */
+    pixt = pixConvolve(pixs, kel1, 8, 1);
+    pixt2 = pixConvolveSep(pixs, kelx, kely, 8, 1);
+    regTestCompareSimilarPix(rp, pixt, pixt2, 2, 0.0, 0);  /* 22 */
+    pixDestroy(&pixt);
+    pixDestroy(&pixt2);
+    kernelDestroy(&kel1);
+    kernelDestroy(&kelx);
+    kernelDestroy(&kely);
+    kel1 = makeDoGKernel(7, 7, 1.5, 2.7);
+    kernelIsSeparable(kel1, &sep, NULL, NULL);
+    regTestCompareValues(rp, 0, sep, 0.0);  /* 23 */
+    kernelDestroy(&kel1);
     pixDestroy(&pixs);
 
     pixd = pixaDisplay(pixa, 0, 0);
@@ -29,6 +29,10 @@
  *
  *    Simple regression test for binary morph sequence (interpreter),
  *    showing display mode and rejection of invalid sequence components.
+ *    Also checks that compiled sequences give the same result as the
+ *    interpreter, with both boundary conditions, and that a compiled
+ *    sequence is not applied after the boundary condition is changed.
+ *    Returns 1 if any of these checks fail.
  */
 
 #include "allheaders.h"
@@ -38,6 +42,8 @@
 #define  SEQUENCE3    "e3.3 + d3.3 + tw5.5"
 #define  SEQUENCE4    "O3.3 + C3.3"
 #define  SEQUENCE5    "O5.5 + C5.5"
+#define  SEQUENCE6    "d3.3 + d5.5 + e3.1 + e1.5 + o16.23 + c51.1"
+#define  SEQUENCE7    "b32 + o1.3 + C3.1 + r23 + e2.2 + D3.2 + X4"
 #define  BAD_SEQUENCE  "O1.+D8 + E2.4 + e.4 + r25 + R + R.5 + X + x5 + y7.3"
 
 #define  DISPLAY_SEPARATION   0   /* use 250 to get images displayed */
@@ -45,7 +51,11 @@
 int main(int    argc,
          char **argv)
 {
-PIX         *pixs, *pixg, *pixc, *pixd;
+l_int32      i, j, n, same, failure;
+const char  *seq[] = {SEQUENCE1, SEQUENCE4, SEQUENCE6, SEQUENCE7};
+L_MORPHSEQ  *ms;
+PIX         *pixs, *pixg, *pixc, *pixd, *pix1;
+PIXA        *pixa1, *pixa2;
 static char  mainName[] = "morphseq_reg";
 
     if (argc != 1)
@@ -82,6 +92,57 @@ static char  mainName[] = "morphseq_reg";
     pixWrite("/tmp/lept/morphseq4.png", pixd, IFF_PNG);
     pixDestroy(&pixd);
 
+        /* Compiled sequences, with both b.c. */
+    pixa1 = pixaCreate(3);
+    pixaAddPix(pixa1, pixs, L_COPY);
+    pixaAddPix(pixa1, pixScale(pixs, 0.5, 0.5), L_INSERT);
+    pixaAddPix(pixa1, pixScale(pixs, 0.7, 0.6), L_INSERT);
+    n = pixaGetCount(pixa1);
+    failure = FALSE;
+    for (i = 0; i < 8; i++) {
+        resetMorphBoundaryCondition((i < 4) ? ASYMMETRIC_MORPH_BC
+                                            : SYMMETRIC_MORPH_BC);
+        ms = morphseqCreate(seq[i % 4]);
+        if ((pixa2 = pixaMorphSeqApply(pixa1, ms)) == NULL) {
+            fprintf(stderr, "Error: compiled sequence %d not applied\n", i);
+            failure = TRUE;
+            morphseqDestroy(&ms);
+            continue;
+        }
+        for (j = 0; j < n; j++) {
+            pixc = pixaGetPix(pixa1, j, L_CLONE);
+            pixd = pixMorphSequence(pixc, seq[i % 4], 0);
+            pix1 = pixaGetPix(pixa2, j, L_CLONE);
+            pixEqual(pixd, pix1, &same);
+            if (!same) {
+                fprintf(stderr, "Error: compiled sequence %d differs "
+                        "for pix %d\n", i, j);
+                failure = TRUE;
+            }
+            pixDestroy(&pixc);
+            pixDestroy(&pixd);
+            pixDestroy(&pix1);
+        }
+        pixaDestroy(&pixa2);
+        morphseqDestroy(&ms);
+    }
+
+        /* A sequence compiled with one b.c. is refused with the other */
+    resetMorphBoundaryCondition(ASYMMETRIC_MORPH_BC);
+    ms = morphseqCreate(SEQUENCE6);
+    resetMorphBoundaryCondition(SYMMETRIC_MORPH_BC);
+    pix1 = pixMorphSeqApply(pixs, ms);
+    pixa2 = pixaMorphSeqApply(pixa1, ms);
+    if (pix1 || pixa2) {
+        fprintf(stderr, "Error: sequence applied with a different b.c.\n");
+        failure = TRUE;
+    }
+    pixDestroy(&pix1);
+    pixaDestroy(&pixa2);
+    morphseqDestroy(&ms);
+    resetMorphBoundaryCondition(ASYMMETRIC_MORPH_BC);
+    pixaDestroy(&pixa1);
+
         /* 8 bpp */
     pixg = pixScaleToGray(pixs, 0.25);
     pixd = pixGrayMorphSequence(pixg, SEQUENCE3, -5, 150);
@@ -112,5 +173,5 @@ static char  mainName[] = "morphseq_reg";
 
     pixDestroy(&pixg);
     pixDestroy(&pixs);
-    return 0;
+    return failure;
 }
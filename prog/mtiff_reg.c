@@ -50,8 +50,10 @@ char          buffer[512];
 l_int32       i, n, npages, equal, success;
 size_t        length, offset, size;
 FILE         *fp;
+BOX          *box;
+L_DNA        *da;
 NUMA         *naflags, *nasizes;
-PIX          *pix, *pix1, *pix2;
+PIX          *pix, *pix1, *pix2, *pix3, *pix4;
 PIXA         *pixa, *pixa1, *pixa2, *pixa3;
 SARRAY       *savals, *satypes, *sa;
 L_REGPARAMS  *rp;
@@ -311,6 +313,94 @@ L_REGPARAMS  *rp;
     regTestCompareFiles(rp, 18, 22);  /* 23 */
     pixaDestroy(&pixa);
 
+    /* ------------------  Test indexed multipage I/O  -------------------*/
+        /* Write the 1000 image file through a single handle, index the
+         * pages, and read a range of them from the middle of the file. */
+    pix1 = pixRead("char.tif");
+    pixa1 = pixaCreate(1000);
+    for (i = 0; i < 1000; i++)
+        pixaAddPix(pixa1, pix1, L_CLONE);
+    pixDestroy(&pix1);
+    startTimer();
+    pixaWriteMultipageTiff("/tmp/lept/tiff/junkm3.tif", pixa1);
+    if (rp->display)
+        fprintf(stderr, "Time to write 1000 images: %7.3f sec\n", stopTimer());
+    fp = lept_fopen("/tmp/lept/tiff/junkm3.tif", "rb");
+    tiffGetPageOffsets(fp, &da);
+    lept_fclose(fp);
+    regTestCompareValues(rp, 1000, l_dnaGetCount(da), 0);  /* 24 */
+    pixa2 = pixaReadMultipageTiffIndexed("/tmp/lept/tiff/junkm3.tif", da,
+                                         600, 10);
+    regTestCompareValues(rp, 10, pixaGetCount(pixa2), 0);  /* 25 */
+    pixaDestroy(&pixa2);
+    pixaDestroy(&pixa1);
+    l_dnaDestroy(&da);
+
+        /* Compare the indexed read of all pages with the serial read */
+    pixa1 = pixaReadMultipageTiff("/tmp/lept/tiff/weasel8.tif");
+    pixa2 = pixaReadMultipageTiffIndexed("/tmp/lept/tiff/weasel8.tif", NULL,
+                                         0, 0);
+    n = pixaGetCount(pixa1);
+    success = (n > 0 && pixaGetCount(pixa2) == n);
+    for (i = 0; i < n && success; i++) {
+        pix1 = pixaGetPix(pixa1, i, L_CLONE);
+        pix2 = pixaGetPix(pixa2, i, L_CLONE);
+        pixEqual(pix1, pix2, &equal);
+        if (!equal) success = FALSE;
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+    regTestCompareValues(rp, TRUE, success, 0);  /* 26 */
+    pixaDestroy(&pixa1);
+    pixaDestroy(&pixa2);
+
+        /* Read regions of a page, decoding only the strips they intersect */
+    box = boxCreate(213, 345, 608, 481);
+    pix1 = pixRead("feyn.tif");
+    pixWrite("/tmp/lept/tiff/feyn_g4.tif", pix1, IFF_TIFF_G4);
+    pix2 = pixClipRectangle(pix1, box, NULL);
+    pix3 = pixReadTiffRegion("/tmp/lept/tiff/feyn_g4.tif", 0, box);
+    regTestComparePix(rp, pix2, pix3);  /* 27 */
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    pix2 = pixConvertTo8(pix1, FALSE);
+    pixWrite("/tmp/lept/tiff/feyn_zip.tif", pix2, IFF_TIFF_ZIP);
+    pix3 = pixClipRectangle(pix2, box, NULL);
+    pix4 = pixReadTiffRegion("/tmp/lept/tiff/feyn_zip.tif", 0, box);
+    regTestComparePix(rp, pix3, pix4);  /* 28 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    pixDestroy(&pix4);
+    boxDestroy(&box);
+
+        /* Read regions of tiled files, where each tile that the
+         * region intersects is decoded and blitted into the region */
+    box = boxCreate(21, 9, 50, 45);
+    pix1 = pixRead("weasel32.png");
+    pix2 = pixClipRectangle(pix1, box, NULL);
+    pix3 = pixReadTiffRegion("weasel32-tiled.tif", 0, box);
+    regTestComparePix(rp, pix2, pix3);  /* 29 */
+    pix4 = pixRead("weasel32-tiled.tif");
+    regTestComparePix(rp, pix1, pix4);  /* 30 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    pixDestroy(&pix4);
+    boxDestroy(&box);
+    box = boxCreate(5, 3, 40, 30);
+    pix1 = pixRead("speckle.png");
+    pix2 = pixClipRectangle(pix1, box, NULL);
+    pix3 = pixReadTiffRegion("speckle-tiled.tif", 0, box);
+    regTestComparePix(rp, pix2, pix3);  /* 31 */
+    pix4 = pixRead("speckle-tiled.tif");
+    regTestComparePix(rp, pix1, pix4);  /* 32 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    pixDestroy(&pix4);
+    boxDestroy(&box);
+
 
 #if 0    /* -----   test adding custom public tags to a tiff header ----- */
     pix = pixRead("feyn.tif");
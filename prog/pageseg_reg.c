@@ -38,7 +38,9 @@ int main(int    argc,
          char **argv)
 {
 l_int32       i, n;
+l_float32     elapsed;
 BOXA         *boxa;
+NUMA         *natime;
 PIX          *pixs, *pix1, *pixhm, *pixtm, *pixtb, *pixdb;
 PIXA         *pixadb;
 L_REGPARAMS  *rp;
@@ -81,10 +83,27 @@ L_REGPARAMS  *rp;
     regTestWritePixAndCheck(rp, pixdb, IFF_PNG);  /* 19 */
     if (rp->display)
         pixDisplay(pixdb, 0, 700);
-    pixDestroy(&pixs);
     pixDestroy(&pix1);
     pixDestroy(&pixdb);
     boxaDestroy(&boxa);
+
+        /* Requesting a subset of the masks skips the stages that
+         * are not needed, without changing the masks that are made */
+    pixGetRegionsBinary(pixs, &pixhm, &pixtm, NULL, NULL);
+    natime = numaCreate(5);
+    pixGetRegionsBinaryTimed(pixs, &pix1, NULL, NULL, natime, NULL);
+    regTestComparePix(rp, pixhm, pix1);  /* 20 */
+    pixDestroy(&pix1);
+    pixGetRegionsBinaryTimed(pixs, NULL, &pix1, NULL, natime, NULL);
+    regTestComparePix(rp, pixtm, pix1);  /* 21 */
+    regTestCompareValues(rp, 10, numaGetCount(natime), 0.0);  /* 22 */
+    numaGetFValue(natime, 3, &elapsed);  /* textblock stage skipped */
+    regTestCompareValues(rp, 0.0, elapsed, 0.0);  /* 23 */
+    pixDestroy(&pix1);
+    pixDestroy(&pixhm);
+    pixDestroy(&pixtm);
+    numaDestroy(&natime);
+    pixDestroy(&pixs);
     return regTestCleanup(rp);
 }
 
@@ -0,0 +1,112 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *  partition_reg.c
+ *
+ *     Regression test for finding whitespace blocks with
+ *     boxaGetWhiteblocks().
+ *
+ *     The obstacles are the bounding boxes of the connected components
+ *     of a dilated page image.  The whitespace boxes are found for
+ *     several sort types and saved for comparison with the goldens.
+ *     Using the default region (box == NULL) must give the same result
+ *     as passing the region from the origin to the far corner of the
+ *     boxes.
+ */
+
+#include "allheaders.h"
+
+static const l_int32  sorttype[] = {L_SORT_BY_WIDTH, L_SORT_BY_HEIGHT,
+                                    L_SORT_BY_MAX_DIMENSION,
+                                    L_SORT_BY_PERIMETER};
+
+int main(int    argc,
+         char **argv)
+{
+char          buf[256];
+l_uint8      *data1, *data2;
+l_int32       i, w, h, wb, hb;
+size_t        size1, size2;
+BOX          *box, *box1;
+BOXA         *boxa1, *boxa2, *boxa3, *boxa4;
+PIX          *pix1, *pixs;
+PIXA         *pixa;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    pix1 = pixRead("rabi.png");
+    pixs = pixReduceRankBinaryCascade(pix1, 1, 0, 0, 0);
+    pixDestroy(&pix1);
+    pixDilateBrick(pixs, pixs, 5, 5);
+    pixGetDimensions(pixs, &w, &h, NULL);
+    boxa1 = pixConnComp(pixs, NULL, 4);
+    boxa2 = boxaSelectBySize(boxa1, 500, 500, L_SELECT_IF_BOTH,
+                             L_SELECT_IF_LT, NULL);
+    box = boxCreate(0, 0, w, h);
+    pixa = pixaCreate(0);
+
+        /* Whitespace blocks for several sort types */
+    for (i = 0; i < 4; i++) {
+        boxa3 = boxaGetWhiteblocks(boxa2, box, sorttype[i], 100, 0.2,
+                                   200, 0.15, 20000);
+        snprintf(buf, sizeof(buf), "/tmp/lept/regout/partition.%d.ba", i);
+        boxaWrite(buf, boxa3);
+        regTestCheckFile(rp, buf);  /* 0 - 3 */
+        pix1 = pixConvertTo8(pixs, FALSE);
+        pixaAddPix(pixa, pixPaintBoxaRandom(pix1, boxa3), L_INSERT);
+        pixDestroy(&pix1);
+        boxaDestroy(&boxa3);
+    }
+
+        /* The default region extends to the far corner of the boxes */
+    boxaGetExtent(boxa2, &wb, &hb, NULL);
+    box1 = boxCreate(0, 0, wb, hb);
+    boxa3 = boxaGetWhiteblocks(boxa2, box1, L_SORT_BY_WIDTH, 100, 0.2,
+                               200, 0.15, 20000);
+    boxa4 = boxaGetWhiteblocks(boxa2, NULL, L_SORT_BY_WIDTH, 100, 0.2,
+                               200, 0.15, 20000);
+    boxaWriteMem(&data1, &size1, boxa3);
+    boxaWriteMem(&data2, &size2, boxa4);
+    regTestCompareStrings(rp, data1, size1, data2, size2);  /* 4 */
+    lept_free(data1);
+    lept_free(data2);
+    boxaDestroy(&boxa3);
+    boxaDestroy(&boxa4);
+    boxDestroy(&box1);
+
+    pix1 = pixaDisplayTiledInRows(pixa, 32, 2000, 0.5, 0, 30, 2);
+    pixDisplayWithTitle(pix1, 100, 100, NULL, rp->display);
+    pixDestroy(&pix1);
+    pixaDestroy(&pixa);
+    boxDestroy(&box);
+    boxaDestroy(&boxa1);
+    boxaDestroy(&boxa2);
+    pixDestroy(&pixs);
+    return regTestCleanup(rp);
+}
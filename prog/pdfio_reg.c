@@ -0,0 +1,282 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ * pdfio_reg.c
+ *
+ *   Tests the streaming multipage pdf writer, for multipage output
+ *   from images and for concatenation of single-page pdf files.
+ *
+ *   The pdf files carry a creation date, so they are not compared
+ *   with golden files.  Instead, the page count is read from the
+ *   Pages object and every entry of the xref table is checked to
+ *   point at the start of its object.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+static l_int32 CheckPdfFile(const char *fname, l_int32 *pnpages);
+static l_int32 CheckPdfData(const l_uint8 *data, size_t size,
+                            l_int32 *pnpages);
+static l_int32 FileExists(const char *fname);
+
+
+int main(int    argc,
+         char **argv)
+{
+char          buf[64];
+l_uint8      *data;
+l_int32       i, ret, npages, loc;
+size_t        size;
+L_BYTEA      *ba;
+L_DNA        *da;
+PIX          *pix1, *pix2;
+PIXA         *pixa;
+L_PTRA       *pa;
+SARRAY       *sa;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    lept_rmdir("lept/pdfio");
+    lept_mkdir("lept/pdfio");
+
+        /* Three pages from a pixa, to a file and to memory */
+    pixa = pixaCreate(3);
+    pix1 = pixRead("weasel8.png");
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pix1 = pixRead("test24.jpg");
+    pix2 = pixScale(pix1, 0.25, 0.25);
+    pixaAddPix(pixa, pix2, L_INSERT);
+    pixDestroy(&pix1);
+    pix1 = pixRead("speckle.png");
+    pixaAddPix(pixa, pix1, L_INSERT);
+    ret = pixaConvertToPdf(pixa, 100, 1.0, 0, 0, "pdfio",
+                           "/tmp/lept/pdfio/pixa.pdf");
+    regTestCompareValues(rp, 0, ret, 0);  /* 0 */
+    ret = CheckPdfFile("/tmp/lept/pdfio/pixa.pdf", &npages);
+    regTestCompareValues(rp, 0, ret, 0);  /* 1 */
+    regTestCompareValues(rp, 3, npages, 0);  /* 2 */
+    ret = pixaConvertToPdfData(pixa, 100, 1.0, 0, 0, "pdfio", &data, &size);
+    regTestCompareValues(rp, 0, ret, 0);  /* 3 */
+    ret = CheckPdfData(data, size, &npages);
+    regTestCompareValues(rp, 0, ret, 0);  /* 4 */
+    regTestCompareValues(rp, 3, npages, 0);  /* 5 */
+    lept_free(data);
+    pixaDestroy(&pixa);
+
+        /* Files that can't be read are skipped */
+    sa = sarrayCreate(3);
+    sarrayAddString(sa, (char *)"weasel8.png", L_COPY);
+    sarrayAddString(sa, (char *)"/tmp/lept/pdfio/missing.png", L_COPY);
+    sarrayAddString(sa, (char *)"weasel2.4c.png", L_COPY);
+    ret = saConvertFilesToPdf(sa, 100, 1.0, 0, 0, "pdfio",
+                              "/tmp/lept/pdfio/files.pdf");
+    regTestCompareValues(rp, 0, ret, 0);  /* 6 */
+    ret = CheckPdfFile("/tmp/lept/pdfio/files.pdf", &npages);
+    regTestCompareValues(rp, 0, ret, 0);  /* 7 */
+    regTestCompareValues(rp, 2, npages, 0);  /* 8 */
+    ret = saConvertUnscaledFilesToPdf(sa, "pdfio",
+                                      "/tmp/lept/pdfio/unscaled.pdf");
+    regTestCompareValues(rp, 0, ret, 0);  /* 9 */
+    ret = CheckPdfFile("/tmp/lept/pdfio/unscaled.pdf", &npages);
+    regTestCompareValues(rp, 0, ret, 0);  /* 10 */
+    regTestCompareValues(rp, 2, npages, 0);  /* 11 */
+    sarrayDestroy(&sa);
+
+        /* If no page can be made, no file is written */
+    sa = sarrayCreate(1);
+    sarrayAddString(sa, (char *)"/tmp/lept/pdfio/missing.png", L_COPY);
+    ret = saConvertFilesToPdf(sa, 100, 1.0, 0, 0, "pdfio",
+                              "/tmp/lept/pdfio/none1.pdf");
+    regTestCompareValues(rp, 1, ret, 0);  /* 12 */
+    regTestCompareValues(rp, 0, FileExists("/tmp/lept/pdfio/none1.pdf"),
+                         0);  /* 13 */
+    ret = saConvertUnscaledFilesToPdf(sa, "pdfio",
+                                      "/tmp/lept/pdfio/none2.pdf");
+    regTestCompareValues(rp, 1, ret, 0);  /* 14 */
+    regTestCompareValues(rp, 0, FileExists("/tmp/lept/pdfio/none2.pdf"),
+                         0);  /* 15 */
+    sarrayDestroy(&sa);
+    pixa = pixaCreate(1);
+    ret = pixaConvertToPdf(pixa, 100, 1.0, 0, 0, "pdfio",
+                           "/tmp/lept/pdfio/none3.pdf");
+    regTestCompareValues(rp, 1, ret, 0);  /* 16 */
+    regTestCompareValues(rp, 0, FileExists("/tmp/lept/pdfio/none3.pdf"),
+                         0);  /* 17 */
+    pixaDestroy(&pixa);
+
+        /* Single-page pdfs to be concatenated.  The second is a copy
+         * of the first with the number of its last object set to
+         * all 9s, so that it is parsed but can't be renumbered; it
+         * must be skipped without writing any of its objects. */
+    pa = ptraCreate(3);
+    pix1 = pixRead("weasel8.png");
+    pixWriteMemPdf(&data, &size, pix1, 100, "pdfio");
+    ptraAdd(pa, l_byteaInitFromMem(data, size));
+    da = arrayFindEachSequence(data, size, (l_uint8 *)" 0 obj\n", 7);
+    l_dnaGetIValue(da, l_dnaGetCount(da) - 1, &loc);
+    for (i = loc - 1; i > 0 && data[i] != '\n'; i--)
+        data[i] = '9';
+    ptraAdd(pa, l_byteaInitFromMem(data, size));
+    l_dnaDestroy(&da);
+    lept_free(data);
+    pixDestroy(&pix1);
+    pix1 = pixRead("weasel2.4c.png");
+    pixWriteMemPdf(&data, &size, pix1, 100, "pdfio");
+    ptraAdd(pa, l_byteaInitFromMem(data, size));
+    lept_free(data);
+    pixDestroy(&pix1);
+    sa = sarrayCreate(3);
+    for (i = 0; i < 3; i++) {
+        snprintf(buf, sizeof(buf), "/tmp/lept/pdfio/single%d.pdf", i);
+        ba = (L_BYTEA *)ptraGetPtrToItem(pa, i);
+        l_byteaWrite(buf, ba, 0, 0);
+        sarrayAddString(sa, buf, L_COPY);
+    }
+
+        /* Concatenate from memory and from files */
+    ret = ptraConcatenatePdf(pa, "/tmp/lept/pdfio/concat1.pdf");
+    regTestCompareValues(rp, 0, ret, 0);  /* 18 */
+    ret = CheckPdfFile("/tmp/lept/pdfio/concat1.pdf", &npages);
+    regTestCompareValues(rp, 0, ret, 0);  /* 19 */
+    regTestCompareValues(rp, 2, npages, 0);  /* 20 */
+    ret = saConcatenatePdf(sa, "/tmp/lept/pdfio/concat2.pdf");
+    regTestCompareValues(rp, 0, ret, 0);  /* 21 */
+    ret = CheckPdfFile("/tmp/lept/pdfio/concat2.pdf", &npages);
+    regTestCompareValues(rp, 0, ret, 0);  /* 22 */
+    regTestCompareValues(rp, 2, npages, 0);  /* 23 */
+    ret = saConcatenatePdfToData(sa, &data, &size);
+    regTestCompareValues(rp, 0, ret, 0);  /* 24 */
+    ret = CheckPdfData(data, size, &npages);
+    regTestCompareValues(rp, 0, ret, 0);  /* 25 */
+    regTestCompareValues(rp, 2, npages, 0);  /* 26 */
+    lept_free(data);
+    sarrayDestroy(&sa);
+
+        /* Nothing is written if no file can be added */
+    sa = sarrayCreate(1);
+    sarrayAddString(sa, (char *)"/tmp/lept/pdfio/single1.pdf", L_COPY);
+    ret = saConcatenatePdf(sa, "/tmp/lept/pdfio/none4.pdf");
+    regTestCompareValues(rp, 1, ret, 0);  /* 27 */
+    regTestCompareValues(rp, 0, FileExists("/tmp/lept/pdfio/none4.pdf"),
+                         0);  /* 28 */
+    sarrayDestroy(&sa);
+    for (i = 0; i < 3; i++) {
+        ba = (L_BYTEA *)ptraRemove(pa, i, L_NO_COMPACTION);
+        l_byteaDestroy(&ba);
+    }
+    ptraDestroy(&pa, FALSE, FALSE);
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Returns 0 if the pdf file is well formed; 1 otherwise */
+static l_int32
+CheckPdfFile(const char  *fname,
+             l_int32     *pnpages)
+{
+l_uint8  *data;
+l_int32   ret;
+size_t    size;
+
+    *pnpages = 0;
+    if ((data = l_binaryRead(fname, &size)) == NULL)
+        return 1;
+    ret = CheckPdfData(data, size, pnpages);
+    lept_free(data);
+    return ret;
+}
+
+
+    /* Returns 0 if every xref entry points to the start of its object
+     * and the xref table is where the trailer says it is; 1 otherwise.
+     * The number of pages is read from the Pages object. */
+static l_int32
+CheckPdfData(const l_uint8  *data,
+             size_t          size,
+             l_int32        *pnpages)
+{
+char     *str, *pcount;
+char      buf[32];
+l_int32   i, loc, found, xrefloc, nobj, offset, ret;
+
+    *pnpages = 0;
+    if (!data || size == 0)
+        return 1;
+
+        /* Make a null-terminated copy for sscanf() */
+    str = (char *)lept_calloc(size + 1, sizeof(char));
+    memcpy(str, data, size);
+
+    ret = 1;
+    arrayFindSequence(data, size, (l_uint8 *)"startxref\n", 10,
+                      &loc, &found);
+    if (!found || sscanf(str + loc + 10, "%d", &xrefloc) != 1 ||
+        xrefloc <= 0 || xrefloc >= (l_int32)size ||
+        sscanf(str + xrefloc, "xref\n0 %d\n", &nobj) != 1 || nobj < 4)
+        goto cleanup;
+
+        /* Each entry is 20 bytes; the first one is for object 0 */
+    loc = (l_int32)(strchr(str + xrefloc + 5, '\n') - str) + 1 + 20;
+    for (i = 1; i < nobj; i++, loc += 20) {
+        if (sscanf(str + loc, "%d", &offset) != 1 ||
+            offset <= 0 || offset >= (l_int32)size)
+            goto cleanup;
+        snprintf(buf, sizeof(buf), "%d 0 obj\n", i);
+        if (strncmp(str + offset, buf, strlen(buf)) != 0)
+            goto cleanup;
+    }
+
+        /* Page count, from the Pages object */
+    arrayFindSequence(data, size, (l_uint8 *)"/Type /Pages\n", 13,
+                      &loc, &found);
+    if (!found)
+        goto cleanup;
+    if ((pcount = strstr(str + loc, "/Count ")) == NULL ||
+        sscanf(pcount + 7, "%d", pnpages) != 1)
+        goto cleanup;
+    ret = 0;
+
+cleanup:
+    lept_free(str);
+    return ret;
+}
+
+
+static l_int32
+FileExists(const char  *fname)
+{
+FILE  *fp;
+
+    if ((fp = fopen(fname, "rb")) == NULL)
+        return 0;
+    fclose(fp);
+    return 1;
+}
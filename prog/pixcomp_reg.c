@@ -189,6 +189,154 @@ SARRAY       *sa;
     lept_free(data1);
     lept_free(data2);
 
+        /* Test that a jpeg pix from a pixacomp with a cache is the same
+         * before and after it is pushed out of the cache.  The cache
+         * only has room for one pix. */
+    pix = pixRead("marge.jpg");
+    pixac1 = pixacompCreate(0);
+    pixacompSetCacheSize(pixac1,
+                         6 * pixGetWpl(pix) * pixGetHeight(pix));  /* 1.5x */
+    pixacompAddPix(pixac1, pix, IFF_JFIF_JPEG);
+    pixacompAddPix(pixac1, pix, IFF_JFIF_JPEG);
+    pix1 = pixacompGetPix(pixac1, 0);  /* decompressed */
+    pix2 = pixacompGetPix(pixac1, 0);  /* from the cache */
+    regTestComparePix(rp, pix1, pix2);  /* 35 */
+    pixDestroy(&pix2);
+    pix2 = pixacompGetPix(pixac1, 1);  /* pushes pix 0 out of the cache */
+    pixDestroy(&pix2);
+    pix2 = pixacompGetPix(pixac1, 0);  /* decompressed again */
+    regTestComparePix(rp, pix1, pix2);  /* 36 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixacompDestroy(&pixac1);
+
+        /* Same test with lossless compression, where the pix is only
+         * compressed when it is pushed out of the cache */
+    pixac1 = pixacompCreate(0);
+    pixacompSetCacheSize(pixac1, 6 * pixGetWpl(pix) * pixGetHeight(pix));
+    pixacompAddPix(pixac1, pix, IFF_PNG);
+    pixacompAddPix(pixac1, pix, IFF_PNG);  /* pushes pix 0 out */
+    pix1 = pixacompGetPix(pixac1, 0);  /* decompressed */
+    regTestComparePix(rp, pix, pix1);  /* 37 */
+    pix2 = pixacompGetPix(pixac1, 1);  /* from the cache */
+    regTestComparePix(rp, pix, pix2);  /* 38 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixacompDestroy(&pixac1);
+    pixDestroy(&pix);
+
+        /* Test indexed pixacomp file I/O, with random access */
+    pixacompWriteIndexed("/tmp/lept/comp/file5.pac", pixac);
+    pixac1 = pixacompReadIndexed("/tmp/lept/comp/file5.pac");
+    n = pixacompGetCount(pixac);
+    regTestCompareValues(rp, n, pixacompGetCount(pixac1), 0);  /* 14 */
+    for (i = n - 1; i >= 0; i--) {
+        pix1 = pixacompGetPix(pixac, i);
+        pix2 = pixacompGetPix(pixac1, i);
+        regTestComparePix(rp, pix1, pix2);  /* 15 - 18 */
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+    pixacompDestroy(&pixac1);
+
+        /* Append to the indexed file, and serialize from it */
+    sa = sarrayCreate(0);
+    for (i = 0; i < 6; i++)
+        sarrayAddString(sa, (char *)fnames[i], L_COPY);
+    pixac2 = pixacompCreateFromSA(sa, IFF_DEFAULT);
+    pixacompAppendIndexed("/tmp/lept/comp/file5.pac", pixac2);
+    pixac1 = pixacompReadIndexed("/tmp/lept/comp/file5.pac");
+    regTestCompareValues(rp, n + 6, pixacompGetCount(pixac1), 0);  /* 19 */
+    pix1 = pixacompGetPix(pixac2, 5);
+    pix2 = pixacompGetPix(pixac1, n + 5);
+    regTestComparePix(rp, pix1, pix2);  /* 20 */
+    pixDestroy(&pix2);
+    pixacompWrite("/tmp/lept/comp/file6.pac", pixac1);
+    pixacompDestroy(&pixac1);
+    pixac1 = pixacompRead("/tmp/lept/comp/file6.pac");
+    pix2 = pixacompGetPix(pixac1, n + 5);
+    regTestComparePix(rp, pix1, pix2);  /* 21 */
+    pixacompDestroy(&pixac1);
+    pixacompDestroy(&pixac2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    sarrayDestroy(&sa);
+
+        /* Test a pixacomp with a cache of uncompressed pix */
+    pixac1 = pixacompCreate(0);
+    pixacompSetCacheSize(pixac1, 100000);
+    for (i = 0; i < 6; i++) {
+        pix = pixRead(fnames[i]);
+        pixacompAddPix(pixac1, pix, IFF_DEFAULT);
+        pixc = pixcompCreateFromPix(pix, IFF_DEFAULT);
+        pix1 = pixCreateFromPixcomp(pixc);  /* jpeg for 8 bpp gray */
+        pix2 = pixacompGetPix(pixac1, i);
+        regTestComparePix(rp, pix1, pix2);  /* 22 - 27 */
+        pixDestroy(&pix);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+        pixcompDestroy(&pixc);
+    }
+    pixac2 = pixacompCreateFromPixa(pixa, IFF_DEFAULT, L_CLONE);
+    pixacompJoin(pixac1, pixac2, 0, -1);
+    pixacompDestroy(&pixac2);
+    pixacompWriteMem(&data1, &size1, pixac1);  /* with cache */
+    pixacompSetCacheSize(pixac1, 0);
+    pixacompWriteMem(&data2, &size2, pixac1);  /* without */
+    regTestCompareStrings(rp, data1, size1, data2, size2);  /* 28 */
+    pixac2 = pixacompReadMem(data1, size1);
+    for (i = 0; i < 6; i++) {
+        pix = pixRead(fnames[i]);
+        pixc = pixcompCreateFromPix(pix, IFF_DEFAULT);
+        pix1 = pixCreateFromPixcomp(pixc);
+        pix2 = pixacompGetPix(pixac2, i);
+        regTestComparePix(rp, pix1, pix2);  /* 29 - 34 */
+        pixDestroy(&pix);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+        pixcompDestroy(&pixc);
+    }
+    pixacompDestroy(&pixac1);
+    pixacompDestroy(&pixac2);
+    lept_free(data1);
+    lept_free(data2);
+
+        /* Test that a jpeg pix from a pixacomp with a cache is the same
+         * before and after it is pushed out of the cache.  The cache
+         * only has room for one pix. */
+    pix = pixRead("marge.jpg");
+    pixac1 = pixacompCreate(0);
+    pixacompSetCacheSize(pixac1,
+                         6 * pixGetWpl(pix) * pixGetHeight(pix));  /* 1.5x */
+    pixacompAddPix(pixac1, pix, IFF_JFIF_JPEG);
+    pixacompAddPix(pixac1, pix, IFF_JFIF_JPEG);
+    pix1 = pixacompGetPix(pixac1, 0);  /* decompressed */
+    pix2 = pixacompGetPix(pixac1, 0);  /* from the cache */
+    regTestComparePix(rp, pix1, pix2);  /* 35 */
+    pixDestroy(&pix2);
+    pix2 = pixacompGetPix(pixac1, 1);  /* pushes pix 0 out of the cache */
+    pixDestroy(&pix2);
+    pix2 = pixacompGetPix(pixac1, 0);  /* decompressed again */
+    regTestComparePix(rp, pix1, pix2);  /* 36 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixacompDestroy(&pixac1);
+
+        /* Same test with lossless compression, where the pix is only
+         * compressed when it is pushed out of the cache */
+    pixac1 = pixacompCreate(0);
+    pixacompSetCacheSize(pixac1, 6 * pixGetWpl(pix) * pixGetHeight(pix));
+    pixacompAddPix(pixac1, pix, IFF_PNG);
+    pixacompAddPix(pixac1, pix, IFF_PNG);  /* pushes pix 0 out */
+    pix1 = pixacompGetPix(pixac1, 0);  /* decompressed */
+    regTestComparePix(rp, pix, pix1);  /* 37 */
+    pix2 = pixacompGetPix(pixac1, 1);  /* from the cache */
+    regTestComparePix(rp, pix, pix2);  /* 38 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixacompDestroy(&pixac1);
+    pixDestroy(&pix);
+
     pixaDestroy(&pixa);
     pixacompDestroy(&pixac);
     return regTestCleanup(rp);
@@ -39,6 +39,7 @@
  *        libpng, libz
  */
 
+#include <string.h>
 #include "allheaders.h"
 
     /* Needed for checking libraries */
@@ -62,6 +63,8 @@
 #define   FILE_GRAY_ALPHA    "test-gray-alpha.png"
 
 static l_int32 test_mem_png(const char *fname);
+static l_int32 test_stream_png(void);
+static l_int32 test_mem_file_png(const char *fname);
 static l_int32 get_header_data(const char *filename);
 static l_int32 test_1bpp_trans(L_REGPARAMS *rp);
 static l_int32 test_1bpp_color(L_REGPARAMS *rp);
@@ -197,6 +200,36 @@ L_REGPARAMS  *rp;
     }
     if (!success) failure = TRUE;
 
+    /* -------- Part 5: Successive reads and 16 bpp unstripped -------- */
+    success = TRUE;
+    if (test_stream_png()) success = FALSE;
+    if (success) {
+        fprintf(stderr,
+            "\n  ******* Success on successive png reads *******\n\n");
+    } else {
+        fprintf(stderr,
+            "\n  ******* Failure on successive png reads *******\n\n");
+    }
+    if (!success) failure = TRUE;
+
+    /* ------- Part 6: Memory r/w is the same as file r/w ------- */
+    success = TRUE;
+    if (test_mem_file_png(FILE_1BPP)) success = FALSE;
+    if (test_mem_file_png(FILE_2BPP_C)) success = FALSE;
+    if (test_mem_file_png(FILE_8BPP)) success = FALSE;
+    if (test_mem_file_png(FILE_16BPP)) success = FALSE;
+    if (test_mem_file_png(FILE_32BPP)) success = FALSE;
+    if (test_mem_file_png(FILE_32BPP_ALPHA)) success = FALSE;
+    if (test_mem_file_png(FILE_GRAY_ALPHA)) success = FALSE;
+    if (success) {
+        fprintf(stderr,
+            "\n  ******* Success on png memory vs file r/w *******\n\n");
+    } else {
+        fprintf(stderr,
+            "\n  ******* Failure on png memory vs file r/w *******\n\n");
+    }
+    if (!success) failure = TRUE;
+
     if (!failure) {
         fprintf(stderr,
             "  ******* Success on all tests *******\n\n");
@@ -243,6 +276,130 @@ PIX      *pixd = NULL;
     return (!same);
 }
 
+    /* Write to memory and to file, and check that the encoded data,
+     * the header, the image and the text are the same.  Then check
+     * that truncated data is handled the same way by both readers.
+     * Returns 1 on error */
+static l_int32
+test_mem_file_png(const char  *fname)
+{
+char     *text1, *text2;
+l_uint8  *data1, *data2;
+l_int32   w1, h1, bps1, spp1, w2, h2, bps2, spp2, same, ret;
+size_t    size1, size2;
+PIX      *pixs, *pix1, *pix2;
+
+    if ((pixs = pixRead(fname)) == NULL) {
+        fprintf(stderr, "Failure to read %s\n", fname);
+        return 1;
+    }
+    pixSetText(pixs, "pngio memory test");
+    pixWrite("/tmp/lept/regout/pngmem.png", pixs, IFF_PNG);
+    pixWriteMem(&data1, &size1, pixs, IFF_PNG);
+    data2 = l_binaryRead("/tmp/lept/regout/pngmem.png", &size2);
+    ret = 0;
+    if (!data1 || !data2 || size1 != size2 ||
+        memcmp(data1, data2, size1)) {
+        fprintf(stderr, "Mem and file data differ for %s\n", fname);
+        ret = 1;
+    }
+    lept_free(data2);
+
+    readHeaderMemPng(data1, size1, &w1, &h1, &bps1, &spp1, NULL);
+    readHeaderPng("/tmp/lept/regout/pngmem.png", &w2, &h2, &bps2, &spp2,
+                  NULL);
+    if (w1 != w2 || h1 != h2 || bps1 != bps2 || spp1 != spp2) {
+        fprintf(stderr, "Mem and file headers differ for %s\n", fname);
+        ret = 1;
+    }
+
+    pix1 = pixReadMem(data1, size1);
+    pix2 = pixRead("/tmp/lept/regout/pngmem.png");
+    pixEqual(pix1, pix2, &same);
+    text1 = pixGetText(pix1);
+    text2 = pixGetText(pix2);
+    if (!same || pixGetSpp(pix1) != pixGetSpp(pix2) ||
+        !text1 || !text2 || strcmp(text1, text2)) {
+        fprintf(stderr, "Mem and file images differ for %s\n", fname);
+        ret = 1;
+    }
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+        /* Neither reader may return an image from half the data */
+    l_binaryWrite("/tmp/lept/regout/pngmem.png", "w", data1, size1 / 2);
+    pix1 = pixReadMemPng(data1, size1 / 2);
+    pix2 = pixRead("/tmp/lept/regout/pngmem.png");
+    if (pix1 || pix2) {
+        fprintf(stderr, "Truncated data was read for %s\n", fname);
+        ret = 1;
+    }
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    lept_free(data1);
+    pixDestroy(&pixs);
+    return ret;
+}
+
+    /* Write a set of png images to a single stream, read them back in
+     * order, and then do a 16 bpp r/w without stripping to 8 bpp.
+     * Returns 1 on error */
+static l_int32
+test_stream_png(void)
+{
+l_int32  i, n, same, ret;
+PIX     *pix1, *pix2, *pix3;
+PIXA    *pixa1, *pixa2;
+
+    pixa1 = pixaCreate(0);
+    pixaAddPix(pixa1, pixRead(FILE_1BPP), L_INSERT);
+    pixaAddPix(pixa1, pixRead(FILE_4BPP_C), L_INSERT);
+    pixaAddPix(pixa1, pixRead(FILE_8BPP_C), L_INSERT);
+    pixaAddPix(pixa1, pixRead(FILE_32BPP), L_INSERT);
+    pixaAddPix(pixa1, pixRead(FILE_32BPP_ALPHA), L_INSERT);
+    pixaAddPix(pixa1, pixRead(FILE_GRAY_ALPHA), L_INSERT);
+    pixaWrite("/tmp/lept/regout/pngstream.pa", pixa1);
+    pixa2 = pixaRead("/tmp/lept/regout/pngstream.pa");
+    n = pixaGetCount(pixa1);
+    ret = (!pixa2 || pixaGetCount(pixa2) != n);
+    for (i = 0; i < n && !ret; i++) {
+        pix1 = pixaGetPix(pixa1, i, L_CLONE);
+        pix2 = pixaGetPix(pixa2, i, L_CLONE);
+        pixEqual(pix1, pix2, &same);
+        if (!same || pixGetSpp(pix1) != pixGetSpp(pix2)) {
+            fprintf(stderr, "Successive read fail for image %d\n", i);
+            ret = 1;
+        }
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+    pixaDestroy(&pixa1);
+    pixaDestroy(&pixa2);
+
+    l_pngSetReadStrip16To8(0);
+    pix1 = pixRead(FILE_16BPP);
+    pixWrite("/tmp/lept/regout/pngstream16.png", pix1, IFF_PNG);
+    pix2 = pixRead("/tmp/lept/regout/pngstream16.png");
+    l_pngSetReadStrip16To8(1);
+    pix3 = pixRead(FILE_16BPP);
+    pixEqual(pix1, pix2, &same);
+    if (!same || pixGetDepth(pix2) != 16) {
+        fprintf(stderr, "16 bpp r/w fail for file %s\n", FILE_16BPP);
+        ret = 1;
+    }
+    pixDestroy(&pix2);
+    pix2 = pixConvert16To8(pix1, L_MS_BYTE);
+    pixEqual(pix2, pix3, &same);
+    if (!same) {
+        fprintf(stderr, "16 bpp strip fail for file %s\n", FILE_16BPP);
+        ret = 1;
+    }
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pix3);
+    return ret;
+}
+
     /* Retrieve header data from file and from array in memory */
 static l_int32
 get_header_data(const char  *filename)
@@ -0,0 +1,106 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *  runlength_reg.c
+ *
+ *     Regression test for the runlength and stroke width transforms.
+ *
+ *     Runlengths of white and black runs are found in both directions,
+ *     and stroke widths of black strokes are found with 2, 4, 6 and 8
+ *     angles, all at both 8 and 16 bpp.  With 2 angles, the stroke
+ *     width is the minimum of the horizontal and vertical runlengths.
+ */
+
+#include "allheaders.h"
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, color, dir, nangles;
+BOX          *box;
+PIX          *pixs, *pix1, *pix2, *pix3, *pixh, *pixv;
+PIXA         *pixa;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    pix1 = pixRead("rabi.png");
+    box = boxCreate(250, 350, 1000, 1200);
+    pixs = pixClipRectangle(pix1, box, NULL);
+    pixDestroy(&pix1);
+    boxDestroy(&box);
+    pixa = pixaCreate(0);
+
+        /* Runlengths of white and black runs in each direction */
+    pixh = pixv = NULL;
+    for (color = 0; color < 2; color++) {
+        for (i = 0; i < 2; i++) {
+            dir = (i == 0) ? L_HORIZONTAL_RUNS : L_VERTICAL_RUNS;
+            pix1 = pixRunlengthTransform(pixs, color, dir, 8);
+            pix2 = pixRunlengthTransform(pixs, color, dir, 16);
+            regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 0, 2, 4, 6 */
+            regTestWritePixAndCheck(rp, pix2, IFF_PNG);  /* 1, 3, 5, 7 */
+            pix3 = pixMaxDynamicRange(pix1, L_LOG_SCALE);
+            pixaAddPix(pixa, pix3, L_INSERT);
+            if (color == 1 && dir == L_HORIZONTAL_RUNS)
+                pixh = pixClone(pix1);
+            else if (color == 1)
+                pixv = pixClone(pix1);
+            pixDestroy(&pix1);
+            pixDestroy(&pix2);
+        }
+    }
+
+        /* Stroke widths of black strokes */
+    for (nangles = 2; nangles <= 8; nangles += 2) {
+        pix1 = pixStrokeWidthTransform(pixs, 1, 8, nangles);
+        pix2 = pixStrokeWidthTransform(pixs, 1, 16, nangles);
+        regTestWritePixAndCheck(rp, pix1, IFF_PNG);  /* 8, 10, 12, 14 */
+        regTestWritePixAndCheck(rp, pix2, IFF_PNG);  /* 9, 11, 13, 15 */
+        pix3 = pixMaxDynamicRange(pix1, L_LINEAR_SCALE);
+        pixaAddPix(pixa, pix3, L_INSERT);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+
+        /* With 2 angles, the stroke width is the smaller runlength */
+    pix1 = pixStrokeWidthTransform(pixs, 1, 8, 2);
+    pix2 = pixMinOrMax(NULL, pixh, pixv, L_CHOOSE_MIN);
+    regTestComparePix(rp, pix1, pix2);  /* 16 */
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pixh);
+    pixDestroy(&pixv);
+
+    pix1 = pixaDisplayTiledInRows(pixa, 8, 2000, 0.5, 0, 30, 2);
+    pixDisplayWithTitle(pix1, 100, 100, NULL, rp->display);
+    pixDestroy(&pix1);
+    pixaDestroy(&pixa);
+    pixDestroy(&pixs);
+    return regTestCleanup(rp);
+}
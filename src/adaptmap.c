@@ -52,6 +52,9 @@
  *          l_int32    pixBackgroundNormGrayArrayMorph()   8 bpp input
  *          l_int32    pixBackgroundNormRGBArraysMorph()   32 bpp input
  *
+ *      Background normalization of a sequence of pages
+ *          PIXA      *pixaBackgroundNorm()           8 and 32 bpp
+ *
  *      Measurement of local background
  *          l_int32    pixGetBackgroundGrayMap()        8 bpp
  *          l_int32    pixGetBackgroundRGBMap()         32 bpp
@@ -822,6 +825,142 @@ PIX     *pixmr, *pixmg, *pixmb;
 }
 
 
+/*------------------------------------------------------------------*
+ *         Background normalization of a sequence of pages          *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   pixaBackgroundNorm()
+ *
+ * \param[in]    pixas 8 bpp grayscale or 32 bpp rgb pages
+ * \param[in]    sx, sy tile size in pixels
+ * \param[in]    thresh threshold for determining foreground
+ * \param[in]    mincount min threshold on counts in a tile
+ * \param[in]    bgval target bg val; typ. > 128
+ * \param[in]    smoothx half-width of block convolution kernel width
+ * \param[in]    smoothy half-width of block convolution kernel height
+ * \param[in]    interval number of consecutive pages that share a map;
+ *                        use 1 to make a new map for every page and
+ *                        0 to make the map only once
+ * \return  pixad normalized pages, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *    (1) See notes in pixBackgroundNorm() for the parameters.
+ *    (2) Scanned pages from the same document often have nearly the
+ *        same background illumination.  Making the inverse background
+ *        maps takes more than half the time of pixBackgroundNorm(),
+ *        so they are made on the first page of each group of
+ *        'interval' pages and applied to the rest of the group.
+ *    (3) One map is kept for 8 bpp pages and one set of three maps
+ *        for 32 bpp pages.  In each group, the map for a depth is made
+ *        on the first page of that depth, so mixing 8 and 32 bpp pages
+ *        does not cause extra maps to be made.  Pages of a different
+ *        size are handled by pixApplyInvBackgroundGrayMap() and
+ *        pixApplyInvBackgroundRGBMap().
+ *    (4) If a map can't be made for a page (e.g., it has no background),
+ *        the previous map of the same depth is used, and a new map is
+ *        tried on the next page of that depth in the group.  If there
+ *        is no previous map, a copy of the page is returned.
+ * </pre>
+ */
+PIXA *
+pixaBackgroundNorm(PIXA    *pixas,
+                   l_int32  sx,
+                   l_int32  sy,
+                   l_int32  thresh,
+                   l_int32  mincount,
+                   l_int32  bgval,
+                   l_int32  smoothx,
+                   l_int32  smoothy,
+                   l_int32  interval)
+{
+l_int32  i, n, d, group, groupgray, grouprgb, ret;
+PIX     *pixs, *pixd, *pixmgray, *pixmr, *pixmg, *pixmb;
+PIX     *pixr, *pixg, *pixb;
+PIXA    *pixad;
+
+    PROCNAME("pixaBackgroundNorm");
+
+    if (!pixas)
+        return (PIXA *)ERROR_PTR("pixas not defined", procName, NULL);
+    if (sx < 4 || sy < 4)
+        return (PIXA *)ERROR_PTR("sx and sy must be >= 4", procName, NULL);
+    if (interval < 0)
+        return (PIXA *)ERROR_PTR("interval < 0", procName, NULL);
+
+    n = pixaGetCount(pixas);
+    pixad = pixaCreate(n);
+    pixmgray = pixmr = pixmg = pixmb = NULL;
+    groupgray = grouprgb = -1;  /* group in which each map was made */
+    for (i = 0; i < n; i++) {
+        pixs = pixaGetPix(pixas, i, L_CLONE);
+        d = pixGetDepth(pixs);
+        if ((d != 8 && d != 32) || pixGetColormap(pixs)) {
+            L_ERROR("page %d not 8 or 32 bpp; copying\n", procName, i);
+            pixaAddPix(pixad, pixs, L_COPY);
+            pixDestroy(&pixs);
+            continue;
+        }
+
+            /* Make a new map for this depth if required */
+        group = (interval > 0) ? i / interval : 0;
+        if (d == 8 && (!pixmgray || group != groupgray)) {
+            pixr = NULL;
+            ret = pixBackgroundNormGrayArray(pixs, NULL, sx, sy, thresh,
+                                             mincount, bgval, smoothx,
+                                             smoothy, &pixr);
+            if (ret == 0) {
+                pixDestroy(&pixmgray);
+                pixmgray = pixr;
+                groupgray = group;
+            } else {
+                pixDestroy(&pixr);
+            }
+        } else if (d == 32 && (!pixmr || group != grouprgb)) {
+            pixr = pixg = pixb = NULL;
+            ret = pixBackgroundNormRGBArrays(pixs, NULL, NULL, sx, sy,
+                                             thresh, mincount, bgval,
+                                             smoothx, smoothy,
+                                             &pixr, &pixg, &pixb);
+            if (ret == 0) {
+                pixDestroy(&pixmr);
+                pixDestroy(&pixmg);
+                pixDestroy(&pixmb);
+                pixmr = pixr;
+                pixmg = pixg;
+                pixmb = pixb;
+                grouprgb = group;
+            } else {
+                pixDestroy(&pixr);
+                pixDestroy(&pixg);
+                pixDestroy(&pixb);
+            }
+        }
+
+        pixd = NULL;
+        if (d == 8 && pixmgray)
+            pixd = pixApplyInvBackgroundGrayMap(pixs, pixmgray, sx, sy);
+        else if (d == 32 && pixmr)
+            pixd = pixApplyInvBackgroundRGBMap(pixs, pixmr, pixmg, pixmb,
+                                               sx, sy);
+        if (pixd) {
+            pixCopyResolution(pixd, pixs);
+            pixaAddPix(pixad, pixd, L_INSERT);
+        } else {
+            L_WARNING("map not made for page %d; copying\n", procName, i);
+            pixaAddPix(pixad, pixs, L_COPY);
+        }
+        pixDestroy(&pixs);
+    }
+
+    pixDestroy(&pixmgray);
+    pixDestroy(&pixmr);
+    pixDestroy(&pixmg);
+    pixDestroy(&pixmb);
+    return pixad;
+}
+
+
 /*------------------------------------------------------------------*
  *                 Measurement of local background                  *
  *------------------------------------------------------------------*/
@@ -855,8 +994,9 @@ pixGetBackgroundGrayMap(PIX     *pixs,
 {
 l_int32    w, h, wd, hd, wim, him, wpls, wplim, wpld, wplf;
 l_int32    xim, yim, delx, nx, ny, i, j, k, m;
-l_int32    count, sum, val8;
+l_int32    s, n, val8;
 l_int32    empty, fgpixels;
+l_int32   *sum, *count;
 l_uint32  *datas, *dataim, *datad, *dataf, *lines, *lineim, *lined, *linef;
 l_float32  scalex, scaley;
 PIX       *pixd, *piximi, *pixb, *pixf, *pixims;
@@ -920,28 +1060,40 @@ PIX       *pixd, *piximi, *pixb, *pixf, *pixims;
     datad = pixGetData(pixd);
     wplf = pixGetWpl(pixf);
     dataf = pixGetData(pixf);
+    sum = (l_int32 *)LEPT_CALLOC(2 * L_MAX(nx, 1), sizeof(l_int32));
+    if (!sum) {
+        pixDestroy(&pixf);
+        pixDestroy(&pixd);
+        return ERROR_INT("sum not made", procName, 1);
+    }
+    count = sum + nx;
     for (i = 0; i < ny; i++) {
-        lines = datas + sy * i * wpls;
-        linef = dataf + sy * i * wplf;
-        lined = datad + i * wpld;
-        for (j = 0; j < nx; j++) {
-            delx = j * sx;
-            sum = 0;
-            count = 0;
-            for (k = 0; k < sy; k++) {
-                for (m = 0; m < sx; m++) {
-                    if (GET_DATA_BIT(linef + k * wplf, delx + m) == 0) {
-                        sum += GET_DATA_BYTE(lines + k * wpls, delx + m);
-                        count++;
-                    }
+        for (j = 0; j < 2 * nx; j++)
+            sum[j] = 0;
+        for (k = 0; k < sy; k++) {
+            lines = datas + (sy * i + k) * wpls;
+            linef = dataf + (sy * i + k) * wplf;
+            for (j = 0, delx = 0; j < nx; j++, delx += sx) {
+                s = n = 0;
+                for (m = delx; m < delx + sx; m++) {
+                    if (GET_DATA_BIT(linef, m))
+                        continue;
+                    s += GET_DATA_BYTE(lines, m);
+                    n++;
                 }
+                sum[j] += s;
+                count[j] += n;
             }
-            if (count >= mincount) {
-                val8 = sum / count;
+        }
+        lined = datad + i * wpld;
+        for (j = 0; j < nx; j++) {
+            if (count[j] >= mincount) {
+                val8 = sum[j] / count[j];
                 SET_DATA_BYTE(lined, j, val8);
             }
         }
     }
+    LEPT_FREE(sum);
     pixDestroy(&pixf);
 
         /* If there is an optional mask with fg pixels, erase the previous
@@ -1034,12 +1186,14 @@ pixGetBackgroundRGBMap(PIX     *pixs,
                        PIX    **ppixmg,
                        PIX    **ppixmb)
 {
-l_int32    w, h, wm, hm, wim, him, wpls, wplim, wplf;
+l_int32    w, h, wm, hm, wim, him, wpls, wplim, wplf, wplm;
 l_int32    xim, yim, delx, nx, ny, i, j, k, m;
-l_int32    count, rsum, gsum, bsum, rval, gval, bval;
+l_int32    rval, gval, bval, rs, gs, bs, n;
 l_int32    empty, fgpixels;
+l_int32   *rsum, *gsum, *bsum, *count;
 l_uint32   pixel;
 l_uint32  *datas, *dataim, *dataf, *lines, *lineim, *linef;
+l_uint32  *datamr, *datamg, *datamb;
 l_float32  scalex, scaley;
 PIX       *piximi, *pixgc, *pixb, *pixf, *pixims;
 PIX       *pixmr, *pixmg, *pixmb;
@@ -1099,40 +1253,64 @@ PIX       *pixmr, *pixmg, *pixmb;
         /* Note: we only compute map values in tiles that are complete.
          * In general, tiles at right and bottom edges will not be
          * complete, and we must fill them in later. */
+        /* The tile sums for all three components are accumulated
+         * together in a single raster-order pass over each row of tiles. */
     nx = w / sx;
     ny = h / sy;
     wpls = pixGetWpl(pixs);
     datas = pixGetData(pixs);
     wplf = pixGetWpl(pixf);
     dataf = pixGetData(pixf);
+    wplm = pixGetWpl(pixmr);
+    datamr = pixGetData(pixmr);
+    datamg = pixGetData(pixmg);
+    datamb = pixGetData(pixmb);
+    rsum = (l_int32 *)LEPT_CALLOC(4 * L_MAX(nx, 1), sizeof(l_int32));
+    if (!rsum) {
+        pixDestroy(&pixf);
+        pixDestroy(&pixmr);
+        pixDestroy(&pixmg);
+        pixDestroy(&pixmb);
+        return ERROR_INT("rsum not made", procName, 1);
+    }
+    gsum = rsum + nx;
+    bsum = gsum + nx;
+    count = bsum + nx;
     for (i = 0; i < ny; i++) {
-        lines = datas + sy * i * wpls;
-        linef = dataf + sy * i * wplf;
-        for (j = 0; j < nx; j++) {
-            delx = j * sx;
-            rsum = gsum = bsum = 0;
-            count = 0;
-            for (k = 0; k < sy; k++) {
-                for (m = 0; m < sx; m++) {
-                    if (GET_DATA_BIT(linef + k * wplf, delx + m) == 0) {
-                        pixel = *(lines + k * wpls + delx + m);
-                        rsum += (pixel >> 24);
-                        gsum += ((pixel >> 16) & 0xff);
-                        bsum += ((pixel >> 8) & 0xff);
-                        count++;
-                    }
+        for (j = 0; j < 4 * nx; j++)
+            rsum[j] = 0;
+        for (k = 0; k < sy; k++) {
+            lines = datas + (sy * i + k) * wpls;
+            linef = dataf + (sy * i + k) * wplf;
+            for (j = 0, delx = 0; j < nx; j++, delx += sx) {
+                rs = gs = bs = n = 0;
+                for (m = delx; m < delx + sx; m++) {
+                    if (GET_DATA_BIT(linef, m))
+                        continue;
+                    pixel = lines[m];
+                    rs += (pixel >> 24);
+                    gs += ((pixel >> 16) & 0xff);
+                    bs += ((pixel >> 8) & 0xff);
+                    n++;
                 }
+                rsum[j] += rs;
+                gsum[j] += gs;
+                bsum[j] += bs;
+                count[j] += n;
             }
-            if (count >= mincount) {
-                rval = rsum / count;
-                gval = gsum / count;
-                bval = bsum / count;
-                pixSetPixel(pixmr, j, i, rval);
-                pixSetPixel(pixmg, j, i, gval);
-                pixSetPixel(pixmb, j, i, bval);
+        }
+        for (j = 0; j < nx; j++) {
+            if (count[j] >= mincount) {
+                rval = rsum[j] / count[j];
+                gval = gsum[j] / count[j];
+                bval = bsum[j] / count[j];
+                SET_DATA_BYTE(datamr + i * wplm, j, rval);
+                SET_DATA_BYTE(datamg + i * wplm, j, gval);
+                SET_DATA_BYTE(datamb + i * wplm, j, bval);
             }
         }
     }
+    LEPT_FREE(rsum);
     pixDestroy(&pixf);
 
         /* If there is an optional mask with fg pixels, erase the previous
@@ -1887,6 +2065,16 @@ PIX       *pixsm, *pixd;
  * \param[in]    sx tile width in pixels
  * \param[in]    sy tile height in pixels
  * \return  pixd 8 bpp, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *    (1) The map is applied in raster order, one output line at a
+ *        time, reading the map values for the tile row directly.
+ *    (2) Pixels of pixs that lie beyond the region covered by the
+ *        map use the nearest tile at the right or bottom edge.  This
+ *        allows a map computed for one page to be applied to another
+ *        page of slightly different size.
+ * </pre>
  */
 PIX *
 pixApplyInvBackgroundGrayMap(PIX     *pixs,
@@ -1894,10 +2082,10 @@ pixApplyInvBackgroundGrayMap(PIX     *pixs,
                              l_int32  sx,
                              l_int32  sy)
 {
-l_int32    w, h, wm, hm, wpls, wpld, i, j, k, m, xoff, yoff;
+l_int32    w, h, wm, hm, wpls, wpld, wplm, i, j, m, xoff, xend;
 l_int32    vals, vald;
 l_uint32   val16;
-l_uint32  *datas, *datad, *lines, *lined, *flines, *flined;
+l_uint32  *datas, *datad, *datam, *lines, *lined, *linem;
 PIX       *pixd;
 
     PROCNAME("pixApplyInvBackgroundGrayMap");
@@ -1908,32 +2096,30 @@ PIX       *pixd;
         return (PIX *)ERROR_PTR("pixs has colormap", procName, NULL);
     if (!pixm || pixGetDepth(pixm) != 16)
         return (PIX *)ERROR_PTR("pixm undefined or not 16 bpp", procName, NULL);
-    if (sx == 0 || sy == 0)
+    if (sx < 1 || sy < 1)
         return (PIX *)ERROR_PTR("invalid sx and/or sy", procName, NULL);
 
     datas = pixGetData(pixs);
     wpls = pixGetWpl(pixs);
     pixGetDimensions(pixs, &w, &h, NULL);
     pixGetDimensions(pixm, &wm, &hm, NULL);
+    datam = pixGetData(pixm);
+    wplm = pixGetWpl(pixm);
     pixd = pixCreateTemplate(pixs);
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
-    for (i = 0; i < hm; i++) {
-        lines = datas + sy * i * wpls;
-        lined = datad + sy * i * wpld;
-        yoff = sy * i;
-        for (j = 0; j < wm; j++) {
-            pixGetPixel(pixm, j, i, &val16);
-            xoff = sx * j;
-            for (k = 0; k < sy && yoff + k < h; k++) {
-                flines = lines + k * wpls;
-                flined = lined + k * wpld;
-                for (m = 0; m < sx && xoff + m < w; m++) {
-                    vals = GET_DATA_BYTE(flines, xoff + m);
-                    vald = (vals * val16) / 256;
-                    vald = L_MIN(vald, 255);
-                    SET_DATA_BYTE(flined, xoff + m, vald);
-                }
+    for (i = 0; i < h; i++) {
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        linem = datam + L_MIN(i / sy, hm - 1) * wplm;
+        for (j = 0, xoff = 0; j < wm && xoff < w; j++, xoff += sx) {
+            val16 = GET_DATA_TWO_BYTES(linem, j);
+            xend = (j == wm - 1) ? w : L_MIN(xoff + sx, w);
+            for (m = xoff; m < xend; m++) {
+                vals = GET_DATA_BYTE(lines, m);
+                vald = (vals * val16) / 256;
+                vald = L_MIN(vald, 255);
+                SET_DATA_BYTE(lined, m, vald);
             }
         }
     }
@@ -1952,6 +2138,14 @@ PIX       *pixd;
  * \param[in]    sx tile width in pixels
  * \param[in]    sy tile height in pixels
  * \return  pixd 32 bpp rbg, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *    (1) The three maps must have the same size.  All three components
+ *        are mapped in a single raster-order pass over pixs.
+ *    (2) See notes in pixApplyInvBackgroundGrayMap() for pixels beyond
+ *        the region covered by the maps.
+ * </pre>
  */
 PIX *
 pixApplyInvBackgroundRGBMap(PIX     *pixs,
@@ -1961,11 +2155,12 @@ pixApplyInvBackgroundRGBMap(PIX     *pixs,
                             l_int32  sx,
                             l_int32  sy)
 {
-l_int32    w, h, wm, hm, wpls, wpld, i, j, k, m, xoff, yoff;
+l_int32    w, h, wm, hm, wpls, wpld, wplm, i, j, m, xoff, xend, moff;
 l_int32    rvald, gvald, bvald;
 l_uint32   vals;
 l_uint32   rval16, gval16, bval16;
-l_uint32  *datas, *datad, *lines, *lined, *flines, *flined;
+l_uint32  *datas, *datad, *datamr, *datamg, *datamb, *lines, *lined;
+l_uint32  *linemr, *linemg, *linemb;
 PIX       *pixd;
 
     PROCNAME("pixApplyInvBackgroundRGBMap");
@@ -1979,7 +2174,9 @@ PIX       *pixd;
     if (pixGetDepth(pixmr) != 16 || pixGetDepth(pixmg) != 16 ||
         pixGetDepth(pixmb) != 16)
         return (PIX *)ERROR_PTR("pix maps not all 16 bpp", procName, NULL);
-    if (sx == 0 || sy == 0)
+    if (!pixSizesEqual(pixmr, pixmg) || !pixSizesEqual(pixmr, pixmb))
+        return (PIX *)ERROR_PTR("pix maps not all same size", procName, NULL);
+    if (sx < 1 || sy < 1)
         return (PIX *)ERROR_PTR("invalid sx and/or sy", procName, NULL);
 
     datas = pixGetData(pixs);
@@ -1988,31 +2185,36 @@ PIX       *pixd;
     h = pixGetHeight(pixs);
     wm = pixGetWidth(pixmr);
     hm = pixGetHeight(pixmr);
+    wplm = pixGetWpl(pixmr);
+    datamr = pixGetData(pixmr);
+    datamg = pixGetData(pixmg);
+    datamb = pixGetData(pixmb);
     pixd = pixCreateTemplate(pixs);
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
-    for (i = 0; i < hm; i++) {
-        lines = datas + sy * i * wpls;
-        lined = datad + sy * i * wpld;
-        yoff = sy * i;
-        for (j = 0; j < wm; j++) {
-            pixGetPixel(pixmr, j, i, &rval16);
-            pixGetPixel(pixmg, j, i, &gval16);
-            pixGetPixel(pixmb, j, i, &bval16);
-            xoff = sx * j;
-            for (k = 0; k < sy && yoff + k < h; k++) {
-                flines = lines + k * wpls;
-                flined = lined + k * wpld;
-                for (m = 0; m < sx && xoff + m < w; m++) {
-                    vals = *(flines + xoff + m);
-                    rvald = ((vals >> 24) * rval16) / 256;
-                    rvald = L_MIN(rvald, 255);
-                    gvald = (((vals >> 16) & 0xff) * gval16) / 256;
-                    gvald = L_MIN(gvald, 255);
-                    bvald = (((vals >> 8) & 0xff) * bval16) / 256;
-                    bvald = L_MIN(bvald, 255);
-                    composeRGBPixel(rvald, gvald, bvald, flined + xoff + m);
-                }
+    for (i = 0; i < h; i++) {
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        moff = L_MIN(i / sy, hm - 1) * wplm;
+        linemr = datamr + moff;
+        linemg = datamg + moff;
+        linemb = datamb + moff;
+        for (j = 0, xoff = 0; j < wm && xoff < w; j++, xoff += sx) {
+            rval16 = GET_DATA_TWO_BYTES(linemr, j);
+            gval16 = GET_DATA_TWO_BYTES(linemg, j);
+            bval16 = GET_DATA_TWO_BYTES(linemb, j);
+            xend = (j == wm - 1) ? w : L_MIN(xoff + sx, w);
+            for (m = xoff; m < xend; m++) {
+                vals = lines[m];
+                rvald = ((vals >> 24) * rval16) / 256;
+                rvald = L_MIN(rvald, 255);
+                gvald = (((vals >> 16) & 0xff) * gval16) / 256;
+                gvald = L_MIN(gvald, 255);
+                bvald = (((vals >> 8) & 0xff) * bval16) / 256;
+                bvald = L_MIN(bvald, 255);
+                lined[m] = (rvald << L_RED_SHIFT) |
+                           (gvald << L_GREEN_SHIFT) |
+                           (bvald << L_BLUE_SHIFT);
             }
         }
     }
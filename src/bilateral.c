@@ -37,6 +37,11 @@
  *          static void         *bilateralDestroy()
  *          static PIX          *bilateralApply()
  *
+ *     Bilateral grid filtering of grayscale or color images
+ *          PIX                 *pixBilateralGrid()
+ *          PIX                 *pixBilateralGridGray()
+ *          static void          bilateralGridBlur()
+ *
  *     Slow, exact implementation of grayscale or color bilateral filtering
  *          PIX                 *pixBilateralExact()
  *          PIX                 *pixBilateralGrayExact()
@@ -49,6 +54,9 @@
  *  filter algorithm (given by Sylvain Paris and Frédo Durand),
  *  and a fast, approximate and separable implementation (following
  *  Yang, Tan and Ahuja).  See bilateral.h for algorithmic details.
+ *  There is also a bilateral grid implementation (following Chen,
+ *  Paris and Durand), whose time does not depend on the size of
+ *  the spatial filter.
  *
  *  The bilateral filter has the nice property of applying a gaussian
  *  filter to smooth parts of the image that don't vary too quickly,
@@ -82,6 +90,11 @@ static L_BILATERAL *bilateralCreate(PIX *pixs, l_float32 spatial_stdev,
                                     l_int32 reduction);
 static PIX *bilateralApply(L_BILATERAL *bil);
 static void bilateralDestroy(L_BILATERAL **pbil);
+static void bilateralGridBlur(l_float32 *grid, l_int32 nx, l_int32 ny,
+                              l_int32 nz);
+
+    /* Largest number of cells allowed in the bilateral grid */
+static const l_float64  MAX_GRID_SIZE = 50000000.;
 
 
 #ifndef  NO_CONSOLE_IO
@@ -550,6 +563,305 @@ L_BILATERAL  *bil;
 }
 
 
+/*----------------------------------------------------------------------*
+ *        Bilateral grid filtering of grayscale or color images         *
+ *----------------------------------------------------------------------*/
+/*!
+ * \brief   pixBilateralGrid()
+ *
+ * \param[in]    pixs 8 bpp gray or 32 bpp rgb, no colormap
+ * \param[in]    spatial_stdev  of gaussian kernel; in pixels, >= 1.0
+ * \param[in]    range_stdev  of gaussian range kernel; >= 2.0; typ. 20.0
+ * \return  pixd bilateral filtered image, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is an approximate bilateral filter that uses the
+ *          bilateral grid of Chen, Paris and Durand:
+ *            "Real-time Edge-Aware Image Processing with the Bilateral
+ *             Grid," SIGGRAPH 2007.
+ *          See pixBilateralGridGray() for details.
+ *      (2) For rgb, each component is filtered separately, as is done
+ *          in pixBilateral() and pixBilateralExact().
+ *      (3) The time is linear in the number of pixels and, unlike
+ *          pixBilateral() and pixBlockBilateralExact(), it does not
+ *          increase with %spatial_stdev.  It decreases slightly as
+ *          either stdev gets larger, because the grid gets smaller.
+ * </pre>
+ */
+PIX *
+pixBilateralGrid(PIX       *pixs,
+                 l_float32  spatial_stdev,
+                 l_float32  range_stdev)
+{
+l_int32  d;
+PIX     *pixt, *pixr, *pixg, *pixb, *pixd;
+
+    PROCNAME("pixBilateralGrid");
+
+    if (!pixs || pixGetColormap(pixs))
+        return (PIX *)ERROR_PTR("pixs not defined or cmapped", procName, NULL);
+    d = pixGetDepth(pixs);
+    if (d != 8 && d != 32)
+        return (PIX *)ERROR_PTR("pixs not 8 or 32 bpp", procName, NULL);
+    if (spatial_stdev < 1.0)
+        return (PIX *)ERROR_PTR("spatial_stdev < 1.0", procName, NULL);
+    if (range_stdev < 2.0)
+        return (PIX *)ERROR_PTR("range_stdev < 2.0", procName, NULL);
+
+    if (d == 8)
+        return pixBilateralGridGray(pixs, spatial_stdev, range_stdev);
+
+    pixt = pixGetRGBComponent(pixs, COLOR_RED);
+    pixr = pixBilateralGridGray(pixt, spatial_stdev, range_stdev);
+    pixDestroy(&pixt);
+    pixt = pixGetRGBComponent(pixs, COLOR_GREEN);
+    pixg = pixBilateralGridGray(pixt, spatial_stdev, range_stdev);
+    pixDestroy(&pixt);
+    pixt = pixGetRGBComponent(pixs, COLOR_BLUE);
+    pixb = pixBilateralGridGray(pixt, spatial_stdev, range_stdev);
+    pixDestroy(&pixt);
+    pixd = pixCreateRGBImage(pixr, pixg, pixb);
+    pixDestroy(&pixr);
+    pixDestroy(&pixg);
+    pixDestroy(&pixb);
+    return pixd;
+}
+
+
+/*!
+ * \brief   pixBilateralGridGray()
+ *
+ * \param[in]    pixs 8 bpp gray
+ * \param[in]    spatial_stdev  of gaussian kernel; in pixels, >= 1.0
+ * \param[in]    range_stdev  of gaussian range kernel; >= 2.0; typ. 20.0
+ * \return  pixd 8 bpp bilateral filtered image, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The bilateral grid is a 3D array with coordinates (x, y, v),
+ *          where x and y are sampled every %spatial_stdev pixels and the
+ *          intensity v is sampled every %range_stdev levels.  There are
+ *          three steps:
+ *          (a) Splat: each pixel adds its value and a weight of 1 to the
+ *              two arrays of the cell nearest to (x, y, v).
+ *          (b) Blur: both arrays are convolved with the 5-tap binomial
+ *              kernel {1, 4, 6, 4, 1} / 16, which has a stdev of 1 cell,
+ *              along each of the 3 axes.  This is a gaussian with
+ *              stdev %spatial_stdev in x and y and %range_stdev in v.
+ *          (c) Slice: the result at each pixel is found by trilinear
+ *              interpolation of both arrays at (x, y, v), and is the
+ *              ratio of the interpolated value sum to weight.
+ *          Because pixels only contribute to cells with nearby v, the
+ *          smoothing does not cross edges whose contrast is large
+ *          compared to %range_stdev.
+ *      (2) The grid has about (w * h * 256) /
+ *          (spatial_stdev^2 * range_stdev) cells, each with two floats.
+ *          Small values of both stdevs can make it large.  If it would
+ *          have more than 5 * 10^7 cells, an error is returned; use
+ *          larger stdevs.
+ *      (3) The result is close to pixBlockBilateralExact() with the same
+ *          stdevs; the differences are mostly at strong edges.
+ * </pre>
+ */
+PIX *
+pixBilateralGridGray(PIX       *pixs,
+                     l_float32  spatial_stdev,
+                     l_float32  range_stdev)
+{
+l_int32     i, j, w, h, nx, ny, nz, ix, iy, iz, wpls, wpld, val, index;
+size_t      size;
+l_int32    *xlow, *ylow;
+l_uint32   *datas, *datad, *lines, *lined;
+l_float32   fx, fy, fz, sum, wsum, f00, f01, f10, f11;
+l_float32  *gridv, *gridw, *xfract, *yfract;
+PIX        *pixd;
+
+    PROCNAME("pixBilateralGridGray");
+
+    if (!pixs || pixGetColormap(pixs))
+        return (PIX *)ERROR_PTR("pixs not defined or cmapped", procName, NULL);
+    if (pixGetDepth(pixs) != 8)
+        return (PIX *)ERROR_PTR("pixs not 8 bpp gray", procName, NULL);
+    if (spatial_stdev < 1.0)
+        return (PIX *)ERROR_PTR("spatial_stdev < 1.0", procName, NULL);
+    if (range_stdev < 2.0)
+        return (PIX *)ERROR_PTR("range_stdev < 2.0", procName, NULL);
+
+        /* The grid has 2 cells of padding on each side of the sampled
+         * region, so the blur does not need to test for boundaries.
+         * The padding cells get no pixels, so the weight sum takes
+         * care of normalization near the image boundary. */
+    pixGetDimensions(pixs, &w, &h, NULL);
+    nx = (l_int32)((w - 1) / spatial_stdev) + 6;
+    ny = (l_int32)((h - 1) / spatial_stdev) + 6;
+    nz = (l_int32)(255. / range_stdev) + 6;
+    if ((l_float64)nx * ny * nz > MAX_GRID_SIZE) {
+        L_ERROR("grid size %d x %d x %d is too large\n", procName,
+                nx, ny, nz);
+        return NULL;
+    }
+    size = (size_t)nx * ny * nz;
+    gridv = (l_float32 *)LEPT_CALLOC(size, sizeof(l_float32));
+    gridw = (l_float32 *)LEPT_CALLOC(size, sizeof(l_float32));
+    xlow = (l_int32 *)LEPT_CALLOC(w, sizeof(l_int32));
+    ylow = (l_int32 *)LEPT_CALLOC(h, sizeof(l_int32));
+    xfract = (l_float32 *)LEPT_CALLOC(w, sizeof(l_float32));
+    yfract = (l_float32 *)LEPT_CALLOC(h, sizeof(l_float32));
+    pixd = NULL;
+    if (!gridv || !gridw || !xlow || !ylow || !xfract || !yfract) {
+        L_ERROR("grid arrays not made\n", procName);
+        goto cleanup;
+    }
+
+        /* Grid coordinates of each column and line */
+    for (j = 0; j < w; j++) {
+        fx = j / spatial_stdev + 2.0;
+        xlow[j] = (l_int32)fx;
+        xfract[j] = fx - xlow[j];
+    }
+    for (i = 0; i < h; i++) {
+        fy = i / spatial_stdev + 2.0;
+        ylow[i] = (l_int32)fy;
+        yfract[i] = fy - ylow[i];
+    }
+
+        /* Splat */
+    datas = pixGetData(pixs);
+    wpls = pixGetWpl(pixs);
+    for (i = 0; i < h; i++) {
+        lines = datas + i * wpls;
+        iy = ylow[i] + (yfract[i] >= 0.5);
+        for (j = 0; j < w; j++) {
+            val = GET_DATA_BYTE(lines, j);
+            ix = xlow[j] + (xfract[j] >= 0.5);
+            iz = (l_int32)(val / range_stdev + 2.5);
+            index = (iy * nx + ix) * nz + iz;
+            gridv[index] += val;
+            gridw[index] += 1.0;
+        }
+    }
+
+        /* Blur */
+    bilateralGridBlur(gridv, nx, ny, nz);
+    bilateralGridBlur(gridw, nx, ny, nz);
+
+        /* Slice */
+    if ((pixd = pixCreateTemplate(pixs)) == NULL) {
+        L_ERROR("pixd not made\n", procName);
+        goto cleanup;
+    }
+    datad = pixGetData(pixd);
+    wpld = pixGetWpl(pixd);
+    for (i = 0; i < h; i++) {
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        iy = ylow[i];
+        fy = yfract[i];
+        for (j = 0; j < w; j++) {
+            val = GET_DATA_BYTE(lines, j);
+            ix = xlow[j];
+            fx = xfract[j];
+            fz = val / range_stdev + 2.0;
+            iz = (l_int32)fz;
+            fz -= iz;
+            f00 = (1.0 - fy) * (1.0 - fx);
+            f01 = (1.0 - fy) * fx;
+            f10 = fy * (1.0 - fx);
+            f11 = fy * fx;
+            index = (iy * nx + ix) * nz + iz;
+            sum = f00 * ((1.0 - fz) * gridv[index] + fz * gridv[index + 1]);
+            wsum = f00 * ((1.0 - fz) * gridw[index] + fz * gridw[index + 1]);
+            index += nz;
+            sum += f01 * ((1.0 - fz) * gridv[index] + fz * gridv[index + 1]);
+            wsum += f01 * ((1.0 - fz) * gridw[index] + fz * gridw[index + 1]);
+            index += (nx - 1) * nz;
+            sum += f10 * ((1.0 - fz) * gridv[index] + fz * gridv[index + 1]);
+            wsum += f10 * ((1.0 - fz) * gridw[index] + fz * gridw[index + 1]);
+            index += nz;
+            sum += f11 * ((1.0 - fz) * gridv[index] + fz * gridv[index + 1]);
+            wsum += f11 * ((1.0 - fz) * gridw[index] + fz * gridw[index + 1]);
+            if (wsum > 0.0)
+                val = (l_int32)(sum / wsum + 0.5);
+            val = L_MIN(255, L_MAX(0, val));
+            SET_DATA_BYTE(lined, j, val);
+        }
+    }
+
+cleanup:
+    LEPT_FREE(gridv);
+    LEPT_FREE(gridw);
+    LEPT_FREE(xlow);
+    LEPT_FREE(ylow);
+    LEPT_FREE(xfract);
+    LEPT_FREE(yfract);
+    return pixd;
+}
+
+
+/*!
+ * \brief   bilateralGridBlur()
+ *
+ * \param[in]    grid array of nx * ny * nz floats, with z varying fastest
+ * \param[in]    nx, ny, nz dimensions of the grid
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This convolves the grid in place with {1, 4, 6, 4, 1} / 16
+ *          along each axis.  Values outside the grid are taken as 0.
+ * </pre>
+ */
+static void
+bilateralGridBlur(l_float32  *grid,
+                  l_int32     nx,
+                  l_int32     ny,
+                  l_int32     nz)
+{
+l_int32     i, k, n, m, axis, nlines, stride, start;
+l_float32  *buf, *line;
+
+    n = L_MAX(nx, L_MAX(ny, nz));
+    if ((buf = (l_float32 *)LEPT_CALLOC(n + 4, sizeof(l_float32))) == NULL)
+        return;
+
+        /* For each axis, visit every line of the grid along that axis */
+    for (axis = 0; axis < 3; axis++) {
+        if (axis == 0) {  /* z */
+            n = nz;
+            stride = 1;
+        } else if (axis == 1) {  /* x */
+            n = nx;
+            stride = nz;
+        } else {  /* y */
+            n = ny;
+            stride = nx * nz;
+        }
+        nlines = nx * ny * nz / n;
+        for (k = 0; k < nlines; k++) {
+            if (axis == 0)
+                start = k * nz;
+            else if (axis == 1)
+                start = (k / nz) * nx * nz + (k % nz);
+            else
+                start = k;
+            line = grid + start;
+            for (i = 0; i < n; i++)
+                buf[i + 2] = line[i * stride];
+            buf[n + 2] = buf[n + 3] = 0.0;
+            for (i = 0; i < n; i++) {
+                m = i + 2;
+                line[i * stride] = 0.0625 * (buf[m - 2] + buf[m + 2]) +
+                                   0.25 * (buf[m - 1] + buf[m + 1]) +
+                                   0.375 * buf[m];
+            }
+        }
+    }
+
+    LEPT_FREE(buf);
+}
+
+
 /*----------------------------------------------------------------------*
  *    Exact implementation of grayscale or color bilateral filtering    *
  *----------------------------------------------------------------------*/
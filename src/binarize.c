@@ -52,6 +52,11 @@
  *          PIX       *pixSauvolaGetThreshold()
  *          PIX       *pixApplyLocalThreshold();
  *
+ *      Fused local threshold binarization (Sauvola, Niblack, Wolf, Bradley)
+ *          PIX       *pixLocalThreshBinarize()
+ *          static PIX  *localThreshBinarizeLow()
+ *          static void  addLineToColumnSums()
+ *
  *      Thresholding using connected components
  *          PIX       *pixThresholdByConnComp()
  *
@@ -68,16 +73,28 @@
  *          the window size for the measurment at each pixel and a
  *          parameter that determines the amount of normalized local
  *          standard deviation to subtract from the local average value.
- *      (4) pixThresholdByCC() uses the numbers of 4 and 8 connected
+ *      (4) pixLocalThreshBinarize() computes the same local statistics
+ *          with column sums that are updated one raster line at a time,
+ *          and writes the binary output directly, without making any
+ *          full-size intermediate images.  It implements the Sauvola
+ *          threshold and the related Niblack, Wolf and Bradley ones.
+ *      (5) pixThresholdByCC() uses the numbers of 4 and 8 connected
  *          components at different thresholding to determine if a
  *          global threshold can be used (for text or line-art) and the
  *          value it should have.
  * </pre>
  */
 
+#include <string.h>
 #include <math.h>
 #include "allheaders.h"
 
+static PIX *localThreshBinarizeLow(PIX *pixs, l_int32 method, l_int32 whsize,
+                                   l_float32 factor, l_int32 hasborder);
+static void addLineToColumnSums(l_uint32 *line, l_int32 *colmap, l_int32 wb,
+                                l_int32 sign, l_uint32 *colsum,
+                                l_float64 *colsq);
+
 /*------------------------------------------------------------------*
  *                 Adaptive Otsu-based thresholding                 *
  *------------------------------------------------------------------*/
@@ -461,6 +478,10 @@ PIX      *pixn, *pixm, *pixd, *pix1, *pix2, *pix3, *pix4;
  *      (4) The Sauvola threshold is determined from the formula:
  *              t = m * (1 - k * (1 - s / 128))
  *          See pixSauvolaBinarize() for details.
+ *      (5) If only the thresholded image is requested, the tiling is
+ *          not used.  pixLocalThreshBinarize() computes it in one pass
+ *          with a few line arrays, so its memory does not grow with the
+ *          image area and the accumulators can not overflow.
  * </pre>
  */
 l_int32
@@ -499,6 +520,15 @@ PIXTILING  *pt;
         return pixSauvolaBinarize(pixs, whsize, factor, 1, NULL, NULL,
                                   ppixth, ppixd);
 
+        /* With no threshold image, binarize directly without tiling */
+    if (!ppixth) {
+        if ((*ppixd = localThreshBinarizeLow(pixs, L_SAUVOLA_THRESH, whsize,
+                                             factor, 0)) == NULL)
+            return ERROR_INT("pixd not made", procName, 1);
+        pixCopyResolution(*ppixd, pixs);
+        return 0;
+    }
+
         /* Test to see if the tiles are too small.  The required
          * condition is that the tile dimensions must be at least
          * (whsize + 2) x (whsize + 2).  */
@@ -588,6 +618,9 @@ PIXTILING  *pt;
  *          and the larger the variance, the closer to the median
  *          it should be chosen.  Typical values for k are between
  *          0.2 and 0.5.
+ *      (6) If only %ppixd is requested, the intermediate images are
+ *          not needed, and the result is made by the fused
+ *          pixLocalThreshBinarize().
  * </pre>
  */
 l_int32
@@ -623,6 +656,15 @@ PIX     *pixg, *pixsc, *pixm, *pixms, *pixth, *pixd;
     if (factor < 0.0)
         return ERROR_INT("factor must be >= 0", procName, 1);
 
+    if (!ppixm && !ppixsd && !ppixth) {
+        if ((pixd = localThreshBinarizeLow(pixs, L_SAUVOLA_THRESH, whsize,
+                                           factor, !addborder)) == NULL)
+            return ERROR_INT("pixd not made", procName, 1);
+        pixCopyResolution(pixd, pixs);
+        *ppixd = pixd;
+        return 0;
+    }
+
     if (addborder) {
         pixg = pixAddMirroredBorder(pixs, whsize + 1, whsize + 1,
                                     whsize + 1, whsize + 1);
@@ -825,6 +867,269 @@ PIX       *pixd;
 }
 
 
+/*----------------------------------------------------------------------*
+ *                Fused local threshold binarization                    *
+ *----------------------------------------------------------------------*/
+/*!
+ * \brief   pixLocalThreshBinarize()
+ *
+ * \param[in]    pixs 8 bpp grayscale; not colormapped
+ * \param[in]    method L_SAUVOLA_THRESH, L_NIBLACK_THRESH, L_WOLF_THRESH,
+ *                      L_BRADLEY_THRESH
+ * \param[in]    whsize window half-width for measuring local statistics
+ * \param[in]    factor k in the threshold formula; >= 0
+ * \return  pixd 1 bpp, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The window width and height are 2 * %whsize + 1.  The minimum
+ *          value for %whsize is 2; typically it is >= 7.
+ *      (2) With m and s the local mean and standard deviation, the
+ *          thresholds are:
+ *            Sauvola:  t = m * (1 - k * (1 - s / 128))   [k typ. 0.35]
+ *            Niblack:  t = m - k * s                     [k typ. 0.2]
+ *            Wolf:     t = m - k * (1 - s / smax) * (m - vmin)
+ *                                                        [k typ. 0.5]
+ *            Bradley:  t = m * (1 - k)                   [k typ. 0.15]
+ *          where smax is the largest local standard deviation and vmin
+ *          is the smallest pixel value in the image.  A pixel is set
+ *          in pixd if its value is below t.
+ *      (3) The Sauvola result is identical to the one from
+ *          pixSauvolaBinarize() with %addborder = 1.  The mean and
+ *          mean square are found in the same way, and the border is
+ *          mirrored in the same way, but no intermediate images are made.
+ *          Instead, the sums of the pixel values and their squares are
+ *          kept for each column over the 2 * %whsize + 1 raster lines
+ *          in the window.  As the window moves down by one line, one
+ *          line is subtracted from the column sums and one is added.
+ *          The sums over each window are then found by moving along
+ *          the column sums.  The memory used is a few arrays the size
+ *          of a raster line, in addition to pixs and pixd.
+ *      (4) Wolf needs smax and vmin before any threshold can be found,
+ *          so the local statistics are computed twice.
+ * </pre>
+ */
+PIX *
+pixLocalThreshBinarize(PIX       *pixs,
+                       l_int32    method,
+                       l_int32    whsize,
+                       l_float32  factor)
+{
+l_int32  w, h;
+PIX     *pixd;
+
+    PROCNAME("pixLocalThreshBinarize");
+
+    if (!pixs || pixGetDepth(pixs) != 8)
+        return (PIX *)ERROR_PTR("pixs undefined or not 8 bpp", procName, NULL);
+    if (pixGetColormap(pixs))
+        return (PIX *)ERROR_PTR("pixs is cmapped", procName, NULL);
+    if (method != L_SAUVOLA_THRESH && method != L_NIBLACK_THRESH &&
+        method != L_WOLF_THRESH && method != L_BRADLEY_THRESH)
+        return (PIX *)ERROR_PTR("invalid method", procName, NULL);
+    pixGetDimensions(pixs, &w, &h, NULL);
+    if (whsize < 2)
+        return (PIX *)ERROR_PTR("whsize must be >= 2", procName, NULL);
+    if (w < 2 * whsize + 3 || h < 2 * whsize + 3)
+        return (PIX *)ERROR_PTR("whsize too large for image", procName, NULL);
+    if (factor < 0.0)
+        return (PIX *)ERROR_PTR("factor must be >= 0", procName, NULL);
+
+    if ((pixd = localThreshBinarizeLow(pixs, method, whsize, factor, 0))
+        == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    pixCopyResolution(pixd, pixs);
+    return pixd;
+}
+
+
+/*!
+ * \brief   localThreshBinarizeLow()
+ *
+ * \param[in]    pixs 8 bpp
+ * \param[in]    method L_SAUVOLA_THRESH, ...
+ * \param[in]    whsize window half-width
+ * \param[in]    factor k in the threshold formula
+ * \param[in]    hasborder 1 if pixs has a border of (%whsize + 1) pixels
+ *                         on each side, which is not in pixd
+ * \return  pixd 1 bpp, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) If pixs has no border, window pixels that are outside pixs
+ *          are taken from the mirror image about the nearest edge, as
+ *          done by pixAddMirroredBorder().
+ *      (2) The arithmetic for the mean and mean square is the same as in
+ *          pixWindowedMean() and pixWindowedMeanSquare(), so that the
+ *          Sauvola thresholds are the same as pixSauvolaGetThreshold().
+ * </pre>
+ */
+static PIX *
+localThreshBinarizeLow(PIX       *pixs,
+                       l_int32    method,
+                       l_int32    whsize,
+                       l_float32  factor,
+                       l_int32    hasborder)
+{
+l_int32     i, j, k, c, r, w, h, ws, hs, wb, off, size, pass;
+l_int32     wpls, wpld, mv, val, vmin, thresh;
+l_int32    *colmap, *rowmap;
+l_uint32    sum, ms, var;
+l_uint32   *colsum, *datas, *datad, *lines, *lined;
+l_float32   norm, sd, maxsd;
+l_float64   normsq, sumsq, ratio;
+l_float64  *colsq;
+PIX        *pixd;
+
+    PROCNAME("localThreshBinarizeLow");
+
+    pixGetDimensions(pixs, &ws, &hs, NULL);
+    off = (hasborder) ? whsize + 1 : 0;
+    w = ws - 2 * off;
+    h = hs - 2 * off;
+    wb = w + 2 * whsize;  /* columns covered by the windows on a line */
+    size = 2 * whsize + 1;
+    if ((pixd = pixCreate(w, h, 1)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    colmap = (l_int32 *)LEPT_CALLOC(wb, sizeof(l_int32));
+    rowmap = (l_int32 *)LEPT_CALLOC(h + 2 * whsize, sizeof(l_int32));
+    colsum = (l_uint32 *)LEPT_CALLOC(wb, sizeof(l_uint32));
+    colsq = (l_float64 *)LEPT_CALLOC(wb, sizeof(l_float64));
+    if (!colmap || !rowmap || !colsum || !colsq) {
+        pixDestroy(&pixd);
+        pixd = (PIX *)ERROR_PTR("arrays not made", procName, NULL);
+        goto cleanup;
+    }
+
+        /* Map window columns and lines to pixs, mirroring at the edges */
+    for (k = 0; k < wb; k++) {
+        c = k - whsize + off;
+        if (c < 0)
+            c = -c - 1;
+        else if (c >= ws)
+            c = 2 * ws - 1 - c;
+        colmap[k] = c;
+    }
+    for (k = 0; k < h + 2 * whsize; k++) {
+        r = k - whsize + off;
+        if (r < 0)
+            r = -r - 1;
+        else if (r >= hs)
+            r = 2 * hs - 1 - r;
+        rowmap[k] = r;
+    }
+
+    datas = pixGetData(pixs);
+    wpls = pixGetWpl(pixs);
+    datad = pixGetData(pixd);
+    wpld = pixGetWpl(pixd);
+    norm = 1.0 / (size * size);
+    normsq = 1.0 / (size * size);
+    maxsd = 0.0;
+    vmin = 255;
+
+        /* For Wolf, the first pass finds smax and vmin */
+    for (pass = (method == L_WOLF_THRESH) ? 0 : 1; pass < 2; pass++) {
+        memset(colsum, 0, wb * sizeof(l_uint32));
+        memset(colsq, 0, wb * sizeof(l_float64));
+        for (k = 0; k < size - 1; k++)
+            addLineToColumnSums(datas + rowmap[k] * wpls, colmap, wb, 1,
+                                colsum, colsq);
+        for (i = 0; i < h; i++) {
+                /* Move the window down to cover lines i to i + size - 1
+                 * in the mirrored coordinates of rowmap */
+            if (i > 0)
+                addLineToColumnSums(datas + rowmap[i - 1] * wpls, colmap,
+                                    wb, -1, colsum, colsq);
+            addLineToColumnSums(datas + rowmap[i + size - 1] * wpls, colmap,
+                                wb, 1, colsum, colsq);
+            lines = datas + (i + off) * wpls;
+            lined = datad + i * wpld;
+            sum = 0;
+            sumsq = 0.0;
+            for (k = 0; k < size - 1; k++) {
+                sum += colsum[k];
+                sumsq += colsq[k];
+            }
+            for (j = 0; j < w; j++) {
+                sum += colsum[j + size - 1];
+                sumsq += colsq[j + size - 1];
+                mv = (l_uint8)(norm * sum);
+                ms = (l_uint32)(normsq * sumsq);
+                var = ms - mv * mv;
+                sd = sqrtf((l_float32)var);
+                sum -= colsum[j];
+                sumsq -= colsq[j];
+                val = GET_DATA_BYTE(lines, j + off);
+                if (pass == 0) {
+                    if (sd > maxsd) maxsd = sd;
+                    if (val < vmin) vmin = val;
+                    continue;
+                }
+
+                if (method == L_SAUVOLA_THRESH) {
+                    thresh = (l_int32)(mv * (1.0 - factor *
+                                             (1.0 - sd / 128.)));
+                } else if (method == L_NIBLACK_THRESH) {
+                    thresh = (l_int32)(mv - factor * sd);
+                } else if (method == L_WOLF_THRESH) {
+                    ratio = (maxsd > 0.0) ? sd / maxsd : 0.0;
+                    thresh = (l_int32)(mv - factor * (1.0 - ratio) *
+                                       (mv - vmin));
+                } else {  /* L_BRADLEY_THRESH */
+                    thresh = (l_int32)(mv * (1.0 - factor));
+                }
+                if (val < thresh)
+                    SET_DATA_BIT(lined, j);
+            }
+        }
+    }
+
+cleanup:
+    LEPT_FREE(colmap);
+    LEPT_FREE(rowmap);
+    LEPT_FREE(colsum);
+    LEPT_FREE(colsq);
+    return pixd;
+}
+
+
+/*!
+ * \brief   addLineToColumnSums()
+ *
+ * \param[in]      line of 8 bpp pixs
+ * \param[in]      colmap pixs column for each window column
+ * \param[in]      wb number of window columns
+ * \param[in]      sign 1 to add the line; -1 to subtract it
+ * \param[in,out]  colsum, colsq sums of values and of squared values
+ * \return  void
+ */
+static void
+addLineToColumnSums(l_uint32   *line,
+                    l_int32    *colmap,
+                    l_int32     wb,
+                    l_int32     sign,
+                    l_uint32   *colsum,
+                    l_float64  *colsq)
+{
+l_int32  k, val;
+
+    if (sign > 0) {
+        for (k = 0; k < wb; k++) {
+            val = GET_DATA_BYTE(line, colmap[k]);
+            colsum[k] += val;
+            colsq[k] += val * val;
+        }
+    } else {
+        for (k = 0; k < wb; k++) {
+            val = GET_DATA_BYTE(line, colmap[k]);
+            colsum[k] -= val;
+            colsq[k] -= val * val;
+        }
+    }
+}
+
+
 /*----------------------------------------------------------------------*
  *                  Thresholding using connected components             *
  *----------------------------------------------------------------------*/
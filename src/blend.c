@@ -36,7 +36,6 @@
  *           PIX             *pixBlendColor()
  *           PIX             *pixBlendColorByChannel()
  *           PIX             *pixBlendGrayAdapt()
- *           static l_int32   blendComponents()
  *           PIX             *pixFadeWithGray()
  *           PIX             *pixBlendHardLight()
  *           static l_int32   blendHardLightComponents()
@@ -62,6 +61,17 @@
  *      Setting a transparent alpha component over a white background
  *           PIX             *pixSetAlphaOverWhite()
  *
+ *      Blending with premultiplied alpha
+ *           PIX             *pixPremultiplyAlpha()
+ *           PIX             *pixBlendPremultAlpha()
+ *
+ *      Row blending
+ *           static void      blendLineColor()
+ *           static void      blendLineGray()
+ *           static void      blendLineWithMask()
+ *           static l_uint8  *makeBlendTab()
+ *           static l_int32   blendComponents()
+ *
  *  In blending operations a new pix is produced where typically
  *  a subset of pixels in src1 are changed by the set of pixels
  *  in src2, when src2 is located in a given position relative
@@ -78,11 +88,12 @@
  *
  *  Because src2 is typically smaller than src1, we can implement by
  *  clipping src2 to src1 and then transforming some of the dest
- *  pixels that are under the support of src2.  In practice, we
- *  do the clipping in the inner pixel loop.  For grayscale and
- *  color src2, we also allow a simple form of transparency, where
- *  pixels of a particular value in src2 are transparent; for those pixels,
- *  no blending is done.
+ *  pixels that are under the support of src2.  The blends with a
+ *  constant fraction or a gray mask (see below) clip src2 once for
+ *  each row; the others do the clipping in the inner pixel loop.
+ *  For grayscale and color src2, we also allow a simple form of
+ *  transparency, where pixels of a particular value in src2 are
+ *  transparent; for those pixels, no blending is done.
  *
  *  The blending functions are categorized by the depth of src2,
  *  the blender, and not that of src1, the blendee.
@@ -138,14 +149,44 @@
  *  blending: pixBlendHardLight().  We generalize by allowing a fraction < 1.0
  *  of the blender to be admixed with the blendee.  The standard function
  *  does full mixing.
+ *
+ *  The blends with a constant fraction (pixBlendGray(), pixBlendColor(),
+ *  pixBlendColorByChannel()) and with a gray or alpha mask
+ *  (pixBlendWithGrayMask()) clip the blender to the blendee once per row,
+ *  and then blend each row without function calls.  The results are
+ *  the same as those of the per-pixel floating point expression
+ *       p --> (l_int32)((1 - f) * p + f * c)
+ *  When the fraction is constant and the blender is large, this is
+ *  tabulated for all (blendee, blender) pairs.  Hard light blending
+ *  uses a table in the same way.
+ *
+ *  An rgba blender that is used repeatedly, such as an overlay that
+ *  is composited onto many images, can be premultiplied by its alpha
+ *  with pixPremultiplyAlpha().  Then pixBlendPremultAlpha() needs only
+ *  one multiplication for each component:
+ *       p --> c + p * (255 - a) / 255
  * </pre>
  */
 
 
 #include "allheaders.h"
 
-static l_int32 blendComponents(l_int32 a, l_int32 b, l_float32 fract);
+    /* Use a table of blended components above this number of samples */
+static const l_int32  BLEND_TABLE_MIN = 65536;
+
 static l_int32 blendHardLightComponents(l_int32 a, l_int32 b, l_float32 fract);
+static void blendLineColor(l_uint32 *lined, l_uint32 *linec, l_int32 n,
+                           l_float32 *fracts, l_uint8 **tabs,
+                           l_int32 transparent, l_uint32 transpix);
+static void blendLineGray(l_uint32 *lined, l_int32 d, l_uint32 *linec,
+                          l_int32 x, l_int32 j1, l_int32 j2, l_float32 fract,
+                          l_uint8 *tab, l_int32 transparent,
+                          l_uint32 transpix);
+static void blendLineWithMask(l_uint32 *lined, l_int32 d, l_uint32 *lines,
+                              l_uint32 *lineg, l_int32 x, l_int32 j1,
+                              l_int32 j2, l_float32 *ftab);
+static l_uint8 *makeBlendTab(l_float32 fract);
+static l_int32 blendComponents(l_int32 a, l_int32 b, l_float32 fract);
 
 
 /*-------------------------------------------------------------*
@@ -462,7 +503,9 @@ PIX       *pixc, *pix1, *pix2;
  *            pixBlendGray(pixs1, pixs1, pixs2, ...)
  *      (2) For generating a new pixd:
  *            pixd = pixBlendGray(NULL, pixs1, pixs2, ...)
- *      (3) Clipping of pixs2 to pixs1 is done in the inner pixel loop.
+ *      (3) Clipping of pixs2 to pixs1 is done once for each row with
+ *          L_BLEND_GRAY, and in the inner pixel loop with
+ *          L_BLEND_GRAY_WITH_INVERSE.
  *      (4) If pixs1 has a colormap, it is removed; otherwise, if pixs1
  *          has depth < 8, it is unpacked to generate a 8 bpp pix.
  *      (5) If transparent = 0, the blending fraction (fract) is
@@ -493,8 +536,9 @@ pixBlendGray(PIX       *pixd,
              l_int32    transparent,
              l_uint32   transpix)
 {
-l_int32    i, j, d, wc, hc, w, h, wplc, wpld, delta;
-l_int32    ival, irval, igval, ibval, cval, dval;
+l_int32    i, j, d, wc, hc, w, h, wplc, wpld, delta, j1, j2;
+l_int32    ival, irval, igval, ibval, cval;
+l_uint8   *tab;
 l_uint32   val32;
 l_uint32  *linec, *lined, *datac, *datad;
 PIX       *pixc, *pix1, *pix2;
@@ -550,45 +594,21 @@ PIX       *pixc, *pix1, *pix2;
          * The basic logic for this blending is:
          *      p -->  (1 - f) * p + f * c
          * where c is the 8 bpp blender.  All values are normalized to [0...1].
+         * The blender is clipped to the blendee once for each row.
          */
+        tab = NULL;
+        if (wc * hc >= BLEND_TABLE_MIN)
+            tab = makeBlendTab(fract);
+        j1 = L_MAX(0, -x);
+        j2 = L_MIN(wc, w - x);
         for (i = 0; i < hc; i++) {
             if (i + y < 0  || i + y >= h) continue;
             linec = datac + i * wplc;
             lined = datad + (i + y) * wpld;
-            switch (d)
-            {
-            case 8:
-                for (j = 0; j < wc; j++) {
-                    if (j + x < 0  || j + x >= w) continue;
-                    cval = GET_DATA_BYTE(linec, j);
-                    if (transparent == 0 ||
-                        (transparent != 0 && cval != transpix)) {
-                        dval = GET_DATA_BYTE(lined, j + x);
-                        ival = (l_int32)((1. - fract) * dval + fract * cval);
-                        SET_DATA_BYTE(lined, j + x, ival);
-                    }
-                }
-                break;
-            case 32:
-                for (j = 0; j < wc; j++) {
-                    if (j + x < 0  || j + x >= w) continue;
-                    cval = GET_DATA_BYTE(linec, j);
-                    if (transparent == 0 ||
-                        (transparent != 0 && cval != transpix)) {
-                        val32 = *(lined + j + x);
-                        extractRGBValues(val32, &irval, &igval, &ibval);
-                        irval = (l_int32)((1. - fract) * irval + fract * cval);
-                        igval = (l_int32)((1. - fract) * igval + fract * cval);
-                        ibval = (l_int32)((1. - fract) * ibval + fract * cval);
-                        composeRGBPixel(irval, igval, ibval, &val32);
-                        *(lined + j + x) = val32;
-                    }
-                }
-                break;
-            default:
-                break;   /* shouldn't happen */
-            }
+            blendLineGray(lined, d, linec, x, j1, j2, fract, tab,
+                          transparent, transpix);
         }
+        LEPT_FREE(tab);
     } else {  /* L_BLEND_GRAY_WITH_INVERSE */
         for (i = 0; i < hc; i++) {
             if (i + y < 0  || i + y >= h) continue;
@@ -808,7 +828,7 @@ PIX       *pixc, *pix1, *pix2;
  *      (2) For generating a new pixd:
  *            pixd = pixBlendColor(NULL, pixs1, pixs2, ...)
  *      (3) If pixs2 is not 32 bpp rgb, it is converted.
- *      (4) Clipping of pixs2 to pixs1 is done in the inner pixel loop.
+ *      (4) Clipping of pixs2 to pixs1 is done once for each row.
  *      (5) If pixs1 has a colormap, it is removed to generate a 32 bpp pix.
  *      (6) If pixs1 has depth < 32, it is unpacked to generate a 32 bpp pix.
  *      (7) If transparent = 0, the blending fraction (fract) is
@@ -827,10 +847,10 @@ pixBlendColor(PIX       *pixd,
               l_int32    transparent,
               l_uint32   transpix)
 {
-l_int32    i, j, wc, hc, w, h, wplc, wpld;
-l_int32    rval, gval, bval, rcval, gcval, bcval;
-l_uint32   cval32, val32;
+l_int32    i, wc, hc, w, h, wplc, wpld, j1, j2;
+l_uint8   *tabs[3];
 l_uint32  *linec, *lined, *datac, *datad;
+l_float32  fracts[3];
 PIX       *pixc;
 
     PROCNAME("pixBlendColor");
@@ -865,35 +885,28 @@ PIX       *pixc;
     datac = pixGetData(pixc);
     wplc = pixGetWpl(pixc);
 
-        /* Check limits for src1, in case clipping was not done */
-    for (i = 0; i < hc; i++) {
         /*
          * The basic logic for this blending is:
          *      p -->  (1 - f) * p + f * c
          * for each color channel.  c is a color component of the blender.
          * All values are normalized to [0...1].
+         * The blender is clipped to the blendee once for each row.
          */
+    fracts[0] = fracts[1] = fracts[2] = fract;
+    tabs[0] = tabs[1] = tabs[2] = NULL;
+    if (wc * hc >= BLEND_TABLE_MIN)
+        tabs[0] = tabs[1] = tabs[2] = makeBlendTab(fract);
+    j1 = L_MAX(0, -x);
+    j2 = L_MIN(wc, w - x);
+    for (i = 0; i < hc && j1 < j2; i++) {
         if (i + y < 0  || i + y >= h) continue;
         linec = datac + i * wplc;
         lined = datad + (i + y) * wpld;
-        for (j = 0; j < wc; j++) {
-            if (j + x < 0  || j + x >= w) continue;
-            cval32 = *(linec + j);
-            if (transparent == 0 ||
-                (transparent != 0 &&
-                     ((cval32 & 0xffffff00) != (transpix & 0xffffff00)))) {
-                val32 = *(lined + j + x);
-                extractRGBValues(cval32, &rcval, &gcval, &bcval);
-                extractRGBValues(val32, &rval, &gval, &bval);
-                rval = (l_int32)((1. - fract) * rval + fract * rcval);
-                gval = (l_int32)((1. - fract) * gval + fract * gcval);
-                bval = (l_int32)((1. - fract) * bval + fract * bcval);
-                composeRGBPixel(rval, gval, bval, &val32);
-                *(lined + j + x) = val32;
-            }
-        }
+        blendLineColor(lined + x + j1, linec + j1, j2 - j1, fracts, tabs,
+                       transparent, transpix);
     }
 
+    LEPT_FREE(tabs[0]);
     pixDestroy(&pixc);
     return pixd;
 }
@@ -942,10 +955,10 @@ pixBlendColorByChannel(PIX       *pixd,
                        l_int32    transparent,
                        l_uint32   transpix)
 {
-l_int32    i, j, wc, hc, w, h, wplc, wpld;
-l_int32    rval, gval, bval, rcval, gcval, bcval;
-l_uint32   cval32, val32;
+l_int32    i, k, wc, hc, w, h, wplc, wpld, j1, j2;
+l_uint8   *tabs[3];
 l_uint32  *linec, *lined, *datac, *datad;
+l_float32  fracts[3];
 PIX       *pixc;
 
     PROCNAME("pixBlendColorByChannel");
@@ -976,47 +989,35 @@ PIX       *pixc;
     datac = pixGetData(pixc);
     wplc = pixGetWpl(pixc);
 
-        /* Check limits for src1, in case clipping was not done */
-    for (i = 0; i < hc; i++) {
+        /* Fractions outside [0.0 ... 1.0] select the min or max */
+    fracts[0] = rfract;
+    fracts[1] = gfract;
+    fracts[2] = bfract;
+    tabs[0] = tabs[1] = tabs[2] = NULL;
+    if (wc * hc >= BLEND_TABLE_MIN) {
+        for (k = 0; k < 3; k++)
+            tabs[k] = makeBlendTab(fracts[k]);
+    }
+
+        /* Clip the blender to the blendee once for each row */
+    j1 = L_MAX(0, -x);
+    j2 = L_MIN(wc, w - x);
+    for (i = 0; i < hc && j1 < j2; i++) {
         if (i + y < 0  || i + y >= h) continue;
         linec = datac + i * wplc;
         lined = datad + (i + y) * wpld;
-        for (j = 0; j < wc; j++) {
-            if (j + x < 0  || j + x >= w) continue;
-            cval32 = *(linec + j);
-            if (transparent == 0 ||
-                (transparent != 0 &&
-                     ((cval32 & 0xffffff00) != (transpix & 0xffffff00)))) {
-                val32 = *(lined + j + x);
-                extractRGBValues(cval32, &rcval, &gcval, &bcval);
-                extractRGBValues(val32, &rval, &gval, &bval);
-                rval = blendComponents(rval, rcval, rfract);
-                gval = blendComponents(gval, gcval, gfract);
-                bval = blendComponents(bval, bcval, bfract);
-                composeRGBPixel(rval, gval, bval, &val32);
-                *(lined + j + x) = val32;
-            }
-        }
+        blendLineColor(lined + x + j1, linec + j1, j2 - j1, fracts, tabs,
+                       transparent, transpix);
     }
 
+    for (k = 0; k < 3; k++)
+        LEPT_FREE(tabs[k]);
+
     pixDestroy(&pixc);
     return pixd;
 }
 
 
-static l_int32
-blendComponents(l_int32    a,
-                l_int32    b,
-                l_float32  fract)
-{
-    if (fract < 0.)
-        return ((a < b) ? a : b);
-    if (fract > 1.)
-        return ((a > b) ? a : b);
-    return (l_int32)((1. - fract) * a + fract * b);
-}
-
-
 /*!
  * \brief   pixBlendGrayAdapt()
  *
@@ -1358,6 +1359,7 @@ pixBlendHardLight(PIX       *pixd,
 {
 l_int32    i, j, w, h, d, wc, hc, dc, wplc, wpld;
 l_int32    cval, dval, rcval, gcval, bcval, rdval, gdval, bdval;
+l_uint8   *tab;
 l_uint32   cval32, dval32;
 l_uint32  *linec, *lined, *datac, *datad;
 PIX       *pixc, *pixt;
@@ -1423,6 +1425,17 @@ PIX       *pixc, *pixt;
         return (PIX *)ERROR_PTR("bad! -- invalid depth combo!", procName, pixd);
     }
 
+        /* For a large blender, tabulate the result for every pair of
+         * (blendee, blender) components, indexed by (a << 8) | b */
+    tab = NULL;
+    if (wc * hc * (d / 8) >= BLEND_TABLE_MIN) {
+        tab = (l_uint8 *)LEPT_CALLOC(256 * 256, sizeof(l_uint8));
+        for (i = 0; i < 256; i++) {
+            for (j = 0; j < 256; j++)
+                tab[(i << 8) | j] = blendHardLightComponents(i, j, fract);
+        }
+    }
+
     wpld = pixGetWpl(pixd);
     datad = pixGetData(pixd);
     datac = pixGetData(pixc);
@@ -1436,15 +1449,24 @@ PIX       *pixc, *pixt;
             if (d == 8 && dc == 8) {
                 dval = GET_DATA_BYTE(lined, x + j);
                 cval = GET_DATA_BYTE(linec, j);
-                dval = blendHardLightComponents(dval, cval, fract);
+                if (tab)
+                    dval = tab[(dval << 8) | cval];
+                else
+                    dval = blendHardLightComponents(dval, cval, fract);
                 SET_DATA_BYTE(lined, x + j, dval);
             } else if (d == 32 && dc == 8) {
                 dval32 = *(lined + x + j);
                 extractRGBValues(dval32, &rdval, &gdval, &bdval);
                 cval = GET_DATA_BYTE(linec, j);
-                rdval = blendHardLightComponents(rdval, cval, fract);
-                gdval = blendHardLightComponents(gdval, cval, fract);
-                bdval = blendHardLightComponents(bdval, cval, fract);
+                if (tab) {
+                    rdval = tab[(rdval << 8) | cval];
+                    gdval = tab[(gdval << 8) | cval];
+                    bdval = tab[(bdval << 8) | cval];
+                } else {
+                    rdval = blendHardLightComponents(rdval, cval, fract);
+                    gdval = blendHardLightComponents(gdval, cval, fract);
+                    bdval = blendHardLightComponents(bdval, cval, fract);
+                }
                 composeRGBPixel(rdval, gdval, bdval, &dval32);
                 *(lined + x + j) = dval32;
             } else if (d == 32 && dc == 32) {
@@ -1452,15 +1474,22 @@ PIX       *pixc, *pixt;
                 extractRGBValues(dval32, &rdval, &gdval, &bdval);
                 cval32 = *(linec + j);
                 extractRGBValues(cval32, &rcval, &gcval, &bcval);
-                rdval = blendHardLightComponents(rdval, rcval, fract);
-                gdval = blendHardLightComponents(gdval, gcval, fract);
-                bdval = blendHardLightComponents(bdval, bcval, fract);
+                if (tab) {
+                    rdval = tab[(rdval << 8) | rcval];
+                    gdval = tab[(gdval << 8) | gcval];
+                    bdval = tab[(bdval << 8) | bcval];
+                } else {
+                    rdval = blendHardLightComponents(rdval, rcval, fract);
+                    gdval = blendHardLightComponents(gdval, gcval, fract);
+                    bdval = blendHardLightComponents(bdval, bcval, fract);
+                }
                 composeRGBPixel(rdval, gdval, bdval, &dval32);
                 *(lined + x + j) = dval32;
             }
         }
     }
 
+    LEPT_FREE(tab);
     pixDestroy(&pixc);
     return pixd;
 }
@@ -1699,11 +1728,9 @@ pixBlendWithGrayMask(PIX     *pixs1,
                      l_int32  y)
 {
 l_int32    w1, h1, d1, w2, h2, d2, spp, wg, hg, wmin, hmin, wpld, wpls, wplg;
-l_int32    i, j, val, dval, sval;
-l_int32    drval, dgval, dbval, srval, sgval, sbval;
-l_uint32   dval32, sval32;
+l_int32    i, j1, j2;
 l_uint32  *datad, *datas, *datag, *lined, *lines, *lineg;
-l_float32  fract;
+l_float32  ftab[256];
 PIX       *pixr1, *pixr2, *pix1, *pix2, *pixg2, *pixd;
 
     PROCNAME("pixBlendWithGrayMask");
@@ -1729,7 +1756,7 @@ PIX       *pixr1, *pixr2, *pix1, *pix2, *pixg2, *pixd;
             return (PIX *)ERROR_PTR("no alpha; pixs2 not rgba", procName, NULL);
         wmin = w2;
         hmin = h2;
-        pixg2 = pixGetRGBComponent(pixs2, L_ALPHA_CHANNEL);
+        pixg2 = NULL;  /* read alpha directly from pixs2 */
     }
 
         /* Remove colormaps if they exist; clones are OK */
@@ -1774,41 +1801,25 @@ PIX       *pixr1, *pixr2, *pix1, *pix2, *pixg2, *pixd;
          * and the pixel values of pixd and pix2 be p1 and p2, rsp.
          * Then the blended value is:
          *      p = (1.0 - f) * p1 + f * p2
-         * Blending is done component-wise if rgb.
-         * Scan over pix2 and pixg2, clipping to pixd where necessary.  */
+         * Blending is done component-wise if rgb.  If pixg2 is null,
+         * f is taken from the alpha component of pix2.
+         * Scan over pix2 and pixg2, clipping to pixd once for each row. */
     datad = pixGetData(pixd);
     datas = pixGetData(pix2);
-    datag = pixGetData(pixg2);
+    datag = (pixg2) ? pixGetData(pixg2) : NULL;
     wpld = pixGetWpl(pixd);
     wpls = pixGetWpl(pix2);
-    wplg = pixGetWpl(pixg2);
+    wplg = (pixg2) ? pixGetWpl(pixg2) : 0;
+    for (i = 0; i < 256; i++)
+        ftab[i] = (l_float32)i / 255.;
+    j1 = L_MAX(0, -x);
+    j2 = L_MIN(wmin, w1 - x);
     for (i = 0; i < hmin; i++) {
         if (i + y < 0  || i + y >= h1) continue;
         lined = datad + (i + y) * wpld;
         lines = datas + i * wpls;
-        lineg = datag + i * wplg;
-        for (j = 0; j < wmin; j++) {
-            if (j + x < 0  || j + x >= w1) continue;
-            val = GET_DATA_BYTE(lineg, j);
-            if (val == 0) continue;  /* pix2 is transparent */
-            fract = (l_float32)val / 255.;
-            if (d1 == 8) {
-                dval = GET_DATA_BYTE(lined, j + x);
-                sval = GET_DATA_BYTE(lines, j);
-                dval = (l_int32)((1.0 - fract) * dval + fract * sval);
-                SET_DATA_BYTE(lined, j + x, dval);
-            } else {  /* 32 */
-                dval32 = *(lined + j + x);
-                sval32 = *(lines + j);
-                extractRGBValues(dval32, &drval, &dgval, &dbval);
-                extractRGBValues(sval32, &srval, &sgval, &sbval);
-                drval = (l_int32)((1.0 - fract) * drval + fract * srval);
-                dgval = (l_int32)((1.0 - fract) * dgval + fract * sgval);
-                dbval = (l_int32)((1.0 - fract) * dbval + fract * sbval);
-                composeRGBPixel(drval, dgval, dbval, &dval32);
-                *(lined + j + x) = dval32;
-            }
-        }
+        lineg = (datag) ? datag + i * wplg : NULL;
+        blendLineWithMask(lined, d1, lines, lineg, x, j1, j2, ftab);
     }
 
     pixDestroy(&pixg2);
@@ -2153,3 +2164,377 @@ PIX  *pixd, *pix1, *pix2, *pix3, *pix4;
     pixDestroy(&pix4);
     return pixd;
 }
+
+
+/*---------------------------------------------------------------------*
+ *                 Blending with premultiplied alpha                   *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   pixPremultiplyAlpha()
+ *
+ * \param[in]    pixs 32 bpp rgba
+ * \return  pixd 32 bpp rgba with premultiplied color, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each color component c is replaced by c * a / 255, rounded,
+ *          where a is the alpha component.  The alpha component
+ *          is unchanged.
+ *      (2) Use this to prepare a blender for pixBlendPremultAlpha().
+ * </pre>
+ */
+PIX *
+pixPremultiplyAlpha(PIX  *pixs)
+{
+l_int32    i, j, w, h, wpl, rval, gval, bval, aval;
+l_uint32   pixel;
+l_uint32  *data, *line;
+PIX       *pixd;
+
+    PROCNAME("pixPremultiplyAlpha");
+
+    if (!pixs)
+        return (PIX *)ERROR_PTR("pixs not defined", procName, NULL);
+    if (pixGetDepth(pixs) != 32 || pixGetSpp(pixs) != 4)
+        return (PIX *)ERROR_PTR("pixs not 32 bpp rgba", procName, NULL);
+
+    if ((pixd = pixCopy(NULL, pixs)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    pixGetDimensions(pixd, &w, &h, NULL);
+    data = pixGetData(pixd);
+    wpl = pixGetWpl(pixd);
+    for (i = 0; i < h; i++) {
+        line = data + i * wpl;
+        for (j = 0; j < w; j++) {
+            pixel = line[j];
+            aval = (pixel >> L_ALPHA_SHIFT) & 0xff;
+            if (aval == 255) continue;
+            rval = ((pixel >> L_RED_SHIFT) & 0xff) * aval;
+            gval = ((pixel >> L_GREEN_SHIFT) & 0xff) * aval;
+            bval = ((pixel >> L_BLUE_SHIFT) & 0xff) * aval;
+            line[j] = (((rval + 127) / 255) << L_RED_SHIFT) |
+                      (((gval + 127) / 255) << L_GREEN_SHIFT) |
+                      (((bval + 127) / 255) << L_BLUE_SHIFT) |
+                      (aval << L_ALPHA_SHIFT);
+        }
+    }
+
+    return pixd;
+}
+
+
+/*!
+ * \brief   pixBlendPremultAlpha()
+ *
+ * \param[in]    pixd [optional]; either NULL or equal to pixs1 for in-place
+ * \param[in]    pixs1 blendee, 32 bpp rgb
+ * \param[in]    pixs2 blender, 32 bpp rgba with premultiplied color
+ * \param[in]    x,y  origin [UL corner] of pixs2 relative to
+ *                    the origin of pixs1; can be < 0
+ * \return  pixd if OK; NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) For inplace operation, call it this way:
+ *            pixBlendPremultAlpha(pixs1, pixs1, pixs2, ...)
+ *          For generating a new pixd:
+ *            pixd = pixBlendPremultAlpha(NULL, pixs1, pixs2, ...)
+ *      (2) %pixs2 is typically made with pixPremultiplyAlpha().  Each
+ *          component is then blended by
+ *               p --> c + p * (255 - a) / 255
+ *          which, up to rounding, gives the same result as blending
+ *          the un-premultiplied blender with pixBlendWithGrayMask()
+ *          using its alpha component.
+ *      (3) Pixels where the blender is transparent (a = 0) or opaque
+ *          (a = 255) are not multiplied.
+ *      (4) Clipping of pixs2 to pixs1 is done once for each row.
+ *          The alpha component of pixs1 is not changed.
+ * </pre>
+ */
+PIX *
+pixBlendPremultAlpha(PIX     *pixd,
+                     PIX     *pixs1,
+                     PIX     *pixs2,
+                     l_int32  x,
+                     l_int32  y)
+{
+l_int32    i, j, w, h, wc, hc, wpld, wplc, j1, j2, inva;
+l_int32    rval, gval, bval;
+l_uint32   cval32, dval32, aval;
+l_uint32  *datad, *datac, *lined, *linec;
+
+    PROCNAME("pixBlendPremultAlpha");
+
+    if (!pixs1 || pixGetDepth(pixs1) != 32)
+        return (PIX *)ERROR_PTR("pixs1 undefined or not 32 bpp",
+                                procName, NULL);
+    if (!pixs2 || pixGetDepth(pixs2) != 32 || pixGetSpp(pixs2) != 4)
+        return (PIX *)ERROR_PTR("pixs2 undefined or not rgba", procName, NULL);
+    if (pixd && (pixd != pixs1))
+        return (PIX *)ERROR_PTR("pixd must be NULL or pixs1", procName, NULL);
+
+    if (!pixd)
+        pixd = pixCopy(NULL, pixs1);
+    pixGetDimensions(pixd, &w, &h, NULL);
+    pixGetDimensions(pixs2, &wc, &hc, NULL);
+    datad = pixGetData(pixd);
+    datac = pixGetData(pixs2);
+    wpld = pixGetWpl(pixd);
+    wplc = pixGetWpl(pixs2);
+    j1 = L_MAX(0, -x);
+    j2 = L_MIN(wc, w - x);
+    for (i = 0; i < hc; i++) {
+        if (i + y < 0  || i + y >= h) continue;
+        linec = datac + i * wplc;
+        lined = datad + (i + y) * wpld;
+        for (j = j1; j < j2; j++) {
+            cval32 = linec[j];
+            aval = (cval32 >> L_ALPHA_SHIFT) & 0xff;
+            if (aval == 0) continue;
+            dval32 = lined[j + x];
+            if (aval == 255) {
+                lined[j + x] = (cval32 & 0xffffff00) | (dval32 & 0xff);
+                continue;
+            }
+            inva = 255 - aval;
+            rval = ((cval32 >> L_RED_SHIFT) & 0xff) +
+                   (((dval32 >> L_RED_SHIFT) & 0xff) * inva + 127) / 255;
+            gval = ((cval32 >> L_GREEN_SHIFT) & 0xff) +
+                   (((dval32 >> L_GREEN_SHIFT) & 0xff) * inva + 127) / 255;
+            bval = ((cval32 >> L_BLUE_SHIFT) & 0xff) +
+                   (((dval32 >> L_BLUE_SHIFT) & 0xff) * inva + 127) / 255;
+            rval = L_MIN(255, rval);
+            gval = L_MIN(255, gval);
+            bval = L_MIN(255, bval);
+            lined[j + x] = (rval << L_RED_SHIFT) | (gval << L_GREEN_SHIFT) |
+                           (bval << L_BLUE_SHIFT) | (dval32 & 0xff);
+        }
+    }
+
+    return pixd;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                            Row blending                             *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   blendLineColor()
+ *
+ * \param[in]    lined  first dest pixel to be blended
+ * \param[in]    linec  first blender pixel, 32 bpp rgb
+ * \param[in]    n      number of pixels
+ * \param[in]    fracts fractions for the r, g and b components;
+ *                      see blendComponents()
+ * \param[in]    tabs   tables made by makeBlendTab() for the r, g and b
+ *                      components; each can be null
+ * \param[in]    transparent 1 to use transparency; 0 otherwise
+ * \param[in]    transpix pixel color in the blender that is transparent
+ * \return  void
+ */
+static void
+blendLineColor(l_uint32   *lined,
+               l_uint32   *linec,
+               l_int32     n,
+               l_float32  *fracts,
+               l_uint8   **tabs,
+               l_int32     transparent,
+               l_uint32    transpix)
+{
+l_int32   j, rval, gval, bval, rcval, gcval, bcval;
+l_uint32  cval32, val32;
+
+    for (j = 0; j < n; j++) {
+        cval32 = linec[j];
+        if (transparent &&
+            (cval32 & 0xffffff00) == (transpix & 0xffffff00))
+            continue;
+        val32 = lined[j];
+        rval = (val32 >> L_RED_SHIFT) & 0xff;
+        gval = (val32 >> L_GREEN_SHIFT) & 0xff;
+        bval = (val32 >> L_BLUE_SHIFT) & 0xff;
+        rcval = (cval32 >> L_RED_SHIFT) & 0xff;
+        gcval = (cval32 >> L_GREEN_SHIFT) & 0xff;
+        bcval = (cval32 >> L_BLUE_SHIFT) & 0xff;
+        rval = (tabs[0]) ? tabs[0][(rval << 8) | rcval] :
+                           blendComponents(rval, rcval, fracts[0]);
+        gval = (tabs[1]) ? tabs[1][(gval << 8) | gcval] :
+                           blendComponents(gval, gcval, fracts[1]);
+        bval = (tabs[2]) ? tabs[2][(bval << 8) | bcval] :
+                           blendComponents(bval, bcval, fracts[2]);
+        lined[j] = (rval << L_RED_SHIFT) | (gval << L_GREEN_SHIFT) |
+                   (bval << L_BLUE_SHIFT);
+    }
+    return;
+}
+
+
+/*!
+ * \brief   blendLineGray()
+ *
+ * \param[in]    lined  dest line; only 8 and 32 bpp are blended
+ * \param[in]    d      depth of dest
+ * \param[in]    linec  blender line, 8 bpp
+ * \param[in]    x      offset of blender in dest
+ * \param[in]    j1, j2 blend blender pixels j1 <= j < j2
+ * \param[in]    fract  blending fraction in [0.0 ... 1.0]
+ * \param[in]    tab    [optional] table made by makeBlendTab() for fract
+ * \param[in]    transparent 1 to use transparency; 0 otherwise
+ * \param[in]    transpix blender value that is transparent
+ * \return  void
+ */
+static void
+blendLineGray(l_uint32  *lined,
+              l_int32    d,
+              l_uint32  *linec,
+              l_int32    x,
+              l_int32    j1,
+              l_int32    j2,
+              l_float32  fract,
+              l_uint8   *tab,
+              l_int32    transparent,
+              l_uint32   transpix)
+{
+l_int32   j, cval, dval, rval, gval, bval;
+l_uint32  val32;
+
+    if (d == 8) {
+        for (j = j1; j < j2; j++) {
+            cval = GET_DATA_BYTE(linec, j);
+            if (transparent && cval == transpix) continue;
+            dval = GET_DATA_BYTE(lined, j + x);
+            dval = (tab) ? tab[(dval << 8) | cval] :
+                           (l_int32)((1. - fract) * dval + fract * cval);
+            SET_DATA_BYTE(lined, j + x, dval);
+        }
+    } else if (d == 32) {
+        for (j = j1; j < j2; j++) {
+            cval = GET_DATA_BYTE(linec, j);
+            if (transparent && cval == transpix) continue;
+            val32 = lined[j + x];
+            rval = (val32 >> L_RED_SHIFT) & 0xff;
+            gval = (val32 >> L_GREEN_SHIFT) & 0xff;
+            bval = (val32 >> L_BLUE_SHIFT) & 0xff;
+            if (tab) {
+                rval = tab[(rval << 8) | cval];
+                gval = tab[(gval << 8) | cval];
+                bval = tab[(bval << 8) | cval];
+            } else {
+                rval = (l_int32)((1. - fract) * rval + fract * cval);
+                gval = (l_int32)((1. - fract) * gval + fract * cval);
+                bval = (l_int32)((1. - fract) * bval + fract * cval);
+            }
+            lined[j + x] = (rval << L_RED_SHIFT) | (gval << L_GREEN_SHIFT) |
+                           (bval << L_BLUE_SHIFT);
+        }
+    }
+    return;
+}
+
+
+/*!
+ * \brief   blendLineWithMask()
+ *
+ * \param[in]    lined  dest line, 8 or 32 bpp
+ * \param[in]    d      depth of dest and blender
+ * \param[in]    lines  blender line, same depth as dest
+ * \param[in]    lineg  [optional] 8 bpp mask line; if null, the mask
+ *                      is the alpha component of the 32 bpp blender
+ * \param[in]    x      offset of blender in dest
+ * \param[in]    j1, j2 blend blender pixels j1 <= j < j2
+ * \param[in]    ftab   blending fraction m / 255 for each mask value m
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each component is blended by
+ *             p --> (l_int32)((1.0 - f) * p + f * c)
+ *          where f is looked up for the mask value.  Pixels with
+ *          mask value 0 are unchanged.
+ * </pre>
+ */
+static void
+blendLineWithMask(l_uint32   *lined,
+                  l_int32     d,
+                  l_uint32   *lines,
+                  l_uint32   *lineg,
+                  l_int32     x,
+                  l_int32     j1,
+                  l_int32     j2,
+                  l_float32  *ftab)
+{
+l_int32    j, m, dval, sval, rval, gval, bval;
+l_uint32   dval32, sval32;
+l_float32  fract;
+
+    if (d == 8) {
+        for (j = j1; j < j2; j++) {
+            m = GET_DATA_BYTE(lineg, j);
+            if (m == 0) continue;  /* blender is transparent */
+            fract = ftab[m];
+            dval = GET_DATA_BYTE(lined, j + x);
+            sval = GET_DATA_BYTE(lines, j);
+            dval = (l_int32)((1.0 - fract) * dval + fract * sval);
+            SET_DATA_BYTE(lined, j + x, dval);
+        }
+        return;
+    }
+
+    for (j = j1; j < j2; j++) {  /* d == 32 */
+        sval32 = lines[j];
+        if (lineg)
+            m = GET_DATA_BYTE(lineg, j);
+        else
+            m = (sval32 >> L_ALPHA_SHIFT) & 0xff;
+        if (m == 0) continue;  /* blender is transparent */
+        fract = ftab[m];
+        dval32 = lined[j + x];
+        rval = (l_int32)((1.0 - fract) * ((dval32 >> L_RED_SHIFT) & 0xff) +
+                         fract * ((sval32 >> L_RED_SHIFT) & 0xff));
+        gval = (l_int32)((1.0 - fract) * ((dval32 >> L_GREEN_SHIFT) & 0xff) +
+                         fract * ((sval32 >> L_GREEN_SHIFT) & 0xff));
+        bval = (l_int32)((1.0 - fract) * ((dval32 >> L_BLUE_SHIFT) & 0xff) +
+                         fract * ((sval32 >> L_BLUE_SHIFT) & 0xff));
+        lined[j + x] = (rval << L_RED_SHIFT) | (gval << L_GREEN_SHIFT) |
+                       (bval << L_BLUE_SHIFT);
+    }
+    return;
+}
+
+
+/*!
+ * \brief   makeBlendTab()
+ *
+ * \param[in]    fract  blending fraction; see blendComponents()
+ * \return  table of 256 * 256 blended components, indexed by
+ *              (a << 8) | b, or NULL on error
+ */
+static l_uint8 *
+makeBlendTab(l_float32  fract)
+{
+l_int32   a, b;
+l_uint8  *tab;
+
+    PROCNAME("makeBlendTab");
+
+    if ((tab = (l_uint8 *)LEPT_CALLOC(256 * 256, sizeof(l_uint8))) == NULL)
+        return (l_uint8 *)ERROR_PTR("tab not made", procName, NULL);
+    for (a = 0; a < 256; a++) {
+        for (b = 0; b < 256; b++)
+            tab[(a << 8) | b] = blendComponents(a, b, fract);
+    }
+    return tab;
+}
+
+
+static l_int32
+blendComponents(l_int32    a,
+                l_int32    b,
+                l_float32  fract)
+{
+    if (fract < 0.)
+        return ((a < b) ? a : b);
+    if (fract > 1.)
+        return ((a > b) ? a : b);
+    return (l_int32)((1. - fract) * a + fract * b);
+}
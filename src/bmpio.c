@@ -31,17 +31,23 @@
  *      Read bmp from file
  *           PIX          *pixReadStreamBmp()
  *
+ *      Read bmp header
+ *           l_int32       freadHeaderBmp()
+ *           l_int32       readHeaderMemBmp()
+ *
  *      Write bmp to file
  *           l_int32       pixWriteStreamBmp()
  *
  *      Read/write to memory
  *           PIX          *pixReadMemBmp()
  *           l_int32       pixWriteMemBmp()
+ *           static void   setLittleEndian16()
+ *           static void   setLittleEndian32()
  *
- *    On systems like windows without fmemopen() and open_memstream(),
- *    we write data to a temp file and read it back for operations
- *    between pix and compressed-data, such as pixReadMemPng() and
- *    pixWriteMemPng().
+ *    The bmp data is encoded and decoded in memory.  The stream
+ *    functions read the whole stream into memory, or write the
+ *    encoded data to it, so they don't need fmemopen(),
+ *    open_memstream() or a temp file.
  * </pre>
  */
 
@@ -71,9 +77,9 @@ static const l_int32  L_MAX_ALLOWED_WIDTH = 1000000;
 static const l_int32  L_MAX_ALLOWED_HEIGHT = 1000000;
 static const l_int64  L_MAX_ALLOWED_AREA = 400000000LL;
 
-#ifndef  NO_CONSOLE_IO
-#define  DEBUG     0
-#endif  /* ~NO_CONSOLE_IO */
+    /* Static functions */
+static void setLittleEndian16(l_uint8 *data, l_uint32 val);
+static void setLittleEndian32(l_uint8 *data, l_uint32 val);
 
 
 /*!
@@ -87,102 +93,266 @@ static const l_int64  L_MAX_ALLOWED_AREA = 400000000LL;
  *      (1) Here are references on the bmp file format:
  *          http://en.wikipedia.org/wiki/BMP_file_format
  *          http://www.fortunecity.com/skyscraper/windows/364/bmpffrmt.html
+ *      (2) The stream is read into memory and decoded with
+ *          pixReadMemBmp().
  * </pre>
  */
 PIX *
 pixReadStreamBmp(FILE  *fp)
 {
-l_uint16   sval;
-l_uint32   ival;
-l_int16    bfType, bfSize, bfFill1, bfReserved1, bfReserved2;
-l_int16    offset, bfFill2, biPlanes, depth, d;
-l_int32    biSize, width, height, xres, yres, compression;
-l_int32    imagebytes, biClrUsed, biClrImportant;
-size_t     filesize;
-l_uint8   *colormapBuf;
-l_int32    colormapEntries;
-l_int32    fileBpl, extrabytes;
-l_int32    pixWpl, pixBpl;
-l_int32    i, j, k;
-l_int64    area;
-l_uint8    pel[4];
-l_uint8   *data;
-l_uint32  *line, *pword;
-PIX        *pix, *pixt;
-PIXCMAP   *cmap;
+l_uint8  *data;
+size_t    size;
+PIX      *pix;
 
     PROCNAME("pixReadStreamBmp");
 
     if (!fp)
         return (PIX *)ERROR_PTR("fp not defined", procName, NULL);
 
-        /* Read bitmap file header */
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 1 not read", procName, NULL);
-    bfType = convertOnBigEnd16(sval);
-    if (bfType != BMP_ID)
-        return (PIX *)ERROR_PTR("not bmf format", procName, NULL);
+    if ((data = l_binaryReadStream(fp, &size)) == NULL)
+        return (PIX *)ERROR_PTR("data not read", procName, NULL);
+    pix = pixReadMemBmp(data, size);
+    LEPT_FREE(data);
+    return pix;
+}
+
+/*!
+ * \brief   freadHeaderBmp()
+ *
+ * \param[in]    fp file stream opened for read
+ * \param[out]   pw, ph [optional] width and height
+ * \param[out]   pbps [optional] bits/sample
+ * \param[out]   pspp [optional] samples/pixel
+ * \param[out]   pres [optional] resolution in x direction, in ppi
+ * \param[out]   piscmap [optional] 1 if the pix will have a cmap
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This reads only the two fixed-size bmp headers, and returns
+ *          the values that pixReadStreamBmp() would give the pix.
+ *          The stream is read from its current position.
+ *      (2) A 24 bpp file gives a 32 bpp rgb pix, with bps = 8 and
+ *          spp = 3.  A 1 bpp file with a colormap gives a pix without
+ *          a colormap.
+ * </pre>
+ */
+l_int32
+freadHeaderBmp(FILE     *fp,
+               l_int32  *pw,
+               l_int32  *ph,
+               l_int32  *pbps,
+               l_int32  *pspp,
+               l_int32  *pres,
+               l_int32  *piscmap)
+{
+l_uint8  data[BMP_FHBYTES + BMP_IHBYTES];
+
+    PROCNAME("freadHeaderBmp");
+
+    if (pw) *pw = 0;
+    if (ph) *ph = 0;
+    if (pbps) *pbps = 0;
+    if (pspp) *pspp = 0;
+    if (pres) *pres = 0;
+    if (piscmap) *piscmap = 0;
+    if (!fp)
+        return ERROR_INT("stream not defined", procName, 1);
+
+    if (fread(data, 1, sizeof(data), fp) != sizeof(data))
+        return ERROR_INT("headers not read", procName, 1);
+    return readHeaderMemBmp(data, sizeof(data), pw, ph, pbps, pspp,
+                            pres, piscmap);
+}
 
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 2 not read", procName, NULL);
-    bfSize = convertOnBigEnd16(sval);
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 3 not read", procName, NULL);
-    bfFill1 = convertOnBigEnd16(sval);
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 4 not read", procName, NULL);
-    bfReserved1 = convertOnBigEnd16(sval);
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 5 not read", procName, NULL);
-    bfReserved2 = convertOnBigEnd16(sval);
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 6 not read", procName, NULL);
-    offset = convertOnBigEnd16(sval);
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 7 not read", procName, NULL);
-    bfFill2 = convertOnBigEnd16(sval);
-
-        /* Read bitmap info header */
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 8 not read", procName, NULL);
-    biSize = convertOnBigEnd32(ival);
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 9 not read", procName, NULL);
-    width = convertOnBigEnd32(ival);
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 10 not read", procName, NULL);
-    height = convertOnBigEnd32(ival);
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 11 not read", procName, NULL);
-    biPlanes = convertOnBigEnd16(sval);
-    if (fread((char *)&sval, 2, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 12 not read", procName, NULL);
-    depth = convertOnBigEnd16(sval);
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 13 not read", procName, NULL);
-    compression = convertOnBigEnd32(ival);
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 14 not read", procName, NULL);
-    imagebytes = convertOnBigEnd32(ival);
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 15 not read", procName, NULL);
-    xres = convertOnBigEnd32(ival);
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 16 not read", procName, NULL);
-    yres = convertOnBigEnd32(ival);
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 17 not read", procName, NULL);
-    biClrUsed = convertOnBigEnd32(ival);
-    if (fread((char *)&ival, 4, 1, fp) != 1)
-        return (PIX *)ERROR_PTR("item 18 not read", procName, NULL);
-    biClrImportant = convertOnBigEnd32(ival);
+
+/*!
+ * \brief   readHeaderMemBmp()
+ *
+ * \param[in]    data bmp compressed
+ * \param[in]    size at least the size of the two bmp headers
+ * \param[out]   pw, ph [optional] width and height
+ * \param[out]   pbps [optional] bits/sample
+ * \param[out]   pspp [optional] samples/pixel
+ * \param[out]   pres [optional] resolution in x direction, in ppi
+ * \param[out]   piscmap [optional] 1 if the pix will have a cmap
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) See freadHeaderBmp().  The header fields are little-endian
+ *          and are assembled byte by byte, so this is independent
+ *          of the platform byte order.
+ * </pre>
+ */
+l_int32
+readHeaderMemBmp(const l_uint8  *data,
+                 size_t          size,
+                 l_int32        *pw,
+                 l_int32        *ph,
+                 l_int32        *pbps,
+                 l_int32        *pspp,
+                 l_int32        *pres,
+                 l_int32        *piscmap)
+{
+l_int32  offset, width, height, depth, compression, xres, ncolors;
+
+    PROCNAME("readHeaderMemBmp");
+
+    if (pw) *pw = 0;
+    if (ph) *ph = 0;
+    if (pbps) *pbps = 0;
+    if (pspp) *pspp = 0;
+    if (pres) *pres = 0;
+    if (piscmap) *piscmap = 0;
+    if (!data)
+        return ERROR_INT("data not defined", procName, 1);
+    if (size < BMP_FHBYTES + BMP_IHBYTES)
+        return ERROR_INT("size too small for bmp headers", procName, 1);
+
+    if ((data[0] | (data[1] << 8)) != BMP_ID)
+        return ERROR_INT("not bmf format", procName, 1);
+    offset = data[10] | (data[11] << 8);
+    width = data[18] | (data[19] << 8) | (data[20] << 16) |
+            ((l_uint32)data[21] << 24);
+    height = data[22] | (data[23] << 8) | (data[24] << 16) |
+             ((l_uint32)data[25] << 24);
+    depth = data[28] | (data[29] << 8);
+    compression = data[30] | (data[31] << 8) | (data[32] << 16) |
+                  ((l_uint32)data[33] << 24);
+    xres = data[38] | (data[39] << 8) | (data[40] << 16) |
+           ((l_uint32)data[41] << 24);
+
+    if (compression != 0)
+        return ERROR_INT("cannot read compressed BMP files", procName, 1);
+    if (width < 1 || width > L_MAX_ALLOWED_WIDTH)
+        return ERROR_INT("invalid width", procName, 1);
+    if (height < 1 || height > L_MAX_ALLOWED_HEIGHT)
+        return ERROR_INT("invalid height", procName, 1);
+    if (depth != 1 && depth != 2 && depth != 4 && depth != 8 &&
+        depth != 16 && depth != 24 && depth != 32)
+        return ERROR_INT("depth not in {1, 2, 4, 8, 16, 24, 32}", procName, 1);
+    ncolors = (offset - (l_int32)BMP_FHBYTES - (l_int32)BMP_IHBYTES) /
+              (l_int32)sizeof(RGBA_QUAD);
+    if (ncolors < 0 || ncolors == 1 || ncolors > L_MAX_ALLOWED_NUM_COLORS)
+        return ERROR_INT("invalid cmap size", procName, 1);
+
+    if (pw) *pw = width;
+    if (ph) *ph = height;
+    if (pbps) *pbps = (depth == 24 || depth == 32) ? 8 : depth;
+    if (pspp) *pspp = (depth == 24 || depth == 32) ? 3 : 1;
+    if (pres) *pres = (l_int32)((l_float32)xres / 39.37 + 0.5);
+    if (piscmap) *piscmap = (ncolors > 0 && depth > 1) ? 1 : 0;
+    return 0;
+}
+
+
+
+/*!
+ * \brief   pixWriteStreamBmp()
+ *
+ * \param[in]    fp file stream opened for write
+ * \param[in]    pix 1, 4, 8, 32 bpp
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) We position fp at the beginning of the stream, so it
+ *          truncates any existing data
+ *      (2) The data is encoded in memory with pixWriteMemBmp().
+ * </pre>
+ */
+l_int32
+pixWriteStreamBmp(FILE  *fp,
+                  PIX   *pix)
+{
+l_uint8  *data;
+size_t    size, nbytes;
+
+    PROCNAME("pixWriteStreamBmp");
+
+    if (!fp)
+        return ERROR_INT("stream not defined", procName, 1);
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 1);
+
+    if (pixWriteMemBmp(&data, &size, pix))
+        return ERROR_INT("bmp data not made", procName, 1);
+    fseek(fp, 0L, 0);
+    nbytes = fwrite(data, 1, size, fp);
+    LEPT_FREE(data);
+    if (nbytes != size)
+        return ERROR_INT("image write fail", procName, 1);
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                         Read/write to memory                        *
+ *---------------------------------------------------------------------*/
+
+/*!
+ * \brief   pixReadMemBmp()
+ *
+ * \param[in]    cdata const; bmp-encoded
+ * \param[in]    size of data
+ * \return  pix, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The header fields are little-endian and are assembled
+ *          byte by byte, as in readHeaderMemBmp().
+ *      (2) The colormap follows the two headers, and the image data
+ *          starts at the offset given in the file header.  The data
+ *          is checked to hold every row before the pix is made.
+ * </pre>
+ */
+PIX *
+pixReadMemBmp(const l_uint8  *cdata,
+              size_t          size)
+{
+const l_uint8  *fdata;
+l_uint8        *data, *colormapBuf;
+l_int32         offset, depth, d, width, height, xres, yres;
+l_int32         compression, imagebytes;
+l_int32         colormapEntries, fileBpl, extrabytes;
+l_int32         pixWpl, pixBpl, i, j;
+l_int64         area;
+l_uint32       *line, *pword;
+PIX            *pix, *pixt;
+PIXCMAP        *cmap;
+
+    PROCNAME("pixReadMemBmp");
+
+    if (!cdata)
+        return (PIX *)ERROR_PTR("cdata not defined", procName, NULL);
+    if (size < BMP_FHBYTES + BMP_IHBYTES)
+        return (PIX *)ERROR_PTR("bmf headers not read", procName, NULL);
+
+        /* Bitmap file header and bitmap info header */
+    if ((cdata[0] | (cdata[1] << 8)) != BMP_ID)
+        return (PIX *)ERROR_PTR("not bmf format", procName, NULL);
+    offset = cdata[10] | (cdata[11] << 8);
+    width = cdata[18] | (cdata[19] << 8) | (cdata[20] << 16) |
+            ((l_uint32)cdata[21] << 24);
+    height = cdata[22] | (cdata[23] << 8) | (cdata[24] << 16) |
+             ((l_uint32)cdata[25] << 24);
+    depth = cdata[28] | (cdata[29] << 8);
+    compression = cdata[30] | (cdata[31] << 8) | (cdata[32] << 16) |
+                  ((l_uint32)cdata[33] << 24);
+    imagebytes = cdata[34] | (cdata[35] << 8) | (cdata[36] << 16) |
+                 ((l_uint32)cdata[37] << 24);
+    xres = cdata[38] | (cdata[39] << 8) | (cdata[40] << 16) |
+           ((l_uint32)cdata[41] << 24);
+    yres = cdata[42] | (cdata[43] << 8) | (cdata[44] << 16) |
+           ((l_uint32)cdata[45] << 24);
 
     if (compression != 0)
         return (PIX *)ERROR_PTR("cannot read compressed BMP files",
                                 procName, NULL);
 
         /* Some sanity checking.  We impose limits on the image
-         * dimensions and number of pixels.  We make sure the file
+         * dimensions and number of pixels.  We make sure the data
          * is large enough to hold the amount of uncompressed data
          * that is specified in the header.  The number of colormap
          * entries is checked: it can be either 0 (no cmap) or some
@@ -208,14 +378,15 @@ PIXCMAP   *cmap;
     fileBpl = 4 * ((1LL * width * depth + 31)/32);
     if (imagebytes != 0 && imagebytes != fileBpl * height)
         return (PIX *)ERROR_PTR("invalid imagebytes", procName, NULL);
-    colormapEntries = (offset - BMP_FHBYTES - BMP_IHBYTES) / sizeof(RGBA_QUAD);
+    colormapEntries = (offset - (l_int32)BMP_FHBYTES - (l_int32)BMP_IHBYTES) /
+                      (l_int32)sizeof(RGBA_QUAD);
     if (colormapEntries < 0 || colormapEntries == 1)
         return (PIX *)ERROR_PTR("invalid: cmap size < 0 or 1", procName, NULL);
     if (colormapEntries > L_MAX_ALLOWED_NUM_COLORS)
         return (PIX *)ERROR_PTR("invalid cmap: too large", procName,NULL);
-    filesize = fnbytesInFile(fp);
-    if (filesize < 1LL * fileBpl * height)
-        return (PIX *)ERROR_PTR("file too small to hold data", procName,NULL);
+    if (size < (size_t)offset + 1LL * fileBpl * height)
+        return (PIX *)ERROR_PTR("data too small to hold image",
+                                procName, NULL);
 
         /* Handle the colormap */
     colormapBuf = NULL;
@@ -223,13 +394,8 @@ PIXCMAP   *cmap;
         if ((colormapBuf = (l_uint8 *)LEPT_CALLOC(colormapEntries,
                                              sizeof(RGBA_QUAD))) == NULL)
             return (PIX *)ERROR_PTR("colormapBuf alloc fail", procName, NULL );
-
-            /* Read colormap */
-        if (fread(colormapBuf, sizeof(RGBA_QUAD), colormapEntries, fp)
-                 != colormapEntries) {
-            LEPT_FREE(colormapBuf);
-            return (PIX *)ERROR_PTR( "colormap read fail", procName, NULL);
-        }
+        memcpy(colormapBuf, cdata + BMP_FHBYTES + BMP_IHBYTES,
+               colormapEntries * sizeof(RGBA_QUAD));
     }
 
         /* Make a 32 bpp pix if depth is 24 bpp */
@@ -255,16 +421,13 @@ PIXCMAP   *cmap;
     }
     pixSetColormap(pix, cmap);
 
-        /* Seek to the start of the image data in the file */
-    fseek(fp, offset, 0);
-
+        /* The image data starts at %offset; the rows are bottom up */
+    fdata = cdata + offset;
     if (depth != 24) {  /* typ. 1 or 8 bpp */
         data = (l_uint8 *)pixGetData(pix) + pixBpl * (height - 1);
         for (i = 0; i < height; i++) {
-            if (fread(data, 1, fileBpl, fp) != fileBpl) {
-                pixDestroy(&pix);
-                return (PIX *)ERROR_PTR("BMP read fail", procName, NULL);
-            }
+            memcpy(data, fdata, fileBpl);
+            fdata += fileBpl;
             data -= pixBpl;
         }
     } else {  /*  24 bpp file; 32 bpp pix
@@ -309,23 +472,12 @@ PIXCMAP   *cmap;
         for (i = 0; i < height; i++) {
             for (j = 0; j < width; j++) {
                 pword = line + j;
-                if (fread(&pel, 1, 3, fp) != 3) {
-                    pixDestroy(&pix);
-                    return (PIX *)ERROR_PTR("bmp(1) read fail", procName, NULL);
-                }
-                *((l_uint8 *)pword + COLOR_RED) = pel[2];
-                *((l_uint8 *)pword + COLOR_GREEN) = pel[1];
-                *((l_uint8 *)pword + COLOR_BLUE) = pel[0];
-            }
-            if (extrabytes) {
-                for (k = 0; k < extrabytes; k++) {
-                    if (fread(&pel, 1, 1, fp) != 1) {
-                        pixDestroy(&pix);
-                        return (PIX *)ERROR_PTR("bmp(2) read fail",
-                                                procName, NULL);
-                    }
-                }
+                *((l_uint8 *)pword + COLOR_RED) = fdata[2];
+                *((l_uint8 *)pword + COLOR_GREEN) = fdata[1];
+                *((l_uint8 *)pword + COLOR_BLUE) = fdata[0];
+                fdata += 3;
             }
+            fdata += extrabytes;
             line -= pixWpl;
         }
     }
@@ -352,56 +504,53 @@ PIXCMAP   *cmap;
 }
 
 
-
 /*!
- * \brief   pixWriteStreamBmp()
+ * \brief   pixWriteMemBmp()
  *
- * \param[in]    fp file stream opened for write
- * \param[in]    pix 1, 4, 8, 32 bpp
+ * \param[out]   pfdata data of bmp formatted image
+ * \param[out]   pfsize size of returned data
+ * \param[in]    pix 1, 2, 4, 8, 16, 32 bpp
  * \return  0 if OK, 1 on error
  *
  * <pre>
  * Notes:
- *      (1) We position fp at the beginning of the stream, so it
- *          truncates any existing data
- *      (2) 2 bpp Bmp files are apparently not valid!.  We can
+ *      (1) 2 bpp bmp files are apparently not valid!.  We can
  *          write and read them, but nobody else can read ours.
+ *      (2) The header fields are written little-endian, byte by byte.
+ *          The row padding is zero.
  * </pre>
  */
 l_int32
-pixWriteStreamBmp(FILE  *fp,
-                  PIX   *pix)
+pixWriteMemBmp(l_uint8  **pfdata,
+               size_t    *pfsize,
+               PIX       *pix)
 {
-l_uint32    offbytes, filebytes, fileimagebytes;
+l_uint8    *fdata, *fmdata, *data;
+l_uint8    *cta;          /* address of the bmp color table array */
+l_int32     cmaplen;      /* number of bytes in the bmp colormap */
+l_int32     ncolors, val, stepsize;
 l_int32     width, height, depth, d, xres, yres;
-l_uint16    bfType, bfSize, bfFill1, bfReserved1, bfReserved2;
-l_uint16    bfOffBits, bfFill2, biPlanes, biBitCount;
-l_uint16    sval;
-l_uint32    biSize, biWidth, biHeight, biCompression, biSizeImage;
-l_uint32    biXPelsPerMeter, biYPelsPerMeter, biClrUsed, biClrImportant;
-l_int32     pixWpl, pixBpl, extrabytes, writeerror;
-l_int32     fileBpl, fileWpl;
-l_int32     i, j, k;
+l_int32     pixWpl, pixBpl, extrabytes, fileBpl, fileWpl;
+l_int32     i, j;
 l_int32     heapcm;  /* extra copy of cta on the heap ? 1 : 0 */
-l_uint8    *data;
-l_uint8     pel[4];
+l_uint32    offbytes, fileimagebytes;
+size_t      fsize;
 l_uint32   *line, *pword;
 PIXCMAP    *cmap;
-l_uint8    *cta;          /* address of the bmp color table array */
-l_int32     cmaplen;      /* number of bytes in the bmp colormap */
-l_int32     ncolors, val, stepsize;
 RGBA_QUAD  *pquad;
 
-    PROCNAME("pixWriteStreamBmp");
+    PROCNAME("pixWriteMemBmp");
 
-    if (!fp)
-        return ERROR_INT("stream not defined", procName, 1);
+    if (pfdata) *pfdata = NULL;
+    if (pfsize) *pfsize = 0;
+    if (!pfdata)
+        return ERROR_INT("&fdata not defined", procName, 1 );
+    if (!pfsize)
+        return ERROR_INT("&fsize not defined", procName, 1 );
     if (!pix)
         return ERROR_INT("pix not defined", procName, 1);
 
-    width  = pixGetWidth(pix);
-    height = pixGetHeight(pix);
-    d  = pixGetDepth(pix);
+    pixGetDimensions(pix, &width, &height, &d);
     if (d == 2)
         L_WARNING("writing 2 bpp bmp file; nobody else can read\n", procName);
     depth = d;
@@ -417,6 +566,8 @@ RGBA_QUAD  *pquad;
     fileimagebytes = height * fileBpl;
 
     heapcm = 0;
+    cmap = NULL;
+    cta = NULL;
     if (d == 32) {   /* 24 bpp rgb; no colormap */
         ncolors = 0;
         cmaplen = 0;
@@ -444,70 +595,31 @@ RGBA_QUAD  *pquad;
         }
     }
 
-#if DEBUG
-    {l_uint8  *pcmptr;
-        pcmptr = (l_uint8 *)pixGetColormap(pix)->array;
-        fprintf(stderr, "Pix colormap[0] = %c%c%c%d\n",
-            pcmptr[0], pcmptr[1], pcmptr[2], pcmptr[3]);
-        fprintf(stderr, "Pix colormap[1] = %c%c%c%d\n",
-            pcmptr[4], pcmptr[5], pcmptr[6], pcmptr[7]);
+    offbytes = BMP_FHBYTES + BMP_IHBYTES + cmaplen;
+    fsize = offbytes + fileimagebytes;
+    if ((fdata = (l_uint8 *)LEPT_CALLOC(fsize, 1)) == NULL) {
+        if (heapcm) LEPT_FREE(cta);
+        return ERROR_INT("fdata not made", procName, 1);
     }
-#endif  /* DEBUG */
 
-    fseek(fp, 0L, 0);
-
-        /* Convert to little-endian and write the file header data */
-    bfType = convertOnBigEnd16(BMP_ID);
-    offbytes = BMP_FHBYTES + BMP_IHBYTES + cmaplen;
-    filebytes = offbytes + fileimagebytes;
-    sval = filebytes & 0x0000ffff;
-    bfSize = convertOnBigEnd16(sval);
-    sval = (filebytes >> 16) & 0x0000ffff;
-    bfFill1 = convertOnBigEnd16(sval);
-    bfReserved1 = 0;
-    bfReserved2 = 0;
-    sval = offbytes & 0x0000ffff;
-    bfOffBits = convertOnBigEnd16(sval);
-    sval = (offbytes >> 16) & 0x0000ffff;
-    bfFill2 = convertOnBigEnd16(sval);
-    fwrite(&bfType, 1, 2, fp);
-    fwrite(&bfSize, 1, 2, fp);
-    fwrite(&bfFill1, 1, 2, fp);
-    fwrite(&bfReserved1, 1, 2, fp);
-    fwrite(&bfReserved2, 1, 2, fp);
-    fwrite(&bfOffBits, 1, 2, fp);
-    fwrite(&bfFill2, 1, 2, fp);
-
-        /* Convert to little-endian and write the info header data */
-    biSize = convertOnBigEnd32(BMP_IHBYTES);
-    biWidth = convertOnBigEnd32(width);
-    biHeight = convertOnBigEnd32(height);
-    biPlanes = convertOnBigEnd16(1);
-    biBitCount = convertOnBigEnd16(depth);
-    biCompression   = 0;
-    biSizeImage = convertOnBigEnd32(fileimagebytes);
-    biXPelsPerMeter = convertOnBigEnd32(xres);
-    biYPelsPerMeter = convertOnBigEnd32(yres);
-    biClrUsed = convertOnBigEnd32(ncolors);
-    biClrImportant = convertOnBigEnd32(ncolors);
-    fwrite(&biSize, 1, 4, fp);
-    fwrite(&biWidth, 1, 4, fp);
-    fwrite(&biHeight, 1, 4, fp);
-    fwrite(&biPlanes, 1, 2, fp);
-    fwrite(&biBitCount, 1, 2, fp);
-    fwrite(&biCompression, 1, 4, fp);
-    fwrite(&biSizeImage, 1, 4, fp);
-    fwrite(&biXPelsPerMeter, 1, 4, fp);
-    fwrite(&biYPelsPerMeter, 1, 4, fp);
-    fwrite(&biClrUsed, 1, 4, fp);
-    fwrite(&biClrImportant, 1, 4, fp);
-
-        /* Write the colormap data and free the cta if necessary */
+        /* File header, then info header; unset fields are 0 */
+    setLittleEndian16(fdata, BMP_ID);
+    setLittleEndian32(fdata + 2, fsize);
+    setLittleEndian32(fdata + 10, offbytes);
+    setLittleEndian32(fdata + 14, BMP_IHBYTES);
+    setLittleEndian32(fdata + 18, width);
+    setLittleEndian32(fdata + 22, height);
+    setLittleEndian16(fdata + 26, 1);  /* planes */
+    setLittleEndian16(fdata + 28, depth);
+    setLittleEndian32(fdata + 34, fileimagebytes);
+    setLittleEndian32(fdata + 38, xres);
+    setLittleEndian32(fdata + 42, yres);
+    setLittleEndian32(fdata + 46, ncolors);
+    setLittleEndian32(fdata + 50, ncolors);
+
+        /* Copy the colormap data and free the cta if necessary */
     if (ncolors > 0) {
-        if (fwrite(cta, 1, cmaplen, fp) != cmaplen) {
-            if (heapcm) LEPT_FREE(cta);
-            return ERROR_INT("colormap write fail", procName, 1);
-        }
+        memcpy(fdata + BMP_FHBYTES + BMP_IHBYTES, cta, cmaplen);
         if (heapcm) LEPT_FREE(cta);
     }
 
@@ -519,16 +631,16 @@ RGBA_QUAD  *pquad;
 
     pixEndianByteSwap(pix);
 
-    writeerror = 0;
+    fmdata = fdata + offbytes;
     if (depth != 24) {   /* typ 1 or 8 bpp */
         data = (l_uint8 *)pixGetData(pix) + pixBpl * (height - 1);
         for (i = 0; i < height; i++) {
-            if (fwrite(data, 1, fileBpl, fp) != fileBpl)
-                writeerror = 1;
+            memcpy(fmdata, data, fileBpl);
+            fmdata += fileBpl;
             data -= pixBpl;
         }
     } else {  /* 32 bpp pix; 24 bpp file
-             * See the comments in pixReadStreamBMP() to
+             * See the comments in pixReadMemBmp() to
              * understand the logic behind the pixel ordering below.
              * Note that we have again done an endian swap on
              * little endian machines before arriving here, so that
@@ -541,16 +653,12 @@ RGBA_QUAD  *pquad;
         for (i = 0; i < height; i++) {
             for (j = 0; j < width; j++) {
                 pword = line + j;
-                pel[2] = *((l_uint8 *)pword + COLOR_RED);
-                pel[1] = *((l_uint8 *)pword + COLOR_GREEN);
-                pel[0] = *((l_uint8 *)pword + COLOR_BLUE);
-                if (fwrite(&pel, 1, 3, fp) != 3)
-                    writeerror = 1;
-            }
-            if (extrabytes) {
-                for (k = 0; k < extrabytes; k++)
-                    fwrite(&pel, 1, 1, fp);
+                fmdata[2] = *((l_uint8 *)pword + COLOR_RED);
+                fmdata[1] = *((l_uint8 *)pword + COLOR_GREEN);
+                fmdata[0] = *((l_uint8 *)pword + COLOR_BLUE);
+                fmdata += 3;
             }
+            fmdata += extrabytes;
             line -= pixWpl;
         }
     }
@@ -560,100 +668,43 @@ RGBA_QUAD  *pquad;
     if (depth == 1 && cmap && ((l_uint8 *)(cmap->array))[0] == 0x0)
         pixInvert(pix, pix);
 
-    if (writeerror)
-        return ERROR_INT("image write fail", procName, 1);
-
+    *pfdata = fdata;
+    *pfsize = fsize;
     return 0;
 }
 
 
-/*---------------------------------------------------------------------*
- *                         Read/write to memory                        *
- *---------------------------------------------------------------------*/
-
 /*!
- * \brief   pixReadMemBmp()
- *
- * \param[in]    data const; bmp-encoded
- * \param[in]    size of data
- * \return  pix, or NULL on error
+ * \brief   setLittleEndian16()
  *
- * <pre>
- * Notes:
- *      (1) The %size byte of %data must be a null character.
- * </pre>
+ * \param[in]    data location of the field
+ * \param[in]    val low 16 bits are written, low byte first
+ * \return  void
  */
-PIX *
-pixReadMemBmp(const l_uint8  *data,
-              size_t          size)
+static void
+setLittleEndian16(l_uint8   *data,
+                  l_uint32   val)
 {
-FILE  *fp;
-PIX   *pix;
-
-    PROCNAME("pixReadMemBmp");
-
-    if (!data)
-        return (PIX *)ERROR_PTR("data not defined", procName, NULL);
-
-    if ((fp = fopenReadFromMemory(data, size)) == NULL)
-        return (PIX *)ERROR_PTR("stream not opened", procName, NULL);
-    pix = pixReadStreamBmp(fp);
-    fclose(fp);
-    if (!pix) L_ERROR("pix not read\n", procName);
-    return pix;
+    data[0] = val & 0xff;
+    data[1] = (val >> 8) & 0xff;
 }
 
 
 /*!
- * \brief   pixWriteMemBmp()
- *
- * \param[out]   pdata data of tiff compressed image
- * \param[out]   psize size of returned data
- * \param[in]    pix
- * \return  0 if OK, 1 on error
+ * \brief   setLittleEndian32()
  *
- * <pre>
- * Notes:
- *      (1) See pixWriteStreamBmp() for usage.  This version writes to
- *          memory instead of to a file stream.
- * </pre>
+ * \param[in]    data location of the field
+ * \param[in]    val written low byte first
+ * \return  void
  */
-l_int32
-pixWriteMemBmp(l_uint8  **pdata,
-               size_t    *psize,
-               PIX       *pix)
+static void
+setLittleEndian32(l_uint8   *data,
+                  l_uint32   val)
 {
-l_int32  ret;
-FILE    *fp;
-
-    PROCNAME("pixWriteMemBmp");
-
-    if (!pdata)
-        return ERROR_INT("&data not defined", procName, 1 );
-    if (!psize)
-        return ERROR_INT("&size not defined", procName, 1 );
-    if (!pix)
-        return ERROR_INT("&pix not defined", procName, 1 );
-
-#if HAVE_FMEMOPEN
-    if ((fp = open_memstream((char **)pdata, psize)) == NULL)
-        return ERROR_INT("stream not opened", procName, 1);
-    ret = pixWriteStreamBmp(fp, pix);
-#else
-    L_INFO("work-around: writing to a temp file\n", procName);
-  #ifdef _WIN32
-    if ((fp = fopenWriteWinTempfile()) == NULL)
-        return ERROR_INT("tmpfile stream not opened", procName, 1);
-  #else
-    if ((fp = tmpfile()) == NULL)
-        return ERROR_INT("tmpfile stream not opened", procName, 1);
-  #endif  /* _WIN32 */
-    ret = pixWriteStreamBmp(fp, pix);
-    rewind(fp);
-    *pdata = l_binaryReadStream(fp, psize);
-#endif  /* HAVE_FMEMOPEN */
-    fclose(fp);
-    return ret;
+    data[0] = val & 0xff;
+    data[1] = (val >> 8) & 0xff;
+    data[2] = (val >> 16) & 0xff;
+    data[3] = (val >> 24) & 0xff;
 }
 
 
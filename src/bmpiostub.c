@@ -45,6 +45,23 @@ PIX * pixReadStreamBmp(FILE *fp)
 
 /* ----------------------------------------------------------------------*/
 
+l_int32 freadHeaderBmp(FILE *fp, l_int32 *pw, l_int32 *ph, l_int32 *pbps,
+                       l_int32 *pspp, l_int32 *pres, l_int32 *piscmap)
+{
+    return ERROR_INT("function not present", "freadHeaderBmp", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 readHeaderMemBmp(const l_uint8 *data, size_t size, l_int32 *pw,
+                         l_int32 *ph, l_int32 *pbps, l_int32 *pspp,
+                         l_int32 *pres, l_int32 *piscmap)
+{
+    return ERROR_INT("function not present", "readHeaderMemBmp", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 pixWriteStreamBmp(FILE *fp, PIX *pix)
 {
     return ERROR_INT("function not present", "pixWriteStreamBmp", 1);
@@ -683,11 +683,8 @@ pixLinearMapToTargetColor(PIX      *pixd,
                           l_uint32  srcval,
                           l_uint32  dstval)
 {
-l_int32    i, j, w, h, wpl;
-l_int32    rval, gval, bval, rsval, gsval, bsval, rdval, gdval, bdval;
-l_int32   *rtab, *gtab, *btab;
-l_uint32   pixel;
-l_uint32  *line, *data;
+l_int32  i, rval, gval, bval, rsval, gsval, bsval, rdval, gdval, bdval;
+NUMA    *nar, *nag, *nab;
 
     PROCNAME("pixLinearMapToTargetColor");
 
@@ -707,39 +704,31 @@ l_uint32  *line, *data;
     rsval = L_MIN(254, L_MAX(1, rsval));
     gsval = L_MIN(254, L_MAX(1, gsval));
     bsval = L_MIN(254, L_MAX(1, bsval));
-    rtab = (l_int32 *)LEPT_CALLOC(256, sizeof(l_int32));
-    gtab = (l_int32 *)LEPT_CALLOC(256, sizeof(l_int32));
-    btab = (l_int32 *)LEPT_CALLOC(256, sizeof(l_int32));
+    nar = numaCreate(256);
+    nag = numaCreate(256);
+    nab = numaCreate(256);
     for (i = 0; i < 256; i++) {
         if (i <= rsval)
-            rtab[i] = (i * rdval) / rsval;
+            rval = (i * rdval) / rsval;
         else
-            rtab[i] = rdval + ((255 - rdval) * (i - rsval)) / (255 - rsval);
+            rval = rdval + ((255 - rdval) * (i - rsval)) / (255 - rsval);
         if (i <= gsval)
-            gtab[i] = (i * gdval) / gsval;
+            gval = (i * gdval) / gsval;
         else
-            gtab[i] = gdval + ((255 - gdval) * (i - gsval)) / (255 - gsval);
+            gval = gdval + ((255 - gdval) * (i - gsval)) / (255 - gsval);
         if (i <= bsval)
-            btab[i] = (i * bdval) / bsval;
+            bval = (i * bdval) / bsval;
         else
-            btab[i] = bdval + ((255 - bdval) * (i - bsval)) / (255 - bsval);
-    }
-    pixGetDimensions(pixd, &w, &h, NULL);
-    data = pixGetData(pixd);
-    wpl = pixGetWpl(pixd);
-    for (i = 0; i < h; i++) {
-        line = data + i * wpl;
-        for (j = 0; j < w; j++) {
-            pixel = line[j];
-            extractRGBValues(pixel, &rval, &gval, &bval);
-            composeRGBPixel(rtab[rval], gtab[gval], btab[bval], &pixel);
-            line[j] = pixel;
-        }
+            bval = bdval + ((255 - bdval) * (i - bsval)) / (255 - bsval);
+        numaAddNumber(nar, rval);
+        numaAddNumber(nag, gval);
+        numaAddNumber(nab, bval);
     }
+    pixTRCMapGeneral(pixd, NULL, nar, nag, nab);
 
-    LEPT_FREE(rtab);
-    LEPT_FREE(gtab);
-    LEPT_FREE(btab);
+    numaDestroy(&nar);
+    numaDestroy(&nag);
+    numaDestroy(&nab);
     return pixd;
 }
 
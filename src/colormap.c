@@ -89,12 +89,33 @@
  *           l_int32     pixcmapContrastTRC()
  *           l_int32     pixcmapShiftIntensity()
  *           l_int32     pixcmapShiftByComponent()
+ *
+ *      Nearest color search cache
+ *           static l_int32   *pixcmapMakeInverse()
+ *           static void       pixcmapClearInverse()
+ *
+ *  pixcmapGetNearestIndex() is called per pixel in some remapping
+ *  and painting operations.  After a number of searches on an unchanged
+ *  colormap, it builds an inverse colormap: a lattice over rgb space,
+ *  where each cell holds the short list of colors that can be nearest
+ *  to some point in the cell.  A search then only visits the colors
+ *  in one cell.  Any function that changes a color or the number of
+ *  colors discards the inverse.
  * </pre>
  */
 
 #include <string.h>
 #include "allheaders.h"
 
+    /* Inverse colormap cache.  The lattice has (256 >> INVMAP_SHIFT)
+     * cells on each side, and is only built after INVMAP_MIN_SEARCHES
+     * linear searches, so that a few lookups never pay for it. */
+static const l_int32  INVMAP_SHIFT = 4;
+static const l_int32  INVMAP_MIN_SEARCHES = 32;
+
+static l_int32 *pixcmapMakeInverse(PIXCMAP *cmap);
+static void pixcmapClearInverse(PIXCMAP *cmap);
+
 /*-------------------------------------------------------------*
  *                Colormap creation and addition               *
  *-------------------------------------------------------------*/
@@ -278,6 +299,7 @@ PIXCMAP  *cmap;
     if ((cmap = *pcmap) == NULL)
         return;
 
+    pixcmapClearInverse(cmap);
     LEPT_FREE(cmap->array);
     LEPT_FREE(cmap);
     *pcmap = NULL;
@@ -314,6 +336,7 @@ RGBA_QUAD  *cta;
     if (cmap->n >= cmap->nalloc)
         return ERROR_INT("no free color entries", procName, 1);
 
+    pixcmapClearInverse(cmap);
     cta = (RGBA_QUAD *)cmap->array;
     cta[cmap->n].red = rval;
     cta[cmap->n].green = gval;
@@ -353,6 +376,7 @@ RGBA_QUAD  *cta;
     if (cmap->n >= cmap->nalloc)
         return ERROR_INT("no free color entries", procName, 1);
 
+    pixcmapClearInverse(cmap);
     cta = (RGBA_QUAD *)cmap->array;
     cta[cmap->n].red = rval;
     cta[cmap->n].green = gval;
@@ -693,6 +717,7 @@ pixcmapClear(PIXCMAP  *cmap)
 
     if (!cmap)
         return ERROR_INT("cmap not defined", procName, 1);
+    pixcmapClearInverse(cmap);
     cmap->n = 0;
     return 0;
 }
@@ -867,6 +892,7 @@ RGBA_QUAD  *cta;
     if (index < 0 || index >= cmap->n)
         return ERROR_INT("index out of bounds", procName, 1);
 
+    pixcmapClearInverse(cmap);
     cta = (RGBA_QUAD *)cmap->array;
     cta[index].red = rval;
     cta[index].green = gval;
@@ -1164,7 +1190,13 @@ NUMA    *na, *nasort;
  *      (1) Returns the index of the exact color if possible, otherwise the
  *          index of the color closest to the target color.
  *      (2) Nearest color is that which is the least sum-of-squares distance
- *          from the target color.
+ *          from the target color.  Of equally near colors, the one with
+ *          the lowest index is chosen.
+ *      (3) After a number of searches on an unchanged colormap, an
+ *          inverse colormap is built and attached to %cmap, and
+ *          subsequent searches only test the few colors that can be
+ *          nearest in the neighborhood of the target color.  The
+ *          result is the same as with a linear search.
  * </pre>
  */
 l_int32
@@ -1174,7 +1206,8 @@ pixcmapGetNearestIndex(PIXCMAP  *cmap,
                        l_int32   bval,
                        l_int32  *pindex)
 {
-l_int32     i, n, delta, dist, mindist;
+l_int32     i, k, n, cell, first, last, delta, dist, mindist;
+l_int32    *invmap;
 RGBA_QUAD  *cta;
 
     PROCNAME("pixcmapGetNearestIndex");
@@ -1189,6 +1222,36 @@ RGBA_QUAD  *cta;
         return ERROR_INT("cta not defined(!)", procName, 1);
     n = pixcmapGetCount(cmap);
 
+        /* Use the inverse colormap if it is available or due */
+    invmap = cmap->invmap;
+    if (!invmap && n > 0 && cmap->nsearch >= INVMAP_MIN_SEARCHES)
+        invmap = cmap->invmap = pixcmapMakeInverse(cmap);
+    if (invmap && ((rval | gval | bval) & ~0xff) == 0) {
+        cell = ((rval >> INVMAP_SHIFT) << (16 - 2 * INVMAP_SHIFT)) |
+               ((gval >> INVMAP_SHIFT) << (8 - INVMAP_SHIFT)) |
+               (bval >> INVMAP_SHIFT);
+        first = invmap[cell];
+        last = invmap[cell + 1];
+        mindist = 3 * 255 * 255 + 1;
+        for (k = first; k < last; k++) {
+            i = invmap[k];
+            delta = cta[i].red - rval;
+            dist = delta * delta;
+            delta = cta[i].green - gval;
+            dist += delta * delta;
+            delta = cta[i].blue - bval;
+            dist += delta * delta;
+            if (dist < mindist) {
+                *pindex = i;
+                if (dist == 0)
+                    break;
+                mindist = dist;
+            }
+        }
+        return 0;
+    }
+    cmap->nsearch++;
+
     mindist = 3 * 255 * 255 + 1;
     for (i = 0; i < n; i++) {
         delta = cta[i].red - rval;
@@ -2189,3 +2252,141 @@ l_uint32  newval;
 
     return 0;
 }
+
+
+/*-------------------------------------------------------------*
+ *                 Nearest color search cache                  *
+ *-------------------------------------------------------------*/
+/*!
+ * \brief   pixcmapMakeInverse()
+ *
+ * \param[in]    cmap
+ * \return  invmap, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The lattice has nside = (256 >> INVMAP_SHIFT) cells on a side.
+ *          The first (ncells + 1) entries of the returned array are
+ *          offsets into the same array: the candidate colormap indices
+ *          for cell i are in [invmap[i], invmap[i + 1]).
+ *      (2) For each cell, let dmax be the smallest, over all colors, of
+ *          the largest distance from the color to a point in the cell.
+ *          Every point in the cell is within dmax of that color, so any
+ *          color whose smallest distance to the cell exceeds dmax can
+ *          never be the nearest one.  The others are the candidates.
+ *          All colors that can tie for nearest are kept, in increasing
+ *          order of index, so the lowest index wins as in the linear
+ *          search.
+ * </pre>
+ */
+static l_int32 *
+pixcmapMakeInverse(PIXCMAP  *cmap)
+{
+l_int32     i, k, n, nside, ncells, cellsize, size, nalloc, dmax;
+l_int32     ir, ig, ib, lo[3], hi[3], val[3], c, d1, d2, dmin, dfar;
+l_int32    *invmap, *mind;
+RGBA_QUAD  *cta;
+
+    PROCNAME("pixcmapMakeInverse");
+
+    if (!cmap)
+        return (l_int32 *)ERROR_PTR("cmap not defined", procName, NULL);
+    if ((n = pixcmapGetCount(cmap)) == 0)
+        return (l_int32 *)ERROR_PTR("cmap is empty", procName, NULL);
+
+    cta = (RGBA_QUAD *)cmap->array;
+    nside = 256 >> INVMAP_SHIFT;
+    ncells = nside * nside * nside;
+    cellsize = 1 << INVMAP_SHIFT;
+    nalloc = ncells + 1 + 4 * ncells;
+    if ((invmap = (l_int32 *)LEPT_CALLOC(nalloc, sizeof(l_int32))) == NULL)
+        return (l_int32 *)ERROR_PTR("invmap not made", procName, NULL);
+    if ((mind = (l_int32 *)LEPT_CALLOC(n, sizeof(l_int32))) == NULL) {
+        LEPT_FREE(invmap);
+        return (l_int32 *)ERROR_PTR("mind not made", procName, NULL);
+    }
+
+    size = ncells + 1;
+    for (ir = 0, i = 0; ir < nside; ir++) {
+        for (ig = 0; ig < nside; ig++) {
+            for (ib = 0; ib < nside; ib++, i++) {
+                lo[0] = ir * cellsize;
+                lo[1] = ig * cellsize;
+                lo[2] = ib * cellsize;
+                hi[0] = lo[0] + cellsize - 1;
+                hi[1] = lo[1] + cellsize - 1;
+                hi[2] = lo[2] + cellsize - 1;
+
+                    /* Min and max squared distance from each color
+                     * to the cell */
+                dmax = 3 * 255 * 255 + 1;
+                for (k = 0; k < n; k++) {
+                    val[0] = cta[k].red;
+                    val[1] = cta[k].green;
+                    val[2] = cta[k].blue;
+                    dmin = dfar = 0;
+                    for (c = 0; c < 3; c++) {
+                        d1 = val[c] - lo[c];
+                        d2 = hi[c] - val[c];
+                        if (d1 < 0)
+                            dmin += d1 * d1;
+                        else if (d2 < 0)
+                            dmin += d2 * d2;
+                        d1 = L_ABS(d1);
+                        d2 = L_ABS(d2);
+                        d1 = L_MAX(d1, d2);
+                        dfar += d1 * d1;
+                    }
+                    mind[k] = dmin;
+                    if (dfar < dmax)
+                        dmax = dfar;
+                }
+
+                    /* Save the candidates */
+                invmap[i] = size;
+                for (k = 0; k < n; k++) {
+                    if (mind[k] > dmax) continue;
+                    if (size >= nalloc) {
+                        if ((invmap = (l_int32 *)reallocNew((void **)&invmap,
+                                          sizeof(l_int32) * nalloc,
+                                          2 * sizeof(l_int32) * nalloc))
+                                == NULL) {
+                            LEPT_FREE(mind);
+                            return (l_int32 *)ERROR_PTR("invmap not extended",
+                                                        procName, NULL);
+                        }
+                        nalloc *= 2;
+                    }
+                    invmap[size++] = k;
+                }
+            }
+        }
+    }
+    invmap[ncells] = size;
+
+    LEPT_FREE(mind);
+    return invmap;
+}
+
+
+/*!
+ * \brief   pixcmapClearInverse()
+ *
+ * \param[in]    cmap
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This must be called before any change to the colors or
+ *          the number of colors in %cmap.
+ * </pre>
+ */
+static void
+pixcmapClearInverse(PIXCMAP  *cmap)
+{
+    if (cmap->invmap)
+        LEPT_FREE(cmap->invmap);
+    cmap->invmap = NULL;
+    cmap->nsearch = 0;
+    return;
+}
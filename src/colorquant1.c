@@ -56,6 +56,7 @@
  *
  *        which calls
  *          static l_int32    octreeFindColorCell()
+ *          static l_uint32  *octreeMakeColorCellLUT()
  *
  *      Helper cqcell functions
  *          static CQCELL  ***cqcellTreeCreate()
@@ -64,6 +65,7 @@
  *      Helper index functions
  *          l_int32           makeRGBToIndexTables()
  *          void              getOctcubeIndexFromRGB()
+ *          l_int32           getOctcubeIndexLine()
  *          static void       getRGBFromOctcube()
  *          static l_int32    getOctcubeIndices()
  *          static l_int32    octcubeGetCount()
@@ -229,6 +231,7 @@ static const l_int32  POP_DIF_CAP = 40;
 
 
     /* Static octree helper function */
+static l_uint32 *octreeMakeColorCellLUT(CQCELL ***cqcaa);
 static l_int32 octreeFindColorCell(l_int32 octindex, CQCELL ***cqcaa,
                                    l_int32 *pindex, l_int32 *prval,
                                    l_int32 *pgval, l_int32 *pbval);
@@ -736,8 +739,9 @@ l_int32    ppc;  /* ave number of pixels left for each color cell */
 l_int32    rv, gv, bv;
 l_float32  thresholdFactor[] = {0.01f, 0.01f, 1.0f, 1.0f, 1.0f, 1.0f};
 l_float32  thresh;  /* factor of ppc for this level */
-l_uint32  *datas, *lines;
+l_uint32  *datas, *lines, *indexa;
 l_uint32  *rtab, *gtab, *btab;
+l_int32   *counts;
 CQCELL  ***cqcaa;   /* one array for each octree level */
 CQCELL   **cqca, **cqcasub;
 CQCELL    *cqc, *cqcsub;
@@ -774,18 +778,33 @@ NUMA      *nar;  /* accumulates levels for residual cells */
     datas = pixGetData(pixs);
     wpls = pixGetWpl(pixs);
 
-        /* Accumulate the centers of each cluster at level CQ_NLEVELS */
+        /* Accumulate the centers of each cluster at level CQ_NLEVELS.
+         * Count in a flat array, and transfer the counts to the cells. */
     ncells = 1 << (3 * CQ_NLEVELS);
     cqca = cqcaa[CQ_NLEVELS];
+    counts = (l_int32 *)LEPT_CALLOC(ncells, sizeof(l_int32));
+    indexa = (l_uint32 *)LEPT_CALLOC(w, sizeof(l_uint32));
+    if (!counts || !indexa) {
+        LEPT_FREE(counts);
+        LEPT_FREE(indexa);
+        LEPT_FREE(rtab);
+        LEPT_FREE(gtab);
+        LEPT_FREE(btab);
+        pixcmapDestroy(pcmap);
+        cqcellTreeDestroy(&cqcaa);
+        return (CQCELL ***)ERROR_PTR("counts or indexa not made",
+                                     procName, NULL);
+    }
     for (i = 0; i < h; i++) {
         lines = datas + i * wpls;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(lines[j], &rval, &gval, &bval);
-            octindex = rtab[rval] | gtab[gval] | btab[bval];
-            cqc = cqca[octindex];
-            cqc->n++;
-        }
+        getOctcubeIndexLine(lines, w, rtab, gtab, btab, indexa);
+        for (j = 0; j < w; j++)
+            counts[indexa[j]]++;
     }
+    for (octindex = 0; octindex < ncells; octindex++)
+        cqca[octindex]->n = counts[octindex];
+    LEPT_FREE(counts);
+    LEPT_FREE(indexa);
 
         /* Arrays for storing statistics */
     nat = numaCreate(0);
@@ -977,12 +996,13 @@ pixOctreeQuantizePixels(PIX       *pixs,
 {
 l_uint8   *bufu8r, *bufu8g, *bufu8b;
 l_int32    rval, gval, bval;
-l_int32    octindex, index;
+l_int32    octindex;
 l_int32    val1, val2, val3, dif;
 l_int32    w, h, wpls, wpld, i, j, success;
 l_int32    rc, gc, bc;
 l_int32   *buf1r, *buf1g, *buf1b, *buf2r, *buf2g, *buf2b;
-l_uint32  *rtab, *gtab, *btab;
+l_uint32   cell;
+l_uint32  *rtab, *gtab, *btab, *celllut, *indexa;
 l_uint32  *datas, *datad, *lines, *lined;
 PIX       *pixd;
 
@@ -1006,26 +1026,41 @@ PIX       *pixd;
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
 
-        /* Make the canonical index tables */
+        /* Make the canonical index tables, and a table that gives
+         * the colortable index and color for every octcube at the
+         * lowest level.  The table is equivalent to traversing the
+         * tree from root, looking for the lowest cube that is a leaf,
+         * which is done once for each cube instead of once per pixel. */
     rtab = gtab = btab = NULL;
     makeRGBToIndexTables(&rtab, &gtab, &btab, CQ_NLEVELS);
+    if ((celllut = octreeMakeColorCellLUT(cqcaa)) == NULL) {
+        pixDestroy(&pixd);
+        LEPT_FREE(rtab);
+        LEPT_FREE(gtab);
+        LEPT_FREE(btab);
+        return (PIX *)ERROR_PTR("celllut not made", procName, NULL);
+    }
 
-        /* Traverse tree from root, looking for lowest cube
-         * that is a leaf, and set dest pix to its
-         * colortable index value.  The results are far
-         * better when dithering to get a more accurate
-         * average color.  */
+        /* Set each dest pix to the colortable index value of its cube.
+         * The results are far better when dithering to get a more
+         * accurate average color.  */
     if (ditherflag == 0) {    /* no dithering */
+        if ((indexa = (l_uint32 *)LEPT_CALLOC(w, sizeof(l_uint32))) == NULL) {
+            pixDestroy(&pixd);
+            LEPT_FREE(rtab);
+            LEPT_FREE(gtab);
+            LEPT_FREE(btab);
+            LEPT_FREE(celllut);
+            return (PIX *)ERROR_PTR("indexa not made", procName, NULL);
+        }
         for (i = 0; i < h; i++) {
             lines = datas + i * wpls;
             lined = datad + i * wpld;
-            for (j = 0; j < w; j++) {
-                extractRGBValues(lines[j], &rval, &gval, &bval);
-                octindex = rtab[rval] | gtab[gval] | btab[bval];
-                octreeFindColorCell(octindex, cqcaa, &index, &rc, &gc, &bc);
-                SET_DATA_BYTE(lined, j, index);
-            }
+            getOctcubeIndexLine(lines, w, rtab, gtab, btab, indexa);
+            for (j = 0; j < w; j++)
+                SET_DATA_BYTE(lined, j, celllut[indexa[j]] & 0xff);
         }
+        LEPT_FREE(indexa);
     } else {  /* Dither */
         success = TRUE;
         bufu8r = bufu8g = bufu8b = NULL;
@@ -1073,8 +1108,9 @@ PIX       *pixd;
                 gval = buf1g[j] / 64;
                 bval = buf1b[j] / 64;
                 octindex = rtab[rval] | gtab[gval] | btab[bval];
-                octreeFindColorCell(octindex, cqcaa, &index, &rc, &gc, &bc);
-                SET_DATA_BYTE(lined, j, index);
+                cell = celllut[octindex];
+                SET_DATA_BYTE(lined, j, cell & 0xff);
+                extractRGBValues(cell, &rc, &gc, &bc);
 
                 dif = buf1r[j] / 8 - 8 * rc;
                 if (dif != 0) {
@@ -1130,8 +1166,7 @@ PIX       *pixd;
             gval = buf1g[w - 1] / 64;
             bval = buf1b[w - 1] / 64;
             octindex = rtab[rval] | gtab[gval] | btab[bval];
-            octreeFindColorCell(octindex, cqcaa, &index, &rc, &gc, &bc);
-            SET_DATA_BYTE(lined, w - 1, index);
+            SET_DATA_BYTE(lined, w - 1, celllut[octindex] & 0xff);
         }
 
             /* Get last row of pixels; no leftward propagation */
@@ -1141,8 +1176,7 @@ PIX       *pixd;
             gval = buf2g[j] / 64;
             bval = buf2b[j] / 64;
             octindex = rtab[rval] | gtab[gval] | btab[bval];
-            octreeFindColorCell(octindex, cqcaa, &index, &rc, &gc, &bc);
-            SET_DATA_BYTE(lined, j, index);
+            SET_DATA_BYTE(lined, j, celllut[octindex] & 0xff);
         }
 
 buffer_cleanup:
@@ -1158,6 +1192,7 @@ buffer_cleanup:
         if (!success) pixDestroy(&pixd);
     }
 
+    LEPT_FREE(celllut);
     LEPT_FREE(rtab);
     LEPT_FREE(gtab);
     LEPT_FREE(btab);
@@ -1165,6 +1200,49 @@ buffer_cleanup:
 }
 
 
+/*!
+ * \brief   octreeMakeColorCellLUT()
+ *
+ * \param[in]    cqcaa   pruned octree
+ * \return  lut   for all octcubes at level CQ_NLEVELS, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each entry holds the result of octreeFindColorCell() for
+ *          that octcube, packed as an rgb pixel with the CTE index
+ *          in the LS byte:
+ *              (rc << 24) | (gc << 16) | (bc << 8) | index
+ *          Use extractRGBValues() to get the color.
+ *      (2) The table has 2^15 entries for CQ_NLEVELS = 5, so building
+ *          it is much cheaper than searching the tree for each pixel
+ *          of a large image.
+ * </pre>
+ */
+static l_uint32 *
+octreeMakeColorCellLUT(CQCELL  ***cqcaa)
+{
+l_int32    i, ncells, index, rc, gc, bc;
+l_uint32  *lut;
+
+    PROCNAME("octreeMakeColorCellLUT");
+
+    if (!cqcaa)
+        return (l_uint32 *)ERROR_PTR("cqcaa not defined", procName, NULL);
+
+    ncells = 1 << (3 * CQ_NLEVELS);
+    if ((lut = (l_uint32 *)LEPT_CALLOC(ncells, sizeof(l_uint32))) == NULL)
+        return (l_uint32 *)ERROR_PTR("lut not made", procName, NULL);
+    for (i = 0; i < ncells; i++) {
+        index = rc = gc = bc = 0;
+        octreeFindColorCell(i, cqcaa, &index, &rc, &gc, &bc);
+        lut[i] = (rc << L_RED_SHIFT) | (gc << L_GREEN_SHIFT) |
+                 (bc << L_BLUE_SHIFT) | (index & 0xff);
+    }
+
+    return lut;
+}
+
+
 /*!
  * \brief   octreeFindColorCell()
  *
@@ -1478,6 +1556,51 @@ getOctcubeIndexFromRGB(l_int32    rval,
 }
 
 
+/*!
+ * \brief   getOctcubeIndexLine()
+ *
+ * \param[in]    lines   row of 32 bpp rgb pixels
+ * \param[in]    w       number of pixels in the row
+ * \param[in]    rtab, gtab, btab  generated with makeRGBToIndexTables()
+ * \param[out]   indexa  array of at least w octcube indices
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This computes the octcube index of each pixel in a row,
+ *          with the component extraction done inline.  It is used
+ *          for building octcube histograms and for mapping pixels to
+ *          colormap indices through a table indexed by octcube.
+ * </pre>
+ */
+l_int32
+getOctcubeIndexLine(l_uint32  *lines,
+                    l_int32    w,
+                    l_uint32  *rtab,
+                    l_uint32  *gtab,
+                    l_uint32  *btab,
+                    l_uint32  *indexa)
+{
+l_int32   j;
+l_uint32  pixel;
+
+    PROCNAME("getOctcubeIndexLine");
+
+    if (!lines || !indexa)
+        return ERROR_INT("lines and indexa not both defined", procName, 1);
+    if (!rtab || !gtab || !btab)
+        return ERROR_INT("not all tabs defined", procName, 1);
+
+    for (j = 0; j < w; j++) {
+        pixel = lines[j];
+        indexa[j] = rtab[(pixel >> L_RED_SHIFT) & 0xff] |
+                    gtab[(pixel >> L_GREEN_SHIFT) & 0xff] |
+                    btab[(pixel >> L_BLUE_SHIFT) & 0xff];
+    }
+    return 0;
+}
+
+
 /*!
  * \brief   getRGBFromOctcube()
  *
@@ -3830,7 +3953,8 @@ cleanup_arrays:
  *                     getOctcubeIndexFromRGB()
  *                * use this table to get the nearest color in the colormap
  *                     cmap_index = tab[index]
- *      (4) Distance can be either manhattan or euclidean.
+ *      (4) Distance can be either manhattan or euclidean.  With
+ *          euclidean distance, the search uses pixcmapGetNearestIndex().
  *      (5) In typical use, level = 4 gives reasonable results, and
  *          level = 5 is slightly better.  When this function is used
  *          for color segmentation, there are typically a small number
@@ -3863,20 +3987,20 @@ l_int32   *rmap, *gmap, *bmap, *tab;
     ncolors = pixcmapGetCount(cmap);
     pixcmapToArrays(cmap, &rmap, &gmap, &bmap, NULL);
 
-        /* Assign based on the closest octcube center to the cmap color */
+        /* Assign based on the closest octcube center to the cmap color.
+         * For the euclidean metric, the colormap search is accelerated
+         * by its inverse colormap. */
     for (i = 0; i < size; i++) {
         getRGBFromOctcube(i, level, &rval, &gval, &bval);
+        if (metric == L_EUCLIDEAN_DISTANCE && ncolors > 0) {
+            pixcmapGetNearestIndex(cmap, rval, gval, bval, &tab[i]);
+            continue;
+        }
         mindist = 1000000;
         mincolor = 0;  /* irrelevant init */
         for (k = 0; k < ncolors; k++) {
-            if (metric == L_MANHATTAN_DISTANCE) {
-                dist = L_ABS(rval - rmap[k]) + L_ABS(gval - gmap[k]) +
-                       L_ABS(bval - bmap[k]);
-            } else {  /* L_EUCLIDEAN_DISTANCE */
-                dist = (rval - rmap[k]) * (rval - rmap[k]) +
-                       (gval - gmap[k]) * (gval - gmap[k]) +
-                       (bval - bmap[k]) * (bval - bmap[k]);
-            }
+            dist = L_ABS(rval - rmap[k]) + L_ABS(gval - gmap[k]) +
+                   L_ABS(bval - bmap[k]);
             if (dist < mindist) {
                 mindist = dist;
                 mincolor = k;
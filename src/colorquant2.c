@@ -33,6 +33,7 @@
  *      High level
  *          PIX              *pixMedianCutQuant()
  *          PIX              *pixMedianCutQuantGeneral()
+ *          PIX              *pixMedianCutQuantKMeans()
  *          PIX              *pixMedianCutQuantMixed()
  *          PIX              *pixFewColorsMedianCutQuantMixed()
  *
@@ -46,6 +47,8 @@
  *          static L_BOX3D   *pixGetColorRegion()
  *          static l_int32    medianCutApply()
  *          static PIXCMAP   *pixcmapGenerateFromMedianCuts()
+ *          static l_int32    pixcmapRefineWithHisto()
+ *          static l_int32    pixcmapRelabelHisto()
  *          static l_int32    vboxGetAverageColor()
  *          static l_int32    vboxGetCount()
  *          static l_int32    vboxGetVolume()
@@ -207,6 +210,10 @@ static l_int32 medianCutApply(l_int32 *histo, l_int32 sigbits,
                               L_BOX3D **pvbox2);
 static PIXCMAP *pixcmapGenerateFromMedianCuts(L_HEAP *lh, l_int32 *histo,
                                               l_int32 sigbits);
+static l_int32 pixcmapRefineWithHisto(PIXCMAP *cmap, l_int32 *histo,
+                                      l_int32 sigbits, l_int32 niters);
+static l_int32 pixcmapRelabelHisto(PIXCMAP *cmap, l_int32 *histo,
+                                   l_int32 sigbits);
 static l_int32 vboxGetAverageColor(L_BOX3D *vbox, l_int32 *histo,
                                    l_int32 sigbits, l_int32 index,
                                    l_int32  *prval, l_int32 *pgval,
@@ -302,6 +309,8 @@ pixMedianCutQuant(PIX     *pixs,
  *          reason is that median cut divides the color space into rectangular
  *          regions, and it does a very poor job if all the pixels are
  *          near the diagonal of the color space cube.
+ *      (7) To improve the colors with a few iterations of k-means,
+ *          use pixMedianCutQuantKMeans().
  * </pre>
  */
 PIX *
@@ -312,17 +321,66 @@ pixMedianCutQuantGeneral(PIX     *pixs,
                          l_int32  sigbits,
                          l_int32  maxsub,
                          l_int32  checkbw)
+{
+    return pixMedianCutQuantKMeans(pixs, ditherflag, outdepth, maxcolors,
+                                   sigbits, maxsub, checkbw, 0);
+}
+
+
+/*!
+ * \brief   pixMedianCutQuantKMeans()
+ *
+ * \param[in]    pixs  32 bpp; rgb color
+ * \param[in]    ditherflag 1 for dither; 0 for no dither
+ * \param[in]    outdepth output depth; valid: 0, 1, 2, 4, 8
+ * \param[in]    maxcolors between 2 and 256
+ * \param[in]    sigbits valid: 5 or 6; use 0 for default
+ * \param[in]    maxsub max subsampling, integer; use 0 for default;
+ *                      1 for no subsampling
+ * \param[in]    checkbw 1 to check if color content is very small,
+ *                       0 to assume there is sufficient color
+ * \param[in]    nrefine number of k-means iterations; 0 for none
+ * \return  pixd 8 bit with colormap, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) See pixMedianCutQuantGeneral() for the other parameters.
+ *          With %nrefine = 0, this gives identical results.
+ *      (2) With %nrefine > 0, the median cut colors are used to seed
+ *          a k-means clustering of the occupied cells of the
+ *          (subsampled) color histogram.  Each iteration assigns
+ *          every occupied cell to the nearest color and replaces
+ *          the colors by the population-weighted means.  Because
+ *          only occupied cells are visited, the cost of an iteration
+ *          depends on the number of distinct quantized colors, not
+ *          on the image size.  A few iterations (typically 2 to 5)
+ *          give most of the reduction in color error.
+ *      (3) After refinement, the inverse colormap is regenerated so
+ *          that every cell in the quantized color space, occupied or
+ *          not, maps to its nearest colormap color.  This is needed
+ *          for dithering and for pixels that were not sampled.
+ * </pre>
+ */
+PIX *
+pixMedianCutQuantKMeans(PIX     *pixs,
+                        l_int32  ditherflag,
+                        l_int32  outdepth,
+                        l_int32  maxcolors,
+                        l_int32  sigbits,
+                        l_int32  maxsub,
+                        l_int32  checkbw,
+                        l_int32  nrefine)
 {
 l_int32    i, subsample, histosize, smalln, ncolors, niters, popcolors;
 l_int32    w, h, minside, factor, index, rval, gval, bval;
-l_int32   *histo;
+l_int32   *histo, *counts;
 l_float32  pixfract, colorfract;
 L_BOX3D   *vbox, *vbox1, *vbox2;
 L_HEAP    *lh, *lhs;
 PIX       *pixd;
 PIXCMAP   *cmap;
 
-    PROCNAME("pixMedianCutQuantGeneral");
+    PROCNAME("pixMedianCutQuantKMeans");
 
     if (!pixs || pixGetDepth(pixs) != 32)
         return (PIX *)ERROR_PTR("pixs undefined or not 32 bpp", procName, NULL);
@@ -339,6 +397,8 @@ PIXCMAP   *cmap;
         return (PIX *)ERROR_PTR("sigbits not 5 or 6", procName, NULL);
     if (maxsub <= 0)
         maxsub = 10;  /* default will prevail for 10^7 pixels or less */
+    if (nrefine < 0)
+        return (PIX *)ERROR_PTR("nrefine < 0", procName, NULL);
 
         /* Determine if the image has sufficient color content.
          * If pixfract << 1, most pixels are close to black or white.
@@ -420,7 +480,7 @@ PIXCMAP   *cmap;
     popcolors = (l_int32)(FRACT_BY_POPULATION * maxcolors);
     while (1) {
         vbox = (L_BOX3D *)lheapRemove(lh);
-        if (vboxGetCount(vbox, histo, sigbits) == 0)  { /* just put it back */
+        if (vbox->npix == 0)  { /* just put it back */
             lheapAdd(lh, vbox);
             continue;
         }
@@ -460,7 +520,7 @@ PIXCMAP   *cmap;
          * median cuts using the (npix * vol) sorting. */
     while (1) {
         vbox = (L_BOX3D *)lheapRemove(lhs);
-        if (vboxGetCount(vbox, histo, sigbits) == 0)  { /* just put it back */
+        if (vbox->npix == 0)  { /* just put it back */
             lheapAdd(lhs, vbox);
             continue;
         }
@@ -497,8 +557,27 @@ PIXCMAP   *cmap;
     }
     lheapDestroy(&lhs, TRUE);
 
-        /* Generate colormap from median cuts and quantize pixd */
+        /* Generate colormap from median cuts.  The histo is then
+         * relabeled as the inverse colormap, so if the colors are to
+         * be refined, first save a copy of the counts. */
+    counts = NULL;
+    if (nrefine > 0) {
+        if ((counts = (l_int32 *)LEPT_CALLOC(histosize, sizeof(l_int32)))
+            == NULL) {
+            lheapDestroy(&lh, TRUE);
+            LEPT_FREE(histo);
+            return (PIX *)ERROR_PTR("counts not made", procName, NULL);
+        }
+        memcpy(counts, histo, histosize * sizeof(l_int32));
+    }
     cmap = pixcmapGenerateFromMedianCuts(lh, histo, sigbits);
+    if (counts) {
+        pixcmapRefineWithHisto(cmap, counts, sigbits, nrefine);
+        pixcmapRelabelHisto(cmap, histo, sigbits);
+        LEPT_FREE(counts);
+    }
+
+        /* Quantize pixd */
     if (outdepth == 0) {
         ncolors = pixcmapGetCount(cmap);
         if (ncolors <= 2)
@@ -959,6 +1038,7 @@ l_int32    i, j, w, h, wpls, wpld, rshift, index, cmapindex, success;
 l_int32    rval, gval, bval, rc, gc, bc;
 l_int32    dif, val1, val2, val3;
 l_int32   *buf1r, *buf1g, *buf1b, *buf2r, *buf2g, *buf2b;
+l_int32   *rmap, *gmap, *bmap;
 l_uint32  *datas, *datad, *lines, *lined;
 l_uint32   mask, pixel;
 PIX       *pixd;
@@ -1025,6 +1105,8 @@ PIX       *pixd;
         success = TRUE;
         bufu8r = bufu8g = bufu8b = NULL;
         buf1r = buf1g = buf1b = buf2r = buf2g = buf2b = NULL;
+        rmap = gmap = bmap = NULL;
+        pixcmapToArrays(cmap, &rmap, &gmap, &bmap, NULL);
         bufu8r = (l_uint8 *)LEPT_CALLOC(w, sizeof(l_uint8));
         bufu8g = (l_uint8 *)LEPT_CALLOC(w, sizeof(l_uint8));
         bufu8b = (l_uint8 *)LEPT_CALLOC(w, sizeof(l_uint8));
@@ -1035,7 +1117,8 @@ PIX       *pixd;
         buf2g = (l_int32 *)LEPT_CALLOC(w, sizeof(l_int32));
         buf2b = (l_int32 *)LEPT_CALLOC(w, sizeof(l_int32));
         if (!bufu8r || !bufu8g || !bufu8b || !buf1r || !buf1g ||
-            !buf1b || !buf2r || !buf2g || !buf2b) {
+            !buf1b || !buf2r || !buf2g || !buf2b ||
+            !rmap || !gmap || !bmap) {
             L_ERROR("buffer not made\n", procName);
             success = FALSE;
             goto buffer_cleanup;
@@ -1071,7 +1154,9 @@ PIX       *pixd;
                         ((gval >> rshift) << sigbits) + (bval >> rshift);
                 cmapindex = indexmap[index];
                 SET_DATA_BYTE(lined, j, cmapindex);
-                pixcmapGetColor(cmap, cmapindex, &rc, &gc, &bc);
+                rc = rmap[cmapindex];
+                gc = gmap[cmapindex];
+                bc = bmap[cmapindex];
 
                 dif = buf1r[j] / 8 - 8 * rc;
                 if (dif > DIF_CAP) dif = DIF_CAP;
@@ -1149,6 +1234,9 @@ PIX       *pixd;
         }
 
 buffer_cleanup:
+        LEPT_FREE(rmap);
+        LEPT_FREE(gmap);
+        LEPT_FREE(bmap);
         LEPT_FREE(bufu8r);
         LEPT_FREE(bufu8g);
         LEPT_FREE(bufu8b);
@@ -1278,7 +1366,7 @@ medianCutApply(l_int32   *histo,
                L_BOX3D  **pvbox2)
 {
 l_int32   i, j, k, sum, rw, gw, bw, maxw, index;
-l_int32   total, left, right;
+l_int32   total, left, right, npix1;
 l_int32   partialsum[128];
 L_BOX3D  *vbox1, *vbox2;
 
@@ -1293,7 +1381,7 @@ L_BOX3D  *vbox1, *vbox2;
     if (!pvbox1 || !pvbox2)
         return ERROR_INT("&vbox1 and &vbox2 not both defined", procName, 1);
 
-    if (vboxGetCount(vbox, histo, sigbits) == 0)
+    if (vbox->npix == 0)
         return ERROR_INT("no pixels in vbox", procName, 1);
 
         /* If the vbox occupies just one element in color space, it can't
@@ -1371,6 +1459,7 @@ L_BOX3D  *vbox1, *vbox2;
          * of low-count vboxes are produced, allowing much better
          * reproduction of low-count spot colors. */
     vbox1 = vbox2 = NULL;
+    npix1 = 0;
     if (maxw == rw) {
         for (i = vbox->r1; i <= vbox->r2; i++) {
             if (partialsum[i] > total / 2) {
@@ -1383,6 +1472,7 @@ L_BOX3D  *vbox1, *vbox2;
                 else  /* left > right */
                     vbox1->r2 = L_MAX(vbox->r1, i - 1 - left / 2);
                 vbox2->r1 = vbox1->r2 + 1;
+                npix1 = partialsum[vbox1->r2];
                 break;
             }
         }
@@ -1398,6 +1488,7 @@ L_BOX3D  *vbox1, *vbox2;
                 else  /* left > right */
                     vbox1->g2 = L_MAX(vbox->g1, i - 1 - left / 2);
                 vbox2->g1 = vbox1->g2 + 1;
+                npix1 = partialsum[vbox1->g2];
                 break;
             }
         }
@@ -1413,6 +1504,7 @@ L_BOX3D  *vbox1, *vbox2;
                 else  /* left > right */
                     vbox1->b2 = L_MAX(vbox->b1, i - 1 - left / 2);
                 vbox2->b1 = vbox1->b2 + 1;
+                npix1 = partialsum[vbox1->b2];
                 break;
             }
         }
@@ -1423,8 +1515,10 @@ L_BOX3D  *vbox1, *vbox2;
         return ERROR_INT("vbox1 not made; shouldn't happen", procName, 1);
     if (!vbox2)
         return ERROR_INT("vbox2 not made; shouldn't happen", procName, 1);
-    vbox1->npix = vboxGetCount(vbox1, histo, sigbits);
-    vbox2->npix = vboxGetCount(vbox2, histo, sigbits);
+
+        /* The counts in the two parts come from the partial sums */
+    vbox1->npix = npix1;
+    vbox2->npix = total - npix1;
     vbox1->vol = vboxGetVolume(vbox1);
     vbox2->vol = vboxGetVolume(vbox2);
 
@@ -1481,6 +1575,228 @@ PIXCMAP  *cmap;
 }
 
 
+/*!
+ * \brief   pixcmapRefineWithHisto()
+ *
+ * \param[in]    cmap   colormap of colors to be refined
+ * \param[in]    histo  pixel counts in quantized color space
+ * \param[in]    sigbits valid: 5 or 6
+ * \param[in]    niters number of k-means iterations
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This does a few iterations of k-means on the colormap colors,
+ *          weighting each occupied cell of the histogram by its count
+ *          and representing it by the color at its center.
+ *      (2) The occupied cells are first gathered into a sparse list,
+ *          so each iteration visits only the cells that hold pixels.
+ *      (3) A color that gets no cells in an iteration is left unchanged.
+ *          Iteration stops early if no cell changes its assigned color.
+ * </pre>
+ */
+static l_int32
+pixcmapRefineWithHisto(PIXCMAP  *cmap,
+                       l_int32  *histo,
+                       l_int32   sigbits,
+                       l_int32   niters)
+{
+l_int32    i, k, iter, histosize, nocc, ncolors, mult, mask, changed;
+l_int32    rval, gval, bval, dr, dg, db, dist, mindist, minindex, count;
+l_int32   *occindex, *occcount, *occlabel, *rmap, *gmap, *bmap;
+l_int32   *ntot;
+l_float64 *rsum, *gsum, *bsum;
+
+    PROCNAME("pixcmapRefineWithHisto");
+
+    if (!cmap)
+        return ERROR_INT("cmap not defined", procName, 1);
+    if (!histo)
+        return ERROR_INT("histo not defined", procName, 1);
+
+    histosize = 1 << (3 * sigbits);
+    for (i = 0, nocc = 0; i < histosize; i++)
+        if (histo[i]) nocc++;
+    if (nocc == 0)
+        return 0;
+
+        /* Sparse histogram: index and count of each occupied cell */
+    occindex = (l_int32 *)LEPT_CALLOC(nocc, sizeof(l_int32));
+    occcount = (l_int32 *)LEPT_CALLOC(nocc, sizeof(l_int32));
+    occlabel = (l_int32 *)LEPT_CALLOC(nocc, sizeof(l_int32));
+    ncolors = pixcmapGetCount(cmap);
+    rmap = gmap = bmap = NULL;
+    pixcmapToArrays(cmap, &rmap, &gmap, &bmap, NULL);
+    ntot = (l_int32 *)LEPT_CALLOC(ncolors, sizeof(l_int32));
+    rsum = (l_float64 *)LEPT_CALLOC(ncolors, sizeof(l_float64));
+    gsum = (l_float64 *)LEPT_CALLOC(ncolors, sizeof(l_float64));
+    bsum = (l_float64 *)LEPT_CALLOC(ncolors, sizeof(l_float64));
+    if (!occindex || !occcount || !occlabel || !rmap || !gmap || !bmap ||
+        !ntot || !rsum || !gsum || !bsum) {
+        LEPT_FREE(occindex);
+        LEPT_FREE(occcount);
+        LEPT_FREE(occlabel);
+        LEPT_FREE(rmap);
+        LEPT_FREE(gmap);
+        LEPT_FREE(bmap);
+        LEPT_FREE(ntot);
+        LEPT_FREE(rsum);
+        LEPT_FREE(gsum);
+        LEPT_FREE(bsum);
+        return ERROR_INT("work arrays not made", procName, 1);
+    }
+    for (i = 0, k = 0; i < histosize; i++) {
+        if (histo[i]) {
+            occindex[k] = i;
+            occcount[k] = histo[i];
+            occlabel[k] = -1;
+            k++;
+        }
+    }
+
+    mult = 1 << (8 - sigbits);
+    mask = (1 << sigbits) - 1;
+    for (iter = 0; iter < niters; iter++) {
+        for (k = 0; k < ncolors; k++) {
+            ntot[k] = 0;
+            rsum[k] = gsum[k] = bsum[k] = 0.0;
+        }
+
+            /* Assign each occupied cell to the nearest color */
+        changed = FALSE;
+        for (i = 0; i < nocc; i++) {
+            rval = mult * (occindex[i] >> (2 * sigbits)) + mult / 2;
+            gval = mult * ((occindex[i] >> sigbits) & mask) + mult / 2;
+            bval = mult * (occindex[i] & mask) + mult / 2;
+            mindist = 1000000;
+            minindex = 0;
+            for (k = 0; k < ncolors; k++) {
+                dr = rval - rmap[k];
+                dist = dr * dr;
+                if (dist >= mindist) continue;
+                dg = gval - gmap[k];
+                dist += dg * dg;
+                if (dist >= mindist) continue;
+                db = bval - bmap[k];
+                dist += db * db;
+                if (dist < mindist) {
+                    mindist = dist;
+                    minindex = k;
+                }
+            }
+            if (occlabel[i] != minindex) {
+                occlabel[i] = minindex;
+                changed = TRUE;
+            }
+            count = occcount[i];
+            ntot[minindex] += count;
+            rsum[minindex] += (l_float64)count * rval;
+            gsum[minindex] += (l_float64)count * gval;
+            bsum[minindex] += (l_float64)count * bval;
+        }
+        if (!changed)
+            break;
+
+            /* Move each color to the mean of its cells */
+        for (k = 0; k < ncolors; k++) {
+            if (ntot[k] == 0) continue;
+            rmap[k] = (l_int32)(rsum[k] / ntot[k] + 0.5);
+            gmap[k] = (l_int32)(gsum[k] / ntot[k] + 0.5);
+            bmap[k] = (l_int32)(bsum[k] / ntot[k] + 0.5);
+            pixcmapResetColor(cmap, k, rmap[k], gmap[k], bmap[k]);
+        }
+    }
+
+    LEPT_FREE(occindex);
+    LEPT_FREE(occcount);
+    LEPT_FREE(occlabel);
+    LEPT_FREE(rmap);
+    LEPT_FREE(gmap);
+    LEPT_FREE(bmap);
+    LEPT_FREE(ntot);
+    LEPT_FREE(rsum);
+    LEPT_FREE(gsum);
+    LEPT_FREE(bsum);
+    return 0;
+}
+
+
+/*!
+ * \brief   pixcmapRelabelHisto()
+ *
+ * \param[in]    cmap   colormap
+ * \param[in]    histo  inverse colormap over quantized color space
+ * \param[in]    sigbits valid: 5 or 6
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) On input, each cell of %histo holds a colormap index, as
+ *          generated by pixcmapGenerateFromMedianCuts().  On output,
+ *          each cell holds the index of the color nearest to the
+ *          center of the cell.
+ *      (2) The input label is used as the starting candidate.  It is
+ *          usually the nearest or close to it, so most colors are
+ *          rejected after the first component difference.
+ * </pre>
+ */
+static l_int32
+pixcmapRelabelHisto(PIXCMAP  *cmap,
+                    l_int32  *histo,
+                    l_int32   sigbits)
+{
+l_int32   i, k, histosize, ncolors, mult, mask;
+l_int32   rval, gval, bval, dr, dg, db, dist, mindist, minindex;
+l_int32  *rmap, *gmap, *bmap;
+
+    PROCNAME("pixcmapRelabelHisto");
+
+    if (!cmap)
+        return ERROR_INT("cmap not defined", procName, 1);
+    if (!histo)
+        return ERROR_INT("histo not defined", procName, 1);
+
+    ncolors = pixcmapGetCount(cmap);
+    if (pixcmapToArrays(cmap, &rmap, &gmap, &bmap, NULL))
+        return ERROR_INT("colormap arrays not made", procName, 1);
+    histosize = 1 << (3 * sigbits);
+    mult = 1 << (8 - sigbits);
+    mask = (1 << sigbits) - 1;
+    for (i = 0; i < histosize; i++) {
+        rval = mult * (i >> (2 * sigbits)) + mult / 2;
+        gval = mult * ((i >> sigbits) & mask) + mult / 2;
+        bval = mult * (i & mask) + mult / 2;
+        minindex = histo[i];
+        if (minindex < 0 || minindex >= ncolors)
+            minindex = 0;
+        dr = rval - rmap[minindex];
+        dg = gval - gmap[minindex];
+        db = bval - bmap[minindex];
+        mindist = dr * dr + dg * dg + db * db;
+        for (k = 0; k < ncolors && mindist > 0; k++) {
+            dr = rval - rmap[k];
+            dist = dr * dr;
+            if (dist >= mindist) continue;
+            dg = gval - gmap[k];
+            dist += dg * dg;
+            if (dist >= mindist) continue;
+            db = bval - bmap[k];
+            dist += db * db;
+            if (dist < mindist) {
+                mindist = dist;
+                minindex = k;
+            }
+        }
+        histo[i] = minindex;
+    }
+
+    LEPT_FREE(rmap);
+    LEPT_FREE(gmap);
+    LEPT_FREE(bmap);
+    return 0;
+}
+
+
 /*!
  * \brief   vboxGetAverageColor()
  *
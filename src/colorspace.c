@@ -76,6 +76,20 @@
  *           PIX        *fpixaConvertLABToRGB()
  *           l_int32     convertRGBToLAB()
  *           l_int32     convertLABToRGB()
+ *
+ *      Fast row-oriented conversion from RGB
+ *           l_int32     convertRGBLineToGray()
+ *           l_int32     convertRGBLineToHSV()
+ *           l_int32     convertRGBLineToYUV()
+ *           l_int32     convertRGBLineToXYZ()
+ *           l_int32     convertRGBLineToLAB()
+ *
+ *      The row functions at the end of this file are the kernels used
+ *      by the image conversion functions above.  They use fixed-point
+ *      integer arithmetic wherever that gives the same result as the
+ *      floating point conversion of a single pixel, have no function
+ *      calls in the inner loop, and can be called directly on rows of
+ *      any 32 bpp raster, for example when processing an image in bands.
  * </pre>
  */
 
@@ -92,6 +106,9 @@
 static l_float32 lab_forward(l_float32 v);
 static l_float32 lab_reverse(l_float32 v);
 
+    /* Number of fractional bits in the fixed-point conversion to gray */
+static const l_int32  L_GRAY_FIXED_SHIFT = 20;
+
 
 /*---------------------------------------------------------------------------*
  *                  Colorspace conversion between RGB and HSB                *
@@ -134,7 +151,7 @@ PIX *
 pixConvertRGBToHSV(PIX  *pixd,
                    PIX  *pixs)
 {
-l_int32    w, h, d, wpl, i, j, rval, gval, bval, hval, sval, vval;
+l_int32    w, h, d, wpl, i;
 l_uint32  *line, *data;
 PIXCMAP   *cmap;
 
@@ -165,11 +182,7 @@ PIXCMAP   *cmap;
     data = pixGetData(pixd);
     for (i = 0; i < h; i++) {
         line = data + i * wpl;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(line[j], &rval, &gval, &bval);
-            convertRGBToHSV(rval, gval, bval, &hval, &sval, &vval);
-            line[j] = (hval << 24) | (sval << 16) | (vval << 8);
-        }
+        convertRGBLineToHSV(line, w, line);
     }
 
     return pixd;
@@ -1454,7 +1467,7 @@ PIX *
 pixConvertRGBToYUV(PIX  *pixd,
                    PIX  *pixs)
 {
-l_int32    w, h, d, wpl, i, j, rval, gval, bval, yval, uval, vval;
+l_int32    w, h, d, wpl, i;
 l_uint32  *line, *data;
 PIXCMAP   *cmap;
 
@@ -1485,11 +1498,7 @@ PIXCMAP   *cmap;
     data = pixGetData(pixd);
     for (i = 0; i < h; i++) {
         line = data + i * wpl;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(line[j], &rval, &gval, &bval);
-            convertRGBToYUV(rval, gval, bval, &yval, &uval, &vval);
-            line[j] = (yval << 24) | (uval << 16) | (vval << 8);
-        }
+        convertRGBLineToYUV(line, w, line);
     }
 
     return pixd;
@@ -1761,9 +1770,8 @@ l_int32   i, ncolors, rval, gval, bval, yval, uval, vval;
 FPIXA *
 pixConvertRGBToXYZ(PIX  *pixs)
 {
-l_int32     w, h, wpls, wpld, i, j, rval, gval, bval;
+l_int32     w, h, wpls, wpld, i;
 l_uint32   *lines, *datas;
-l_float32   fxval, fyval, fzval;
 l_float32  *linex, *liney, *linez, *datax, *datay, *dataz;
 FPIX       *fpix;
 FPIXA      *fpixa;
@@ -1791,13 +1799,7 @@ FPIXA      *fpixa;
         linex = datax + i * wpld;
         liney = datay + i * wpld;
         linez = dataz + i * wpld;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(lines[j], &rval, &gval, &bval);
-            convertRGBToXYZ(rval, gval, bval, &fxval, &fyval, &fzval);
-            *(linex + j) = fxval;
-            *(liney + j) = fyval;
-            *(linez + j) = fzval;
-        }
+        convertRGBLineToXYZ(lines, w, linex, liney, linez);
     }
 
     return fpixa;
@@ -2242,9 +2244,8 @@ const l_float32  r_offset = 0.13793;  /* 4/29 */
 FPIXA *
 pixConvertRGBToLAB(PIX  *pixs)
 {
-l_int32     w, h, wpls, wpld, i, j, rval, gval, bval;
+l_int32     w, h, wpls, wpld, i;
 l_uint32   *lines, *datas;
-l_float32   flval, faval, fbval;
 l_float32  *linel, *linea, *lineb, *datal, *dataa, *datab;
 FPIX       *fpix;
 FPIXA      *fpixa;
@@ -2272,13 +2273,7 @@ FPIXA      *fpixa;
         linel = datal + i * wpld;
         linea = dataa + i * wpld;
         lineb = datab + i * wpld;
-        for (j = 0; j < w; j++) {
-            extractRGBValues(lines[j], &rval, &gval, &bval);
-            convertRGBToLAB(rval, gval, bval, &flval, &faval, &fbval);
-            *(linel + j) = flval;
-            *(linea + j) = faval;
-            *(lineb + j) = fbval;
-        }
+        convertRGBLineToLAB(lines, w, linel, linea, lineb);
     }
 
     return fpixa;
@@ -2413,3 +2408,307 @@ l_float32  fxval, fyval, fzval;
     convertXYZToRGB(fxval, fyval, fzval, 0, prval, pgval, pbval);
     return 0;
 }
+
+
+/*---------------------------------------------------------------------------*
+ *                  Fast row-oriented conversion from RGB                    *
+ *---------------------------------------------------------------------------*/
+/*!
+ * \brief   convertRGBLineToGray()
+ *
+ * \param[in]    lines    row of 32 bpp rgb pixels
+ * \param[in]    w        number of pixels in the row
+ * \param[in]    rwt, gwt, bwt  non-negative weights, summing to 1.0
+ * \param[out]   lined    row of 8 bpp gray pixels; must hold w bytes
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the kernel for pixConvertRGBToGray().  The caller
+ *          is responsible for normalizing the weights.
+ *      (2) For the default luminance weights, the weights are converted
+ *          to fixed-point with 20 fractional bits, rounding up.  This
+ *          gives exactly the same result as the floating point sum
+ *              (l_int32)(rwt * r + gwt * g + bwt * b + 0.5)
+ *          for all 2^24 colors.  For arbitrary weights, a fixed-point
+ *          sum can differ by 1 for colors whose weighted sum falls
+ *          within float roundoff of a half-integer, so the floating
+ *          point sum is used instead.
+ *      (3) Four gray pixels are composed into each output word, so the
+ *          inner loop has no byte addressing and no function calls.
+ * </pre>
+ */
+l_int32
+convertRGBLineToGray(l_uint32   *lines,
+                     l_int32     w,
+                     l_float32   rwt,
+                     l_float32   gwt,
+                     l_float32   bwt,
+                     l_uint32   *lined)
+{
+l_int32   j, k, nwords, rw, gw, bw, half, shift;
+l_uint32  word, pixel, val;
+
+    PROCNAME("convertRGBLineToGray");
+
+    if (!lines || !lined)
+        return ERROR_INT("lines and lined not both defined", procName, 1);
+    if (rwt < 0.0 || gwt < 0.0 || bwt < 0.0)
+        return ERROR_INT("weights not all >= 0.0", procName, 1);
+
+    if (rwt != L_RED_WEIGHT || gwt != L_GREEN_WEIGHT ||
+        bwt != L_BLUE_WEIGHT) {  /* float; see note 2 */
+        for (j = 0; j < w; j++) {
+            pixel = lines[j];
+            val = (l_int32)(rwt * ((pixel >> L_RED_SHIFT) & 0xff) +
+                            gwt * ((pixel >> L_GREEN_SHIFT) & 0xff) +
+                            bwt * ((pixel >> L_BLUE_SHIFT) & 0xff) + 0.5);
+            SET_DATA_BYTE(lined, j, val);
+        }
+        return 0;
+    }
+
+    shift = L_GRAY_FIXED_SHIFT;
+    rw = (l_int32)ceil(rwt * (1 << shift));
+    gw = (l_int32)ceil(gwt * (1 << shift));
+    bw = (l_int32)ceil(bwt * (1 << shift));
+    half = 1 << (shift - 1);
+
+    nwords = w / 4;
+    for (j = 0; j < nwords; j++) {
+        word = 0;
+        for (k = 0; k < 4; k++) {
+            pixel = lines[4 * j + k];
+            val = (rw * ((pixel >> L_RED_SHIFT) & 0xff) +
+                   gw * ((pixel >> L_GREEN_SHIFT) & 0xff) +
+                   bw * ((pixel >> L_BLUE_SHIFT) & 0xff) + half) >> shift;
+            if (val > 255) val = 255;
+            word |= val << (24 - 8 * k);
+        }
+        lined[j] = word;
+    }
+    for (j = 4 * nwords; j < w; j++) {
+        pixel = lines[j];
+        val = (rw * ((pixel >> L_RED_SHIFT) & 0xff) +
+               gw * ((pixel >> L_GREEN_SHIFT) & 0xff) +
+               bw * ((pixel >> L_BLUE_SHIFT) & 0xff) + half) >> shift;
+        if (val > 255) val = 255;
+        SET_DATA_BYTE(lined, j, val);
+    }
+
+    return 0;
+}
+
+
+/*!
+ * \brief   convertRGBLineToHSV()
+ *
+ * \param[in]    lines    row of 32 bpp rgb pixels
+ * \param[in]    w        number of pixels in the row
+ * \param[out]   lined    row of 32 bpp hsv pixels; can be equal to lines
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the kernel for pixConvertRGBToHSV().  The hsv values
+ *          are placed in the 3 MS bytes of each pixel, as described
+ *          in pixConvertRGBToHSV().
+ *      (2) The hue and saturation are computed with exact integer
+ *          arithmetic, and are identical to the values returned by
+ *          convertRGBToHSV() for all 2^24 colors.
+ * </pre>
+ */
+l_int32
+convertRGBLineToHSV(l_uint32  *lines,
+                    l_int32    w,
+                    l_uint32  *lined)
+{
+l_int32   j, rval, gval, bval, minrg, maxrg, min, max, delta, hd;
+l_int32   hval, sval;
+l_uint32  pixel;
+
+    PROCNAME("convertRGBLineToHSV");
+
+    if (!lines || !lined)
+        return ERROR_INT("lines and lined not both defined", procName, 1);
+
+    for (j = 0; j < w; j++) {
+        pixel = lines[j];
+        rval = (pixel >> L_RED_SHIFT) & 0xff;
+        gval = (pixel >> L_GREEN_SHIFT) & 0xff;
+        bval = (pixel >> L_BLUE_SHIFT) & 0xff;
+        minrg = L_MIN(rval, gval);
+        min = L_MIN(minrg, bval);
+        maxrg = L_MAX(rval, gval);
+        max = L_MAX(maxrg, bval);
+        delta = max - min;
+        if (delta == 0) {  /* gray; no chroma */
+            hval = sval = 0;
+        } else {
+                /* sval = round(255 * delta / max) */
+            sval = (510 * delta + max) / (2 * max);
+                /* hd = 40 * h * delta, with h as in convertRGBToHSV() */
+            if (rval == max)
+                hd = 40 * (gval - bval);
+            else if (gval == max)
+                hd = 80 * delta + 40 * (bval - rval);
+            else
+                hd = 160 * delta + 40 * (rval - gval);
+            if (hd < 0)
+                hd += 240 * delta;
+            if (2 * hd >= 479 * delta)  /* h >= 239.5 wraps to 0 */
+                hval = 0;
+            else
+                hval = (2 * hd + delta) / (2 * delta);
+        }
+        lined[j] = (hval << 24) | (sval << 16) | (max << 8);
+    }
+
+    return 0;
+}
+
+
+/*!
+ * \brief   convertRGBLineToYUV()
+ *
+ * \param[in]    lines    row of 32 bpp rgb pixels
+ * \param[in]    w        number of pixels in the row
+ * \param[out]   lined    row of 32 bpp yuv pixels; can be equal to lines
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the kernel for pixConvertRGBToYUV().  The yuv values
+ *          are placed in the 3 MS bytes of each pixel.
+ *      (2) This uses the same floating point arithmetic as
+ *          convertRGBToYUV(), and gives identical results.  No
+ *          fixed-point approximation is exact for all 2^24 colors.
+ * </pre>
+ */
+l_int32
+convertRGBLineToYUV(l_uint32  *lines,
+                    l_int32    w,
+                    l_uint32  *lined)
+{
+l_int32    j, rval, gval, bval, yval, uval, vval;
+l_uint32   pixel;
+l_float32  norm;
+
+    PROCNAME("convertRGBLineToYUV");
+
+    if (!lines || !lined)
+        return ERROR_INT("lines and lined not both defined", procName, 1);
+
+    norm = 1.0 / 256.;
+    for (j = 0; j < w; j++) {
+        pixel = lines[j];
+        rval = (pixel >> L_RED_SHIFT) & 0xff;
+        gval = (pixel >> L_GREEN_SHIFT) & 0xff;
+        bval = (pixel >> L_BLUE_SHIFT) & 0xff;
+        yval = (l_int32)(16.0 +
+               norm * (65.738 * rval + 129.057 * gval + 25.064 * bval) + 0.5);
+        uval = (l_int32)(128.0 +
+               norm * (-37.945 * rval -74.494 * gval + 112.439 * bval) + 0.5);
+        vval = (l_int32)(128.0 +
+               norm * (112.439 * rval - 94.154 * gval - 18.285 * bval) + 0.5);
+        lined[j] = (yval << 24) | (uval << 16) | (vval << 8);
+    }
+
+    return 0;
+}
+
+
+/*!
+ * \brief   convertRGBLineToXYZ()
+ *
+ * \param[in]    lines    row of 32 bpp rgb pixels
+ * \param[in]    w        number of pixels in the row
+ * \param[out]   linex, liney, linez   rows of x, y and z values
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the kernel for pixConvertRGBToXYZ(), and gives the
+ *          same result as convertRGBToXYZ() on each pixel.
+ * </pre>
+ */
+l_int32
+convertRGBLineToXYZ(l_uint32   *lines,
+                    l_int32     w,
+                    l_float32  *linex,
+                    l_float32  *liney,
+                    l_float32  *linez)
+{
+l_int32   j, rval, gval, bval;
+l_uint32  pixel;
+
+    PROCNAME("convertRGBLineToXYZ");
+
+    if (!lines || !linex || !liney || !linez)
+        return ERROR_INT("lines and xyz lines not all defined", procName, 1);
+
+    for (j = 0; j < w; j++) {
+        pixel = lines[j];
+        rval = (pixel >> L_RED_SHIFT) & 0xff;
+        gval = (pixel >> L_GREEN_SHIFT) & 0xff;
+        bval = (pixel >> L_BLUE_SHIFT) & 0xff;
+        linex[j] = 0.4125 * rval + 0.3576 * gval + 0.1804 * bval;
+        liney[j] = 0.2127 * rval + 0.7152 * gval + 0.0722 * bval;
+        linez[j] = 0.0193 * rval + 0.1192 * gval + 0.9502 * bval;
+    }
+
+    return 0;
+}
+
+
+/*!
+ * \brief   convertRGBLineToLAB()
+ *
+ * \param[in]    lines    row of 32 bpp rgb pixels
+ * \param[in]    w        number of pixels in the row
+ * \param[out]   linel, linea, lineb   rows of l, a and b values
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the kernel for pixConvertRGBToLAB(), and gives the
+ *          same result as convertRGBToLAB() on each pixel.
+ *      (2) The cube root approximation in lab_forward() is evaluated
+ *          inline, once for each component, without the intermediate
+ *          xyz function calls.
+ * </pre>
+ */
+l_int32
+convertRGBLineToLAB(l_uint32   *lines,
+                    l_int32     w,
+                    l_float32  *linel,
+                    l_float32  *linea,
+                    l_float32  *lineb)
+{
+l_int32    j, rval, gval, bval;
+l_uint32   pixel;
+l_float32  xval, yval, zval, fx, fy, fz;
+
+    PROCNAME("convertRGBLineToLAB");
+
+    if (!lines || !linel || !linea || !lineb)
+        return ERROR_INT("lines and lab lines not all defined", procName, 1);
+
+    for (j = 0; j < w; j++) {
+        pixel = lines[j];
+        rval = (pixel >> L_RED_SHIFT) & 0xff;
+        gval = (pixel >> L_GREEN_SHIFT) & 0xff;
+        bval = (pixel >> L_BLUE_SHIFT) & 0xff;
+        xval = 0.4125 * rval + 0.3576 * gval + 0.1804 * bval;
+        yval = 0.2127 * rval + 0.7152 * gval + 0.0722 * bval;
+        zval = 0.0193 * rval + 0.1192 * gval + 0.9502 * bval;
+        fx = lab_forward(0.0041259 * xval);
+        fy = lab_forward(0.0039216 * yval);
+        fz = lab_forward(0.0036012 * zval);
+        linel[j] = 116.0 * fy - 16.0;
+        linea[j] = 500.0 * (fx - fy);
+        lineb[j] = 200.0 * (fy - fz);
+    }
+
+    return 0;
+}
@@ -71,6 +71,8 @@
  *      Generic convolution (with float arrays)
  *          FPIX         *fpixConvolve()
  *          FPIX         *fpixConvolveSep()
+ *          static FPIX  *fpixConvolveLow()
+ *          static FPIX  *fpixConvolveSepLow()
  *
  *      Convolution with bias (for non-negative output)
  *          PIX          *pixConvolveWithBias()
@@ -102,6 +104,10 @@ static void blockconvAccumLow(l_uint32 *datad, l_int32 w, l_int32 h,
                               l_int32 wpls);
 static void blocksumLow(l_uint32 *datad, l_int32 w, l_int32 h, l_int32 wpl,
                         l_uint32 *dataa, l_int32 wpla, l_int32 wc, l_int32 hc);
+static FPIX *fpixConvolveLow(FPIX *fpixt, L_KERNEL *kel, l_int32 wd,
+                             l_int32 hd);
+static FPIX *fpixConvolveSepLow(FPIX *fpixt, L_KERNEL *kelx, L_KERNEL *kely,
+                                l_int32 wd, l_int32 hd);
 
 
 /*----------------------------------------------------------------------*
@@ -1865,6 +1871,9 @@ PIX       *pixav, *pixd;
  *          each pixel-op in the convolution.  For example, with a 3 GHz
  *          cpu, a 1 Mpixel grayscale image, and a kernel with
  *          (sx * sy) = 25 elements, the convolution takes about 100 msec.
+ *          If the kernel is separable (see kernelIsSeparable()), use
+ *          pixConvolveSep() with its factors, which takes (sx + sy)
+ *          pixel-ops for each output pixel instead of (sx * sy).
  * </pre>
  */
 PIX *
@@ -2188,6 +2197,10 @@ PIX  *pixt, *pixr, *pixg, *pixb, *pixd;
  *          product of the sampling factors.
  *      (5) This uses a mirrored border to avoid special casing on
  *          the boundaries.
+ *      (6) If the kernel is separable (see kernelIsSeparable()), it
+ *          is much faster to convolve with its factors, using
+ *          fpixConvolveSep().  The results are the same to within
+ *          float rounding.
  * </pre>
  */
 FPIX *
@@ -2195,12 +2208,9 @@ fpixConvolve(FPIX      *fpixs,
              L_KERNEL  *kel,
              l_int32    normflag)
 {
-l_int32     i, j, id, jd, k, m, w, h, wd, hd, sx, sy, cx, cy, wplt, wpld;
-l_float32   val;
-l_float32  *datat, *datad, *linet, *lined;
-l_float32   sum;
-L_KERNEL   *keli, *keln;
-FPIX       *fpixt, *fpixd;
+l_int32    w, h, wd, hd, sx, sy, cx, cy;
+L_KERNEL  *keli, *keln;
+FPIX      *fpixt, *fpixd;
 
     PROCNAME("fpixConvolve");
 
@@ -2227,25 +2237,7 @@ FPIX       *fpixt, *fpixd;
 
     wd = (w + ConvolveSamplingFactX - 1) / ConvolveSamplingFactX;
     hd = (h + ConvolveSamplingFactY - 1) / ConvolveSamplingFactY;
-    fpixd = fpixCreate(wd, hd);
-    datat = fpixGetData(fpixt);
-    datad = fpixGetData(fpixd);
-    wplt = fpixGetWpl(fpixt);
-    wpld = fpixGetWpl(fpixd);
-    for (i = 0, id = 0; id < hd; i += ConvolveSamplingFactY, id++) {
-        lined = datad + id * wpld;
-        for (j = 0, jd = 0; jd < wd; j += ConvolveSamplingFactX, jd++) {
-            sum = 0.0;
-            for (k = 0; k < sy; k++) {
-                linet = datat + (i + k) * wplt;
-                for (m = 0; m < sx; m++) {
-                    val = *(linet + j + m);
-                    sum += val * keln->data[k][m];
-                }
-            }
-            *(lined + jd) = sum;
-        }
-    }
+    fpixd = fpixConvolveLow(fpixt, keln, wd, hd);
 
 cleanup:
     kernelDestroy(&keli);
@@ -2272,14 +2264,12 @@ cleanup:
  *          the full kernel is the product of these components.
  *          The support for the full kernel is thus a rectangular region.
  *      (2) The normflag parameter is used as in fpixConvolve().
- *      (3) Warning: if you use l_setConvolveSampling() to get a
- *          subsampled output, and the sampling factor is larger than
- *          the kernel half-width, it is faster to use the non-separable
- *          version pixConvolve().  This is because the first convolution
- *          here must be done on every raster line, regardless of the
- *          vertical sampling factor.  If the sampling factor is smaller
- *          than kernel half-width, it's faster to use the separable
- *          convolution.
+ *      (3) With a subsampled output (see l_setConvolveSampling()),
+ *          the first convolution is only done on the raster lines that
+ *          are needed for the second one.  If the vertical sampling
+ *          factor is at least the height of %kely, that is every line
+ *          that the non-separable fpixConvolve() would use, and the
+ *          two take about the same time.
  *      (4) This uses mirrored borders to avoid special casing on
  *          the boundaries.
  * </pre>
@@ -2290,8 +2280,8 @@ fpixConvolveSep(FPIX      *fpixs,
                 L_KERNEL  *kely,
                 l_int32    normflag)
 {
-l_int32    xfact, yfact;
-L_KERNEL  *kelxn, *kelyn;
+l_int32    w, h, wd, hd, sx, sy, cx, cy, xfact, yfact;
+L_KERNEL  *kelxi, *kelyi, *kelxn, *kelyn;
 FPIX      *fpixt, *fpixd;
 
     PROCNAME("fpixConvolveSep");
@@ -2303,31 +2293,182 @@ FPIX      *fpixt, *fpixd;
     if (!kely)
         return (FPIX *)ERROR_PTR("kely not defined", procName, NULL);
 
-    xfact = ConvolveSamplingFactX;
-    yfact = ConvolveSamplingFactY;
-    if (normflag) {
-        kelxn = kernelNormalize(kelx, 1.0);
-        kelyn = kernelNormalize(kely, 1.0);
+        /* If the components are not 1D, do them in sequence */
+    if (kelx->sy != 1 || kely->sx != 1) {
+        xfact = ConvolveSamplingFactX;
+        yfact = ConvolveSamplingFactY;
         l_setConvolveSampling(xfact, 1);
-        fpixt = fpixConvolve(fpixs, kelxn, 0);
+        fpixt = fpixConvolve(fpixs, kelx, normflag);
         l_setConvolveSampling(1, yfact);
-        fpixd = fpixConvolve(fpixt, kelyn, 0);
+        fpixd = fpixConvolve(fpixt, kely, normflag);
         l_setConvolveSampling(xfact, yfact);  /* restore */
-        kernelDestroy(&kelxn);
-        kernelDestroy(&kelyn);
-    } else {  /* don't normalize */
-        l_setConvolveSampling(xfact, 1);
-        fpixt = fpixConvolve(fpixs, kelx, 0);
-        l_setConvolveSampling(1, yfact);
-        fpixd = fpixConvolve(fpixt, kely, 0);
-        l_setConvolveSampling(xfact, yfact);
+        fpixDestroy(&fpixt);
+        return fpixd;
+    }
+
+    fpixd = NULL;
+    kelxi = kernelInvert(kelx);
+    kelyi = kernelInvert(kely);
+    if (normflag) {
+        kelxn = kernelNormalize(kelxi, 1.0);
+        kelyn = kernelNormalize(kelyi, 1.0);
+    } else {
+        kelxn = kernelCopy(kelxi);
+        kelyn = kernelCopy(kelyi);
     }
+    kernelGetParameters(kelxn, NULL, &sx, NULL, &cx);
+    kernelGetParameters(kelyn, &sy, NULL, &cy, NULL);
 
+    fpixGetDimensions(fpixs, &w, &h);
+    fpixt = fpixAddMirroredBorder(fpixs, cx, sx - cx, cy, sy - cy);
+    if (!fpixt) {
+        L_ERROR("fpixt not made\n", procName);
+        goto cleanup;
+    }
+
+    wd = (w + ConvolveSamplingFactX - 1) / ConvolveSamplingFactX;
+    hd = (h + ConvolveSamplingFactY - 1) / ConvolveSamplingFactY;
+    fpixd = fpixConvolveSepLow(fpixt, kelxn, kelyn, wd, hd);
+
+cleanup:
+    kernelDestroy(&kelxi);
+    kernelDestroy(&kelyi);
+    kernelDestroy(&kelxn);
+    kernelDestroy(&kelyn);
     fpixDestroy(&fpixt);
     return fpixd;
 }
 
 
+/*!
+ * \brief   fpixConvolveLow()
+ *
+ * \param[in]    fpixt   with border added for the kernel
+ * \param[in]    kel     inverted and, if requested, normalized
+ * \param[in]    wd, hd  size of the output, after subsampling
+ * \return  fpixd, or NULL on error
+ */
+static FPIX *
+fpixConvolveLow(FPIX      *fpixt,
+                L_KERNEL  *kel,
+                l_int32    wd,
+                l_int32    hd)
+{
+l_int32     i, j, id, jd, k, m, sx, sy, xfact, yfact, wplt, wpld;
+l_float32   sum;
+l_float32  *datat, *datad, *linet, *lined, *kelrow;
+FPIX       *fpixd;
+
+    PROCNAME("fpixConvolveLow");
+
+    if ((fpixd = fpixCreate(wd, hd)) == NULL)
+        return (FPIX *)ERROR_PTR("fpixd not made", procName, NULL);
+    kernelGetParameters(kel, &sy, &sx, NULL, NULL);
+    xfact = ConvolveSamplingFactX;
+    yfact = ConvolveSamplingFactY;
+    datat = fpixGetData(fpixt);
+    datad = fpixGetData(fpixd);
+    wplt = fpixGetWpl(fpixt);
+    wpld = fpixGetWpl(fpixd);
+    for (i = 0, id = 0; id < hd; i += yfact, id++) {
+        lined = datad + id * wpld;
+        for (j = 0, jd = 0; jd < wd; j += xfact, jd++) {
+            sum = 0.0;
+            for (k = 0; k < sy; k++) {
+                linet = datat + (i + k) * wplt + j;
+                kelrow = kel->data[k];
+                for (m = 0; m < sx; m++)
+                    sum += linet[m] * kelrow[m];
+            }
+            lined[jd] = sum;
+        }
+    }
+
+    return fpixd;
+}
+
+
+/*!
+ * \brief   fpixConvolveSepLow()
+ *
+ * \param[in]    fpixt   with border added for the full kernel
+ * \param[in]    kelx    1 x sx; inverted and, if requested, normalized
+ * \param[in]    kely    sy x 1; inverted and, if requested, normalized
+ * \param[in]    wd, hd  size of the output, after subsampling
+ * \return  fpixd, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The convolution in x is done into a float buffer that holds
+ *          the subsampled columns for the raster lines that are used
+ *          by the convolution in y.  The convolution in y then
+ *          accumulates entire lines of that buffer, so that both passes
+ *          access memory sequentially.
+ * </pre>
+ */
+static FPIX *
+fpixConvolveSepLow(FPIX      *fpixt,
+                   L_KERNEL  *kelx,
+                   L_KERNEL  *kely,
+                   l_int32    wd,
+                   l_int32    hd)
+{
+l_int32     i, j, id, jd, k, m, sx, sy, xfact, yfact, nrows, wplt, wpld;
+l_float32   sum, val;
+l_float32  *datat, *datad, *buf, *linet, *lineb, *lined, *kelrow;
+FPIX       *fpixd;
+
+    PROCNAME("fpixConvolveSepLow");
+
+    kernelGetParameters(kelx, NULL, &sx, NULL, NULL);
+    kernelGetParameters(kely, &sy, NULL, NULL, NULL);
+    xfact = ConvolveSamplingFactX;
+    yfact = ConvolveSamplingFactY;
+    nrows = (hd - 1) * yfact + sy;
+    if ((buf = (l_float32 *)LEPT_CALLOC(nrows * wd, sizeof(l_float32)))
+        == NULL)
+        return (FPIX *)ERROR_PTR("buf not made", procName, NULL);
+    if ((fpixd = fpixCreate(wd, hd)) == NULL) {
+        LEPT_FREE(buf);
+        return (FPIX *)ERROR_PTR("fpixd not made", procName, NULL);
+    }
+    datat = fpixGetData(fpixt);
+    datad = fpixGetData(fpixd);
+    wplt = fpixGetWpl(fpixt);
+    wpld = fpixGetWpl(fpixd);
+
+        /* Convolve in x.  Raster line i is used for output lines
+         * with i - sy < id * yfact <= i, which exist iff
+         * (i % yfact) < sy. */
+    kelrow = kelx->data[0];
+    for (i = 0; i < nrows; i++) {
+        if (i % yfact >= sy) continue;
+        linet = datat + i * wplt;
+        lineb = buf + i * wd;
+        for (j = 0, jd = 0; jd < wd; j += xfact, jd++) {
+            sum = 0.0;
+            for (m = 0; m < sx; m++)
+                sum += linet[j + m] * kelrow[m];
+            lineb[jd] = sum;
+        }
+    }
+
+        /* Convolve in y */
+    for (i = 0, id = 0; id < hd; i += yfact, id++) {
+        lined = datad + id * wpld;
+        for (k = 0; k < sy; k++) {
+            lineb = buf + (i + k) * wd;
+            val = kely->data[k][0];
+            for (jd = 0; jd < wd; jd++)
+                lined[jd] += val * lineb[jd];
+        }
+    }
+
+    LEPT_FREE(buf);
+    return fpixd;
+}
+
+
 /*------------------------------------------------------------------------*
  *              Convolution with bias (for non-negative output)           *
  *------------------------------------------------------------------------*/
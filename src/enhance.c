@@ -45,6 +45,9 @@
  *
  *      Generic TRC mapper
  *           PIX     *pixTRCMap()
+ *           l_int32  pixTRCMapGeneral()
+ *           NUMA    *numaComposeTRC()
+ *           static void  trcMakeByteTab()
  *
  *      Unsharp-masking
  *           PIX     *pixUnsharpMasking()
@@ -121,6 +124,8 @@ static const l_float32  ENHANCE_SCALE_FACTOR = 5.;
     /* Default number of pixels sampled to determine histogram */
 static const l_int32  DEFAULT_HISTO_SAMPLES = 100000;
 
+static void trcMakeByteTab(NUMA *na, l_uint8 *tab);
+
 
 /*-------------------------------------------------------------*
  *         Gamma TRC (tone reproduction curve) mapping         *
@@ -766,11 +771,18 @@ NUMA      *nah, *nasum, *nad;
  *      (2) For 32 bpp, this applies the same map to each of the r,g,b
  *          components.
  *      (3) The mapping array is of size 256, and it maps the input
- *          index into values in the range [0, 255].
+ *          index into values in the range [0, 255].  Values outside
+ *          that range are clipped.
  *      (4) If defined, the optional 1 bpp mask pixm has its origin
  *          aligned with pixs, and the map function is applied only
  *          to pixels in pixs under the fg of pixm.
  *      (5) For 32 bpp, this does not save the alpha channel.
+ *      (6) 8 bpp images are mapped a full word (4 pixels) at a time.
+ *          With a mask, runs of 32 pixels that are entirely bg or
+ *          entirely fg in pixm are skipped or mapped without testing
+ *          each mask bit.
+ *      (7) To apply a sequence of TRCs in a single pass, first combine
+ *          their mapping arrays with numaComposeTRC().
  * </pre>
  */
 l_int32
@@ -778,9 +790,9 @@ pixTRCMap(PIX   *pixs,
           PIX   *pixm,
           NUMA  *na)
 {
-l_int32    w, h, d, wm, hm, wpl, wplm, i, j, sval8, dval8;
-l_int32   *tab;
-l_uint32   sval32, dval32;
+l_int32    w, h, d, wm, hm, wpl, wplm, i, j, k, nw, jend;
+l_uint8    tab[256];
+l_uint32   word, mword;
 l_uint32  *data, *datam, *line, *linem;
 
     PROCNAME("pixTRCMap");
@@ -801,79 +813,226 @@ l_uint32  *data, *datam, *line, *linem;
             return ERROR_INT("pixm not 1 bpp", procName, 1);
     }
 
-    tab = numaGetIArray(na);  /* get the array for efficiency */
+    if (d == 32)
+        return pixTRCMapGeneral(pixs, pixm, na, na, na);
+
+    trcMakeByteTab(na, tab);
     wpl = pixGetWpl(pixs);
     data = pixGetData(pixs);
     if (!pixm) {
-        if (d == 8) {
-            for (i = 0; i < h; i++) {
-                line = data + i * wpl;
-                for (j = 0; j < w; j++) {
-                    sval8 = GET_DATA_BYTE(line, j);
-                    dval8 = tab[sval8];
-                    SET_DATA_BYTE(line, j, dval8);
-                }
-            }
-        } else {  /* d == 32 */
-            for (i = 0; i < h; i++) {
-                line = data + i * wpl;
-                for (j = 0; j < w; j++) {
-                    sval32 = *(line + j);
-                    dval32 =
-                        tab[(sval32 >> L_RED_SHIFT) & 0xff] << L_RED_SHIFT |
-                        tab[(sval32 >> L_GREEN_SHIFT) & 0xff] << L_GREEN_SHIFT |
-                        tab[(sval32 >> L_BLUE_SHIFT) & 0xff] << L_BLUE_SHIFT;
-                    *(line + j) = dval32;
-                }
+        nw = w / 4;  /* full words; the remaining pixels are done singly */
+        for (i = 0; i < h; i++) {
+            line = data + i * wpl;
+            for (k = 0; k < nw; k++) {
+                word = line[k];
+                line[k] = ((l_uint32)tab[word >> 24] << 24) |
+                          (tab[(word >> 16) & 0xff] << 16) |
+                          (tab[(word >> 8) & 0xff] << 8) |
+                          tab[word & 0xff];
             }
+            for (j = 4 * nw; j < w; j++)
+                SET_DATA_BYTE(line, j, tab[GET_DATA_BYTE(line, j)]);
         }
     } else {
         datam = pixGetData(pixm);
         wplm = pixGetWpl(pixm);
         pixGetDimensions(pixm, &wm, &hm, NULL);
-        if (d == 8) {
-            for (i = 0; i < h; i++) {
-                if (i >= hm)
-                    break;
-                line = data + i * wpl;
-                linem = datam + i * wplm;
-                for (j = 0; j < w; j++) {
-                    if (j >= wm)
-                        break;
-                    if (GET_DATA_BIT(linem, j) == 0)
+        w = L_MIN(w, wm);
+        h = L_MIN(h, hm);
+        for (i = 0; i < h; i++) {
+            line = data + i * wpl;
+            linem = datam + i * wplm;
+            for (k = 0; 32 * k < w; k++) {
+                if ((mword = linem[k]) == 0)
+                    continue;
+                jend = L_MIN(32 * k + 32, w);
+                for (j = 32 * k; j < jend; j++) {
+                    if (mword != 0xffffffff &&
+                        ((mword >> (31 - (j & 31))) & 1) == 0)
                         continue;
-                    sval8 = GET_DATA_BYTE(line, j);
-                    dval8 = tab[sval8];
-                    SET_DATA_BYTE(line, j, dval8);
+                    SET_DATA_BYTE(line, j, tab[GET_DATA_BYTE(line, j)]);
                 }
             }
-        } else {  /* d == 32 */
-            for (i = 0; i < h; i++) {
-                if (i >= hm)
-                    break;
-                line = data + i * wpl;
-                linem = datam + i * wplm;
-                for (j = 0; j < w; j++) {
-                    if (j >= wm)
-                        break;
-                    if (GET_DATA_BIT(linem, j) == 0)
+        }
+    }
+
+    return 0;
+}
+
+
+/*!
+ * \brief   pixTRCMapGeneral()
+ *
+ * \param[in]    pixs 32 bpp rgb; not colormapped
+ * \param[in]    pixm [optional] 1 bpp mask
+ * \param[in]    nar, nag, nab mapping arrays
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This operation is in-place on pixs.
+ *      (2) Each of the r,g,b mapping arrays is of size 256.  They map the
+ *          input component value into values in the range [0, 255];
+ *          values outside that range are clipped.
+ *      (3) If defined, the optional 1 bpp mask pixm has its origin
+ *          aligned with pixs, and the map function is applied only
+ *          to pixels in pixs under the fg of pixm.
+ *      (4) This does not save the alpha channel.
+ * </pre>
+ */
+l_int32
+pixTRCMapGeneral(PIX   *pixs,
+                 PIX   *pixm,
+                 NUMA  *nar,
+                 NUMA  *nag,
+                 NUMA  *nab)
+{
+l_int32    w, h, wm, hm, wpl, wplm, i, j, k, jend;
+l_uint8    rtab[256], gtab[256], btab[256];
+l_uint32   sval32, mword, rval, gval, bval;
+l_uint32  *data, *datam, *line, *linem;
+
+    PROCNAME("pixTRCMapGeneral");
+
+    if (!pixs || pixGetDepth(pixs) != 32)
+        return ERROR_INT("pixs not defined or not 32 bpp", procName, 1);
+    if (pixm && pixGetDepth(pixm) != 1)
+        return ERROR_INT("pixm defined and not 1 bpp", procName, 1);
+    if (!nar || !nag || !nab)
+        return ERROR_INT("na{r,g,b} not all defined", procName, 1);
+    if (numaGetCount(nar) != 256 || numaGetCount(nag) != 256 ||
+        numaGetCount(nab) != 256)
+        return ERROR_INT("na{r,g,b} not all of size 256", procName, 1);
+
+    trcMakeByteTab(nar, rtab);
+    trcMakeByteTab(nag, gtab);
+    trcMakeByteTab(nab, btab);
+    pixGetDimensions(pixs, &w, &h, NULL);
+    wpl = pixGetWpl(pixs);
+    data = pixGetData(pixs);
+    if (!pixm) {
+        for (i = 0; i < h; i++) {
+            line = data + i * wpl;
+            for (j = 0; j < w; j++) {
+                sval32 = line[j];
+                rval = rtab[(sval32 >> L_RED_SHIFT) & 0xff];
+                gval = gtab[(sval32 >> L_GREEN_SHIFT) & 0xff];
+                bval = btab[(sval32 >> L_BLUE_SHIFT) & 0xff];
+                line[j] = (rval << L_RED_SHIFT) | (gval << L_GREEN_SHIFT) |
+                          (bval << L_BLUE_SHIFT);
+            }
+        }
+    } else {
+        datam = pixGetData(pixm);
+        wplm = pixGetWpl(pixm);
+        pixGetDimensions(pixm, &wm, &hm, NULL);
+        w = L_MIN(w, wm);
+        h = L_MIN(h, hm);
+        for (i = 0; i < h; i++) {
+            line = data + i * wpl;
+            linem = datam + i * wplm;
+            for (k = 0; 32 * k < w; k++) {
+                if ((mword = linem[k]) == 0)
+                    continue;
+                jend = L_MIN(32 * k + 32, w);
+                for (j = 32 * k; j < jend; j++) {
+                    if (mword != 0xffffffff &&
+                        ((mword >> (31 - (j & 31))) & 1) == 0)
                         continue;
-                    sval32 = *(line + j);
-                    dval32 =
-                        tab[(sval32 >> L_RED_SHIFT) & 0xff] << L_RED_SHIFT |
-                        tab[(sval32 >> L_GREEN_SHIFT) & 0xff] << L_GREEN_SHIFT |
-                        tab[(sval32 >> L_BLUE_SHIFT) & 0xff] << L_BLUE_SHIFT;
-                    *(line + j) = dval32;
+                    sval32 = line[j];
+                    rval = rtab[(sval32 >> L_RED_SHIFT) & 0xff];
+                    gval = gtab[(sval32 >> L_GREEN_SHIFT) & 0xff];
+                    bval = btab[(sval32 >> L_BLUE_SHIFT) & 0xff];
+                    line[j] = (rval << L_RED_SHIFT) |
+                              (gval << L_GREEN_SHIFT) |
+                              (bval << L_BLUE_SHIFT);
                 }
             }
         }
     }
 
-    LEPT_FREE(tab);
     return 0;
 }
 
 
+/*!
+ * \brief   numaComposeTRC()
+ *
+ * \param[in]    na1 first mapping array, of size 256
+ * \param[in]    na2 second mapping array, of size 256
+ * \return  nad composite mapping array, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The result applies na1 followed by na2:
+ *              nad[i] = na2[na1[i]]
+ *          Output values of na1 are clipped to [0, 255] before they
+ *          are used to index na2.
+ *      (2) Any sequence of TRCs (e.g., from numaGammaTRC(),
+ *          numaContrastTRC() and numaEqualizeTRC()) can be composed
+ *          this way and applied to an image in one pass with
+ *          pixTRCMap().  For example, a gamma correction followed
+ *          by contrast enhancement:
+ *              nag = numaGammaTRC(gamma, minval, maxval);
+ *              nac = numaContrastTRC(factor);
+ *              na = numaComposeTRC(nag, nac);
+ *              pixTRCMap(pixs, pixm, na);
+ * </pre>
+ */
+NUMA *
+numaComposeTRC(NUMA  *na1,
+               NUMA  *na2)
+{
+l_int32  i, val;
+l_uint8  tab1[256], tab2[256];
+NUMA    *nad;
+
+    PROCNAME("numaComposeTRC");
+
+    if (!na1 || !na2)
+        return (NUMA *)ERROR_PTR("na1 and na2 not both defined",
+                                 procName, NULL);
+    if (numaGetCount(na1) != 256 || numaGetCount(na2) != 256)
+        return (NUMA *)ERROR_PTR("na1 and na2 not both of size 256",
+                                 procName, NULL);
+
+    trcMakeByteTab(na1, tab1);
+    trcMakeByteTab(na2, tab2);
+    if ((nad = numaCreate(256)) == NULL)
+        return (NUMA *)ERROR_PTR("nad not made", procName, NULL);
+    for (i = 0; i < 256; i++) {
+        val = tab2[tab1[i]];
+        numaAddNumber(nad, val);
+    }
+    return nad;
+}
+
+
+/*!
+ * \brief   trcMakeByteTab()
+ *
+ * \param[in]    na mapping array, of size 256
+ * \param[in]    tab array of 256 bytes, to be filled
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Values in na are rounded and clipped to [0, 255].
+ * </pre>
+ */
+static void
+trcMakeByteTab(NUMA     *na,
+               l_uint8  *tab)
+{
+l_int32  i, ival;
+
+    for (i = 0; i < 256; i++) {
+        numaGetIValue(na, i, &ival);
+        tab[i] = (l_uint8)L_MAX(0, L_MIN(ival, 255));
+    }
+}
+
+
 
 /*-----------------------------------------------------------------------*
  *                             Unsharp masking                           *
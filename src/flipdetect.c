@@ -37,11 +37,17 @@
  *          l_int32      pixUpDownDetectDwa()
  *          l_int32      pixUpDownDetectGeneralDwa()
  *
+ *      Page orientation correction (pure rotation by 90 degree increments):
+ *          PIX         *pixOrientCorrect()
+ *          PIXA        *pixaOrientCorrect()
+ *
  *      Page mirror detection (flip 180 degrees about line in plane of image):
  *          l_int32      pixMirrorDetect()
  *          l_int32      pixMirrorDetectDwa()
  *
- *      Static debug helper
+ *      Static helpers
+ *          l_int32      pixUpDownCountsDwa()
+ *          l_float32    upDownConfidence()
  *          void         pixDebugFlipDetect()
  *
  *  ===================================================================
@@ -201,7 +207,12 @@ static const l_float32  DEFAULT_MIN_UP_DOWN_RATIO = 2.5;
 static const l_int32  DEFAULT_MIN_MIRROR_FLIP_COUNT = 100;
 static const l_float32  DEFAULT_MIN_MIRROR_FLIP_CONF = 5.0;
 
-    /* Static debug function */
+    /* Static functions */
+static l_int32 pixUpDownCountsDwa(PIX *pixs, l_int32 npixels,
+                                  l_int32 *pcountup, l_int32 *pcountdown,
+                                  l_int32 debug);
+static l_float32 upDownConfidence(l_int32 countup, l_int32 countdown,
+                                  l_int32 mincount);
 static void pixDebugFlipDetect(const char *filename, PIX *pixs,
                                PIX *pixhm, l_int32 enable);
 
@@ -520,7 +531,7 @@ SEL       *sel1, *sel2, *sel3, *sel4;
         pixAnd(pixt1, pixt1, pixm);
     pixt3 = pixReduceRankBinaryCascade(pixt1, 1, 1, 0, 0);
     pixCountPixels(pixt3, &countup, NULL);
-    pixDebugFlipDetect("junkpixup", pixs, pixt1, debug);
+    pixDebugFlipDetect("pixup", pixs, pixt1, debug);
     pixDestroy(&pixt1);
     pixDestroy(&pixt2);
     pixDestroy(&pixt3);
@@ -533,7 +544,7 @@ SEL       *sel1, *sel2, *sel3, *sel4;
         pixAnd(pixt1, pixt1, pixm);
     pixt3 = pixReduceRankBinaryCascade(pixt1, 1, 1, 0, 0);
     pixCountPixels(pixt3, &countdown, NULL);
-    pixDebugFlipDetect("junkpixdown", pixs, pixt1, debug);
+    pixDebugFlipDetect("pixdown", pixs, pixt1, debug);
     pixDestroy(&pixt1);
     pixDestroy(&pixt2);
     pixDestroy(&pixt3);
@@ -547,7 +558,10 @@ SEL       *sel1, *sel2, *sel3, *sel4;
         *pconf = 2. * ((nup - ndown) / sqrt(nup + ndown));
 
     if (debug) {
-        if (pixm) pixWrite("junkpixm1", pixm, IFF_PNG);
+        if (pixm) {
+            lept_mkdir("lept/orient");
+            pixWrite("/tmp/lept/orient/pixm1.png", pixm, IFF_PNG);
+        }
         fprintf(stderr, "nup = %7.3f, ndown = %7.3f, conf = %7.3f\n",
                 nup, ndown, *pconf);
         if (*pconf > DEFAULT_MIN_UP_DOWN_CONF)
@@ -678,13 +692,7 @@ pixUpDownDetectGeneralDwa(PIX        *pixs,
                           l_int32     npixels,
                           l_int32     debug)
 {
-char       flipsel1[] = "flipsel1";
-char       flipsel2[] = "flipsel2";
-char       flipsel3[] = "flipsel3";
-char       flipsel4[] = "flipsel4";
-l_int32    countup, countdown, nmax;
-l_float32  nup, ndown;
-PIX       *pixt, *pixt0, *pixt1, *pixt2, *pixt3, *pixm;
+l_int32  countup, countdown;
 
     PROCNAME("pixUpDownDetectGeneralDwa");
 
@@ -698,90 +706,241 @@ PIX       *pixt, *pixt0, *pixt1, *pixt2, *pixt3, *pixm;
     if (npixels < 0)
         npixels = 0;
 
-        /* One of many reasonable pre-filtering sequences: (1, 8) and (30, 1).
-         * This closes holes in x-height characters and joins them at
-         * the x-height.  There is more noise in the descender detection
-         * from this, but it works fairly well. */
-    pixt = pixMorphSequenceDwa(pixs, "c1.8 + c30.1", 0);
-
-        /* Be sure to add the border before the flip DWA operations! */
-    pixt0 = pixAddBorderGeneral(pixt, ADDED_BORDER, ADDED_BORDER,
-                                ADDED_BORDER, ADDED_BORDER, 0);
-    pixDestroy(&pixt);
-
-        /* Optionally, make a mask of the word bounding boxes, shortening
-         * each of them by a fixed amount at each end. */
-    pixm = NULL;
-    if (npixels > 0) {
-        l_int32  i, nbox, x, y, w, h;
-        BOX   *box;
-        BOXA  *boxa;
-        pixt1 = pixMorphSequenceDwa(pixt0, "o10.1", 0);
-        boxa = pixConnComp(pixt1, NULL, 8);
-        pixm = pixCreateTemplate(pixt1);
-        pixDestroy(&pixt1);
-        nbox = boxaGetCount(boxa);
-        for (i = 0; i < nbox; i++) {
-            box = boxaGetBox(boxa, i, L_CLONE);
-            boxGetGeometry(box, &x, &y, &w, &h);
-            if (w > 2 * npixels)
-                pixRasterop(pixm, x + npixels, y - 6, w - 2 * npixels, h + 13,
-                            PIX_SET, NULL, 0, 0);
-            boxDestroy(&box);
-        }
-        boxaDestroy(&boxa);
-    }
-
-        /* Find the ascenders and optionally filter with pixm.
-         * For an explanation of the procedure used for counting the result
-         * of the HMT, see comments in pixUpDownDetectGeneral().  */
-    pixt1 = pixFlipFHMTGen(NULL, pixt0, flipsel1);
-    pixt2 = pixFlipFHMTGen(NULL, pixt0, flipsel2);
-    pixOr(pixt1, pixt1, pixt2);
-    if (pixm)
-        pixAnd(pixt1, pixt1, pixm);
-    pixt3 = pixReduceRankBinaryCascade(pixt1, 1, 1, 0, 0);
-    pixCountPixels(pixt3, &countup, NULL);
-    pixDestroy(&pixt1);
-    pixDestroy(&pixt2);
-    pixDestroy(&pixt3);
-
-        /* Find the ascenders and optionally filter with pixm. */
-    pixt1 = pixFlipFHMTGen(NULL, pixt0, flipsel3);
-    pixt2 = pixFlipFHMTGen(NULL, pixt0, flipsel4);
-    pixOr(pixt1, pixt1, pixt2);
-    if (pixm)
-        pixAnd(pixt1, pixt1, pixm);
-    pixt3 = pixReduceRankBinaryCascade(pixt1, 1, 1, 0, 0);
-    pixCountPixels(pixt3, &countdown, NULL);
-    pixDestroy(&pixt1);
-    pixDestroy(&pixt2);
-    pixDestroy(&pixt3);
-
-        /* Evaluate statistically, generating a confidence that is
-         * related to the probability with a gaussian distribution. */
-    nup = (l_float32)(countup);
-    ndown = (l_float32)(countdown);
-    nmax = L_MAX(countup, countdown);
-    if (nmax > mincount)
-        *pconf = 2. * ((nup - ndown) / sqrt(nup + ndown));
+    if (pixUpDownCountsDwa(pixs, npixels, &countup, &countdown, debug))
+        return ERROR_INT("up-down counts not made", procName, 1);
+    *pconf = upDownConfidence(countup, countdown, mincount);
 
     if (debug) {
-        if (pixm) pixWrite("junkpixm2", pixm, IFF_PNG);
         fprintf(stderr, "nup = %7.3f, ndown = %7.3f, conf = %7.3f\n",
-                nup, ndown, *pconf);
+                (l_float32)countup, (l_float32)countdown, *pconf);
         if (*pconf > DEFAULT_MIN_UP_DOWN_CONF)
             fprintf(stderr, "Text is rightside-up\n");
         if (*pconf < -DEFAULT_MIN_UP_DOWN_CONF)
             fprintf(stderr, "Text is upside-down\n");
     }
 
-    pixDestroy(&pixt0);
-    pixDestroy(&pixm);
     return 0;
 }
 
 
+/*----------------------------------------------------------------*
+ *            Orientation correction (four 90 degree angles)      *
+ *----------------------------------------------------------------*/
+/*!
+ * \brief   pixOrientCorrect()
+ *
+ * \param[in]    pixs 1 bpp, or converted to 1 bpp; deskewed English text
+ * \param[in]    minupconf minimum value for which a decision can be made
+ * \param[in]    minratio minimum conf ratio required for a decision
+ * \param[in]    mirror 1 to also detect and correct LR mirror reversal
+ * \param[out]   pupconf [optional] ; use NULL to skip
+ * \param[out]   pleftconf [optional] ; use NULL to skip
+ * \param[out]   pmirrorconf [optional] ; use NULL to skip
+ * \param[out]   protation [optional] ; use NULL to skip
+ * \param[out]   pflip [optional] 1 if LR flipped; use NULL to skip
+ * \param[in]    debug 1 for debug output; 0 otherwise
+ * \return  pixd  with text rightside-up, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is a single pass classifier for the four 90 degree
+ *          orientations.  The ascender and descender HMT counts for
+ *          0 and 180 degrees come from one pre-filtered image, and
+ *          those for 90 and 270 degrees come from one pre-filtered
+ *          image rotated 90 degrees cw.  upconf and leftconf are
+ *          identical to those from pixOrientDetectDwa().  The
+ *          decision is made with makeOrientDecision().
+ *      (2) If pixs is not 1 bpp, it is converted with a threshold
+ *          of 130 for the detection.
+ *      (3) Input 0.0 for the default values for minupconf and minratio.
+ *      (4) The returned rotation is the cw angle, in degrees, that
+ *          was applied to pixs: 0, 90, 180 or 270.  If the orientation
+ *          can't be determined, pixd is a copy of pixs and the
+ *          rotation is 0.
+ *      (5) If %mirror == 1 and the orientation is known, the 1 bpp
+ *          image that is rightside-up is tested with pixMirrorDetectDwa().
+ *          If the text is found to be mirror reversed, pixd is flipped
+ *          LR after the rotation and %flip is 1.
+ *      (6) The 1 bpp image and its 90 degree rotation made for the
+ *          detection are reused for the mirror detection and, if
+ *          pixs is 1 bpp, for the correction.
+ * </pre>
+ */
+PIX *
+pixOrientCorrect(PIX        *pixs,
+                 l_float32   minupconf,
+                 l_float32   minratio,
+                 l_int32     mirror,
+                 l_float32  *pupconf,
+                 l_float32  *pleftconf,
+                 l_float32  *pmirrorconf,
+                 l_int32    *protation,
+                 l_int32    *pflip,
+                 l_int32     debug)
+{
+l_int32    orient, reuse, rotation;
+l_int32    count0, count90, count180, count270;
+l_float32  upconf, leftconf, mirrorconf;
+PIX       *pix1, *pix2, *pixb, *pixd;
+
+    PROCNAME("pixOrientCorrect");
+
+    if (pupconf) *pupconf = 0.0;
+    if (pleftconf) *pleftconf = 0.0;
+    if (pmirrorconf) *pmirrorconf = 0.0;
+    if (protation) *protation = 0;
+    if (pflip) *pflip = 0;
+    if (!pixs)
+        return (PIX *)ERROR_PTR("pixs not defined", procName, NULL);
+
+        /* Get the up and down counts at 0 and 90 degree rotation.
+         * The down counts are the up counts at 180 and 270 degrees. */
+    reuse = (pixGetDepth(pixs) == 1 && !pixGetColormap(pixs));
+    if (reuse)
+        pix1 = pixClone(pixs);
+    else
+        pix1 = pixConvertTo1(pixs, 130);
+    if (!pix1)
+        return (PIX *)ERROR_PTR("pix1 not made", procName, NULL);
+    pix2 = pixRotate90(pix1, 1);
+    if (pixUpDownCountsDwa(pix1, 0, &count0, &count180, debug) ||
+        pixUpDownCountsDwa(pix2, 0, &count90, &count270, debug)) {
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+        return (PIX *)ERROR_PTR("counts not made", procName, NULL);
+    }
+    upconf = upDownConfidence(count0, count180, DEFAULT_MIN_UP_DOWN_COUNT);
+    leftconf = upDownConfidence(count90, count270, DEFAULT_MIN_UP_DOWN_COUNT);
+    if (pupconf) *pupconf = upconf;
+    if (pleftconf) *pleftconf = leftconf;
+    if (debug)
+        fprintf(stderr, "counts: 0: %d, 90: %d, 180: %d, 270: %d\n",
+                count0, count90, count180, count270);
+
+        /* Decide what to do */
+    orient = L_TEXT_ORIENT_UNKNOWN;
+    if (upconf != 0.0 && leftconf != 0.0)
+        makeOrientDecision(upconf, leftconf, minupconf, minratio,
+                           &orient, debug);
+
+        /* Get the 1 bpp image that is rightside-up */
+    switch (orient)
+    {
+    case L_TEXT_ORIENT_LEFT:
+        pixb = pixClone(pix2);
+        rotation = 90;
+        break;
+    case L_TEXT_ORIENT_DOWN:
+        pixb = pixRotate180(NULL, pix1);
+        rotation = 180;
+        break;
+    case L_TEXT_ORIENT_RIGHT:
+        pixb = pixRotate180(NULL, pix2);
+        rotation = 270;
+        break;
+    default:  /* L_TEXT_ORIENT_UNKNOWN or L_TEXT_ORIENT_UP */
+        pixb = pixClone(pix1);
+        rotation = 0;
+        break;
+    }
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    if (protation) *protation = rotation;
+
+        /* Do it */
+    if (rotation == 0)
+        pixd = pixCopy(NULL, pixs);
+    else if (reuse)
+        pixd = pixClone(pixb);
+    else
+        pixd = pixRotateOrth(pixs, rotation / 90);
+
+        /* Optionally, undo any mirror reversal */
+    if (mirror && orient != L_TEXT_ORIENT_UNKNOWN) {
+        pixMirrorDetectDwa(pixb, &mirrorconf, 0, debug);
+        if (pmirrorconf) *pmirrorconf = mirrorconf;
+        if (mirrorconf < -DEFAULT_MIN_MIRROR_FLIP_CONF) {
+            pixFlipLR(pixd, pixd);
+            if (pflip) *pflip = 1;
+        }
+    }
+
+    pixDestroy(&pixb);
+    return pixd;
+}
+
+
+/*!
+ * \brief   pixaOrientCorrect()
+ *
+ * \param[in]    pixas of pages with deskewed English text
+ * \param[in]    minupconf minimum value for which a decision can be made
+ * \param[in]    minratio minimum conf ratio required for a decision
+ * \param[in]    mirror 1 to also detect and correct LR mirror reversal
+ * \param[out]   pnarot [optional] cw rotation applied to each page
+ * \param[out]   pnaflip [optional] 1 for each page that was LR flipped
+ * \return  pixad with text rightside-up, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This applies pixOrientCorrect() to each page.  The
+ *          rotation of each page, in degrees, is returned in %narot,
+ *          and whether it was found to be mirror reversed and
+ *          flipped is returned in %naflip.
+ *      (2) The boxa of pixas is not copied, because the page
+ *          dimensions change with a 90 degree rotation.
+ * </pre>
+ */
+PIXA *
+pixaOrientCorrect(PIXA       *pixas,
+                  l_float32   minupconf,
+                  l_float32   minratio,
+                  l_int32     mirror,
+                  NUMA      **pnarot,
+                  NUMA      **pnaflip)
+{
+l_int32  i, n, rotation, flip;
+NUMA    *narot, *naflip;
+PIX     *pix1, *pix2;
+PIXA    *pixad;
+
+    PROCNAME("pixaOrientCorrect");
+
+    if (pnarot) *pnarot = NULL;
+    if (pnaflip) *pnaflip = NULL;
+    if (!pixas)
+        return (PIXA *)ERROR_PTR("pixas not defined", procName, NULL);
+
+    n = pixaGetCount(pixas);
+    pixad = pixaCreate(n);
+    narot = numaCreate(n);
+    naflip = numaCreate(n);
+    for (i = 0; i < n; i++) {
+        pix1 = pixaGetPix(pixas, i, L_CLONE);
+        pix2 = pixOrientCorrect(pix1, minupconf, minratio, mirror, NULL,
+                                NULL, NULL, &rotation, &flip, 0);
+        if (pix2) {
+            pixaAddPix(pixad, pix2, L_INSERT);
+        } else {
+            L_ERROR("page %d not corrected\n", procName, i);
+            pixaAddPix(pixad, pix1, L_COPY);
+        }
+        numaAddNumber(narot, rotation);
+        numaAddNumber(naflip, flip);
+        pixDestroy(&pix1);
+    }
+
+    if (pnarot)
+        *pnarot = narot;
+    else
+        numaDestroy(&narot);
+    if (pnaflip)
+        *pnaflip = naflip;
+    else
+        numaDestroy(&naflip);
+    return pixad;
+}
+
 
 /*----------------------------------------------------------------*
  *                     Left-right mirror detection                *
@@ -863,7 +1022,7 @@ SEL       *sel1, *sel2;
     pixt1 = pixHMT(NULL, pixt0, sel1);
     pixt3 = pixReduceRankBinaryCascade(pixt1, 1, 1, 0, 0);
     pixCountPixels(pixt3, &count1, NULL);
-    pixDebugFlipDetect("junkpixright", pixs, pixt1, debug);
+    pixDebugFlipDetect("pixright", pixs, pixt1, debug);
     pixDestroy(&pixt1);
     pixDestroy(&pixt3);
 
@@ -871,7 +1030,7 @@ SEL       *sel1, *sel2;
     pixt2 = pixHMT(NULL, pixt0, sel2);
     pixt3 = pixReduceRankBinaryCascade(pixt2, 1, 1, 0, 0);
     pixCountPixels(pixt3, &count2, NULL);
-    pixDebugFlipDetect("junkpixleft", pixs, pixt2, debug);
+    pixDebugFlipDetect("pixleft", pixs, pixt2, debug);
     pixDestroy(&pixt2);
     pixDestroy(&pixt3);
 
@@ -985,13 +1144,151 @@ PIX       *pixt0, *pixt1, *pixt2, *pixt3;
 }
 
 
+/*----------------------------------------------------------------*
+ *                   Static up-down count helpers                 *
+ *----------------------------------------------------------------*/
+/*
+ *  pixUpDownCountsDwa()
+ *
+ *      Input:  pixs (1 bpp, deskewed, English text)
+ *              npixels (number of pixels removed from each side of
+ *                       word box; 0 for no word mask)
+ *              &countup (<return> number of up ascenders)
+ *              &countdown (<return> number of down ascenders)
+ *              debug (1 for debug output; 0 otherwise)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) The countdown is the number of up ascenders found in
+ *          pixs rotated by 180 degrees, so one pre-filtering of pixs
+ *          gives the counts for both 0 and 180 degrees.
+ *      (2) See pixUpDownDetectGeneral() for details.
+ */
+static l_int32
+pixUpDownCountsDwa(PIX      *pixs,
+                   l_int32   npixels,
+                   l_int32  *pcountup,
+                   l_int32  *pcountdown,
+                   l_int32   debug)
+{
+char    flipsel1[] = "flipsel1";
+char    flipsel2[] = "flipsel2";
+char    flipsel3[] = "flipsel3";
+char    flipsel4[] = "flipsel4";
+PIX    *pixt, *pixt0, *pixt1, *pixt2, *pixt3, *pixm;
+
+    PROCNAME("pixUpDownCountsDwa");
+
+    *pcountup = *pcountdown = 0;
+
+        /* One of many reasonable pre-filtering sequences: (1, 8) and (30, 1).
+         * This closes holes in x-height characters and joins them at
+         * the x-height.  There is more noise in the descender detection
+         * from this, but it works fairly well. */
+    if ((pixt = pixMorphSequenceDwa(pixs, "c1.8 + c30.1", 0)) == NULL)
+        return ERROR_INT("pixt not made", procName, 1);
+
+        /* Be sure to add the border before the flip DWA operations! */
+    pixt0 = pixAddBorderGeneral(pixt, ADDED_BORDER, ADDED_BORDER,
+                                ADDED_BORDER, ADDED_BORDER, 0);
+    pixDestroy(&pixt);
+
+        /* Optionally, make a mask of the word bounding boxes, shortening
+         * each of them by a fixed amount at each end. */
+    pixm = NULL;
+    if (npixels > 0) {
+        l_int32  i, nbox, x, y, w, h;
+        BOX   *box;
+        BOXA  *boxa;
+        pixt1 = pixMorphSequenceDwa(pixt0, "o10.1", 0);
+        boxa = pixConnComp(pixt1, NULL, 8);
+        pixm = pixCreateTemplate(pixt1);
+        pixDestroy(&pixt1);
+        nbox = boxaGetCount(boxa);
+        for (i = 0; i < nbox; i++) {
+            box = boxaGetBox(boxa, i, L_CLONE);
+            boxGetGeometry(box, &x, &y, &w, &h);
+            if (w > 2 * npixels)
+                pixRasterop(pixm, x + npixels, y - 6, w - 2 * npixels, h + 13,
+                            PIX_SET, NULL, 0, 0);
+            boxDestroy(&box);
+        }
+        boxaDestroy(&boxa);
+    }
+
+        /* Find the ascenders and optionally filter with pixm.
+         * For an explanation of the procedure used for counting the result
+         * of the HMT, see comments in pixUpDownDetectGeneral().  */
+    pixt1 = pixFlipFHMTGen(NULL, pixt0, flipsel1);
+    pixt2 = pixFlipFHMTGen(NULL, pixt0, flipsel2);
+    pixOr(pixt1, pixt1, pixt2);
+    if (pixm)
+        pixAnd(pixt1, pixt1, pixm);
+    pixt3 = pixReduceRankBinaryCascade(pixt1, 1, 1, 0, 0);
+    pixCountPixels(pixt3, pcountup, NULL);
+    pixDestroy(&pixt1);
+    pixDestroy(&pixt2);
+    pixDestroy(&pixt3);
+
+        /* Find the ascenders and optionally filter with pixm. */
+    pixt1 = pixFlipFHMTGen(NULL, pixt0, flipsel3);
+    pixt2 = pixFlipFHMTGen(NULL, pixt0, flipsel4);
+    pixOr(pixt1, pixt1, pixt2);
+    if (pixm)
+        pixAnd(pixt1, pixt1, pixm);
+    pixt3 = pixReduceRankBinaryCascade(pixt1, 1, 1, 0, 0);
+    pixCountPixels(pixt3, pcountdown, NULL);
+    pixDestroy(&pixt1);
+    pixDestroy(&pixt2);
+    pixDestroy(&pixt3);
+
+    if (debug && pixm) {
+        lept_mkdir("lept/orient");
+        pixWrite("/tmp/lept/orient/pixm2.png", pixm, IFF_PNG);
+    }
+
+    pixDestroy(&pixt0);
+    pixDestroy(&pixm);
+    return 0;
+}
+
+
+/*
+ *  upDownConfidence()
+ *
+ *      Input:  countup (number of up ascenders)
+ *              countdown (number of down ascenders)
+ *              mincount (min number of up or down for a decision)
+ *      Return: conf (confidence that text is rightside-up; 0.0 if
+ *                    there are too few ascenders)
+ *
+ *  Notes:
+ *      (1) This evaluates the counts statistically, generating a
+ *          confidence that is related to the probability with a
+ *          gaussian distribution.
+ */
+static l_float32
+upDownConfidence(l_int32  countup,
+                 l_int32  countdown,
+                 l_int32  mincount)
+{
+l_float32  nup, ndown;
+
+    if (L_MAX(countup, countdown) <= mincount)
+        return 0.0;
+    nup = (l_float32)(countup);
+    ndown = (l_float32)(countdown);
+    return 2. * ((nup - ndown) / sqrt(nup + ndown));
+}
+
+
 /*----------------------------------------------------------------*
  *                        Static debug helper                     *
  *----------------------------------------------------------------*/
 /*
  *  pixDebugFlipDetect()
  *
- *      Input:  filename (for output debug file)
+ *      Input:  filename (root name of debug file in /tmp/lept/orient)
  *              pixs (input to pix*Detect)
  *              pixhm (hit-miss result from ascenders or descenders)
  *              enable (1 to enable this function; 0 to disable)
@@ -1003,6 +1300,7 @@ pixDebugFlipDetect(const char *filename,
                    PIX        *pixhm,
                    l_int32     enable)
 {
+char  buf[256];
 PIX  *pixt, *pixthm;
 
    if (!enable) return;
@@ -1012,7 +1310,9 @@ PIX  *pixt, *pixthm;
     pixthm = pixMorphSequence(pixhm, "d5.5", 0);
     pixSetMaskedCmap(pixt, pixthm, 0, 0, 255, 0, 0);
 
-    pixWrite(filename, pixt, IFF_PNG);
+    lept_mkdir("lept/orient");
+    snprintf(buf, sizeof(buf), "/tmp/lept/orient/%s.png", filename);
+    pixWrite(buf, pixt, IFF_PNG);
     pixDestroy(&pixthm);
     pixDestroy(&pixt);
     return;
@@ -32,6 +32,7 @@
  *          PIX            *pixReadStreamGif()
  *          static PIX     *gifToPix()
  *          static PIX     *pixUninterlaceGIF()
+ *          l_int32         freadHeaderGif()
  *
  *    Write gif file
  *          l_int32         pixWriteStreamGif()
@@ -339,6 +340,104 @@ PIX       *pixd;
 }
 
 
+/*!
+ * \brief   freadHeaderGif()
+ *
+ * \param[in]    fp file stream opened for read
+ * \param[out]   pw, ph [optional] width and height
+ * \param[out]   pbps [optional] bits/sample
+ * \param[out]   pspp [optional] samples/pixel; always 1
+ * \param[out]   piscmap [optional] always 1
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This walks the gif block structure up to the descriptor of
+ *          the first image, skipping the global color table and any
+ *          extension blocks without decoding them.  It returns the
+ *          values that pixReadStreamGif() would give the pix, which
+ *          is made from the first image only.
+ *      (2) The depth is determined, as in gifToPix(), by the size of
+ *          the colormap for the first image: the local one if it
+ *          exists, and otherwise the global one.
+ * </pre>
+ */
+l_int32
+freadHeaderGif(FILE     *fp,
+               l_int32  *pw,
+               l_int32  *ph,
+               l_int32  *pbps,
+               l_int32  *pspp,
+               l_int32  *piscmap)
+{
+l_uint8  buf[13];
+l_int32  c, n, w, h, d, ncolors, gcolors;
+
+    PROCNAME("freadHeaderGif");
+
+    if (pw) *pw = 0;
+    if (ph) *ph = 0;
+    if (pbps) *pbps = 0;
+    if (pspp) *pspp = 0;
+    if (piscmap) *piscmap = 0;
+    if (!fp)
+        return ERROR_INT("stream not defined", procName, 1);
+
+        /* Signature and logical screen descriptor */
+    if (fread(buf, 1, 13, fp) != 13)
+        return ERROR_INT("gif header not read", procName, 1);
+    if (memcmp(buf, "GIF87a", 6) && memcmp(buf, "GIF89a", 6))
+        return ERROR_INT("not gif format", procName, 1);
+    gcolors = 0;
+    if (buf[10] & 0x80) {
+        gcolors = 1 << ((buf[10] & 0x07) + 1);
+        if (fseek(fp, 3 * gcolors, SEEK_CUR))
+            return ERROR_INT("global cmap not skipped", procName, 1);
+    }
+
+        /* Skip extension blocks until the first image descriptor */
+    while ((c = fgetc(fp)) == 0x21) {
+        if (fgetc(fp) == EOF)
+            return ERROR_INT("truncated extension", procName, 1);
+        while ((n = fgetc(fp)) > 0) {
+            if (fseek(fp, n, SEEK_CUR))
+                return ERROR_INT("truncated extension", procName, 1);
+        }
+        if (n == EOF)
+            return ERROR_INT("truncated extension", procName, 1);
+    }
+    if (c != 0x2c)
+        return ERROR_INT("no images found in GIF", procName, 1);
+    if (fread(buf, 1, 9, fp) != 9)
+        return ERROR_INT("image descriptor not read", procName, 1);
+    w = buf[4] | (buf[5] << 8);
+    h = buf[6] | (buf[7] << 8);
+    if (w <= 0 || h <= 0)
+        return ERROR_INT("invalid image dimensions", procName, 1);
+    if (buf[8] & 0x80)
+        ncolors = 1 << ((buf[8] & 0x07) + 1);
+    else if (gcolors > 0)
+        ncolors = gcolors;
+    else
+        return ERROR_INT("color map is missing", procName, 1);
+
+    if (ncolors <= 2)
+        d = 1;
+    else if (ncolors <= 4)
+        d = 2;
+    else if (ncolors <= 16)
+        d = 4;
+    else
+        d = 8;
+    if (pw) *pw = w;
+    if (ph) *ph = h;
+    if (pbps) *pbps = d;
+    if (pspp) *pspp = 1;
+    if (piscmap) *piscmap = 1;
+    return 0;
+}
+
+
 /*---------------------------------------------------------------------*
  *                         Writing gif to file                         *
  *---------------------------------------------------------------------*/
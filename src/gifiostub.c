@@ -49,6 +49,14 @@ PIX * pixReadStreamGif(FILE *fp)
 
 /* ----------------------------------------------------------------------*/
 
+l_int32 freadHeaderGif(FILE *fp, l_int32 *pw, l_int32 *ph, l_int32 *pbps,
+                       l_int32 *pspp, l_int32 *piscmap)
+{
+    return ERROR_INT("function not present", "freadHeaderGif", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 pixWriteStreamGif(FILE *fp, PIX *pix)
 {
     return ERROR_INT("function not present", "pixWriteStreamGif", 1);
@@ -130,7 +130,8 @@ enum {
 /*! Hinting bit flags in jpeg reader */
 enum {
     L_JPEG_READ_LUMINANCE = 1,   /*!< only want luminance data; no chroma */
-    L_JPEG_FAIL_ON_BAD_DATA = 2  /*!< don't return possibly damaged pix */
+    L_JPEG_FAIL_ON_BAD_DATA = 2, /*!< don't return possibly damaged pix */
+    L_JPEG_FAST_DECODE = 4       /*!< fast dct and upsampling; less accurate */
 };
 
 
@@ -234,4 +235,25 @@ struct L_Pdf_Data
 typedef struct L_Pdf_Data  L_PDF_DATA;
 
 
+/* ------------------------------------------------------------------------- *
+ *                      Streaming multipage pdf output                       *
+ * ------------------------------------------------------------------------- */
+/*
+ *  This writes a multipage pdf to a stream one page at a time.  Only the
+ *  locations of the objects and the object numbers of the pages are kept.
+ */
+
+/*! Streaming multipage pdf writer */
+struct L_Pdf_Writer
+{
+    FILE              *fp;           /*!< output stream                       */
+    char              *fileout;      /*!< output file, opened at first page   */
+    size_t             nbytes;       /*!< number of bytes written             */
+    l_int32            nobj;         /*!< next object number to be assigned   */
+    struct L_Dna      *daloc;        /*!< location of each object             */
+    struct Numa       *napage;       /*!< Page object number of each page     */
+};
+typedef struct L_Pdf_Writer  L_PDF_WRITER;
+
+
 #endif  /* LEPTONICA_IMAGEIO_H */
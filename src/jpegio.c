@@ -31,25 +31,48 @@
  *    Read jpeg from file
  *          PIX             *pixReadJpeg()  [special top level]
  *          PIX             *pixReadStreamJpeg()
+ *          static PIX      *pixReadJpegGeneric()
+ *
+ *    Read jpeg region and thumbnail
+ *          PIX             *pixReadJpegRegion()
+ *          PIX             *pixReadJpegThumbnail()
  *
  *    Read jpeg metadata from file
  *          l_int32          readHeaderJpeg()
  *          l_int32          freadHeaderJpeg()
+ *          static l_int32   readHeaderJpegGeneric()
  *          l_int32          fgetJpegResolution()
  *          l_int32          fgetJpegComment()
+ *          static l_int32   getJpegCommentGeneric()
  *
  *    Write jpeg to file
  *          l_int32          pixWriteJpeg()  [special top level]
  *          l_int32          pixWriteStreamJpeg()
+ *          static l_int32   pixWriteJpegGeneric()
  *
  *    Read/write to memory
  *          PIX             *pixReadMemJpeg()
  *          l_int32          readHeaderMemJpeg()
  *          l_int32          pixWriteMemJpeg()
  *
+ *    Memory source and destination managers
+ *          static void      jpegSetMemSource()
+ *          static void      jpegSetMemDest()
+ *          static void      jpegMemInitSource()
+ *          static boolean   jpegMemFillInput()
+ *          static void      jpegMemSkipInput()
+ *          static void      jpegMemTermSource()
+ *          static void      jpegMemInitDest()
+ *          static boolean   jpegMemEmptyOutput()
+ *          static void      jpegMemTermDest()
+ *
  *    Setting special flag for chroma sampling on write
  *          l_int32          pixSetChromaSampling()
  *
+ *    Lossless transforms in the dct domain
+ *          l_int32          jpegTransformLossless()
+ *          static void      jpegTransformBlock()
+ *
  *    Static system helpers
  *          static void      jpeg_error_catch_all_1()
  *          static void      jpeg_error_catch_all_2()
@@ -110,10 +133,11 @@
  *
  *    Compressing to memory and decompressing from memory
  *    ---------------------------------------------------
- *    On systems like windows without fmemopen() and open_memstream(),
- *    we write data to a temp file and read it back for operations
- *    between pix and compressed-data, such as pixReadMemJpeg() and
- *    pixWriteMemJpeg().
+ *    pixReadMemJpeg() and readHeaderMemJpeg() give the jpeg library a
+ *    source manager that reads directly from the caller's data, and
+ *    pixWriteMemJpeg() gives it a destination manager that writes to
+ *    a growing buffer.  No stream or temp file is used, so this works
+ *    the same way on all platforms.
  *
  *    Vestigial code: parsing the jpeg file for header metadata
  *    ---------------------------------------------------------
@@ -146,10 +170,45 @@
      * but we suppress it by undefining the variable. */
 #undef HAVE_STDLIB_H
 #include "jpeglib.h"
+#include "jerror.h"
 
 static void jpeg_error_catch_all_1(j_common_ptr cinfo);
 static void jpeg_error_catch_all_2(j_common_ptr cinfo);
 static l_uint8 jpeg_getc(j_decompress_ptr cinfo);
+static void jpegTransformBlock(JCOEFPTR src, JCOEFPTR dst, l_int32 quads);
+
+    /*! Memory sink for jpeg data, used in place of a stream */
+typedef struct L_JpegMemDest
+{
+    struct jpeg_destination_mgr  pub;     /*!< must be first             */
+    l_uint8                     *data;    /*!< buffer for encoded data   */
+    size_t                       nalloc;  /*!< allocated size of buffer  */
+    size_t                       size;    /*!< number of bytes written   */
+} L_JPEG_MEMDEST;
+
+static PIX *pixReadJpegGeneric(FILE *fp, const l_uint8 *cdata, size_t size,
+                               l_int32 cmapflag, l_int32 reduction,
+                               l_int32 *pnwarn, l_int32 hint);
+static l_int32 readHeaderJpegGeneric(FILE *fp, const l_uint8 *data,
+                                     size_t size, l_int32 *pw, l_int32 *ph,
+                                     l_int32 *pspp, l_int32 *pycck,
+                                     l_int32 *pcmyk);
+static l_int32 getJpegCommentGeneric(FILE *fp, const l_uint8 *data,
+                                     size_t size, l_uint8 **pcomment);
+static l_int32 pixWriteJpegGeneric(FILE *fp, L_JPEG_MEMDEST *memdest,
+                                   PIX *pixs, l_int32 quality,
+                                   l_int32 progressive);
+static void jpegSetMemSource(j_decompress_ptr cinfo,
+                             struct jpeg_source_mgr *src,
+                             const l_uint8 *data, size_t size);
+static void jpegSetMemDest(j_compress_ptr cinfo, L_JPEG_MEMDEST *dest);
+static void jpegMemInitSource(j_decompress_ptr cinfo);
+static boolean jpegMemFillInput(j_decompress_ptr cinfo);
+static void jpegMemSkipInput(j_decompress_ptr cinfo, long nbytes);
+static void jpegMemTermSource(j_decompress_ptr cinfo);
+static void jpegMemInitDest(j_compress_ptr cinfo);
+static boolean jpegMemEmptyOutput(j_compress_ptr cinfo);
+static void jpegMemTermDest(j_compress_ptr cinfo);
 
     /* Note: 'boolean' is defined in jmorecfg.h.  We use it explicitly
      * here because for windows where __MINGW32__ is defined,
@@ -206,7 +265,10 @@ struct callback_data {
  *      (5) The possible hint values are given in the enum in imageio.h:
  *            * L_JPEG_READ_LUMINANCE
  *            * L_JPEG_FAIL_ON_BAD_DATA
- *          Default (0) is to do neither.
+ *            * L_JPEG_FAST_DECODE
+ *          Default (0) is to do none of these.  L_JPEG_FAST_DECODE uses
+ *          the fast integer dct and simple chroma upsampling, trading
+ *          a small loss in accuracy for speed.
  * </pre>
  */
 PIX *
@@ -271,6 +333,39 @@ pixReadStreamJpeg(FILE     *fp,
                   l_int32   reduction,
                   l_int32  *pnwarn,
                   l_int32   hint)
+{
+    PROCNAME("pixReadStreamJpeg");
+
+    if (pnwarn) *pnwarn = 0;
+    if (!fp)
+        return (PIX *)ERROR_PTR("fp not defined", procName, NULL);
+    return pixReadJpegGeneric(fp, NULL, 0, cmapflag, reduction, pnwarn, hint);
+}
+
+
+/*!
+ * \brief   pixReadJpegGeneric()
+ *
+ * \param[in]    fp [optional] file stream
+ * \param[in]    cdata [optional] jpeg-encoded; use if %fp is null
+ * \param[in]    size of cdata
+ * \param[in]    cmapflag, reduction, pnwarn, hint see pixReadStreamJpeg()
+ * \return  pix, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The compressed data is taken from %fp or, when reading from
+ *          memory, directly from %cdata through a jpeg source manager.
+ * </pre>
+ */
+static PIX *
+pixReadJpegGeneric(FILE           *fp,
+                   const l_uint8  *cdata,
+                   size_t          size,
+                   l_int32         cmapflag,
+                   l_int32         reduction,
+                   l_int32        *pnwarn,
+                   l_int32         hint)
 {
 l_int32                        cyan, yellow, magenta, black, nwarn;
 l_int32                        i, j, k, rval, gval, bval;
@@ -281,14 +376,15 @@ JSAMPROW                       rowbuffer;
 PIX                           *pix;
 PIXCMAP                       *cmap;
 struct jpeg_decompress_struct  cinfo;
+struct jpeg_source_mgr         memsrc;
 struct jpeg_error_mgr          jerr;
 jmp_buf                        jmpbuf;  /* must be local to the function */
 
-    PROCNAME("pixReadStreamJpeg");
+    PROCNAME("pixReadJpegGeneric");
 
     if (pnwarn) *pnwarn = 0;
-    if (!fp)
-        return (PIX *)ERROR_PTR("fp not defined", procName, NULL);
+    if (!fp && !cdata)
+        return (PIX *)ERROR_PTR("no source defined", procName, NULL);
     if (cmapflag != 0 && cmapflag != 1)
         cmapflag = 0;  /* default */
     if (reduction != 1 && reduction != 2 && reduction != 4 && reduction != 8)
@@ -297,7 +393,7 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
     if (BITS_IN_JSAMPLE != 8)  /* set in jmorecfg.h */
         return (PIX *)ERROR_PTR("BITS_IN_JSAMPLE != 8", procName, NULL);
 
-    rewind(fp);
+    if (fp) rewind(fp);
     pix = NULL;
     rowbuffer = NULL;
 
@@ -313,10 +409,17 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
 
         /* Initialize jpeg structs for decompression */
     jpeg_create_decompress(&cinfo);
-    jpeg_stdio_src(&cinfo, fp);
+    if (fp)
+        jpeg_stdio_src(&cinfo, fp);
+    else
+        jpegSetMemSource(&cinfo, &memsrc, cdata, size);
     jpeg_read_header(&cinfo, TRUE);
     cinfo.scale_denom = reduction;
     cinfo.scale_num = 1;
+    if (hint & L_JPEG_FAST_DECODE) {
+        cinfo.dct_method = JDCT_IFAST;
+        cinfo.do_fancy_upsampling = FALSE;
+    }
     jpeg_calc_output_dimensions(&cinfo);
     if (hint & L_JPEG_READ_LUMINANCE) {
         cinfo.out_color_space = JCS_GRAYSCALE;
@@ -488,6 +591,239 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
 }
 
 
+/*---------------------------------------------------------------------*
+ *                  Read jpeg region and thumbnail                     *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   pixReadJpegRegion()
+ *
+ * \param[in]    filename
+ * \param[in]    box region of the full resolution image to be read
+ * \param[in]    reduction scaling factor: 1, 2, 4 or 8
+ * \param[in]    hint a bitwise OR of L_JPEG_* values; 0 for default
+ * \return  pix, or NULL on error or if %box does not intersect the image
+ *
+ * <pre>
+ * Notes:
+ *      (1) This returns the part of the image within %box, reduced by
+ *          %reduction.  The result is 8 bpp for grayscale (or with
+ *          L_JPEG_READ_LUMINANCE) and 32 bpp for rgb.
+ *      (2) Decoding stops after the last row of the region.  With
+ *          libjpeg-turbo, the rows above the region are skipped without
+ *          the inverse dct, and only the MCU columns that intersect the
+ *          region are decoded; entropy decoding of the skipped data
+ *          is unavoidable in a jpeg stream.  Otherwise, all rows above
+ *          the region are fully decoded and discarded.
+ *      (3) YCCK and CMYK images are read in full and clipped.
+ * </pre>
+ */
+PIX *
+pixReadJpegRegion(const char  *filename,
+                  BOX         *box,
+                  l_int32      reduction,
+                  l_int32      hint)
+{
+l_int32                        i, j, k, w, h, bx, by, bw, bh, spp, wpl, nwarn;
+l_int32                        margin;
+l_uint32                      *line;
+JDIMENSION                     xoff, cropw;
+JSAMPROW                       rowbuffer;
+BOX                           *boxs, *boxc;
+FILE                          *fp;
+PIX                           *pix, *pixt;
+struct jpeg_decompress_struct  cinfo;
+struct jpeg_error_mgr          jerr;
+jmp_buf                        jmpbuf;  /* must be local to the function */
+
+    PROCNAME("pixReadJpegRegion");
+
+    if (!filename)
+        return (PIX *)ERROR_PTR("filename not defined", procName, NULL);
+    if (!box)
+        return (PIX *)ERROR_PTR("box not defined", procName, NULL);
+    if (reduction != 1 && reduction != 2 && reduction != 4 && reduction != 8)
+        return (PIX *)ERROR_PTR("reduction not in {1,2,4,8}", procName, NULL);
+
+    if ((fp = fopenReadStream(filename)) == NULL)
+        return (PIX *)ERROR_PTR("image file not found", procName, NULL);
+    pix = NULL;
+    rowbuffer = NULL;
+
+        /* Modify the jpeg error handling to catch fatal errors  */
+    cinfo.err = jpeg_std_error(&jerr);
+    jerr.error_exit = jpeg_error_catch_all_1;
+    cinfo.client_data = (void *)&jmpbuf;
+    if (setjmp(jmpbuf)) {
+        pixDestroy(&pix);
+        LEPT_FREE(rowbuffer);
+        fclose(fp);
+        return (PIX *)ERROR_PTR("internal jpeg error", procName, NULL);
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, fp);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.scale_denom = reduction;
+    cinfo.scale_num = 1;
+    if (hint & L_JPEG_FAST_DECODE) {
+        cinfo.dct_method = JDCT_IFAST;
+        cinfo.do_fancy_upsampling = FALSE;
+    }
+    jpeg_calc_output_dimensions(&cinfo);
+    if (hint & L_JPEG_READ_LUMINANCE)
+        cinfo.out_color_space = JCS_GRAYSCALE;
+    spp = (hint & L_JPEG_READ_LUMINANCE) ? 1 : cinfo.out_color_components;
+    if (spp != 1 && spp != 3) {  /* YCCK or CMYK */
+        jpeg_destroy_decompress(&cinfo);
+        fclose(fp);
+        if ((pixt = pixReadJpeg(filename, 0, reduction, NULL, hint)) == NULL)
+            return (PIX *)ERROR_PTR("pixt not read", procName, NULL);
+        boxs = boxTransform(box, 0, 0, 1.0 / reduction, 1.0 / reduction);
+        pix = pixClipRectangle(pixt, boxs, NULL);
+        boxDestroy(&boxs);
+        pixDestroy(&pixt);
+        return pix;
+    }
+
+        /* Find the region in the reduced image */
+    w = cinfo.output_width;
+    h = cinfo.output_height;
+    boxs = boxTransform(box, 0, 0, 1.0 / reduction, 1.0 / reduction);
+    boxc = boxClipToRectangle(boxs, w, h);
+    boxDestroy(&boxs);
+    if (!boxc) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(fp);
+        return (PIX *)ERROR_PTR("box outside image", procName, NULL);
+    }
+    boxGetGeometry(boxc, &bx, &by, &bw, &bh);
+    boxDestroy(&boxc);
+    if (bw == 0 || bh == 0) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(fp);
+        return (PIX *)ERROR_PTR("region is empty", procName, NULL);
+    }
+
+        /* Restrict the decoding to the columns and rows of the region.
+         * A margin of one MCU on each side gives the chroma upsampler
+         * the same context as in a full decode.  The crop is expanded
+         * to MCU boundaries, so we still need the offset of the region
+         * within the decoded row. */
+    jpeg_start_decompress(&cinfo);
+    margin = 8 * cinfo.max_h_samp_factor / reduction;
+    xoff = L_MAX(0, bx - margin);
+    cropw = L_MIN(w, bx + bw + margin) - xoff;
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER)
+    jpeg_crop_scanline(&cinfo, &xoff, &cropw);
+    jpeg_skip_scanlines(&cinfo, L_MAX(0, by - margin));
+#else
+    xoff = 0;
+    cropw = w;
+#endif  /* LIBJPEG_TURBO_VERSION_NUMBER */
+    rowbuffer = (JSAMPROW)LEPT_CALLOC(sizeof(JSAMPLE), spp * cinfo.output_width);
+    pix = pixCreate(bw, bh, (spp == 1) ? 8 : 32);
+    if (!rowbuffer || !pix) {
+        LEPT_FREE(rowbuffer);
+        pixDestroy(&pix);
+        jpeg_destroy_decompress(&cinfo);
+        fclose(fp);
+        return (PIX *)ERROR_PTR("rowbuffer or pix not made", procName, NULL);
+    }
+    pixSetInputFormat(pix, IFF_JFIF_JPEG);
+    wpl = pixGetWpl(pix);
+    xoff = bx - xoff;
+
+    for (i = cinfo.output_scanline; i < by + bh; i++) {
+        if (jpeg_read_scanlines(&cinfo, &rowbuffer, (JDIMENSION)1) == 0) {
+            L_ERROR("read error at scanline %d\n", procName, i);
+            pixDestroy(&pix);
+            break;
+        }
+        if (i < by) continue;
+        line = pixGetData(pix) + (i - by) * wpl;
+        if (spp == 1) {
+            for (j = 0; j < bw; j++)
+                SET_DATA_BYTE(line, j, rowbuffer[xoff + j]);
+        } else {
+            for (j = 0, k = 3 * xoff; j < bw; j++, k += 3)
+                composeRGBPixel(rowbuffer[k], rowbuffer[k + 1],
+                                rowbuffer[k + 2], line + j);
+        }
+    }
+
+    nwarn = cinfo.err->num_warnings;
+    if (pix && cinfo.density_unit == 1) {  /* pixels per inch */
+        pixSetXRes(pix, cinfo.X_density);
+        pixSetYRes(pix, cinfo.Y_density);
+    } else if (pix && cinfo.density_unit == 2) {  /* pixels per centimeter */
+        pixSetXRes(pix, (l_int32)((l_float32)cinfo.X_density * 2.54 + 0.5));
+        pixSetYRes(pix, (l_int32)((l_float32)cinfo.Y_density * 2.54 + 0.5));
+    }
+
+        /* The rows below the region are not read */
+    jpeg_abort_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    LEPT_FREE(rowbuffer);
+    fclose(fp);
+
+    if (pix && nwarn > 0) {
+        if (hint & L_JPEG_FAIL_ON_BAD_DATA) {
+            L_ERROR("fail with %d warning(s) of bad data\n", procName, nwarn);
+            pixDestroy(&pix);
+        } else {
+            L_WARNING("%d warning(s) of bad data\n", procName, nwarn);
+        }
+    }
+    if (!pix)
+        return (PIX *)ERROR_PTR("region not read", procName, NULL);
+    return pix;
+}
+
+
+/*!
+ * \brief   pixReadJpegThumbnail()
+ *
+ * \param[in]    filename
+ * \param[in]    reduction scaling factor: 8, 16, 32 or 64
+ * \return  pix, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) At a reduction of 8, the jpeg library replaces the inverse
+ *          dct by the dc coefficient of each block, which is the block
+ *          average.  This decodes at that reduction with the fast
+ *          upsampling and dct options, and averages further by powers
+ *          of 2 for larger reductions.
+ *      (2) For a grayscale image, the result is 8 bpp; for rgb, 32 bpp.
+ * </pre>
+ */
+PIX *
+pixReadJpegThumbnail(const char  *filename,
+                     l_int32      reduction)
+{
+PIX  *pix, *pix1;
+
+    PROCNAME("pixReadJpegThumbnail");
+
+    if (!filename)
+        return (PIX *)ERROR_PTR("filename not defined", procName, NULL);
+    if (reduction != 8 && reduction != 16 && reduction != 32 &&
+        reduction != 64)
+        return (PIX *)ERROR_PTR("reduction not in {8,16,32,64}",
+                                procName, NULL);
+
+    if ((pix = pixReadJpeg(filename, 0, 8, NULL, L_JPEG_FAST_DECODE)) == NULL)
+        return (PIX *)ERROR_PTR("pix not read", procName, NULL);
+    for (; reduction > 8; reduction /= 2) {
+        pix1 = pixScaleAreaMap2(pix);
+        pixDestroy(&pix);
+        if ((pix = pix1) == NULL)
+            return (PIX *)ERROR_PTR("pix not reduced", procName, NULL);
+    }
+    return pix;
+}
+
+
 /*---------------------------------------------------------------------*
  *                     Read jpeg metadata from file                    *
  *---------------------------------------------------------------------*/
@@ -551,25 +887,58 @@ freadHeaderJpeg(FILE     *fp,
                 l_int32  *pspp,
                 l_int32  *pycck,
                 l_int32  *pcmyk)
+{
+    PROCNAME("freadHeaderJpeg");
+
+    if (pw) *pw = 0;
+    if (ph) *ph = 0;
+    if (pspp) *pspp = 0;
+    if (pycck) *pycck = 0;
+    if (pcmyk) *pcmyk = 0;
+    if (!fp)
+        return ERROR_INT("stream not defined", procName, 1);
+    return readHeaderJpegGeneric(fp, NULL, 0, pw, ph, pspp, pycck, pcmyk);
+}
+
+
+/*!
+ * \brief   readHeaderJpegGeneric()
+ *
+ * \param[in]    fp [optional] file stream
+ * \param[in]    data [optional] jpeg-encoded; use if %fp is null
+ * \param[in]    size of data
+ * \param[out]   pw, ph, pspp, pycck, pcmyk see freadHeaderJpeg()
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+readHeaderJpegGeneric(FILE           *fp,
+                      const l_uint8  *data,
+                      size_t          size,
+                      l_int32        *pw,
+                      l_int32        *ph,
+                      l_int32        *pspp,
+                      l_int32        *pycck,
+                      l_int32        *pcmyk)
 {
 l_int32                        spp;
 struct jpeg_decompress_struct  cinfo;
+struct jpeg_source_mgr         memsrc;
 struct jpeg_error_mgr          jerr;
 jmp_buf                        jmpbuf;  /* must be local to the function */
 
-    PROCNAME("freadHeaderJpeg");
+    PROCNAME("readHeaderJpegGeneric");
 
     if (pw) *pw = 0;
     if (ph) *ph = 0;
     if (pspp) *pspp = 0;
     if (pycck) *pycck = 0;
     if (pcmyk) *pcmyk = 0;
-    if (!fp)
-        return ERROR_INT("stream not defined", procName, 1);
+    if (!fp && !data)
+        return ERROR_INT("no source defined", procName, 1);
     if (!pw && !ph && !pspp && !pycck && !pcmyk)
         return ERROR_INT("no results requested", procName, 1);
 
-    rewind(fp);
+    if (fp) rewind(fp);
 
         /* Modify the jpeg error handling to catch fatal errors  */
     cinfo.err = jpeg_std_error(&jerr);
@@ -580,7 +949,10 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
 
         /* Initialize the jpeg structs for reading the header */
     jpeg_create_decompress(&cinfo);
-    jpeg_stdio_src(&cinfo, fp);
+    if (fp)
+        jpeg_stdio_src(&cinfo, fp);
+    else
+        jpegSetMemSource(&cinfo, &memsrc, data, size);
     jpeg_read_header(&cinfo, TRUE);
     jpeg_calc_output_dimensions(&cinfo);
 
@@ -594,7 +966,7 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
         (cinfo.jpeg_color_space == JCS_CMYK && spp == 4);
 
     jpeg_destroy_decompress(&cinfo);
-    rewind(fp);
+    if (fp) rewind(fp);
     return 0;
 }
 
@@ -672,20 +1044,47 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
 l_int32
 fgetJpegComment(FILE      *fp,
                 l_uint8  **pcomment)
+{
+    PROCNAME("fgetJpegComment");
+
+    if (!pcomment)
+        return ERROR_INT("&comment not defined", procName, 1);
+    *pcomment = NULL;
+    if (!fp)
+        return ERROR_INT("stream not opened", procName, 1);
+    return getJpegCommentGeneric(fp, NULL, 0, pcomment);
+}
+
+
+/*
+ *  getJpegCommentGeneric()
+ *
+ *      Input:  fp (<optional> file stream opened for read)
+ *              data (<optional> jpeg-encoded; use if %fp is null)
+ *              size (of data)
+ *              &comment (<return> comment)
+ *      Return: 0 if OK; 1 on error
+ */
+static l_int32
+getJpegCommentGeneric(FILE           *fp,
+                      const l_uint8  *data,
+                      size_t          size,
+                      l_uint8       **pcomment)
 {
 struct jpeg_decompress_struct  cinfo;
+struct jpeg_source_mgr         memsrc;
 struct jpeg_error_mgr          jerr;
 struct callback_data           cb_data;  /* contains local jmp_buf */
 
-    PROCNAME("fgetJpegComment");
+    PROCNAME("getJpegCommentGeneric");
 
     if (!pcomment)
         return ERROR_INT("&comment not defined", procName, 1);
     *pcomment = NULL;
-    if (!fp)
-        return ERROR_INT("stream not opened", procName, 1);
+    if (!fp && !data)
+        return ERROR_INT("no source defined", procName, 1);
 
-    rewind(fp);
+    if (fp) rewind(fp);
 
         /* Modify the jpeg error handling to catch fatal errors  */
     cinfo.err = jpeg_std_error(&jerr);
@@ -700,13 +1099,16 @@ struct callback_data           cb_data;  /* contains local jmp_buf */
         /* Initialize the jpeg structs for reading the header */
     jpeg_create_decompress(&cinfo);
     jpeg_set_marker_processor(&cinfo, JPEG_COM, jpeg_comment_callback);
-    jpeg_stdio_src(&cinfo, fp);
+    if (fp)
+        jpeg_stdio_src(&cinfo, fp);
+    else
+        jpegSetMemSource(&cinfo, &memsrc, data, size);
     jpeg_read_header(&cinfo, TRUE);
 
         /* Save the result */
     *pcomment = cb_data.comment;
     jpeg_destroy_decompress(&cinfo);
-    rewind(fp);
+    if (fp) rewind(fp);
     return 0;
 }
 
@@ -789,6 +1191,38 @@ pixWriteStreamJpeg(FILE    *fp,
                    PIX     *pixs,
                    l_int32  quality,
                    l_int32  progressive)
+{
+    PROCNAME("pixWriteStreamJpeg");
+
+    if (!fp)
+        return ERROR_INT("stream not open", procName, 1);
+    if (!pixs)
+        return ERROR_INT("pixs not defined", procName, 1);
+    return pixWriteJpegGeneric(fp, NULL, pixs, quality, progressive);
+}
+
+
+/*!
+ * \brief   pixWriteJpegGeneric()
+ *
+ * \param[in]    fp [optional] file stream
+ * \param[in]    memdest [optional] memory sink; use if %fp is null
+ * \param[in]    pixs, quality, progressive see pixWriteStreamJpeg()
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The compressed data is written to %fp or, when writing to
+ *          memory, to a buffer owned by %memdest, which the caller
+ *          takes over (or frees on error).
+ * </pre>
+ */
+static l_int32
+pixWriteJpegGeneric(FILE            *fp,
+                    L_JPEG_MEMDEST  *memdest,
+                    PIX             *pixs,
+                    l_int32          quality,
+                    l_int32          progressive)
 {
 l_int32                      xres, yres;
 l_int32                      i, j, k;
@@ -801,10 +1235,10 @@ struct jpeg_error_mgr        jerr;
 char                        *text;
 jmp_buf                      jmpbuf;  /* must be local to the function */
 
-    PROCNAME("pixWriteStreamJpeg");
+    PROCNAME("pixWriteJpegGeneric");
 
-    if (!fp)
-        return ERROR_INT("stream not open", procName, 1);
+    if (!fp && !memdest)
+        return ERROR_INT("no sink defined", procName, 1);
     if (!pixs)
         return ERROR_INT("pixs not defined", procName, 1);
     if (quality <= 0)
@@ -831,7 +1265,7 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
     if (!pix)
         return ERROR_INT("pix not made", procName, 1);
 
-    rewind(fp);
+    if (fp) rewind(fp);
     rowbuffer = NULL;
 
         /* Modify the jpeg error handling to catch fatal errors  */
@@ -846,7 +1280,10 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
 
         /* Initialize the jpeg structs for compression */
     jpeg_create_compress(&cinfo);
-    jpeg_stdio_dest(&cinfo, fp);
+    if (fp)
+        jpeg_stdio_dest(&cinfo, fp);
+    else
+        jpegSetMemDest(&cinfo, memdest);
     cinfo.image_width  = w;
     cinfo.image_height = h;
 
@@ -988,7 +1425,6 @@ pixReadMemJpeg(const l_uint8  *data,
 {
 l_int32   ret;
 l_uint8  *comment;
-FILE     *fp;
 PIX      *pix;
 
     PROCNAME("pixReadMemJpeg");
@@ -997,17 +1433,15 @@ PIX      *pix;
     if (!data)
         return (PIX *)ERROR_PTR("data not defined", procName, NULL);
 
-    if ((fp = fopenReadFromMemory(data, size)) == NULL)
-        return (PIX *)ERROR_PTR("stream not opened", procName, NULL);
-    pix = pixReadStreamJpeg(fp, cmflag, reduction, pnwarn, hint);
+    pix = pixReadJpegGeneric(NULL, data, size, cmflag, reduction, pnwarn,
+                             hint);
     if (pix) {
-        ret = fgetJpegComment(fp, &comment);
+        ret = getJpegCommentGeneric(NULL, data, size, &comment);
         if (!ret && comment) {
             pixSetText(pix, (char *)comment);
             LEPT_FREE(comment);
         }
     }
-    fclose(fp);
     if (!pix) L_ERROR("pix not read\n", procName);
     return pix;
 }
@@ -1034,9 +1468,6 @@ readHeaderMemJpeg(const l_uint8  *data,
                   l_int32        *pycck,
                   l_int32        *pcmyk)
 {
-l_int32  ret;
-FILE    *fp;
-
     PROCNAME("readHeaderMemJpeg");
 
     if (pw) *pw = 0;
@@ -1049,11 +1480,8 @@ FILE    *fp;
     if (!pw && !ph && !pspp && !pycck && !pcmyk)
         return ERROR_INT("no results requested", procName, 1);
 
-    if ((fp = fopenReadFromMemory(data, size)) == NULL)
-        return ERROR_INT("stream not opened", procName, 1);
-    ret = freadHeaderJpeg(fp, pw, ph, pspp, pycck, pcmyk);
-    fclose(fp);
-    return ret;
+    return readHeaderJpegGeneric(NULL, data, size, pw, ph, pspp,
+                                 pycck, pcmyk);
 }
 
 
@@ -1071,6 +1499,8 @@ FILE    *fp;
  * Notes:
  *      (1) See pixWriteStreamJpeg() for usage.  This version writes to
  *          memory instead of to a file stream.
+ *      (2) The encoder writes directly into a buffer that grows by
+ *          doubling, which is returned to the caller without a copy.
  * </pre>
  */
 l_int32
@@ -1080,8 +1510,7 @@ pixWriteMemJpeg(l_uint8  **pdata,
                 l_int32    quality,
                 l_int32    progressive)
 {
-l_int32  ret;
-FILE    *fp;
+L_JPEG_MEMDEST  memdest;
 
     PROCNAME("pixWriteMemJpeg");
 
@@ -1094,25 +1523,170 @@ FILE    *fp;
     if (!pix)
         return ERROR_INT("&pix not defined", procName, 1 );
 
-#if HAVE_FMEMOPEN
-    if ((fp = open_memstream((char **)pdata, psize)) == NULL)
-        return ERROR_INT("stream not opened", procName, 1);
-    ret = pixWriteStreamJpeg(fp, pix, quality, progressive);
-#else
-    L_INFO("work-around: writing to a temp file\n", procName);
-  #ifdef _WIN32
-    if ((fp = fopenWriteWinTempfile()) == NULL)
-        return ERROR_INT("tmpfile stream not opened", procName, 1);
-  #else
-    if ((fp = tmpfile()) == NULL)
-        return ERROR_INT("tmpfile stream not opened", procName, 1);
-  #endif  /* _WIN32 */
-    ret = pixWriteStreamJpeg(fp, pix, quality, progressive);
-    rewind(fp);
-    *pdata = l_binaryReadStream(fp, psize);
-#endif  /* HAVE_FMEMOPEN */
-    fclose(fp);
-    return ret;
+    memset(&memdest, 0, sizeof(L_JPEG_MEMDEST));
+    if (pixWriteJpegGeneric(NULL, &memdest, pix, quality, progressive)) {
+        LEPT_FREE(memdest.data);
+        return ERROR_INT("jpeg data not written", procName, 1);
+    }
+    *pdata = memdest.data;
+    *psize = memdest.size;
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------*
+ *               Memory source and destination managers                *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   jpegSetMemSource()
+ *
+ * \param[in]    cinfo
+ * \param[in]    src source manager, owned by the caller
+ * \param[in]    data jpeg-encoded
+ * \param[in]    size of data
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The whole of %data is handed to the decoder as its input
+ *          buffer, so nothing is copied.  %src and %data must stay
+ *          valid until the decompress struct is done with them.
+ * </pre>
+ */
+static void
+jpegSetMemSource(j_decompress_ptr         cinfo,
+                 struct jpeg_source_mgr  *src,
+                 const l_uint8           *data,
+                 size_t                   size)
+{
+    src->init_source = jpegMemInitSource;
+    src->fill_input_buffer = jpegMemFillInput;
+    src->skip_input_data = jpegMemSkipInput;
+    src->resync_to_restart = jpeg_resync_to_restart;  /* use default */
+    src->term_source = jpegMemTermSource;
+    src->next_input_byte = (const JOCTET *)data;
+    src->bytes_in_buffer = size;
+    cinfo->src = src;
+}
+
+
+/*!
+ * \brief   jpegSetMemDest()
+ *
+ * \param[in]    cinfo
+ * \param[in]    dest destination manager, owned by the caller
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The encoded data is written to dest->data, which is
+ *          allocated and grown here.  The caller takes ownership of
+ *          it, and must free it if compression fails.
+ * </pre>
+ */
+static void
+jpegSetMemDest(j_compress_ptr   cinfo,
+               L_JPEG_MEMDEST  *dest)
+{
+    dest->pub.init_destination = jpegMemInitDest;
+    dest->pub.empty_output_buffer = jpegMemEmptyOutput;
+    dest->pub.term_destination = jpegMemTermDest;
+    cinfo->dest = &dest->pub;
+}
+
+
+    /* Source manager callbacks.  All data is already in the input
+     * buffer, so running out of data means that the file is truncated.
+     * As with the stdio source manager, a warning is issued and a
+     * fake EOI marker is inserted, so that a damaged image is
+     * decoded as far as possible. */
+static void
+jpegMemInitSource(j_decompress_ptr  cinfo)
+{
+}
+
+
+static boolean
+jpegMemFillInput(j_decompress_ptr  cinfo)
+{
+static const JOCTET  eoi[2] = {0xff, JPEG_EOI};
+
+    WARNMS(cinfo, JWRN_JPEG_EOF);
+    cinfo->src->next_input_byte = eoi;
+    cinfo->src->bytes_in_buffer = 2;
+    return TRUE;
+}
+
+
+static void
+jpegMemSkipInput(j_decompress_ptr  cinfo,
+                 long              nbytes)
+{
+struct jpeg_source_mgr  *src;
+
+    src = cinfo->src;
+    if (nbytes <= 0)
+        return;
+    if ((size_t)nbytes > src->bytes_in_buffer) {
+        jpegMemFillInput(cinfo);
+    } else {
+        src->next_input_byte += nbytes;
+        src->bytes_in_buffer -= nbytes;
+    }
+}
+
+
+static void
+jpegMemTermSource(j_decompress_ptr  cinfo)
+{
+}
+
+
+    /* Destination manager callbacks.  The buffer starts at 16 KB and
+     * is doubled each time the encoder fills it. */
+static void
+jpegMemInitDest(j_compress_ptr  cinfo)
+{
+L_JPEG_MEMDEST  *dest;
+
+    dest = (L_JPEG_MEMDEST *)cinfo->dest;
+    if (!dest->data) {
+        dest->nalloc = 16384;
+        if ((dest->data = (l_uint8 *)LEPT_MALLOC(dest->nalloc)) == NULL)
+            ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 0);
+    }
+    dest->size = 0;
+    dest->pub.next_output_byte = dest->data;
+    dest->pub.free_in_buffer = dest->nalloc;
+}
+
+
+static boolean
+jpegMemEmptyOutput(j_compress_ptr  cinfo)
+{
+size_t           oldsize;
+l_uint8         *data;
+L_JPEG_MEMDEST  *dest;
+
+    dest = (L_JPEG_MEMDEST *)cinfo->dest;
+    oldsize = dest->nalloc;
+    if ((data = (l_uint8 *)LEPT_REALLOC(dest->data, 2 * oldsize)) == NULL)
+        ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 1);
+    dest->data = data;
+    dest->nalloc = 2 * oldsize;
+    dest->pub.next_output_byte = data + oldsize;
+    dest->pub.free_in_buffer = oldsize;
+    return TRUE;
+}
+
+
+static void
+jpegMemTermDest(j_compress_ptr  cinfo)
+{
+L_JPEG_MEMDEST  *dest;
+
+    dest = (L_JPEG_MEMDEST *)cinfo->dest;
+    dest->size = dest->nalloc - dest->pub.free_in_buffer;
 }
 
 
@@ -1150,6 +1724,272 @@ pixSetChromaSampling(PIX     *pix,
 }
 
 
+/*---------------------------------------------------------------------*
+ *               Lossless transforms in the dct domain                 *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   jpegTransformLossless()
+ *
+ * \param[in]    filein jpeg file
+ * \param[in]    fileout can be the same as %filein
+ * \param[in]    quads number of 90 degree cw rotations; 0, 1, 2 or 3
+ * \param[in]    box [optional] region to crop, before rotation;
+ *                   use NULL to keep the full image
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This crops and rotates a jpeg image by rearranging and
+ *          transforming its dct coefficients, without decoding it.
+ *          There is no generation loss, and it is much faster than
+ *          decoding, transforming the pix and re-encoding.
+ *      (2) The UL corner of the crop box is moved up and to the left
+ *          to the nearest MCU boundary (8 or 16 pixels, depending on
+ *          the chroma subsampling), so the cropped image can be slightly
+ *          larger than %box.
+ *      (3) An edge that is moved to the top or left by the rotation
+ *          must lie on an MCU boundary.  If not, the partial MCU row
+ *          or column on that edge is trimmed, as with 'jpegtran -trim'.
+ *          Thus, for the result to be the same as rotating the decoded
+ *          image, the image dimensions (or box) should be multiples of
+ *          the MCU size.
+ *      (4) Jpeg comments are copied to the output.
+ * </pre>
+ */
+l_int32
+jpegTransformLossless(const char  *filein,
+                      const char  *fileout,
+                      l_int32      quads,
+                      BOX         *box)
+{
+l_int32                        ci, i, mcuw, mcuh, hsamp, vsamp, tmp;
+l_int32                        cx, cy, cw, ch, sbw, sbh, dbw, dbh;
+l_int32                        xoffb, yoffb, sx, sy, x, y;
+BOX                           *boxc;
+FILE                *volatile  fpin;  /* modified after setjmp() */
+FILE                *volatile  fpout;
+JBLOCKARRAY                    srow, drow;
+JQUANT_TBL                    *qtbl;
+JQUANT_TBL                     qsave;
+jpeg_component_info           *compptr;
+jvirt_barray_ptr              *src_coefs;
+jvirt_barray_ptr               dst_coefs[MAX_COMPONENTS];
+jpeg_saved_marker_ptr          marker;
+struct jpeg_decompress_struct  srcinfo;
+struct jpeg_compress_struct    dstinfo;
+struct jpeg_error_mgr          jerr;
+jmp_buf                        jmpbuf;  /* must be local to the function */
+
+    PROCNAME("jpegTransformLossless");
+
+    if (!filein)
+        return ERROR_INT("filein not defined", procName, 1);
+    if (!fileout)
+        return ERROR_INT("fileout not defined", procName, 1);
+    if (quads < 0 || quads > 3)
+        return ERROR_INT("quads not in {0,1,2,3}", procName, 1);
+
+    if ((fpin = fopenReadStream(filein)) == NULL)
+        return ERROR_INT("image file not found", procName, 1);
+    fpout = NULL;
+
+        /* Both structs share the error handler; on a fatal error,
+         * destroying either struct a second time is harmless. */
+    memset(&srcinfo, 0, sizeof(srcinfo));
+    memset(&dstinfo, 0, sizeof(dstinfo));
+    srcinfo.err = dstinfo.err = jpeg_std_error(&jerr);
+    jerr.error_exit = jpeg_error_catch_all_1;
+    srcinfo.client_data = dstinfo.client_data = (void *)&jmpbuf;
+    if (setjmp(jmpbuf)) {
+        jpeg_destroy_compress(&dstinfo);
+        jpeg_destroy_decompress(&srcinfo);
+        if (fpin) fclose(fpin);
+        if (fpout) fclose(fpout);
+        return ERROR_INT("internal jpeg error", procName, 1);
+    }
+    jpeg_create_decompress(&srcinfo);
+    jpeg_create_compress(&dstinfo);
+    jpeg_stdio_src(&srcinfo, fpin);
+    jpeg_save_markers(&srcinfo, JPEG_COM, 0xffff);
+    jpeg_read_header(&srcinfo, TRUE);
+
+        /* Align the crop region to MCU boundaries at the UL corner,
+         * and trim partial MCUs at edges that move to the UL */
+    mcuw = 8 * srcinfo.max_h_samp_factor;
+    mcuh = 8 * srcinfo.max_v_samp_factor;
+    cx = cy = 0;
+    cw = srcinfo.image_width;
+    ch = srcinfo.image_height;
+    if (box) {
+        if ((boxc = boxClipToRectangle(box, cw, ch)) == NULL) {
+            jpeg_destroy_compress(&dstinfo);
+            jpeg_destroy_decompress(&srcinfo);
+            fclose(fpin);
+            return ERROR_INT("box outside image", procName, 1);
+        }
+        boxGetGeometry(boxc, &cx, &cy, &cw, &ch);
+        boxDestroy(&boxc);
+        cw += cx % mcuw;
+        ch += cy % mcuh;
+        cx -= cx % mcuw;
+        cy -= cy % mcuh;
+    }
+    if (quads == 2 || quads == 3)  /* right edge goes to the left or top */
+        cw -= cw % mcuw;
+    if (quads == 1 || quads == 2)  /* bottom edge goes to the left or top */
+        ch -= ch % mcuh;
+    if (cw <= 0 || ch <= 0) {
+        jpeg_destroy_compress(&dstinfo);
+        jpeg_destroy_decompress(&srcinfo);
+        fclose(fpin);
+        return ERROR_INT("region smaller than one MCU", procName, 1);
+    }
+
+        /* Request the output coefficient arrays before reading, so
+         * they are realized along with the input arrays */
+    for (ci = 0; ci < srcinfo.num_components; ci++) {
+        compptr = srcinfo.comp_info + ci;
+        sbw = ((cw + mcuw - 1) / mcuw) * compptr->h_samp_factor;
+        sbh = ((ch + mcuh - 1) / mcuh) * compptr->v_samp_factor;
+        dbw = (quads & 1) ? sbh : sbw;
+        dbh = (quads & 1) ? sbw : sbh;
+        dst_coefs[ci] = (*srcinfo.mem->request_virt_barray)
+                ((j_common_ptr)&srcinfo, JPOOL_IMAGE, FALSE, dbw, dbh,
+                 (quads & 1) ? compptr->h_samp_factor :
+                 compptr->v_samp_factor);
+    }
+    src_coefs = jpeg_read_coefficients(&srcinfo);
+    fclose(fpin);  /* the coefficients have all been read */
+    fpin = NULL;
+
+        /* Set up the output parameters, swapping axes for 90 and
+         * 270 degree rotation.  Note that the quantization tables
+         * must be transposed along with the coefficients. */
+    jpeg_copy_critical_parameters(&srcinfo, &dstinfo);
+    dstinfo.image_width = (quads & 1) ? ch : cw;
+    dstinfo.image_height = (quads & 1) ? cw : ch;
+    if (quads & 1) {
+        tmp = dstinfo.X_density;
+        dstinfo.X_density = dstinfo.Y_density;
+        dstinfo.Y_density = tmp;
+        for (ci = 0; ci < dstinfo.num_components; ci++) {
+            compptr = dstinfo.comp_info + ci;
+            tmp = compptr->h_samp_factor;
+            compptr->h_samp_factor = compptr->v_samp_factor;
+            compptr->v_samp_factor = tmp;
+        }
+        for (i = 0; i < NUM_QUANT_TBLS; i++) {
+            if ((qtbl = dstinfo.quant_tbl_ptrs[i]) == NULL) continue;
+            qsave = *qtbl;
+            for (y = 0; y < DCTSIZE; y++) {
+                for (x = 0; x < DCTSIZE; x++)
+                    qtbl->quantval[y * DCTSIZE + x] =
+                        qsave.quantval[x * DCTSIZE + y];
+            }
+        }
+    }
+
+        /* Move and transform each block */
+    for (ci = 0; ci < srcinfo.num_components; ci++) {
+        compptr = srcinfo.comp_info + ci;
+        hsamp = compptr->h_samp_factor;
+        vsamp = compptr->v_samp_factor;
+        sbw = ((cw + mcuw - 1) / mcuw) * hsamp;
+        sbh = ((ch + mcuh - 1) / mcuh) * vsamp;
+        dbw = (quads & 1) ? sbh : sbw;
+        dbh = (quads & 1) ? sbw : sbh;
+        xoffb = (cx / mcuw) * hsamp;
+        yoffb = (cy / mcuh) * vsamp;
+        for (y = 0; y < dbh; y++) {
+            drow = (*srcinfo.mem->access_virt_barray)
+                    ((j_common_ptr)&srcinfo, dst_coefs[ci], y, 1, TRUE);
+            for (x = 0; x < dbw; x++) {
+                if (quads == 0) {
+                    sx = x;
+                    sy = y;
+                } else if (quads == 1) {
+                    sx = y;
+                    sy = sbh - 1 - x;
+                } else if (quads == 2) {
+                    sx = sbw - 1 - x;
+                    sy = sbh - 1 - y;
+                } else {  /* quads == 3 */
+                    sx = sbw - 1 - y;
+                    sy = x;
+                }
+                srow = (*srcinfo.mem->access_virt_barray)
+                        ((j_common_ptr)&srcinfo, src_coefs[ci], sy + yoffb,
+                         1, FALSE);
+                jpegTransformBlock(srow[0][sx + xoffb], drow[0][x], quads);
+            }
+        }
+    }
+
+        /* Write the output */
+    if ((fpout = fopenWriteStream(fileout, "wb")) == NULL) {
+        jpeg_destroy_compress(&dstinfo);
+        jpeg_destroy_decompress(&srcinfo);
+        return ERROR_INT("stream not opened", procName, 1);
+    }
+    jpeg_stdio_dest(&dstinfo, fpout);
+    jpeg_write_coefficients(&dstinfo, dst_coefs);
+    for (marker = srcinfo.marker_list; marker; marker = marker->next) {
+        if (marker->marker == JPEG_COM)
+            jpeg_write_marker(&dstinfo, JPEG_COM, marker->data,
+                              marker->data_length);
+    }
+    jpeg_finish_compress(&dstinfo);
+    jpeg_destroy_compress(&dstinfo);
+    jpeg_finish_decompress(&srcinfo);
+    jpeg_destroy_decompress(&srcinfo);
+    fclose(fpout);
+    return 0;
+}
+
+
+/*!
+ * \brief   jpegTransformBlock()
+ *
+ * \param[in]    src dct coefficients of the input block
+ * \param[out]   dst dct coefficients of the output block
+ * \param[in]    quads number of 90 degree cw rotations; 0, 1, 2 or 3
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Coefficient (v, u) multiplies a cosine with vertical
+ *          frequency v and horizontal frequency u.  Flipping the block
+ *          LR (TB) negates the coefficients with odd u (v), and
+ *          transposing the block transposes the coefficients.
+ *          A cw rotation is a transpose followed by an LR flip;
+ *          a ccw rotation is a transpose followed by a TB flip.
+ * </pre>
+ */
+static void
+jpegTransformBlock(JCOEFPTR  src,
+                   JCOEFPTR  dst,
+                   l_int32   quads)
+{
+l_int32  u, v;
+
+    for (v = 0; v < DCTSIZE; v++) {
+        for (u = 0; u < DCTSIZE; u++) {
+            if (quads == 0)
+                dst[v * DCTSIZE + u] = src[v * DCTSIZE + u];
+            else if (quads == 1)
+                dst[v * DCTSIZE + u] = (u & 1) ? -src[u * DCTSIZE + v] :
+                                                 src[u * DCTSIZE + v];
+            else if (quads == 2)
+                dst[v * DCTSIZE + u] = ((u + v) & 1) ? -src[v * DCTSIZE + u] :
+                                                       src[v * DCTSIZE + u];
+            else  /* quads == 3 */
+                dst[v * DCTSIZE + u] = (v & 1) ? -src[u * DCTSIZE + v] :
+                                                 src[u * DCTSIZE + v];
+        }
+    }
+}
+
+
 /*---------------------------------------------------------------------*
  *                        Static system helpers                        *
  *---------------------------------------------------------------------*/
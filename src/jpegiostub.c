@@ -60,6 +60,22 @@ PIX * pixReadStreamJpeg(FILE *fp, l_int32 cmflag, l_int32 reduction,
 
 /* ----------------------------------------------------------------------*/
 
+PIX * pixReadJpegRegion(const char *filename, BOX *box, l_int32 reduction,
+                        l_int32 hint)
+{
+    return (PIX * )ERROR_PTR("function not present", "pixReadJpegRegion", NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
+PIX * pixReadJpegThumbnail(const char *filename, l_int32 reduction)
+{
+    return (PIX * )ERROR_PTR("function not present", "pixReadJpegThumbnail",
+                             NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 readHeaderJpeg(const char *filename, l_int32 *pw, l_int32 *ph,
                        l_int32 *pspp, l_int32 *pycck, l_int32 *pcmyk)
 {
@@ -138,6 +154,14 @@ l_int32 pixSetChromaSampling(PIX *pix, l_int32 sampling)
 
 /* ----------------------------------------------------------------------*/
 
+l_int32 jpegTransformLossless(const char *filein, const char *fileout,
+                              l_int32 quads, BOX *box)
+{
+    return ERROR_INT("function not present", "jpegTransformLossless", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 /* --------------------------------------------*/
 #endif  /* !HAVE_LIBJPEG */
 /* --------------------------------------------*/
@@ -48,6 +48,9 @@
  *            L_KERNEL   *kernelNormalize()
  *            L_KERNEL   *kernelInvert()
  *
+ *         Separable decomposition
+ *            l_int32     kernelIsSeparable()
+ *
  *         Helper function
  *            l_float32 **create2dFloatArray()
  *
@@ -463,6 +466,108 @@ L_KERNEL  *keld;
 }
 
 
+/*----------------------------------------------------------------------*
+ *                        Separable decomposition                       *
+ *----------------------------------------------------------------------*/
+/*!
+ * \brief   kernelIsSeparable()
+ *
+ * \param[in]    kel
+ * \param[out]   psep 1 if the kernel is separable; 0 otherwise
+ * \param[out]   pkelx [optional] horizontal factor; null if not separable
+ * \param[out]   pkely [optional] vertical factor; null if not separable
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) A kernel is separable if it is the product of a column vector
+ *          and a row vector; i.e., if it has rank 1.  A convolution
+ *          with a separable kernel can be done as a sequence of
+ *          convolutions in x and y, and the number of pixel-ops goes
+ *          from (sx * sy) to (sx + sy).
+ *      (2) The test uses the element of largest magnitude as a pivot,
+ *          at (p, q).  The kernel has rank 1 if every element satisfies
+ *              kel[i][j] == kel[i][q] * kel[p][j] / kel[p][q]
+ *          This is checked to within a small fraction of the pivot
+ *          magnitude, which allows for the rounding in kernels such
+ *          as those made by makeGaussianKernel().
+ *      (3) The factors are returned as a 1 x sx kernel with origin
+ *          (0, cx) and an sy x 1 kernel with origin (cy, 0), so that
+ *          pixConvolveSep(pixs, kelx, kely, ...) gives the same result
+ *          as pixConvolve(pixs, kel, ...) to within rounding.
+ *      (4) A kernel that is identically zero is not considered separable.
+ * </pre>
+ */
+l_int32
+kernelIsSeparable(L_KERNEL   *kel,
+                  l_int32    *psep,
+                  L_KERNEL  **pkelx,
+                  L_KERNEL  **pkely)
+{
+l_int32    i, j, p, q, sx, sy, cx, cy;
+l_float32  val, maxval, pivot, tol;
+L_KERNEL  *kelx, *kely;
+
+    PROCNAME("kernelIsSeparable");
+
+    if (pkelx) *pkelx = NULL;
+    if (pkely) *pkely = NULL;
+    if (!psep)
+        return ERROR_INT("&sep not defined", procName, 1);
+    *psep = 0;
+    if (!kel)
+        return ERROR_INT("kel not defined", procName, 1);
+
+        /* Find the pivot */
+    kernelGetParameters(kel, &sy, &sx, &cy, &cx);
+    maxval = 0.0;
+    p = q = 0;
+    for (i = 0; i < sy; i++) {
+        for (j = 0; j < sx; j++) {
+            val = L_ABS(kel->data[i][j]);
+            if (val > maxval) {
+                maxval = val;
+                p = i;
+                q = j;
+            }
+        }
+    }
+    if (maxval == 0.0)
+        return 0;
+
+        /* Check that every element is the product of its row and
+         * column factors */
+    pivot = kel->data[p][q];
+    tol = 0.00001 * maxval;
+    for (i = 0; i < sy; i++) {
+        for (j = 0; j < sx; j++) {
+            val = kel->data[i][q] * kel->data[p][j] / pivot;
+            if (L_ABS(kel->data[i][j] - val) > tol)
+                return 0;
+        }
+    }
+    *psep = 1;
+
+    if (pkelx) {
+        if ((kelx = kernelCreate(1, sx)) == NULL)
+            return ERROR_INT("kelx not made", procName, 1);
+        kelx->cx = cx;
+        for (j = 0; j < sx; j++)
+            kelx->data[0][j] = kel->data[p][j] / pivot;
+        *pkelx = kelx;
+    }
+    if (pkely) {
+        if ((kely = kernelCreate(sy, 1)) == NULL)
+            return ERROR_INT("kely not made", procName, 1);
+        kely->cy = cy;
+        for (i = 0; i < sy; i++)
+            kely->data[i][0] = kel->data[i][q];
+        *pkely = kely;
+    }
+    return 0;
+}
+
+
 /*----------------------------------------------------------------------*
  *                            Helper function                           *
  *----------------------------------------------------------------------*/
@@ -35,6 +35,7 @@
  *      struct Sel
  *      struct Sela
  *      struct Kernel
+ *      struct MorphSeq
  *
  *  Contains definitions for:
  *      morphological b.c. flags
@@ -97,6 +98,25 @@ struct L_Kernel
 typedef struct L_Kernel  L_KERNEL;
 
 
+/*-------------------------------------------------------------------------*
+ *               Compiled sequence of binary morphological ops             *
+ *-------------------------------------------------------------------------*/
+/*! Compiled sequence of binary morphological operations */
+struct L_MorphSeq
+{
+    l_int32       nops;      /*!< number of ops, after fusion              */
+    l_int32      *optype;    /*!< op char: 'd', 'e', 'o', 'c', 'r', 'x', 'b' */
+    l_int32      *args;      /*!< 4 args per op: brick (w,h), reduction    */
+                             /*!< levels, expansion factor or border size  */
+    char        **nameh;     /*!< dwa horizontal sel name; null if unused  */
+    char        **namev;     /*!< dwa vertical sel name; null if unused    */
+    l_int32       border;    /*!< size of border added by 'b'; 0 if none   */
+    l_int32       bc;        /*!< b.c. when compiled; must be the same    */
+                             /*!< when the sequence is applied           */
+};
+typedef struct L_MorphSeq  L_MORPHSEQ;
+
+
 /*-------------------------------------------------------------------------*
  *                 Morphological boundary condition flags                  *
  *                                                                         *
@@ -40,6 +40,13 @@
  *      Run a sequence of binary composite dwa morphological operations
  *            PIX     *pixMorphCompSequenceDwa()
  *
+ *      Compiled sequence of binary morphological operations
+ *            L_MORPHSEQ  *morphseqCreate()
+ *            void         morphseqDestroy()
+ *            PIX         *pixMorphSeqApply()
+ *            PIXA        *pixaMorphSeqApply()
+ *            static PIX  *morphseqApplyLow()
+ *
  *      Parser verifier for binary morphological operations
  *            l_int32  morphSequenceVerify()
  *
@@ -54,6 +61,11 @@
 #include <string.h>
 #include "allheaders.h"
 
+static const l_int32  L_BUF_SIZE = 64;
+
+static PIX *morphseqApplyLow(PIX *pixs, L_MORPHSEQ *ms, PIX **ppixb1,
+                             PIX **ppixb2);
+
 /*-------------------------------------------------------------------------*
  *         Run a sequence of binary rasterop morphological operations      *
  *-------------------------------------------------------------------------*/
@@ -717,6 +729,469 @@ SARRAY  *sa;
 }
 
 
+/*-------------------------------------------------------------------------*
+ *           Compiled sequence of binary morphological operations          *
+ *-------------------------------------------------------------------------*/
+/*!
+ * \brief   morphseqCreate()
+ *
+ * \param[in]    sequence string specifying sequence
+ * \return  ms compiled sequence, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This parses and verifies a sequence of binary morphological
+ *          operations once, so that it can be applied to many images
+ *          with pixMorphSeqApply() or pixaMorphSeqApply().  The format
+ *          of the sequence string is given in pixMorphSequence().
+ *      (2) Two simplifications are made in the compiled sequence:
+ *           ~ Brick operations of size 1 x 1 are removed.
+ *           ~ Adjacent dilations are fused into one dilation if all
+ *             brick dimensions are odd: successive dilations by
+ *             centered bricks of widths w1 and w2 are equivalent to a
+ *             dilation by a centered brick of width w1 + w2 - 1, and
+ *             likewise for the height.  Adjacent erosions are fused in
+ *             the same way if the asymmetric b.c. is in effect when
+ *             the sequence is compiled; with the symmetric b.c. the
+ *             result would differ near the image boundary.
+ *      (3) Each brick operation is done with dwa if the linear Sels
+ *          it needs are in the basic set made by selaAddBasic(), and
+ *          otherwise with rasterop.  The Sel names are found here, so
+ *          that the Sel set is not made each time the sequence is
+ *          applied.
+ *      (4) Applying the compiled sequence gives the same result as
+ *          pixMorphSequence() with the same string.
+ *      (5) Because of (2), the compiled sequence depends on the b.c.
+ *          in effect when it is made.  That b.c. is saved, and the
+ *          sequence can't be applied after the b.c. has been changed
+ *          with resetMorphBoundaryCondition(); compile it again.
+ * </pre>
+ */
+L_MORPHSEQ *
+morphseqCreate(const char  *sequence)
+{
+char        *rawop, *op;
+char         name[L_BUF_SIZE];
+l_int32      nops, i, j, k, nred, w, h, opc, asymmetric;
+l_int32     *a, *ap;
+SARRAY      *sa;
+SELA        *sela;
+L_MORPHSEQ  *ms;
+
+    PROCNAME("morphseqCreate");
+
+    if (!sequence)
+        return (L_MORPHSEQ *)ERROR_PTR("sequence not defined", procName, NULL);
+
+        /* Split sequence into individual operations and verify */
+    sa = sarrayCreate(0);
+    sarraySplitString(sa, sequence, "+");
+    nops = sarrayGetCount(sa);
+    if (!morphSequenceVerify(sa)) {
+        sarrayDestroy(&sa);
+        return (L_MORPHSEQ *)ERROR_PTR("sequence not valid", procName, NULL);
+    }
+
+    ms = (L_MORPHSEQ *)LEPT_CALLOC(1, sizeof(L_MORPHSEQ));
+    ms->optype = (l_int32 *)LEPT_CALLOC(L_MAX(nops, 1), sizeof(l_int32));
+    ms->args = (l_int32 *)LEPT_CALLOC(4 * L_MAX(nops, 1), sizeof(l_int32));
+    ms->nameh = (char **)LEPT_CALLOC(L_MAX(nops, 1), sizeof(char *));
+    ms->namev = (char **)LEPT_CALLOC(L_MAX(nops, 1), sizeof(char *));
+
+        /* Parse, dropping identity ops and fusing adjacent dilations
+         * or erosions where the result is unchanged */
+    asymmetric = (getMorphBorderPixelColor(L_MORPH_ERODE, 1) == 0);
+    ms->bc = (asymmetric) ? ASYMMETRIC_MORPH_BC : SYMMETRIC_MORPH_BC;
+    k = 0;
+    for (i = 0; i < nops; i++) {
+        rawop = sarrayGetString(sa, i, L_NOCOPY);
+        op = stringRemoveChars(rawop, " \n\t");
+        a = ms->args + 4 * k;
+        switch (op[0])
+        {
+        case 'd':
+        case 'D':
+        case 'e':
+        case 'E':
+        case 'o':
+        case 'O':
+        case 'c':
+        case 'C':
+            opc = (op[0] >= 'a') ? op[0] : op[0] + ('a' - 'A');
+            sscanf(&op[1], "%d.%d", &w, &h);
+            if (w == 1 && h == 1)
+                break;
+            if (k > 0 && ms->optype[k - 1] == opc &&
+                (opc == 'd' || (opc == 'e' && asymmetric))) {
+                ap = ms->args + 4 * (k - 1);
+                if ((w & 1) && (h & 1) && (ap[0] & 1) && (ap[1] & 1)) {
+                    ap[0] += w - 1;
+                    ap[1] += h - 1;
+                    break;
+                }
+            }
+            ms->optype[k] = opc;
+            a[0] = w;
+            a[1] = h;
+            k++;
+            break;
+        case 'r':
+        case 'R':
+            nred = strlen(op) - 1;
+            for (j = 0; j < nred; j++)
+                a[j] = op[j + 1] - '0';
+            ms->optype[k++] = 'r';
+            break;
+        case 'x':
+        case 'X':
+            sscanf(&op[1], "%d", &a[0]);
+            ms->optype[k++] = 'x';
+            break;
+        case 'b':
+        case 'B':
+            sscanf(&op[1], "%d", &a[0]);
+            ms->border = a[0];
+            ms->optype[k++] = 'b';
+            break;
+        default:
+            /* All invalid ops are caught by morphSequenceVerify() */
+            break;
+        }
+        LEPT_FREE(op);
+    }
+    ms->nops = k;
+    sarrayDestroy(&sa);
+
+        /* Select dwa for the brick ops that have all their Sels */
+    sela = selaAddBasic(NULL);
+    for (i = 0; i < ms->nops; i++) {
+        opc = ms->optype[i];
+        if (opc != 'd' && opc != 'e' && opc != 'o' && opc != 'c')
+            continue;
+        w = ms->args[4 * i];
+        h = ms->args[4 * i + 1];
+        if (w > 1) {
+            snprintf(name, L_BUF_SIZE, "sel_%dh", w);
+            if (selaFindSelByName(sela, name, NULL, NULL))
+                continue;
+        }
+        if (h > 1) {
+            snprintf(name, L_BUF_SIZE, "sel_%dv", h);
+            if (selaFindSelByName(sela, name, NULL, NULL))
+                continue;
+        }
+        if (w > 1) {
+            snprintf(name, L_BUF_SIZE, "sel_%dh", w);
+            ms->nameh[i] = stringNew(name);
+        }
+        if (h > 1) {
+            snprintf(name, L_BUF_SIZE, "sel_%dv", h);
+            ms->namev[i] = stringNew(name);
+        }
+    }
+    selaDestroy(&sela);
+
+    return ms;
+}
+
+
+/*!
+ * \brief   morphseqDestroy()
+ *
+ * \param[in,out]   pms will be set to null before returning
+ * \return  void
+ */
+void
+morphseqDestroy(L_MORPHSEQ  **pms)
+{
+l_int32      i;
+L_MORPHSEQ  *ms;
+
+    PROCNAME("morphseqDestroy");
+
+    if (pms == NULL) {
+        L_WARNING("ptr address is NULL!\n", procName);
+        return;
+    }
+    if ((ms = *pms) == NULL)
+        return;
+
+    for (i = 0; i < ms->nops; i++) {
+        LEPT_FREE(ms->nameh[i]);
+        LEPT_FREE(ms->namev[i]);
+    }
+    LEPT_FREE(ms->optype);
+    LEPT_FREE(ms->args);
+    LEPT_FREE(ms->nameh);
+    LEPT_FREE(ms->namev);
+    LEPT_FREE(ms);
+    *pms = NULL;
+    return;
+}
+
+
+/*!
+ * \brief   pixMorphSeqApply()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    ms compiled sequence
+ * \return  pixd, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) A new image is always produced; the input image is not changed.
+ *      (2) Consecutive dwa operations work in a pair of bordered
+ *          images, alternating between them, so the border is added
+ *          and removed once for each run of dwa operations, rather than
+ *          for each operation.  The rasterop operations likewise
+ *          alternate between two images of the same size.
+ *      (3) The b.c. must be the same as when %ms was made; otherwise
+ *          an error is returned.  See morphseqCreate().
+ * </pre>
+ */
+PIX *
+pixMorphSeqApply(PIX         *pixs,
+                 L_MORPHSEQ  *ms)
+{
+l_int32  bc;
+PIX     *pixd, *pixb1, *pixb2;
+
+    PROCNAME("pixMorphSeqApply");
+
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return (PIX *)ERROR_PTR("pixs undefined or not 1 bpp", procName, NULL);
+    if (!ms)
+        return (PIX *)ERROR_PTR("ms not defined", procName, NULL);
+    bc = (getMorphBorderPixelColor(L_MORPH_ERODE, 1) == 0) ?
+         ASYMMETRIC_MORPH_BC : SYMMETRIC_MORPH_BC;
+    if (bc != ms->bc)
+        return (PIX *)ERROR_PTR("b.c. changed since ms was made",
+                                procName, NULL);
+
+    pixb1 = pixb2 = NULL;
+    pixd = morphseqApplyLow(pixs, ms, &pixb1, &pixb2);
+    pixDestroy(&pixb1);
+    pixDestroy(&pixb2);
+    return pixd;
+}
+
+
+/*!
+ * \brief   pixaMorphSeqApply()
+ *
+ * \param[in]    pixas of 1 bpp pix
+ * \param[in]    ms compiled sequence
+ * \return  pixad, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This applies the compiled sequence to each pix in pixas.
+ *          The bordered images used for dwa operations are kept from
+ *          one pix to the next, and are only remade when the size
+ *          changes.
+ *      (2) Any pix in pixas that is not 1 bpp is copied to pixad.
+ *          The boxa of pixas is not copied, because the sequence
+ *          may change the image size.
+ *      (3) The b.c. must be the same as when %ms was made; otherwise
+ *          an error is returned.  See morphseqCreate().
+ * </pre>
+ */
+PIXA *
+pixaMorphSeqApply(PIXA        *pixas,
+                  L_MORPHSEQ  *ms)
+{
+l_int32  i, n, bc;
+PIX     *pixs, *pixd, *pixb1, *pixb2;
+PIXA    *pixad;
+
+    PROCNAME("pixaMorphSeqApply");
+
+    if (!pixas)
+        return (PIXA *)ERROR_PTR("pixas not defined", procName, NULL);
+    if (!ms)
+        return (PIXA *)ERROR_PTR("ms not defined", procName, NULL);
+    bc = (getMorphBorderPixelColor(L_MORPH_ERODE, 1) == 0) ?
+         ASYMMETRIC_MORPH_BC : SYMMETRIC_MORPH_BC;
+    if (bc != ms->bc)
+        return (PIXA *)ERROR_PTR("b.c. changed since ms was made",
+                                 procName, NULL);
+
+    n = pixaGetCount(pixas);
+    pixad = pixaCreate(n);
+    pixb1 = pixb2 = NULL;
+    for (i = 0; i < n; i++) {
+        pixs = pixaGetPix(pixas, i, L_CLONE);
+        if (pixGetDepth(pixs) != 1) {
+            L_ERROR("pix %d not 1 bpp; copying\n", procName, i);
+            pixaAddPix(pixad, pixs, L_COPY);
+        } else {
+            pixd = morphseqApplyLow(pixs, ms, &pixb1, &pixb2);
+            pixaAddPix(pixad, pixd, L_INSERT);
+        }
+        pixDestroy(&pixs);
+    }
+
+    pixDestroy(&pixb1);
+    pixDestroy(&pixb2);
+    return pixad;
+}
+
+
+/*!
+ * \brief   morphseqApplyLow()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    ms compiled sequence
+ * \param[in,out]   ppixb1, ppixb2 bordered images for dwa; can be reused
+ * \return  pixd, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) For dwa, the border is 32 pixels, or 64 pixels with the
+ *          asymmetric b.c. so that the closing is safe.  The entire
+ *          border is cleared before each operation.  This is
+ *          equivalent to removing the border and adding a new one,
+ *          because pixFMorphopGen_1() sets the outer 32 pixels to the
+ *          required b.c. before each erosion or dilation.
+ * </pre>
+ */
+static PIX *
+morphseqApplyLow(PIX          *pixs,
+                 L_MORPHSEQ   *ms,
+                 PIX         **ppixb1,
+                 PIX         **ppixb2)
+{
+char    *name[4];
+l_int32  i, j, w, h, bs, inbuf, npass, opc;
+l_int32  pass[4];
+l_int32 *a;
+PIX     *pixc, *pixt, *pix1;
+
+    bs = (getMorphBorderPixelColor(L_MORPH_ERODE, 1) == 0) ? 64 : 32;
+    pixc = pixClone(pixs);  /* never altered in place */
+    pixt = NULL;  /* spare image for rasterop */
+    inbuf = FALSE;  /* TRUE when the current image is in *ppixb1 */
+    for (i = 0; i < ms->nops; i++) {
+        opc = ms->optype[i];
+        a = ms->args + 4 * i;
+
+            /* Dwa brick operation */
+        if (ms->nameh[i] || ms->namev[i]) {
+            if (!inbuf) {
+                pixGetDimensions(pixc, &w, &h, NULL);
+                if (!*ppixb1 || pixGetWidth(*ppixb1) != w + 2 * bs ||
+                    pixGetHeight(*ppixb1) != h + 2 * bs) {
+                    pixDestroy(ppixb1);
+                    pixDestroy(ppixb2);
+                    *ppixb1 = pixAddBorder(pixc, bs, 0);
+                    *ppixb2 = pixCreateTemplate(*ppixb1);
+                } else {
+                    pixRasterop(*ppixb1, bs, bs, w, h, PIX_SRC, pixc, 0, 0);
+                }
+                pixDestroy(&pixc);
+                inbuf = TRUE;
+            }
+            pixSetOrClearBorder(*ppixb1, bs, bs, bs, bs, PIX_CLR);
+
+                /* Separable passes, in the order used in morphdwa.c */
+            npass = 0;
+            if (opc == 'e' || opc == 'o') {
+                if (ms->nameh[i]) {
+                    pass[npass] = L_MORPH_ERODE;
+                    name[npass++] = ms->nameh[i];
+                }
+                if (ms->namev[i]) {
+                    pass[npass] = L_MORPH_ERODE;
+                    name[npass++] = ms->namev[i];
+                }
+            }
+            if (opc != 'e') {
+                if (ms->nameh[i]) {
+                    pass[npass] = L_MORPH_DILATE;
+                    name[npass++] = ms->nameh[i];
+                }
+                if (ms->namev[i]) {
+                    pass[npass] = L_MORPH_DILATE;
+                    name[npass++] = ms->namev[i];
+                }
+            }
+            if (opc == 'c') {
+                if (ms->nameh[i]) {
+                    pass[npass] = L_MORPH_ERODE;
+                    name[npass++] = ms->nameh[i];
+                }
+                if (ms->namev[i]) {
+                    pass[npass] = L_MORPH_ERODE;
+                    name[npass++] = ms->namev[i];
+                }
+            }
+            for (j = 0; j < npass; j++) {
+                pixFMorphopGen_1(*ppixb2, *ppixb1, pass[j], name[j]);
+                pix1 = *ppixb1;
+                *ppixb1 = *ppixb2;
+                *ppixb2 = pix1;
+            }
+            continue;
+        }
+
+            /* Rasterop operations */
+        if (inbuf) {
+            pixc = pixRemoveBorder(*ppixb1, bs);
+            inbuf = FALSE;
+        }
+        switch (opc)
+        {
+        case 'd':
+            pixt = pixDilateBrick(pixt, pixc, a[0], a[1]);
+            break;
+        case 'e':
+            pixt = pixErodeBrick(pixt, pixc, a[0], a[1]);
+            break;
+        case 'o':
+            pixt = pixOpenBrick(pixt, pixc, a[0], a[1]);
+            break;
+        case 'c':
+            pixt = pixCloseSafeBrick(pixt, pixc, a[0], a[1]);
+            break;
+        case 'r':
+            pixDestroy(&pixt);
+            pixt = pixReduceRankBinaryCascade(pixc, a[0], a[1], a[2], a[3]);
+            break;
+        case 'x':
+            pixDestroy(&pixt);
+            pixt = pixExpandReplicate(pixc, a[0]);
+            break;
+        case 'b':
+            pixDestroy(&pixt);
+            pixt = pixAddBorder(pixc, a[0], 0);
+            break;
+        default:
+            break;
+        }
+
+            /* Swap; the input is never used as the spare image */
+        pix1 = pixc;
+        pixc = pixt;
+        pixt = pix1;
+        if (pixt == pixs)
+            pixDestroy(&pixt);
+    }
+    if (inbuf)
+        pixc = pixRemoveBorder(*ppixb1, bs);
+    pixDestroy(&pixt);
+
+    if (ms->border > 0) {
+        pix1 = pixRemoveBorder(pixc, ms->border);
+        pixSwapAndDestroy(&pixc, &pix1);
+    }
+    if (pixc == pixs) {  /* no ops */
+        pixDestroy(&pixc);
+        pixc = pixCopy(NULL, pixs);
+    }
+    return pixc;
+}
+
+
 /*-------------------------------------------------------------------------*
  *            Parser verifier for binary morphological operations          *
  *-------------------------------------------------------------------------*/
@@ -30,6 +30,7 @@
  *
  *      Top level page segmentation
  *          l_int32   pixGetRegionsBinary()
+ *          l_int32   pixGetRegionsBinaryTimed()
  *
  *      Halftone region extraction
  *          PIX      *pixGenHalftoneMask()    **Deprecated wrapper**
@@ -95,6 +96,7 @@ static const l_int32  MinHeight = 100;
  * Notes:
  *      (1) It is best to deskew the image before segmenting.
  *      (2) Passing in %pixadb enables debug output.
+ *      (3) See pixGetRegionsBinaryTimed() for details.
  * </pre>
  */
 l_int32
@@ -104,19 +106,68 @@ pixGetRegionsBinary(PIX   *pixs,
                     PIX  **ppixtb,
                     PIXA  *pixadb)
 {
-l_int32  w, h, htfound, tlfound;
-PIX     *pixr, *pix1, *pix2;
-PIX     *pixtext;  /* text pixels only */
-PIX     *pixhm2;   /* halftone mask; 2x reduction */
-PIX     *pixhm;    /* halftone mask;  */
-PIX     *pixtm2;   /* textline mask; 2x reduction */
-PIX     *pixtm;    /* textline mask */
-PIX     *pixvws;   /* vertical white space mask */
-PIX     *pixtb2;   /* textblock mask; 2x reduction */
-PIX     *pixtbf2;  /* textblock mask; 2x reduction; small comps filtered */
-PIX     *pixtb;    /* textblock mask */
-
-    PROCNAME("pixGetRegionsBinary");
+    return pixGetRegionsBinaryTimed(pixs, ppixhm, ppixtm, ppixtb,
+                                    NULL, pixadb);
+}
+
+
+/*!
+ * \brief   pixGetRegionsBinaryTimed()
+ *
+ * \param[in]    pixs 1 bpp, assumed to be 300 to 400 ppi
+ * \param[out]   ppixhm [optional] halftone mask
+ * \param[out]   ppixtm [optional] textline mask
+ * \param[out]   ppixtb [optional] textblock mask
+ * \param[in]    natime [optional] input for collecting stage times;
+ *                      use NULL to skip
+ * \param[in]    pixadb  input for collecting debug pix; use NULL to skip
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) It is best to deskew the image before segmenting.
+ *      (2) Passing in %pixadb enables debug output.
+ *      (3) The masks are computed at 2x reduction in a chain of
+ *          dependent stages: the halftone mask gives the text pixels,
+ *          from which the textline mask is made, from which the
+ *          textblock mask is made.  Only the stages required for the
+ *          requested masks are run, and only the requested masks are
+ *          expanded to full resolution.  For example, if only the
+ *          halftone mask is requested, the textline and textblock
+ *          stages are skipped.
+ *      (4) If %natime is defined, the CPU time in seconds for each
+ *          of these stages is appended to it, in this order:
+ *              0: 2x rank reduction
+ *              1: halftone mask
+ *              2: textline mask
+ *              3: textblock mask, including removal of small blocks
+ *              4: expansion of the masks to full resolution
+ *          Stages that are skipped are given a time of 0.0.
+ * </pre>
+ */
+l_int32
+pixGetRegionsBinaryTimed(PIX   *pixs,
+                         PIX  **ppixhm,
+                         PIX  **ppixtm,
+                         PIX  **ppixtb,
+                         NUMA  *natime,
+                         PIXA  *pixadb)
+{
+l_int32   w, h, htfound, tlfound, needtm, needtb;
+l_float32 times[5];
+L_TIMER   timer;
+PIX      *pixr, *pix1, *pix2;
+PIX      *pixtext;  /* text pixels only */
+PIX      *pixhm2;   /* halftone mask; 2x reduction */
+PIX      *pixhm;    /* halftone mask;  */
+PIX      *pixtm2;   /* textline mask; 2x reduction */
+PIX      *pixtm;    /* textline mask */
+PIX      *pixvws;   /* vertical white space mask */
+PIX      *pixtb2;   /* textblock mask; 2x reduction */
+PIX      *pixtbf2;  /* textblock mask; 2x reduction; small comps filtered */
+PIX      *pixtb;    /* textblock mask */
+
+    PROCNAME("pixGetRegionsBinaryTimed");
 
     if (ppixhm) *ppixhm = NULL;
     if (ppixtm) *ppixtm = NULL;
@@ -129,50 +180,84 @@ PIX     *pixtb;    /* textblock mask */
         return 1;
     }
 
+        /* Determine which stages are needed */
+    needtb = (ppixtb || pixadb) ? 1 : 0;
+    needtm = (needtb || ppixtm) ? 1 : 0;
+    times[0] = times[1] = times[2] = times[3] = times[4] = 0.0;
+    pixtext = pixvws = pixtm2 = pixtbf2 = NULL;
+    pixhm = pixtm = pixtb = NULL;
+
         /* 2x reduce, to 150 -200 ppi */
+    timer = startTimerNested();
     pixr = pixReduceRankBinaryCascade(pixs, 1, 0, 0, 0);
+    times[0] = stopTimerNested(timer);
     if (pixadb) pixaAddPix(pixadb, pixr, L_COPY);
 
         /* Get the halftone mask */
-    pixhm2 = pixGenerateHalftoneMask(pixr, &pixtext, &htfound, pixadb);
+    timer = startTimerNested();
+    pixhm2 = pixGenerateHalftoneMask(pixr, needtm ? &pixtext : NULL,
+                                     &htfound, pixadb);
+    pixDestroy(&pixr);
+    times[1] = stopTimerNested(timer);
 
         /* Get the textline mask from the text pixels */
-    pixtm2 = pixGenTextlineMask(pixtext, &pixvws, &tlfound, pixadb);
+    if (needtm) {
+        timer = startTimerNested();
+        pixtm2 = pixGenTextlineMask(pixtext, &pixvws, &tlfound, pixadb);
+        pixDestroy(&pixtext);
+        times[2] = stopTimerNested(timer);
+    }
 
-        /* Get the textblock mask from the textline mask */
-    pixtb2 = pixGenTextblockMask(pixtm2, pixvws, pixadb);
-    pixDestroy(&pixr);
-    pixDestroy(&pixtext);
+        /* Get the textblock mask from the textline mask, and remove
+         * small components from it, where a small component is
+         * defined as one with both width and height < 60 */
+    if (needtb) {
+        timer = startTimerNested();
+        pixtb2 = pixGenTextblockMask(pixtm2, pixvws, pixadb);
+        pixtbf2 = pixSelectBySize(pixtb2, 60, 60, 4, L_SELECT_IF_EITHER,
+                                  L_SELECT_IF_GTE, NULL);
+        pixDestroy(&pixtb2);
+        times[3] = stopTimerNested(timer);
+        if (pixadb) pixaAddPix(pixadb, pixtbf2, L_COPY);
+    }
     pixDestroy(&pixvws);
 
-        /* Remove small components from the mask, where a small
-         * component is defined as one with both width and height < 60 */
-    pixtbf2 = pixSelectBySize(pixtb2, 60, 60, 4, L_SELECT_IF_EITHER,
-                              L_SELECT_IF_GTE, NULL);
-    pixDestroy(&pixtb2);
-    if (pixadb) pixaAddPix(pixadb, pixtbf2, L_COPY);
-
-        /* Expand all masks to full resolution, and do filling or
-         * small dilations for better coverage. */
-    pixhm = pixExpandReplicate(pixhm2, 2);
-    pix1 = pixSeedfillBinary(NULL, pixhm, pixs, 8);
-    pixOr(pixhm, pixhm, pix1);
-    pixDestroy(&pix1);
-    if (pixadb) pixaAddPix(pixadb, pixhm, L_COPY);
+        /* Expand the requested masks to full resolution, and do
+         * filling or small dilations for better coverage. */
+    timer = startTimerNested();
+    if (ppixhm || pixadb) {
+        pixhm = pixExpandReplicate(pixhm2, 2);
+        pix1 = pixSeedfillBinary(NULL, pixhm, pixs, 8);
+        pixOr(pixhm, pixhm, pix1);
+        pixDestroy(&pix1);
+        if (pixadb) pixaAddPix(pixadb, pixhm, L_COPY);
+    }
 
-    pix1 = pixExpandReplicate(pixtm2, 2);
-    pixtm = pixDilateBrick(NULL, pix1, 3, 3);
-    pixDestroy(&pix1);
-    if (pixadb) pixaAddPix(pixadb, pixtm, L_COPY);
+    if (ppixtm || pixadb) {
+        pix1 = pixExpandReplicate(pixtm2, 2);
+        pixtm = pixDilateBrick(NULL, pix1, 3, 3);
+        pixDestroy(&pix1);
+        if (pixadb) pixaAddPix(pixadb, pixtm, L_COPY);
+    }
 
-    pix1 = pixExpandReplicate(pixtbf2, 2);
-    pixtb = pixDilateBrick(NULL, pix1, 3, 3);
-    pixDestroy(&pix1);
-    if (pixadb) pixaAddPix(pixadb, pixtb, L_COPY);
+    if (ppixtb || pixadb) {
+        pix1 = pixExpandReplicate(pixtbf2, 2);
+        pixtb = pixDilateBrick(NULL, pix1, 3, 3);
+        pixDestroy(&pix1);
+        if (pixadb) pixaAddPix(pixadb, pixtb, L_COPY);
+    }
+    times[4] = stopTimerNested(timer);
 
     pixDestroy(&pixhm2);
     pixDestroy(&pixtm2);
     pixDestroy(&pixtbf2);
+    if (natime) {
+        numaAddNumber(natime, times[0]);
+        numaAddNumber(natime, times[1]);
+        numaAddNumber(natime, times[2]);
+        numaAddNumber(natime, times[3]);
+        numaAddNumber(natime, times[4]);
+    }
 
         /* Debug: identify objects that are neither text nor halftone image */
     if (pixadb) {
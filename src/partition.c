@@ -35,30 +35,35 @@
  *          static PARTEL   *partelCreate()
  *          static void      partelDestroy()
  *          static l_int32   partelSetSize()
- *          static BOXA     *boxaGenerateSubboxes()
- *          static BOX      *boxaSelectPivotBox()
- *          static l_int32   boxaCheckIfOverlapIsSmall()
+ *          static l_int32   partelSetSubset()
+ *          static BOXA     *partelGenerateSubboxes()
+ *          static l_int32   partelSelectPivot()
+ *          static l_int32   boxCheckIfOverlapIsBig()
  *          BOXA            *boxaPruneSortedOnOverlap()
  * </pre>
  */
 
+#include <string.h>
 #include "allheaders.h"
 
 /*! Partition element */
 struct PartitionElement {
-    l_float32  size;  /* sorting key */
-    BOX       *box;   /* region of the element */
-    BOXA      *boxa;  /* set of intersecting boxes */
+    l_float32  size;   /* sorting key */
+    BOX       *box;    /* region of the element */
+    l_int32   *index;  /* indices of the intersecting boxes */
+    l_int32    n;      /* number of intersecting boxes */
 };
 typedef struct PartitionElement PARTEL;
 
 static PARTEL * partelCreate(BOX *box);
 static void partelDestroy(PARTEL **ppartel);
 static l_int32 partelSetSize(PARTEL *partel, l_int32 sortflag);
-static BOXA * boxaGenerateSubboxes(BOX *box, BOXA *boxa, l_int32 maxperim,
-                                   l_float32  fract);
-static BOX * boxaSelectPivotBox(BOX *box, BOXA *boxa, l_int32 maxperim,
-                                l_float32 fract);
+static l_int32 partelSetSubset(PARTEL *partel, PARTEL *parent,
+                               const l_int32 *geom, l_int32 *buf);
+static BOXA * partelGenerateSubboxes(PARTEL *partel, const l_int32 *geom,
+                                     l_int32 maxperim, l_float32 fract);
+static l_int32 partelSelectPivot(PARTEL *partel, const l_int32 *geom,
+                                 l_int32 maxperim, l_float32 fract);
 static l_int32 boxCheckIfOverlapIsBig(BOX *box, BOXA *boxa,
                                       l_float32 maxoverlap);
 
@@ -183,6 +188,13 @@ static const l_int32  DEFAULT_MAX_POPS = 20000;
  *          between a box and any of the taller ones, and avoiding the
  *          use of any c.c. with a b.b. half perimeter greater than 200
  *          as a pivot.
+ *     (12) The geometry of the boxes in boxas is copied once into an
+ *          array, and each partel holds only the indices of the boxes
+ *          that intersect its region.  The boxes intersecting a subregion
+ *          are found by scanning the (already localized) index list of
+ *          its parent, so the work done at each pop is proportional
+ *          to the number of boxes in that region, and no box copies
+ *          are made.
  * </pre>
  */
 BOXA *
@@ -195,11 +207,12 @@ boxaGetWhiteblocks(BOXA      *boxas,
                    l_float32  fract,
                    l_int32    maxpops)
 {
-l_int32  i, w, h, n, nsub, npush, npop;
-BOX     *boxsub;
-BOXA    *boxa, *boxa4, *boxasub, *boxad;
-PARTEL  *partel;
-L_HEAP  *lh;
+l_int32   i, w, h, n, nsub, npush, npop;
+l_int32  *geom, *buf;
+BOX      *boxt, *boxsub;
+BOXA     *boxa4, *boxad;
+PARTEL   *partel, *partelsub;
+L_HEAP   *lh;
 
     PROCNAME("boxaGetWhiteblocks");
 
@@ -219,15 +232,29 @@ L_HEAP  *lh;
     if (maxpops == 0)
         maxpops = DEFAULT_MAX_POPS;
 
-    if (!box) {
-        boxaGetExtent(boxas, &w, &h, NULL);
-        box = boxCreate(0, 0, w, h);
+        /* Save the geometry of all boxes, to be referenced by index */
+    n = boxaGetCount(boxas);
+    geom = (l_int32 *)LEPT_CALLOC(4 * n + 1, sizeof(l_int32));
+    buf = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    for (i = 0; i < n; i++) {
+        boxaGetBoxGeometry(boxas, i, geom + 4 * i, geom + 4 * i + 1,
+                           geom + 4 * i + 2, geom + 4 * i + 3);
     }
 
         /* Prime the heap */
     lh = lheapCreate(20, L_SORT_DECREASING);
-    partel = partelCreate(box);
-    partel->boxa = boxaCopy(boxas, L_CLONE);
+    if (!box) {
+        boxaGetExtent(boxas, &w, &h, NULL);
+        boxt = boxCreate(0, 0, w, h);
+        partel = partelCreate(boxt);
+        boxDestroy(&boxt);
+    } else {
+        partel = partelCreate(box);
+    }
+    partel->index = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    for (i = 0; i < n; i++)
+        partel->index[i] = i;
+    partel->n = n;
     partelSetSize(partel, sortflag);
     lheapAdd(lh, partel);
 
@@ -244,36 +271,25 @@ L_HEAP  *lh;
             break;
         }
 
-            /* Extract the contents */
-        boxa = boxaCopy(partel->boxa, L_CLONE);
-        box = boxClone(partel->box);
-        partelDestroy(&partel);
-
             /* Can we output this one? */
-        n = boxaGetCount(boxa);
-        if (n == 0) {
-            if (boxCheckIfOverlapIsBig(box, boxad, maxoverlap) == 0)
-                boxaAddBox(boxad, box, L_INSERT);
-            else
-                boxDestroy(&box);
-            boxaDestroy(&boxa);
+        if (partel->n == 0) {
+            if (boxCheckIfOverlapIsBig(partel->box, boxad, maxoverlap) == 0)
+                boxaAddBox(boxad, partel->box, L_COPY);
+            partelDestroy(&partel);
             if (boxaGetCount(boxad) >= maxboxes)  /* we're done */
                 break;
             continue;
         }
 
-
             /* Generate up to 4 subboxes and put them on the heap */
-        boxa4 = boxaGenerateSubboxes(box, boxa, maxperim, fract);
-        boxDestroy(&box);
+        boxa4 = partelGenerateSubboxes(partel, geom, maxperim, fract);
         nsub = boxaGetCount(boxa4);
         for (i = 0; i < nsub; i++) {
             boxsub = boxaGetBox(boxa4, i, L_CLONE);
-            boxasub = boxaIntersectsBox(boxa, boxsub);
-            partel = partelCreate(boxsub);
-            partel->boxa = boxasub;
-            partelSetSize(partel, sortflag);
-            lheapAdd(lh, partel);
+            partelsub = partelCreate(boxsub);
+            partelSetSubset(partelsub, partel, geom, buf);
+            partelSetSize(partelsub, sortflag);
+            lheapAdd(lh, partelsub);
             boxDestroy(&boxsub);
         }
         npush += nsub;  /* How many boxes have we put on the queue? */
@@ -281,7 +297,7 @@ L_HEAP  *lh;
 /*        boxaWriteStream(stderr, boxa4); */
 
         boxaDestroy(&boxa4);
-        boxaDestroy(&boxa);
+        partelDestroy(&partel);
     }
 
 #if  OUTPUT_HEAP_STATS
@@ -295,6 +311,8 @@ L_HEAP  *lh;
     while ((partel = (PARTEL *)lheapRemove(lh)) != NULL)
         partelDestroy(&partel);
     lheapDestroy(&lh, FALSE);
+    LEPT_FREE(geom);
+    LEPT_FREE(buf);
 
     return boxad;
 }
@@ -346,7 +364,7 @@ PARTEL  *partel;
         return;
 
     boxDestroy(&partel->box);
-    boxaDestroy(&partel->boxa);
+    LEPT_FREE(partel->index);
     LEPT_FREE(partel);
     *ppartel = NULL;
     return;
@@ -393,10 +411,67 @@ l_int32  w, h;
 
 
 /*!
- * \brief   boxaGenerateSubboxes()
+ * \brief   partelSetSubset()
+ *
+ * \param[in]    partel whose index list is to be set
+ * \param[in]    parent partel whose region contains that of partel
+ * \param[in]    geom array of (x, y, w, h) for every box
+ * \param[in]    buf scratch array, at least as large as the parent list
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Every box intersecting the region of partel also intersects
+ *          the region of its parent, so only the parent list is scanned.
+ *          The order of the parent list is preserved.
+ *      (2) The intersection test is the same as in boxIntersects().
+ * </pre>
+ */
+static l_int32
+partelSetSubset(PARTEL         *partel,
+                PARTEL         *parent,
+                const l_int32  *geom,
+                l_int32        *buf)
+{
+l_int32         i, j, n, l1, t1, r1, b1, l2, t2, r2, b2;
+const l_int32  *g;
+
+    PROCNAME("partelSetSubset");
+
+    if (!partel || !parent)
+        return ERROR_INT("partel and parent not both defined", procName, 1);
+    if (!geom || !buf)
+        return ERROR_INT("geom and buf not both defined", procName, 1);
+
+    boxGetGeometry(partel->box, &l1, &t1, &r1, &b1);
+    r1 = l1 + r1 - 1;
+    b1 = t1 + b1 - 1;
+    for (i = 0, n = 0; i < parent->n; i++) {
+        j = parent->index[i];
+        g = geom + 4 * j;
+        l2 = g[0];
+        t2 = g[1];
+        r2 = l2 + g[2] - 1;
+        b2 = t2 + g[3] - 1;
+        if (b2 < t1 || b1 < t2 || r1 < l2 || r2 < l1)
+            continue;
+        buf[n++] = j;
+    }
+
+    partel->index = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    if (n > 0)
+        memcpy(partel->index, buf, n * sizeof(l_int32));
+    partel->n = n;
+    return 0;
+}
+
+
+/*!
+ * \brief   partelGenerateSubboxes()
  *
- * \param[in]    box region to be split into up to four overlapping subregions
- * \param[in]    boxa boxes of rectangles intersecting the box
+ * \param[in]    partel region to be split into up to four overlapping
+ *                      subregions, with the boxes that intersect it
+ * \param[in]    geom array of (x, y, w, h) for every box
  * \param[in]    maxperim maximum half-perimeter for which pivot
  *                        is selected by proximity to box centroid
  * \param[in]    fract fraction of box diagonal that is an acceptable
@@ -405,28 +480,32 @@ l_int32  w, h;
  *              or NULL on error
  */
 static BOXA *
-boxaGenerateSubboxes(BOX       *box,
-                     BOXA      *boxa,
-                     l_int32    maxperim,
-                     l_float32  fract)
+partelGenerateSubboxes(PARTEL         *partel,
+                       const l_int32  *geom,
+                       l_int32         maxperim,
+                       l_float32       fract)
 {
-l_int32  x, y, w, h, xp, yp, wp, hp;
-BOX     *boxp;  /* pivot box */
-BOX     *boxsub;
-BOXA    *boxa4;
+l_int32         x, y, w, h, xp, yp, wp, hp, pivot;
+const l_int32  *g;
+BOX            *boxsub;
+BOXA           *boxa4;
 
-    PROCNAME("boxaGenerateSubboxes");
+    PROCNAME("partelGenerateSubboxes");
 
-    if (!box)
-        return (BOXA *)ERROR_PTR("box not defined", procName, NULL);
-    if (!boxa)
-        return (BOXA *)ERROR_PTR("boxa not defined", procName, NULL);
+    if (!partel)
+        return (BOXA *)ERROR_PTR("partel not defined", procName, NULL);
+    if (!geom)
+        return (BOXA *)ERROR_PTR("geom not defined", procName, NULL);
+    if ((pivot = partelSelectPivot(partel, geom, maxperim, fract)) < 0)
+        return (BOXA *)ERROR_PTR("pivot not found", procName, NULL);
 
     boxa4 = boxaCreate(4);
-    boxp = boxaSelectPivotBox(box, boxa, maxperim, fract);
-    boxGetGeometry(box, &x, &y, &w, &h);
-    boxGetGeometry(boxp, &xp, &yp, &wp, &hp);
-    boxDestroy(&boxp);
+    boxGetGeometry(partel->box, &x, &y, &w, &h);
+    g = geom + 4 * pivot;
+    xp = g[0];
+    yp = g[1];
+    wp = g[2];
+    hp = g[3];
     if (xp > x) {   /* left sub-box */
         boxsub = boxCreate(x, y, xp - x, h);
         boxaAddBox(boxa4, boxsub, L_INSERT);
@@ -449,25 +528,26 @@ BOXA    *boxa4;
 
 
 /*!
- * \brief   boxaSelectPivotBox()
+ * \brief   partelSelectPivot()
  *
- * \param[in]    box containing box; to be split by the pivot box
- * \param[in]    boxa boxes of rectangles, from which 1 is to be chosen
+ * \param[in]    partel containing box, to be split by the pivot box,
+ *                      with the boxes from which 1 is to be chosen
+ * \param[in]    geom array of (x, y, w, h) for every box
  * \param[in]    maxperim maximum half-perimeter for which pivot
  *                        is selected by proximity to box centroid
  * \param[in]    fract fraction of box diagonal that is an acceptable
  *                     distance from the box centroid to select the pivot
- * \return  box pivot box for subdivision into 4 rectangles, or
- *                   NULL on error
+ * \return  index of pivot box for subdivision into 4 rectangles,
+ *          or -1 on error
  *
  * <pre>
  * Notes:
  *      (1) This is a tricky piece that wasn't discussed in the
  *          Breuel's 2002 paper.
- *      (2) Selects a box from boxa whose centroid is reasonably close to
- *          the centroid of the containing box (xc, yc) and whose
+ *      (2) Selects a box from the partel whose centroid is reasonably
+ *          close to the centroid of the containing box (xc, yc) and whose
  *          half-perimeter does not exceed the maxperim value.
- *      (3) If there are no boxes in the boxa that are small enough,
+ *      (3) If there are no boxes in the partel that are small enough,
  *          then it selects the smallest of the larger boxes,
  *          without reference to its location in the containing box.
  *      (4) If a small box has a centroid at a distance from the
@@ -482,52 +562,53 @@ BOXA    *boxa4;
  *          that could be inside of it.
  * </pre>
  */
-static BOX *
-boxaSelectPivotBox(BOX       *box,
-                   BOXA      *boxa,
-                   l_int32    maxperim,
-                   l_float32  fract)
+static l_int32
+partelSelectPivot(PARTEL         *partel,
+                  const l_int32  *geom,
+                  l_int32         maxperim,
+                  l_float32       fract)
 {
-l_int32    i, n, bw, bh, w, h;
-l_int32    smallfound, minindex, perim, minsize;
-l_float32  delx, dely, mindist, threshdist, dist, x, y, cx, cy;
-BOX       *boxt;
+l_int32         i, j, bw, bh, w, h;
+l_int32         smallfound, minindex, perim, minsize;
+l_float32       delx, dely, mindist, threshdist, dist, x, y, cx, cy;
+const l_int32  *g;
 
-    PROCNAME("boxaSelectPivotBox");
+    PROCNAME("partelSelectPivot");
 
-    if (!box)
-        return (BOX *)ERROR_PTR("box not defined", procName, NULL);
-    if (!boxa)
-        return (BOX *)ERROR_PTR("boxa not defined", procName, NULL);
-    n = boxaGetCount(boxa);
-    if (n == 0)
-        return (BOX *)ERROR_PTR("no boxes in boxa", procName, NULL);
+    if (!partel)
+        return ERROR_INT("partel not defined", procName, -1);
+    if (!geom)
+        return ERROR_INT("geom not defined", procName, -1);
+    if (partel->n == 0)
+        return ERROR_INT("no boxes in partel", procName, -1);
     if (fract < 0.0 || fract > 1.0) {
         L_WARNING("fract out of bounds; using 0.0\n", procName);
         fract = 0.0;
     }
 
-    boxGetGeometry(box, NULL, NULL, &w, &h);
-    boxGetCenter(box, &x, &y);
+    boxGetGeometry(partel->box, NULL, NULL, &w, &h);
+    boxGetCenter(partel->box, &x, &y);
     threshdist = fract * (w * w + h * h);
     mindist = 1000000000.;
-    minindex = 0;
+    minindex = partel->index[0];
     smallfound = FALSE;
-    for (i = 0; i < n; i++) {
-        boxt = boxaGetBox(boxa, i, L_CLONE);
-        boxGetGeometry(boxt, NULL, NULL, &bw, &bh);
-        boxGetCenter(boxt, &cx, &cy);
-        boxDestroy(&boxt);
+    for (i = 0; i < partel->n; i++) {
+        j = partel->index[i];
+        g = geom + 4 * j;
+        bw = g[2];
+        bh = g[3];
         if (bw + bh > maxperim)
             continue;
         smallfound = TRUE;
+        cx = (l_float32)(g[0] + 0.5 * bw);  /* as in boxGetCenter() */
+        cy = (l_float32)(g[1] + 0.5 * bh);
         delx = cx - x;
         dely = cy - y;
         dist = delx * delx + dely * dely;
         if (dist <= threshdist)
-            return boxaGetBox(boxa, i, L_COPY);
+            return j;
         if (dist < mindist) {
-            minindex = i;
+            minindex = j;
             mindist = dist;
         }
     }
@@ -535,20 +616,20 @@ BOX       *boxt;
         /* If there are small boxes but none are within 'fract' of the
          * centroid, return the nearest one. */
     if (smallfound == TRUE)
-        return boxaGetBox(boxa, minindex, L_COPY);
+        return minindex;
 
         /* No small boxes; return the smallest of the large boxes */
     minsize = 1000000000;
-    minindex = 0;
-    for (i = 0; i < n; i++) {
-        boxaGetBoxGeometry(boxa, i, NULL, NULL, &bw, &bh);
-        perim = bw + bh;
+    minindex = partel->index[0];
+    for (i = 0; i < partel->n; i++) {
+        j = partel->index[i];
+        perim = geom[4 * j + 2] + geom[4 * j + 3];
         if (perim < minsize) {
             minsize = perim;
-            minindex = i;
+            minindex = j;
         }
     }
-    return boxaGetBox(boxa, minindex, L_COPY);
+    return minindex;
 }
 
 
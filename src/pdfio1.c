@@ -93,17 +93,21 @@
  *          l_int32             convertFilesToPdf()
  *          l_int32             saConvertFilesToPdf()
  *          l_int32             saConvertFilesToPdfData()
+ *          static l_int32      saConvertFilesToPdfStream()
  *          l_int32             selectDefaultPdfEncoding()
  *
  *     2. Convert specified image files to pdf without scaling
  *          l_int32             convertUnscaledFilesToPdf()
  *          l_int32             saConvertUnscaledFilesToPdf()
  *          l_int32             saConvertUnscaledFilesToPdfData()
+ *          static l_int32      saConvertUnscaledFilesToPdfStream()
  *          l_int32             convertUnscaledToPdfData()
  *
  *     3. Convert multiple images to pdf (one image per page)
  *          l_int32             pixaConvertToPdf()
  *          l_int32             pixaConvertToPdfData()
+ *          static l_int32      pixaConvertToPdfStream()
+ *          static l_int32      pixWritePdfPage()
  *
  *     4. Single page, multi-image converters
  *          l_int32             convertToPdf()
@@ -130,6 +134,7 @@
  *          l_int32             ptraConcatenatePdf()
  *          l_int32             concatenatePdfToData()
  *          l_int32             saConcatenatePdfToData()
+ *          static l_int32      saConcatenatePdfStream()
  *
  *     The top-level multi-image functions can be visualized as follows:
  *          Output pdf data to file:
@@ -187,6 +192,10 @@
  * </pre>
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif  /* HAVE_CONFIG_H */
+
 #include <string.h>
 #include <math.h>
 #include "allheaders.h"
@@ -198,6 +207,24 @@
     /* Typical scan resolution in ppi (pixels/inch) */
 static const l_int32  DEFAULT_INPUT_RES = 300;
 
+    /* Static helpers for streaming multipage output */
+static l_int32 saConvertFilesToPdfStream(SARRAY *sa, l_int32 res,
+                                         l_float32 scalefactor, l_int32 type,
+                                         l_int32 quality, const char *title,
+                                         FILE *fp, const char *fileout);
+static l_int32 saConvertUnscaledFilesToPdfStream(SARRAY *sa,
+                                                 const char *title, FILE *fp,
+                                                 const char *fileout);
+static l_int32 pixaConvertToPdfStream(PIXA *pixa, l_int32 res,
+                                      l_float32 scalefactor, l_int32 type,
+                                      l_int32 quality, const char *title,
+                                      FILE *fp, const char *fileout);
+static l_int32 saConcatenatePdfStream(SARRAY *sa, FILE *fp,
+                                      const char *fileout);
+static l_int32 pixWritePdfPage(L_PDF_WRITER *pw, PIX *pixs, l_int32 res,
+                               l_float32 scalefactor, l_int32 type,
+                               l_int32 quality, const char *title);
+
 
 /*---------------------------------------------------------------------*
  *    Convert specified image files to pdf (one image file per page)   *
@@ -290,27 +317,17 @@ saConvertFilesToPdf(SARRAY      *sa,
                     const char  *title,
                     const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
-
     PROCNAME("saConvertFilesToPdf");
 
     if (!sa)
         return ERROR_INT("sa not defined", procName, 1);
+    if (!fileout)
+        return ERROR_INT("fileout not defined", procName, 1);
 
-    ret = saConvertFilesToPdfData(sa, res, scalefactor, type, quality,
-                                  title, &data, &nbytes);
-    if (ret) {
-        if (data) LEPT_FREE(data);
-        return ERROR_INT("pdf data not made", procName, 1);
-    }
-
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    if (ret)
-        L_ERROR("pdf data not written to file\n", procName);
-    return ret;
+    if (saConvertFilesToPdfStream(sa, res, scalefactor, type, quality,
+                                  title, NULL, fileout))
+        return ERROR_INT("pdf data not written to file", procName, 1);
+    return 0;
 }
 
 
@@ -344,14 +361,8 @@ saConvertFilesToPdfData(SARRAY      *sa,
                         l_uint8    **pdata,
                         size_t      *pnbytes)
 {
-char        *fname;
-const char  *pdftitle;
-l_uint8     *imdata;
-l_int32      i, n, ret, pagetype, npages, scaledres;
-size_t       imbytes;
-L_BYTEA     *ba;
-PIX         *pixs, *pix;
-L_PTRA      *pa_data;
+l_int32  ret;
+FILE    *fp;
 
     PROCNAME("saConvertFilesToPdfData");
 
@@ -363,6 +374,80 @@ L_PTRA      *pa_data;
     *pnbytes = 0;
     if (!sa)
         return ERROR_INT("sa not defined", procName, 1);
+
+#if HAVE_FMEMOPEN
+    if ((fp = open_memstream((char **)pdata, pnbytes)) == NULL)
+        return ERROR_INT("stream not opened", procName, 1);
+    ret = saConvertFilesToPdfStream(sa, res, scalefactor, type, quality,
+                                    title, fp, NULL);
+#else
+    L_INFO("work-around: writing to a temp file\n", procName);
+  #ifdef _WIN32
+    if ((fp = fopenWriteWinTempfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #else
+    if ((fp = tmpfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #endif  /* _WIN32 */
+    ret = saConvertFilesToPdfStream(sa, res, scalefactor, type, quality,
+                                    title, fp, NULL);
+    rewind(fp);
+    *pdata = l_binaryReadStream(fp, pnbytes);
+#endif  /* HAVE_FMEMOPEN */
+    fclose(fp);
+    if (ret) {
+        LEPT_FREE(*pdata);
+        *pdata = NULL;
+        *pnbytes = 0;
+        return ERROR_INT("pdf data not made", procName, 1);
+    }
+    return 0;
+}
+
+
+/*!
+ * \brief   saConvertFilesToPdfStream()
+ *
+ * \param[in]    sa string array of pathnames for images
+ * \param[in]    res input resolution of all images
+ * \param[in]    scalefactor scaling factor applied to each image; > 0.0
+ * \param[in]    type encoding type (L_JPEG_ENCODE, L_G4_ENCODE,
+ *                    L_FLATE_ENCODE, or 0 for default
+ * \param[in]    quality used for JPEG only; 0 for default (75)
+ * \param[in]    title [optional] pdf title; if null, taken from the first
+ *                     image filename
+ * \param[in]    fp [optional] output stream for the pdf
+ * \param[in]    fileout [optional] output file for the pdf
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each image is read, encoded and written as a page before
+ *          the next one is read, so only one page of image and
+ *          compressed data is in memory at a time.
+ *      (2) Exactly one of %fp and %fileout is given.  See
+ *          pdfwriterCreate(); %fileout is not made if no image
+ *          can be converted.
+ * </pre>
+ */
+static l_int32
+saConvertFilesToPdfStream(SARRAY      *sa,
+                          l_int32      res,
+                          l_float32    scalefactor,
+                          l_int32      type,
+                          l_int32      quality,
+                          const char  *title,
+                          FILE        *fp,
+                          const char  *fileout)
+{
+char          *fname;
+const char    *pdftitle;
+l_int32        i, n;
+PIX           *pixs;
+L_PDF_WRITER  *pw;
+
+    PROCNAME("saConvertFilesToPdfStream");
+
     if (scalefactor <= 0.0) scalefactor = 1.0;
     if (type < 0 || type > L_FLATE_ENCODE) {
         L_WARNING("invalid compression type; using per-page default\n",
@@ -370,9 +455,9 @@ L_PTRA      *pa_data;
         type = 0;
     }
 
-        /* Generate all the encoded pdf strings */
     n = sarrayGetCount(sa);
-    pa_data = ptraCreate(n);
+    if ((pw = pdfwriterCreate(fp, fileout)) == NULL)
+        return ERROR_INT("pw not made", procName, 1);
     pdftitle = NULL;
     for (i = 0; i < n; i++) {
         if (i && (i % 10 == 0)) fprintf(stderr, ".. %d ", i);
@@ -383,51 +468,14 @@ L_PTRA      *pa_data;
         }
         if (!pdftitle)
             pdftitle = (title) ? title : fname;
-        if (scalefactor != 1.0)
-            pix = pixScale(pixs, scalefactor, scalefactor);
-        else
-            pix = pixClone(pixs);
-        pixDestroy(&pixs);
-        scaledres = (l_int32)(res * scalefactor);
-        if (type != 0) {
-            pagetype = type;
-        } else if (selectDefaultPdfEncoding(pix, &pagetype) != 0) {
-            pixDestroy(&pix);
-            L_ERROR("encoding type selection failed for file %s\n",
-                    procName, fname);
-            continue;
-        }
-        ret = pixConvertToPdfData(pix, pagetype, quality, &imdata, &imbytes,
-                                  0, 0, scaledres, pdftitle, NULL, 0);
-        pixDestroy(&pix);
-        if (ret) {
-            LEPT_FREE(imdata);
+        if (pixWritePdfPage(pw, pixs, res, scalefactor, type, quality,
+                            pdftitle))
             L_ERROR("pdf encoding failed for %s\n", procName, fname);
-            continue;
-        }
-        ba = l_byteaInitFromMem(imdata, imbytes);
-        LEPT_FREE(imdata);
-        ptraAdd(pa_data, ba);
-    }
-    ptraGetActualCount(pa_data, &npages);
-    if (npages == 0) {
-        L_ERROR("no pdf files made\n", procName);
-        ptraDestroy(&pa_data, FALSE, FALSE);
-        return 1;
+        pixDestroy(&pixs);
     }
+    if (n >= 10) fprintf(stderr, "\n");
 
-        /* Concatenate them */
-    fprintf(stderr, "\nconcatenating ... ");
-    ret = ptraConcatenatePdfToData(pa_data, NULL, pdata, pnbytes);
-    fprintf(stderr, "done\n");
-
-    ptraGetActualCount(pa_data, &npages);  /* recalculate in case it changes */
-    for (i = 0; i < npages; i++) {
-        ba = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
-        l_byteaDestroy(&ba);
-    }
-    ptraDestroy(&pa_data, FALSE, FALSE);
-    return ret;
+    return pdfwriterFinish(&pw);
 }
 
 
@@ -556,26 +604,16 @@ saConvertUnscaledFilesToPdf(SARRAY      *sa,
                             const char  *title,
                             const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
-
     PROCNAME("saConvertUnscaledFilesToPdf");
 
     if (!sa)
         return ERROR_INT("sa not defined", procName, 1);
+    if (!fileout)
+        return ERROR_INT("fileout not defined", procName, 1);
 
-    ret = saConvertUnscaledFilesToPdfData(sa, title, &data, &nbytes);
-    if (ret) {
-        if (data) LEPT_FREE(data);
-        return ERROR_INT("pdf data not made", procName, 1);
-    }
-
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    if (ret)
-        L_ERROR("pdf data not written to file\n", procName);
-    return ret;
+    if (saConvertUnscaledFilesToPdfStream(sa, title, NULL, fileout))
+        return ERROR_INT("pdf data not written to file", procName, 1);
+    return 0;
 }
 
 
@@ -595,12 +633,8 @@ saConvertUnscaledFilesToPdfData(SARRAY      *sa,
                                 l_uint8    **pdata,
                                 size_t      *pnbytes)
 {
-char         *fname;
-l_uint8      *imdata;
-l_int32       i, n, ret, npages;
-size_t        imbytes;
-L_BYTEA      *ba;
-L_PTRA       *pa_data;
+l_int32  ret;
+FILE    *fp;
 
     PROCNAME("saConvertUnscaledFilesToPdfData");
 
@@ -613,42 +647,80 @@ L_PTRA       *pa_data;
     if (!sa)
         return ERROR_INT("sa not defined", procName, 1);
 
-        /* Generate all the encoded pdf strings */
+#if HAVE_FMEMOPEN
+    if ((fp = open_memstream((char **)pdata, pnbytes)) == NULL)
+        return ERROR_INT("stream not opened", procName, 1);
+    ret = saConvertUnscaledFilesToPdfStream(sa, title, fp, NULL);
+#else
+    L_INFO("work-around: writing to a temp file\n", procName);
+  #ifdef _WIN32
+    if ((fp = fopenWriteWinTempfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #else
+    if ((fp = tmpfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #endif  /* _WIN32 */
+    ret = saConvertUnscaledFilesToPdfStream(sa, title, fp, NULL);
+    rewind(fp);
+    *pdata = l_binaryReadStream(fp, pnbytes);
+#endif  /* HAVE_FMEMOPEN */
+    fclose(fp);
+    if (ret) {
+        LEPT_FREE(*pdata);
+        *pdata = NULL;
+        *pnbytes = 0;
+        return ERROR_INT("pdf data not made", procName, 1);
+    }
+    return 0;
+}
+
+
+/*!
+ * \brief   saConvertUnscaledFilesToPdfStream()
+ *
+ * \param[in]    sa string array of pathnames for images
+ * \param[in]    title [optional] pdf title; if null, taken from the first
+ *                     image filename
+ * \param[in]    fp [optional] output stream for the pdf
+ * \param[in]    fileout [optional] output file for the pdf
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each page is written as soon as it is generated.
+ *      (2) Exactly one of %fp and %fileout is given; see
+ *          saConvertFilesToPdfStream().
+ * </pre>
+ */
+static l_int32
+saConvertUnscaledFilesToPdfStream(SARRAY      *sa,
+                                  const char  *title,
+                                  FILE        *fp,
+                                  const char  *fileout)
+{
+char          *fname;
+l_uint8       *imdata;
+l_int32        i, n;
+size_t         imbytes;
+L_PDF_WRITER  *pw;
+
+    PROCNAME("saConvertUnscaledFilesToPdfStream");
+
     n = sarrayGetCount(sa);
-    pa_data = ptraCreate(n);
+    if ((pw = pdfwriterCreate(fp, fileout)) == NULL)
+        return ERROR_INT("pw not made", procName, 1);
     for (i = 0; i < n; i++) {
         if (i && (i % 10 == 0)) fprintf(stderr, ".. %d ", i);
         fname = sarrayGetString(sa, i, L_NOCOPY);
-
-            /* Generate the pdf data */
         if (convertUnscaledToPdfData(fname, title, &imdata, &imbytes))
             continue;
-
-            /* ... and add it to the array of single page data */
-        ba = l_byteaInitFromMem(imdata, imbytes);
-        if (imdata) LEPT_FREE(imdata);
-        ptraAdd(pa_data, ba);
-    }
-    ptraGetActualCount(pa_data, &npages);
-    if (npages == 0) {
-        L_ERROR("no pdf files made\n", procName);
-        ptraDestroy(&pa_data, FALSE, FALSE);
-        return 1;
+        if (pdfwriterAddPage(pw, imdata, imbytes))
+            L_ERROR("page not added for %s\n", procName, fname);
+        LEPT_FREE(imdata);
     }
+    if (n >= 10) fprintf(stderr, "\n");
 
-        /* Concatenate to generate a multipage pdf */
-    fprintf(stderr, "\nconcatenating ... ");
-    ret = ptraConcatenatePdfToData(pa_data, NULL, pdata, pnbytes);
-    fprintf(stderr, "done\n");
-
-        /* Clean up */
-    ptraGetActualCount(pa_data, &npages);  /* maybe failed to read some files */
-    for (i = 0; i < npages; i++) {
-        ba = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
-        l_byteaDestroy(&ba);
-    }
-    ptraDestroy(&pa_data, FALSE, FALSE);
-    return ret;
+    return pdfwriterFinish(&pw);
 }
 
 
@@ -754,27 +826,17 @@ pixaConvertToPdf(PIXA        *pixa,
                  const char  *title,
                  const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
-
     PROCNAME("pixaConvertToPdf");
 
     if (!pixa)
         return ERROR_INT("pixa not defined", procName, 1);
+    if (!fileout)
+        return ERROR_INT("fileout not defined", procName, 1);
 
-    ret = pixaConvertToPdfData(pixa, res, scalefactor, type, quality,
-                               title, &data, &nbytes);
-    if (ret) {
-        LEPT_FREE(data);
+    if (pixaConvertToPdfStream(pixa, res, scalefactor, type, quality,
+                               title, NULL, fileout))
         return ERROR_INT("conversion to pdf failed", procName, 1);
-    }
-
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    if (ret)
-        L_ERROR("pdf data not written to file\n", procName);
-    return ret;
+    return 0;
 }
 
 
@@ -807,12 +869,8 @@ pixaConvertToPdfData(PIXA        *pixa,
                      l_uint8    **pdata,
                      size_t      *pnbytes)
 {
-l_uint8  *imdata;
-l_int32   i, n, ret, scaledres, pagetype;
-size_t    imbytes;
-L_BYTEA  *ba;
-PIX      *pixs, *pix;
-L_PTRA   *pa_data;
+l_int32  ret;
+FILE    *fp;
 
     PROCNAME("pixaConvertToPdfData");
 
@@ -824,6 +882,74 @@ L_PTRA   *pa_data;
     *pnbytes = 0;
     if (!pixa)
         return ERROR_INT("pixa not defined", procName, 1);
+
+#if HAVE_FMEMOPEN
+    if ((fp = open_memstream((char **)pdata, pnbytes)) == NULL)
+        return ERROR_INT("stream not opened", procName, 1);
+    ret = pixaConvertToPdfStream(pixa, res, scalefactor, type, quality,
+                                 title, fp, NULL);
+#else
+    L_INFO("work-around: writing to a temp file\n", procName);
+  #ifdef _WIN32
+    if ((fp = fopenWriteWinTempfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #else
+    if ((fp = tmpfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #endif  /* _WIN32 */
+    ret = pixaConvertToPdfStream(pixa, res, scalefactor, type, quality,
+                                 title, fp, NULL);
+    rewind(fp);
+    *pdata = l_binaryReadStream(fp, pnbytes);
+#endif  /* HAVE_FMEMOPEN */
+    fclose(fp);
+    if (ret) {
+        LEPT_FREE(*pdata);
+        *pdata = NULL;
+        *pnbytes = 0;
+        return ERROR_INT("pdf data not made", procName, 1);
+    }
+    return 0;
+}
+
+
+/*!
+ * \brief   pixaConvertToPdfStream()
+ *
+ * \param[in]    pixa containing images all at the same resolution
+ * \param[in]    res input resolution of all images
+ * \param[in]    scalefactor scaling factor applied to each image; > 0.0
+ * \param[in]    type encoding type (L_JPEG_ENCODE, L_G4_ENCODE,
+ *                    L_FLATE_ENCODE, or 0 for default
+ * \param[in]    quality used for JPEG only; 0 for default (75)
+ * \param[in]    title [optional] pdf title
+ * \param[in]    fp [optional] output stream for the pdf
+ * \param[in]    fileout [optional] output file for the pdf
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each page is written as soon as it is encoded.
+ *      (2) Exactly one of %fp and %fileout is given; see
+ *          saConvertFilesToPdfStream().
+ * </pre>
+ */
+static l_int32
+pixaConvertToPdfStream(PIXA        *pixa,
+                       l_int32      res,
+                       l_float32    scalefactor,
+                       l_int32      type,
+                       l_int32      quality,
+                       const char  *title,
+                       FILE        *fp,
+                       const char  *fileout)
+{
+l_int32        i, n;
+PIX           *pixs;
+L_PDF_WRITER  *pw;
+
+    PROCNAME("pixaConvertToPdfStream");
+
     if (scalefactor <= 0.0) scalefactor = 1.0;
     if (type < 0 || type > L_FLATE_ENCODE) {
         L_WARNING("invalid compression type; using per-page default\n",
@@ -831,56 +957,68 @@ L_PTRA   *pa_data;
         type = 0;
     }
 
-        /* Generate all the encoded pdf strings */
     n = pixaGetCount(pixa);
-    pa_data = ptraCreate(n);
+    if ((pw = pdfwriterCreate(fp, fileout)) == NULL)
+        return ERROR_INT("pw not made", procName, 1);
     for (i = 0; i < n; i++) {
         if ((pixs = pixaGetPix(pixa, i, L_CLONE)) == NULL) {
             L_ERROR("pix[%d] not retrieved\n", procName, i);
             continue;
         }
-        if (scalefactor != 1.0)
-            pix = pixScale(pixs, scalefactor, scalefactor);
-        else
-            pix = pixClone(pixs);
-        pixDestroy(&pixs);
-        scaledres = (l_int32)(res * scalefactor);
-        if (type != 0) {
-            pagetype = type;
-        } else if (selectDefaultPdfEncoding(pix, &pagetype) != 0) {
-            L_ERROR("encoding type selection failed for pix[%d]\n",
-                        procName, i);
-            pixDestroy(&pix);
-            continue;
-        }
-        ret = pixConvertToPdfData(pix, pagetype, quality, &imdata, &imbytes,
-                                  0, 0, scaledres, title, NULL, 0);
-        pixDestroy(&pix);
-        if (ret) {
-            LEPT_FREE(imdata);
+        if (pixWritePdfPage(pw, pixs, res, scalefactor, type, quality, title))
             L_ERROR("pdf encoding failed for pix[%d]\n", procName, i);
-            continue;
-        }
-        ba = l_byteaInitFromMem(imdata, imbytes);
-        LEPT_FREE(imdata);
-        ptraAdd(pa_data, ba);
-    }
-    ptraGetActualCount(pa_data, &n);
-    if (n == 0) {
-        L_ERROR("no pdf files made\n", procName);
-        ptraDestroy(&pa_data, FALSE, FALSE);
-        return 1;
+        pixDestroy(&pixs);
     }
 
-        /* Concatenate them */
-    ret = ptraConcatenatePdfToData(pa_data, NULL, pdata, pnbytes);
+    return pdfwriterFinish(&pw);
+}
 
-    ptraGetActualCount(pa_data, &n);  /* recalculate in case it changes */
-    for (i = 0; i < n; i++) {
-        ba = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
-        l_byteaDestroy(&ba);
+
+/*!
+ * \brief   pixWritePdfPage()
+ *
+ * \param[in]    pw pdf writer
+ * \param[in]    pixs image for the page
+ * \param[in]    res input resolution of the image
+ * \param[in]    scalefactor scaling factor applied to the image; > 0.0
+ * \param[in]    type encoding type, or 0 for default
+ * \param[in]    quality used for JPEG only; 0 for default (75)
+ * \param[in]    title [optional] pdf title
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+pixWritePdfPage(L_PDF_WRITER  *pw,
+                PIX           *pixs,
+                l_int32        res,
+                l_float32      scalefactor,
+                l_int32        type,
+                l_int32        quality,
+                const char    *title)
+{
+l_uint8  *imdata;
+l_int32   ret, scaledres, pagetype;
+size_t    imbytes;
+PIX      *pix;
+
+    PROCNAME("pixWritePdfPage");
+
+    if (scalefactor != 1.0)
+        pix = pixScale(pixs, scalefactor, scalefactor);
+    else
+        pix = pixClone(pixs);
+    scaledres = (l_int32)(res * scalefactor);
+    if (type != 0) {
+        pagetype = type;
+    } else if (selectDefaultPdfEncoding(pix, &pagetype) != 0) {
+        pixDestroy(&pix);
+        return ERROR_INT("encoding type selection failed", procName, 1);
     }
-    ptraDestroy(&pa_data, FALSE, FALSE);
+    ret = pixConvertToPdfData(pix, pagetype, quality, &imdata, &imbytes,
+                              0, 0, scaledres, title, NULL, 0);
+    pixDestroy(&pix);
+    if (!ret)
+        ret = pdfwriterAddPage(pw, imdata, imbytes);
+    LEPT_FREE(imdata);
     return ret;
 }
 
@@ -1420,14 +1558,13 @@ convertSegmentedFilesToPdf(const char  *dirname,
                            const char  *title,
                            const char  *fileout)
 {
-char     *fname;
-l_uint8  *imdata, *data;
-l_int32   i, npages, nboxa, nboxes, ret;
-size_t    imbytes, databytes;
-BOXA     *boxa;
-L_BYTEA  *ba;
-L_PTRA   *pa_data;
-SARRAY   *sa;
+char          *fname;
+l_uint8       *imdata;
+l_int32        i, npages, nboxa, nboxes, ret;
+size_t         imbytes;
+BOXA          *boxa;
+L_PDF_WRITER  *pw;
+SARRAY        *sa;
 
     PROCNAME("convertSegmentedFilesToPdf");
 
@@ -1452,8 +1589,11 @@ SARRAY   *sa;
         }
     }
 
-        /* Generate and save all the encoded pdf strings */
-    pa_data = ptraCreate(npages);
+        /* Encode each page and write it out before making the next */
+    if ((pw = pdfwriterCreate(NULL, fileout)) == NULL) {
+        sarrayDestroy(&sa);
+        return ERROR_INT("pw not made", procName, 1);
+    }
     for (i = 0; i < npages; i++) {
         fname = sarrayGetString(sa, i, L_NOCOPY);
         if (!strcmp(fname, "")) continue;
@@ -1472,37 +1612,13 @@ SARRAY   *sa;
             L_ERROR("pdf encoding failed for %s\n", procName, fname);
             continue;
         }
-        ba = l_byteaInitFromMem(imdata, imbytes);
-        if (imdata) LEPT_FREE(imdata);
-        ptraAdd(pa_data, ba);
+        if (pdfwriterAddPage(pw, imdata, imbytes))
+            L_ERROR("pdf page not written for %s\n", procName, fname);
+        LEPT_FREE(imdata);
     }
     sarrayDestroy(&sa);
 
-    ptraGetActualCount(pa_data, &npages);
-    if (npages == 0) {
-        L_ERROR("no pdf files made\n", procName);
-        ptraDestroy(&pa_data, FALSE, FALSE);
-        return 1;
-    }
-
-        /* Concatenate */
-    ret = ptraConcatenatePdfToData(pa_data, NULL, &data, &databytes);
-
-        /* Clean up */
-    ptraGetActualCount(pa_data, &npages);  /* recalculate in case it changes */
-    for (i = 0; i < npages; i++) {
-        ba = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
-        l_byteaDestroy(&ba);
-    }
-    ptraDestroy(&pa_data, FALSE, FALSE);
-
-    if (ret) {
-        if (data) LEPT_FREE(data);
-        return ERROR_INT("pdf data not made", procName, 1);
-    }
-
-    ret = l_binaryWrite(fileout, "w", data, databytes);
-    LEPT_FREE(data);
+    ret = pdfwriterFinish(&pw);
     if (ret)
         L_ERROR("pdf data not written to file\n", procName);
     return ret;
@@ -2024,16 +2140,14 @@ SARRAY  *sa;
  * <pre>
  * Notes:
  *      (1) This only works with leptonica-formatted single-page pdf files.
+ *      (2) The files are read and written one at a time, so memory use
+ *          does not grow with the number of files.
  * </pre>
  */
 l_int32
 saConcatenatePdf(SARRAY      *sa,
                  const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
-
     PROCNAME("saConcatenatePdf");
 
     if (!sa)
@@ -2041,12 +2155,9 @@ size_t    nbytes;
     if (!fileout)
         return ERROR_INT("fileout not defined", procName, 1);
 
-    ret = saConcatenatePdfToData(sa, &data, &nbytes);
-    if (ret)
-        return ERROR_INT("pdf data not made", procName, 1);
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    return ret;
+    if (saConcatenatePdfStream(sa, NULL, fileout))
+        return ERROR_INT("pdf data not written to file", procName, 1);
+    return 0;
 }
 
 
@@ -2066,9 +2177,11 @@ l_int32
 ptraConcatenatePdf(L_PTRA      *pa,
                    const char  *fileout)
 {
-l_uint8  *data;
-l_int32   ret;
-size_t    nbytes;
+l_uint8       *pdfdata;
+l_int32        i, n;
+size_t         size;
+L_BYTEA       *bas;
+L_PDF_WRITER  *pw;
 
     PROCNAME("ptraConcatenatePdf");
 
@@ -2077,12 +2190,19 @@ size_t    nbytes;
     if (!fileout)
         return ERROR_INT("fileout not defined", procName, 1);
 
-    ret = ptraConcatenatePdfToData(pa, NULL, &data, &nbytes);
-    if (ret)
-        return ERROR_INT("pdf data not made", procName, 1);
-    ret = l_binaryWrite(fileout, "w", data, nbytes);
-    LEPT_FREE(data);
-    return ret;
+    if ((pw = pdfwriterCreate(NULL, fileout)) == NULL)
+        return ERROR_INT("pw not made", procName, 1);
+    ptraGetMaxIndex(pa, &n);
+    for (i = 0; i <= n; i++) {
+        if ((bas = (L_BYTEA *)ptraGetPtrToItem(pa, i)) == NULL)
+            continue;
+        pdfdata = l_byteaGetData(bas, &size);
+        if (pdfwriterAddPage(pw, pdfdata, size))
+            L_ERROR("can't parse file %d; skipping\n", procName, i);
+    }
+    if (pdfwriterFinish(&pw))
+        return ERROR_INT("pdf data not written to file", procName, 1);
+    return 0;
 }
 
 
@@ -2152,10 +2272,8 @@ saConcatenatePdfToData(SARRAY    *sa,
                        l_uint8  **pdata,
                        size_t    *pnbytes)
 {
-char     *fname;
-l_int32   i, npages, ret;
-L_BYTEA  *bas;
-L_PTRA   *pa_data;  /* input pdf data for each page */
+l_int32  ret;
+FILE    *fp;
 
     PROCNAME("saConcatenatePdfToData");
 
@@ -2168,26 +2286,79 @@ L_PTRA   *pa_data;  /* input pdf data for each page */
     if (!sa)
         return ERROR_INT("sa not defined", procName, 1);
 
-        /* Read the pdf files into memory */
-    if ((npages = sarrayGetCount(sa)) == 0)
-        return ERROR_INT("no filenames found", procName, 1);
-    pa_data = ptraCreate(npages);
-    for (i = 0; i < npages; i++) {
-        fname = sarrayGetString(sa, i, L_NOCOPY);
-        bas = l_byteaInitFromFile(fname);
-        ptraAdd(pa_data, bas);
+#if HAVE_FMEMOPEN
+    if ((fp = open_memstream((char **)pdata, pnbytes)) == NULL)
+        return ERROR_INT("stream not opened", procName, 1);
+    ret = saConcatenatePdfStream(sa, fp, NULL);
+#else
+    L_INFO("work-around: writing to a temp file\n", procName);
+  #ifdef _WIN32
+    if ((fp = fopenWriteWinTempfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #else
+    if ((fp = tmpfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #endif  /* _WIN32 */
+    ret = saConcatenatePdfStream(sa, fp, NULL);
+    rewind(fp);
+    *pdata = l_binaryReadStream(fp, pnbytes);
+#endif  /* HAVE_FMEMOPEN */
+    fclose(fp);
+    if (ret) {
+        LEPT_FREE(*pdata);
+        *pdata = NULL;
+        *pnbytes = 0;
+        return ERROR_INT("pdf data not made", procName, 1);
     }
+    return 0;
+}
 
-    ret = ptraConcatenatePdfToData(pa_data, sa, pdata, pnbytes);
 
-        /* Cleanup: some pages could have been removed */
-    ptraGetActualCount(pa_data, &npages);
-    for (i = 0; i < npages; i++) {
-        bas = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
-        l_byteaDestroy(&bas);
+/*!
+ * \brief   saConcatenatePdfStream()
+ *
+ * \param[in]    sa string array of pathnames for single-page pdf files
+ * \param[in]    fp [optional] output stream for the concatenated pdf
+ * \param[in]    fileout [optional] output file for the concatenated pdf
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each file is read, renumbered and written before the next
+ *          one is read.  Files that cannot be parsed are skipped.
+ *      (2) Exactly one of %fp and %fileout is given; see
+ *          saConvertFilesToPdfStream().
+ * </pre>
+ */
+static l_int32
+saConcatenatePdfStream(SARRAY      *sa,
+                       FILE        *fp,
+                       const char  *fileout)
+{
+char          *fname;
+l_uint8       *pdfdata;
+l_int32        i, n;
+size_t         size;
+L_PDF_WRITER  *pw;
+
+    PROCNAME("saConcatenatePdfStream");
+
+    if ((n = sarrayGetCount(sa)) == 0)
+        return ERROR_INT("no filenames found", procName, 1);
+
+    if ((pw = pdfwriterCreate(fp, fileout)) == NULL)
+        return ERROR_INT("pw not made", procName, 1);
+    for (i = 0; i < n; i++) {
+        fname = sarrayGetString(sa, i, L_NOCOPY);
+        if ((pdfdata = l_binaryRead(fname, &size)) == NULL) {
+            L_ERROR("can't read file %s; skipping\n", procName, fname);
+            continue;
+        }
+        if (pdfwriterAddPage(pw, pdfdata, size))
+            L_ERROR("can't parse file %s; skipping\n", procName, fname);
+        LEPT_FREE(pdfdata);
     }
-    ptraDestroy(&pa_data, FALSE, FALSE);
-    return ret;
+    return pdfwriterFinish(&pw);
 }
 
 /* --------------------------------------------*/
@@ -36,6 +36,12 @@
  *     Intermediate function for generating multipage pdf output
  *          l_int32              ptraConcatenatePdfToData()
  *
+ *     Streaming multipage pdf output
+ *          L_PDF_WRITER        *pdfwriterCreate()
+ *          l_int32              pdfwriterAddPage()
+ *          l_int32              pdfwriterFinish()
+ *          static l_int32       pdfwriterWrite()
+ *
  *     Convert tiff multipage to pdf file
  *          l_int32              convertTiffMultipageToPdf()
  *
@@ -89,6 +95,10 @@
  * </pre>
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif  /* HAVE_CONFIG_H */
+
 #include <string.h>
 #include <math.h>
 #include "allheaders.h"
@@ -121,9 +131,14 @@ static char         *makeTrailerStringPdf(L_DNA *daloc);
 static l_int32       generateOutputDataPdf(l_uint8 **pdata, size_t *pnbytes,
                                        L_PDF_DATA *lpd);
 
-static l_int32       parseTrailerPdf(L_BYTEA *bas, L_DNA **pda);
+static l_int32       pdfwriterWrite(L_PDF_WRITER *pw, const l_uint8 *data,
+                                    size_t nbytes);
+static l_int32       parseTrailerPdf(const l_uint8 *data, size_t size,
+                                     L_DNA **pda);
 static char         *generatePagesObjStringPdf(NUMA *napage);
-static L_BYTEA      *substituteObjectNumbers(L_BYTEA *bas, NUMA *na_objs);
+static L_BYTEA      *substituteObjectNumbers(const l_uint8 *data, size_t size,
+                                             const l_int32 *objs,
+                                             l_int32 nobjs, size_t *pnhead);
 
 static L_PDF_DATA   *pdfdataCreate(const char *title);
 static void          pdfdataDestroy(L_PDF_DATA **plpd);
@@ -296,10 +311,12 @@ L_PDF_DATA   *lpd = NULL;
  *          in the local file:
  *              Page:  Parent(object 3), Contents, XObject(typically multiple)
  *              XObject:  [ColorSpace if indexed]
- *          The Pages object on the first page (object 3) has a Kids array
- *          of references to all the Page objects, with a Count equal
- *          to the number of pages.  Each Page object refers back to
- *          this parent.
+ *          The Pages object (object 3) has a Kids array of references
+ *          to all the Page objects, with a Count equal to the number
+ *          of pages.  Each Page object refers back to this parent.
+ *      (4) The pages are written one at a time with an L_PDF_WRITER,
+ *          which puts the Pages object after the last page.  Input
+ *          data that cannot be parsed is removed from %pa_data.
  * </pre>
  */
 l_int32
@@ -308,16 +325,13 @@ ptraConcatenatePdfToData(L_PTRA    *pa_data,
                          l_uint8  **pdata,
                          size_t    *pnbytes)
 {
-char     *fname, *str_pages, *str_trailer;
-l_uint8  *pdfdata, *data;
-l_int32   i, j, index, nobj, npages;
-l_int32  *sizes, *locs;
-size_t    size;
-L_BYTEA  *bas, *bad, *bat1, *bat2;
-L_DNA    *da_locs, *da_sizes, *da_outlocs, *da;
-L_DNAA   *daa_locs;  /* object locations on each page */
-NUMA     *na_objs, *napage;
-NUMAA    *naa_objs;  /* object mapping numbers to new values */
+char          *fname;
+l_uint8       *pdfdata;
+l_int32        i, npages, ret;
+size_t         size;
+FILE          *fp;
+L_BYTEA       *bas;
+L_PDF_WRITER  *pw;
 
     PROCNAME("ptraConcatenatePdfToData");
 
@@ -330,13 +344,34 @@ NUMAA    *naa_objs;  /* object mapping numbers to new values */
     if (!pa_data)
         return ERROR_INT("pa_data not defined", procName, 1);
 
-        /* Parse the files and find the object locations.
-         * Remove file data that cannot be parsed. */
+#if HAVE_FMEMOPEN
+    if ((fp = open_memstream((char **)pdata, pnbytes)) == NULL)
+        return ERROR_INT("stream not opened", procName, 1);
+#else
+    L_INFO("work-around: writing to a temp file\n", procName);
+  #ifdef _WIN32
+    if ((fp = fopenWriteWinTempfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #else
+    if ((fp = tmpfile()) == NULL)
+        return ERROR_INT("tmpfile stream not opened", procName, 1);
+  #endif  /* _WIN32 */
+#endif  /* HAVE_FMEMOPEN */
+
+        /* Write the pages in order.  Remove file data that
+         * cannot be parsed. */
+    if ((pw = pdfwriterCreate(fp, NULL)) == NULL) {
+        fclose(fp);
+        LEPT_FREE(*pdata);
+        *pdata = NULL;
+        *pnbytes = 0;
+        return ERROR_INT("pw not made", procName, 1);
+    }
     ptraGetActualCount(pa_data, &npages);
-    daa_locs = l_dnaaCreate(npages);
     for (i = 0; i < npages; i++) {
         bas = (L_BYTEA *)ptraGetPtrToItem(pa_data, i);
-        if (parseTrailerPdf(bas, &da_locs) != 0) {
+        pdfdata = l_byteaGetData(bas, &size);
+        if (pdfwriterAddPage(pw, pdfdata, size) != 0) {
             bas = (L_BYTEA *)ptraRemove(pa_data, i, L_NO_COMPACTION);
             l_byteaDestroy(&bas);
             if (sa) {
@@ -345,107 +380,273 @@ NUMAA    *naa_objs;  /* object mapping numbers to new values */
             } else {
                 L_ERROR("can't parse file %d; skipping\n", procName, i);
             }
-        } else {
-            l_dnaaAddDna(daa_locs, da_locs, L_INSERT);
         }
     }
-
-        /* Recompute npages in case some of the files were not pdf */
     ptraCompactArray(pa_data);
     ptraGetActualCount(pa_data, &npages);
-    if (npages == 0) {
-        l_dnaaDestroy(&daa_locs);
-        return ERROR_INT("no parsable pdf files found", procName, 1);
-    }
+    ret = pdfwriterFinish(&pw);
 
-        /* Find the mapping from initial to final object numbers */
-    naa_objs = numaaCreate(npages);  /* stores final object numbers */
-    napage = numaCreate(npages);  /* stores "Page" object numbers */
-    index = 0;
-    for (i = 0; i < npages; i++) {
-        da = l_dnaaGetDna(daa_locs, i, L_CLONE);
-        nobj = l_dnaGetCount(da);
-        if (i == 0) {
-            numaAddNumber(napage, 4);  /* object 4 on first page */
-            na_objs = numaMakeSequence(0.0, 1.0, nobj - 1);
-            index = nobj - 1;
-        } else {  /* skip the first 3 objects in each file */
-            numaAddNumber(napage, index);  /* Page object is first we add */
-            na_objs = numaMakeConstant(0.0, nobj - 1);
-            numaReplaceNumber(na_objs, 3, 3);  /* refers to parent of all */
-            for (j = 4; j < nobj - 1; j++)
-                numaSetValue(na_objs, j, index++);
-        }
-        numaaAddNuma(naa_objs, na_objs, L_INSERT);
-        l_dnaDestroy(&da);
+#if !HAVE_FMEMOPEN
+    rewind(fp);
+    *pdata = l_binaryReadStream(fp, pnbytes);
+#endif  /* !HAVE_FMEMOPEN */
+    fclose(fp);
+    if (npages == 0 || ret) {
+        LEPT_FREE(*pdata);
+        *pdata = NULL;
+        *pnbytes = 0;
+        if (npages == 0)
+            return ERROR_INT("no parsable pdf files found", procName, 1);
+        return ERROR_INT("pdf data not made", procName, 1);
     }
+    return 0;
+}
 
-        /* Make the Pages object (#3) */
-    str_pages = generatePagesObjStringPdf(napage);
 
-        /* Build the output */
-    bad = l_byteaCreate(5000);
-    da_outlocs = l_dnaCreate(0);  /* locations of all output objects */
-    for (i = 0; i < npages; i++) {
-        bas = (L_BYTEA *)ptraGetPtrToItem(pa_data, i);
-        pdfdata = l_byteaGetData(bas, &size);
-        da_locs = l_dnaaGetDna(daa_locs, i, L_CLONE);  /* locs on this page */
-        na_objs = numaaGetNuma(naa_objs, i, L_CLONE);  /* obj # on this page */
-        nobj = l_dnaGetCount(da_locs) - 1;
-        da_sizes = l_dnaDiffAdjValues(da_locs);  /* object sizes on this page */
-        sizes = l_dnaGetIArray(da_sizes);
-        locs = l_dnaGetIArray(da_locs);
-        if (i == 0) {
-            l_byteaAppendData(bad, pdfdata, sizes[0]);
-            l_byteaAppendData(bad, pdfdata + locs[1], sizes[1]);
-            l_byteaAppendData(bad, pdfdata + locs[2], sizes[2]);
-            l_byteaAppendString(bad, str_pages);
-            for (j = 0; j < 4; j++)
-                l_dnaAddNumber(da_outlocs, locs[j]);
-        }
-        for (j = 4; j < nobj; j++) {
-            l_dnaAddNumber(da_outlocs, l_byteaGetSize(bad));
-            bat1 = l_byteaInitFromMem(pdfdata + locs[j], sizes[j]);
-            bat2 = substituteObjectNumbers(bat1, na_objs);
-            data = l_byteaGetData(bat2, &size);
-            l_byteaAppendData(bad, data, size);
-            l_byteaDestroy(&bat1);
-            l_byteaDestroy(&bat2);
+/*---------------------------------------------------------------------*
+ *                  Streaming multipage pdf output                     *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   pdfwriterCreate()
+ *
+ * \param[in]    fp [optional] output stream, opened for binary writing
+ * \param[in]    fileout [optional] output file
+ * \return  pw, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The writer appends leptonica-formatted single-page pdf data
+ *          one page at a time, with pdfwriterAddPage(), and then
+ *          writes the Pages object and the trailer with pdfwriterFinish().
+ *          Only the object locations are kept in memory, so the output
+ *          can have any number of pages.
+ *      (2) Exactly one of %fp and %fileout must be given.  The caller
+ *          opens and closes %fp.  The file %fileout is opened when the
+ *          first page is added and is closed by pdfwriterFinish(), so
+ *          it is not made if no page can be added.
+ * </pre>
+ */
+L_PDF_WRITER *
+pdfwriterCreate(FILE        *fp,
+                const char  *fileout)
+{
+L_PDF_WRITER  *pw;
+
+    PROCNAME("pdfwriterCreate");
+
+    if (!fp && !fileout)
+        return (L_PDF_WRITER *)ERROR_PTR("fp and fileout not defined",
+                                         procName, NULL);
+    if (fp && fileout)
+        return (L_PDF_WRITER *)ERROR_PTR("fp and fileout both defined",
+                                         procName, NULL);
+
+    if ((pw = (L_PDF_WRITER *)LEPT_CALLOC(1, sizeof(L_PDF_WRITER))) == NULL)
+        return (L_PDF_WRITER *)ERROR_PTR("pw not made", procName, NULL);
+    pw->fp = fp;
+    if (fileout)
+        pw->fileout = stringNew(fileout);
+    pw->nobj = 4;  /* the first 3 objects come from the first page */
+    pw->daloc = l_dnaCreate(0);
+    pw->napage = numaCreate(0);
+    return pw;
+}
+
+
+/*!
+ * \brief   pdfwriterAddPage()
+ *
+ * \param[in]    pw pdf writer
+ * \param[in]    data leptonica-formatted single-page pdf data
+ * \param[in]    nbytes size of %data
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The ID and the Catalog and Info objects are taken from the
+ *          first page.  The Page object and all objects after it are
+ *          renumbered and written for every page.  See the notes in
+ *          ptraConcatenatePdfToData() for the object layout.
+ *      (2) All objects of the page are renumbered into a buffer before
+ *          anything is written.  If the data can't be parsed or any
+ *          object can't be renumbered, nothing is written and the
+ *          page is skipped, so the output stays valid.
+ * </pre>
+ */
+l_int32
+pdfwriterAddPage(L_PDF_WRITER   *pw,
+                 const l_uint8  *data,
+                 size_t          nbytes)
+{
+l_uint8   *objdata;
+l_int32    j, nobj, ret;
+l_int32   *locs, *objs;
+size_t     size, nhead, objsize, start;
+l_float64  loc;
+L_BYTEA   *bat, *bap;
+L_DNA     *da_locs, *da_obj;
+
+    PROCNAME("pdfwriterAddPage");
+
+    if (!pw)
+        return ERROR_INT("pw not defined", procName, 1);
+    if (!data || nbytes == 0)
+        return ERROR_INT("no data", procName, 1);
+
+    if (parseTrailerPdf(data, nbytes, &da_locs) != 0)
+        return ERROR_INT("can't parse pdf data", procName, 1);
+    nobj = l_dnaGetCount(da_locs) - 1;
+    if (nobj < 5) {
+        l_dnaDestroy(&da_locs);
+        return ERROR_INT("too few objects", procName, 1);
+    }
+    locs = l_dnaGetIArray(da_locs);
+    l_dnaDestroy(&da_locs);
+
+        /* Objects 4 and higher get the next available numbers;
+         * references to object 3 (Pages) are unchanged. */
+    objs = (l_int32 *)LEPT_CALLOC(nobj, sizeof(l_int32));
+    objs[3] = 3;
+    for (j = 4; j < nobj; j++)
+        objs[j] = pw->nobj + j - 4;
+
+        /* Renumber the page objects into %bap, saving the location
+         * of each object in it */
+    bap = l_byteaCreate(nbytes);
+    da_obj = l_dnaCreate(nobj - 4);
+    ret = 0;
+    for (j = 4; j < nobj; j++) {
+        l_dnaAddNumber(da_obj, l_byteaGetSize(bap));
+        objsize = locs[j + 1] - locs[j];
+        bat = substituteObjectNumbers(data + locs[j], objsize, objs, nobj,
+                                      &nhead);
+        if (!bat) {
+            ret = 1;
+            break;
         }
-        if (i == npages - 1)  /* last one */
-            l_dnaAddNumber(da_outlocs, l_byteaGetSize(bad));
-        LEPT_FREE(sizes);
+        objdata = l_byteaGetData(bat, &size);
+        l_byteaAppendData(bap, objdata, size);
+        l_byteaAppendData(bap, (l_uint8 *)data + locs[j] + nhead,
+                          objsize - nhead);
+        l_byteaDestroy(&bat);
+    }
+    LEPT_FREE(objs);
+    if (ret) {
         LEPT_FREE(locs);
-        l_dnaDestroy(&da_locs);
-        numaDestroy(&na_objs);
-        l_dnaDestroy(&da_sizes);
+        l_byteaDestroy(&bap);
+        l_dnaDestroy(&da_obj);
+        return ERROR_INT("can't renumber page objects", procName, 1);
     }
 
-        /* Add the trailer */
-    str_trailer = makeTrailerStringPdf(da_outlocs);
-    l_byteaAppendString(bad, str_trailer);
+    if (!pw->fp && (pw->fp = fopenWriteStream(pw->fileout, "wb")) == NULL) {
+        LEPT_FREE(locs);
+        l_byteaDestroy(&bap);
+        l_dnaDestroy(&da_obj);
+        return ERROR_INT("stream not opened", procName, 1);
+    }
 
-        /* Transfer the output data */
-    *pdata = l_byteaCopyData(bad, pnbytes);
-    l_byteaDestroy(&bad);
+    if (numaGetCount(pw->napage) == 0) {  /* ID, Catalog and Info */
+        l_dnaAddNumber(pw->daloc, 0);
+        ret |= pdfwriterWrite(pw, data, locs[1]);
+        l_dnaAddNumber(pw->daloc, pw->nbytes);
+        ret |= pdfwriterWrite(pw, data + locs[1], locs[2] - locs[1]);
+        l_dnaAddNumber(pw->daloc, pw->nbytes);
+        ret |= pdfwriterWrite(pw, data + locs[2], locs[3] - locs[2]);
+        l_dnaAddNumber(pw->daloc, 0);  /* Pages; written at the end */
+    }
+    numaAddNumber(pw->napage, pw->nobj);
+    start = pw->nbytes;
+    for (j = 0; j < nobj - 4; j++) {
+        l_dnaGetDValue(da_obj, j, &loc);
+        l_dnaAddNumber(pw->daloc, start + loc);
+    }
+    objdata = l_byteaGetData(bap, &size);
+    ret |= pdfwriterWrite(pw, objdata, size);
+    pw->nobj += nobj - 4;
 
-#if  DEBUG_MULTIPAGE
-    fprintf(stderr, "******** object mapper **********");
-    numaaWriteStream(stderr, naa_objs);
+    LEPT_FREE(locs);
+    l_byteaDestroy(&bap);
+    l_dnaDestroy(&da_obj);
+    if (ret)
+        return ERROR_INT("write failure", procName, 1);
+    return 0;
+}
 
-    fprintf(stderr, "******** Page object numbers ***********");
-    numaWriteStream(stderr, napage);
 
-    fprintf(stderr, "******** Pages object ***********\n");
-    fprintf(stderr, "%s\n", str_pages);
-#endif  /* DEBUG_MULTIPAGE */
+/*!
+ * \brief   pdfwriterFinish()
+ *
+ * \param[in,out]   ppw will be set to null before returning
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This writes the Pages object, with references to the Page
+ *          object of every page, and the trailer.  It then destroys
+ *          the writer.  A stream given to pdfwriterCreate() is not
+ *          closed; a file given by name is.
+ *      (2) It is an error if no pages have been added.
+ * </pre>
+ */
+l_int32
+pdfwriterFinish(L_PDF_WRITER  **ppw)
+{
+char          *str_pages, *str_trailer;
+l_int32        ret;
+L_PDF_WRITER  *pw;
+
+    PROCNAME("pdfwriterFinish");
+
+    if (!ppw)
+        return ERROR_INT("&pw not defined", procName, 1);
+    if ((pw = *ppw) == NULL)
+        return ERROR_INT("pw not defined", procName, 1);
+    *ppw = NULL;
+
+    ret = 0;
+    if (numaGetCount(pw->napage) == 0) {
+        L_ERROR("no pages were added\n", procName);
+        ret = 1;
+    } else {
+        l_dnaSetValue(pw->daloc, 3, pw->nbytes);
+        str_pages = generatePagesObjStringPdf(pw->napage);
+        ret |= pdfwriterWrite(pw, (l_uint8 *)str_pages, strlen(str_pages));
+        l_dnaAddNumber(pw->daloc, pw->nbytes);  /* xref location */
+        str_trailer = makeTrailerStringPdf(pw->daloc);
+        ret |= pdfwriterWrite(pw, (l_uint8 *)str_trailer, strlen(str_trailer));
+        LEPT_FREE(str_pages);
+        LEPT_FREE(str_trailer);
+        if (ret) L_ERROR("write failure\n", procName);
+    }
+
+    if (pw->fileout) {
+        if (pw->fp) fclose(pw->fp);
+        LEPT_FREE(pw->fileout);
+    }
+    l_dnaDestroy(&pw->daloc);
+    numaDestroy(&pw->napage);
+    LEPT_FREE(pw);
+    return ret;
+}
+
 
-    numaDestroy(&napage);
-    numaaDestroy(&naa_objs);
-    l_dnaDestroy(&da_outlocs);
-    l_dnaaDestroy(&daa_locs);
-    LEPT_FREE(str_pages);
-    LEPT_FREE(str_trailer);
+/*!
+ * \brief   pdfwriterWrite()
+ *
+ * \param[in]    pw pdf writer
+ * \param[in]    data bytes to write
+ * \param[in]    nbytes number of bytes to write
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+pdfwriterWrite(L_PDF_WRITER   *pw,
+               const l_uint8  *data,
+               size_t          nbytes)
+{
+    if (nbytes == 0) return 0;
+    if (fwrite(data, 1, nbytes, pw->fp) != nbytes)
+        return 1;
+    pw->nbytes += nbytes;
     return 0;
 }
 
@@ -2091,30 +2292,42 @@ L_COMP_DATA  *cid;
 /*!
  * \brief   parseTrailerPdf()
  *
- * \param[in]    bas lba of a pdf file
+ * \param[in]    data pdf file data
+ * \param[in]    size size of %data
  * \param[out]   pda byte locations of the beginning of each object
  * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The object locations are read from the xref table, which
+ *          leptonica writes as a single subsection of fixed-size
+ *          20-byte entries.  %da[0] is the ID location (0), %da[i]
+ *          is the location of object i, and the last entry is the
+ *          location of the xref table.
+ *      (2) Each location is checked against the "n 0 obj" line it
+ *          should point to.  Only if the table is broken are the
+ *          objects found by scanning the data.
+ * </pre>
  */
 static l_int32
-parseTrailerPdf(L_BYTEA  *bas,
-                L_DNA   **pda)
+parseTrailerPdf(const l_uint8  *data,
+                size_t          size,
+                L_DNA         **pda)
 {
-char     *str;
-l_uint8   nl = '\n';
-l_uint8  *data;
-l_int32   i, j, start, startloc, xrefloc, found, loc, nobj, objno, trailer_ok;
-size_t    size;
-L_DNA    *da, *daobj, *daxref;
-SARRAY   *sa;
+char      *str, *tail;
+l_uint8    nl = '\n';
+l_int32    i, j, start, startloc, prevloc, xrefloc, found, loc;
+l_int32    nobj, objno, trailer_ok;
+size_t     entry;
+L_DNA     *da, *daobj, *daxref;
 
     PROCNAME("parseTrailerPdf");
 
     if (!pda)
         return ERROR_INT("&da not defined", procName, 1);
     *pda = NULL;
-    if (!bas)
-        return ERROR_INT("bas not defined", procName, 1);
-    data = l_byteaGetData(bas, &size);
+    if (!data || size < 8)
+        return ERROR_INT("data not defined", procName, 1);
     if (strncmp((char *)data, "%PDF-1.", 7) != 0)
         return ERROR_INT("PDF header signature not found", procName, 1);
 
@@ -2128,53 +2341,75 @@ SARRAY   *sa;
         return ERROR_INT("startxref not found!", procName, 1);
     if (sscanf((char *)(data + start + loc + 10), "%d\n", &xrefloc) != 1)
         return ERROR_INT("xrefloc not found!", procName, 1);
-    if (xrefloc < 0 || xrefloc >= size)
+    if (xrefloc < 0 || xrefloc >= size - 5)
         return ERROR_INT("invalid xrefloc!", procName, 1);
-    sa = sarrayCreateLinesFromString((char *)(data + xrefloc), 0);
-    str = sarrayGetString(sa, 1, L_NOCOPY);
-    if ((sscanf(str, "0 %d", &nobj)) != 1) {
-        sarrayDestroy(&sa);
-        return ERROR_INT("nobj not found", procName, 1);
-    }
 
-        /* Get starting locations.  The numa index is the
-         * object number.  loc[0] is the ID; loc[nobj + 1] is xrefloc.  */
+        /* Read the subsection header "xref\n0 nobj\n" */
+    str = (char *)(data + xrefloc);
+    if (strncmp(str, "xref", 4) != 0)
+        return ERROR_INT("xref not found at xrefloc", procName, 1);
+    str += 4;
+    while (str < (char *)data + size && (*str == '\r' || *str == '\n'))
+        str++;
+    if (str + 4 >= (char *)data + size || str[0] != '0' || str[1] != ' ')
+        return ERROR_INT("xref subsection not found", procName, 1);
+    nobj = strtol(str + 2, &tail, 10);
+    if (tail == str + 2 || nobj < 1)
+        return ERROR_INT("nobj not found", procName, 1);
+    while (tail < (char *)data + size && (*tail == '\r' || *tail == '\n'))
+        tail++;
+    entry = (l_uint8 *)tail - data;
+    if (entry + 20 * (size_t)nobj > size)
+        return ERROR_INT("xref table is truncated", procName, 1);
+
+        /* Get starting locations.  The dna index is the object number.
+         * da[0] is the ID; da[nobj] is xrefloc.  Each entry is
+         * "oooooooooo ggggg n" followed by a 2-byte end of line. */
     da = l_dnaCreate(nobj + 1);
     *pda = da;
-    for (i = 0; i < nobj; i++) {
-        str = sarrayGetString(sa, i + 2, L_NOCOPY);
-        sscanf(str, "%d", &startloc);
+    l_dnaAddNumber(da, 0);
+    trailer_ok = TRUE;
+    prevloc = 0;
+    for (i = 1; i < nobj; i++) {
+        str = (char *)(data + entry + 20 * i);
+        startloc = strtol(str, &tail, 10);
+        if (tail != str + 10 || startloc <= prevloc || startloc >= xrefloc) {
+            trailer_ok = FALSE;
+            break;
+        }
         l_dnaAddNumber(da, startloc);
+        prevloc = startloc;
     }
     l_dnaAddNumber(da, xrefloc);
 
-#if  DEBUG_MULTIPAGE
-    fprintf(stderr, "************** Trailer string ************\n");
-    fprintf(stderr, "xrefloc = %d", xrefloc);
-    sarrayWriteStream(stderr, sa);
-
-    fprintf(stderr, "************** Object locations ************");
-    l_dnaWriteStream(stderr, da);
-#endif  /* DEBUG_MULTIPAGE */
-    sarrayDestroy(&sa);
-
-        /* Verify correct parsing */
-    trailer_ok = TRUE;
-    for (i = 1; i < nobj; i++) {
+        /* Verify that each location points to its object */
+    for (i = 1; trailer_ok && i < nobj; i++) {
         l_dnaGetIValue(da, i, &startloc);
-        if ((sscanf((char *)(data + startloc), "%d 0 obj", &objno)) != 1) {
+        if (sscanf((char *)(data + startloc), "%d 0 obj", &objno) != 1 ||
+            objno != i) {
             L_ERROR("bad trailer for object %d\n", procName, i);
             trailer_ok = FALSE;
-            break;
         }
     }
 
+#if  DEBUG_MULTIPAGE
+    fprintf(stderr, "************** Object locations ************");
+    l_dnaWriteStream(stderr, da);
+#endif  /* DEBUG_MULTIPAGE */
+
         /* If the trailer is broken, reconstruct the correct obj locations */
     if (!trailer_ok) {
         L_INFO("rebuilding pdf trailer\n", procName);
         l_dnaEmpty(da);
         l_dnaAddNumber(da, 0);
-        l_byteaFindEachSequence(bas, (l_uint8 *)" 0 obj\n", 7, &daobj);
+        daobj = arrayFindEachSequence(data, size, (l_uint8 *)" 0 obj\n", 7);
+        daxref = arrayFindEachSequence(data, size, (l_uint8 *)"xref", 4);
+        if (!daobj || !daxref) {
+            l_dnaDestroy(&daobj);
+            l_dnaDestroy(&daxref);
+            l_dnaDestroy(pda);
+            return ERROR_INT("objects not found", procName, 1);
+        }
         nobj = l_dnaGetCount(daobj);
         for (i = 0; i < nobj; i++) {
             l_dnaGetIValue(daobj, i, &loc);
@@ -2184,7 +2419,6 @@ SARRAY   *sa;
             }
             l_dnaAddNumber(da, j + 1);
         }
-        l_byteaFindEachSequence(bas, (l_uint8 *)"xref", 4, &daxref);
         l_dnaGetIValue(daxref, 0, &loc);
         l_dnaAddNumber(da, loc);
         l_dnaDestroy(&daobj);
@@ -2224,7 +2458,8 @@ SARRAY  *sa;
                                "/Type /Pages\n"
                                "/Kids [%s]\n"
                                "/Count %d\n"
-                               ">>\n", str, n);
+                               ">>\n"
+                               "endobj\n", str, n);
     sarrayDestroy(&sa);
     LEPT_FREE(str);
     return buf;
@@ -2234,47 +2469,61 @@ SARRAY  *sa;
 /*!
  * \brief   substituteObjectNumbers()
  *
- *  Input:  bas (lba of a pdf object)
- *          na_objs (object number mapping array)
- *  Return: bad (lba of rewritten pdf for the object)
+ *  Input:  data (pdf object, starting with "n 0 obj")
+ *          size (of the object)
+ *          objs (object number mapping array)
+ *          nobjs (size of %objs)
+ *          &nhead (<return> number of bytes of %data that were rewritten)
+ *  Return: bad (lba of rewritten object dictionary)
  *
  *  Notes:
  *      (1) Interpret the first set of bytes as the object number,
  *          map to the new number, and write it out.
- *      (2) Find all occurrences of this 4-byte sequence: " 0 R"
- *      (3) Find the location and value of the integer preceding this,
- *          and map it to the new value.
- *      (4) Rewrite the object with new object numbers.
+ *      (2) Object references " 0 R" are only looked for in the
+ *          dictionary, which ends with the "stream" keyword for objects
+ *          that have a stream.  The stream data is binary and can
+ *          contain the same bytes; it is not returned here, and the
+ *          caller writes bytes from %nhead to the end unchanged.
+ *      (3) Find the location and value of the integer preceding each
+ *          reference, and map it to the new value.
  */
 static L_BYTEA *
-substituteObjectNumbers(L_BYTEA  *bas,
-                        NUMA     *na_objs)
+substituteObjectNumbers(const l_uint8  *data,
+                        size_t          size,
+                        const l_int32  *objs,
+                        l_int32         nobjs,
+                        size_t         *pnhead)
 {
 l_uint8   space = ' ';
-l_uint8  *datas;
 l_uint8   buf[32];  /* only needs to hold one integer in ascii format */
-l_int32   start, nrepl, i, j, objin, objout, found;
-l_int32  *objs, *matches;
-size_t    size;
+l_int32   start, nrepl, i, j, objin, objout, found, loc;
+l_int32  *matches;
+size_t    nhead;
 L_BYTEA  *bad;
 L_DNA    *da_match;
 
-    datas = l_byteaGetData(bas, &size);
-    bad = l_byteaCreate(100);
-    objs = numaGetIArray(na_objs);  /* object number mapper */
+    PROCNAME("substituteObjectNumbers");
+
+    *pnhead = 0;
+    if (sscanf((char *)data, "%d", &objin) != 1 || objin < 0 || objin >= nobjs)
+        return (L_BYTEA *)ERROR_PTR("invalid object number", procName, NULL);
+
+        /* Limit the search to the dictionary */
+    arrayFindSequence(data, size, (l_uint8 *)"stream\n", 7, &loc, &found);
+    nhead = (found) ? loc + 7 : size;
 
         /* Substitute the object number on the first line */
-    sscanf((char *)datas, "%d", &objin);
+    bad = l_byteaCreate(nhead + 16);
     objout = objs[objin];
     snprintf((char *)buf, 32, "%d", objout);
     l_byteaAppendString(bad, (char *)buf);
 
         /* Find the set of matching locations for object references */
-    arrayFindSequence(datas, size, &space, 1, &start, &found);
-    da_match = arrayFindEachSequence(datas, size, (l_uint8 *)" 0 R", 4);
+    arrayFindSequence(data, nhead, &space, 1, &start, &found);
+    da_match = arrayFindEachSequence(data, nhead, (l_uint8 *)" 0 R", 4);
     if (!da_match) {
-        l_byteaAppendData(bad, datas + start, size - start);
-        LEPT_FREE(objs);
+        l_byteaAppendData(bad, (l_uint8 *)data + start, nhead - start);
+        *pnhead = nhead;
         return bad;
     }
 
@@ -2284,20 +2533,22 @@ L_DNA    *da_match;
     for (i = 0; i < nrepl; i++) {
             /* Find the first space before the object number */
         for (j = matches[i] - 1; j > 0; j--) {
-            if (datas[j] == space)
+            if (data[j] == space)
                 break;
         }
+        if (j < start) continue;  /* not a reference */
+        sscanf((char *)(data + j + 1), "%d", &objin);
+        if (objin < 0 || objin >= nobjs) continue;
             /* Copy bytes from 'start' up to the object number */
-        l_byteaAppendData(bad, datas + start, j - start + 1);
-        sscanf((char *)(datas + j + 1), "%d", &objin);
+        l_byteaAppendData(bad, (l_uint8 *)data + start, j - start + 1);
         objout = objs[objin];
         snprintf((char *)buf, 32, "%d", objout);
         l_byteaAppendString(bad, (char *)buf);
         start = matches[i];
     }
-    l_byteaAppendData(bad, datas + start, size - start);
+    l_byteaAppendData(bad, (l_uint8 *)data + start, nhead - start);
+    *pnhead = nhead;
 
-    LEPT_FREE(objs);
     LEPT_FREE(matches);
     l_dnaDestroy(&da_match);
     return bad;
@@ -59,6 +59,29 @@ l_int32 ptraConcatenatePdfToData(L_PTRA *pa_data, SARRAY *sa,
 
 /* ----------------------------------------------------------------------*/
 
+L_PDF_WRITER * pdfwriterCreate(FILE *fp, const char *fileout)
+{
+    return (L_PDF_WRITER *)ERROR_PTR("function not present",
+                                     "pdfwriterCreate", NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 pdfwriterAddPage(L_PDF_WRITER *pw, const l_uint8 *data,
+                         size_t nbytes)
+{
+    return ERROR_INT("function not present", "pdfwriterAddPage", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
+l_int32 pdfwriterFinish(L_PDF_WRITER **ppw)
+{
+    return ERROR_INT("function not present", "pdfwriterFinish", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 convertTiffMultipageToPdf(const char *filein, const char *fileout)
 {
     return ERROR_INT("function not present", "convertTiffMultipageToPdf", 1);
@@ -67,6 +67,7 @@
  *         struct DPix
  *         struct PixComp
  *         struct PixaComp
+ *         struct L_PixacCache
  *
  *   (2) This file has definitions for:
  *         Colors for RGB
@@ -156,6 +157,9 @@ struct PixColormap
     l_int32          depth;   /*!< of pix (1, 2, 4 or 8 bpp)               */
     l_int32          nalloc;  /*!< number of color entries allocated       */
     l_int32          n;       /*!< number of color entries used            */
+    l_int32         *invmap;  /*!< cache for nearest color search; made    */
+                              /*!< lazily and freed when cmap is changed   */
+    l_int32          nsearch; /*!< nearest color searches without cache    */
 };
 typedef struct PixColormap  PIXCMAP;
 
@@ -650,6 +654,7 @@ typedef struct PixComp PIXC;
  *                     PixaComp: array of compressed pix                   *
  *-------------------------------------------------------------------------*/
 #define  PIXACOMP_VERSION_NUMBER 2  /*!< Version for PixaComp serialization */
+#define  PIXACOMP_INDEXED_VERSION 1  /*!< Version for indexed PixaComp file  */
 
 /*! Array of compressed pix */
 struct PixaComp
@@ -659,9 +664,25 @@ struct PixaComp
     l_int32              offset;    /*!< indexing offset into ptr array    */
     struct PixComp     **pixc;      /*!< the array of ptrs to PixComp      */
     struct Boxa         *boxa;      /*!< array of boxes                    */
+    FILE                *fp;        /*!< [optional] indexed file stream    */
+    struct L_Dna        *daloc;     /*!< [optional] data locations in file */
+    struct L_PixacCache *cache;     /*!< [optional] uncompressed pix       */
 };
 typedef struct PixaComp PIXAC;
 
+/*! Cache of recently used uncompressed pix in a PixaComp */
+struct L_PixacCache
+{
+    size_t               maxbytes;  /*!< limit on the size of cached pix   */
+    size_t               nbytes;    /*!< size of the pix now cached        */
+    l_int32              nalloc;    /*!< size of the arrays; as in pixac   */
+    l_uint32             clock;     /*!< incremented on each cache access  */
+    struct Pix         **pix;       /*!< cached pix, indexed as the pixc   */
+    l_uint32            *lastuse;   /*!< clock value at the last access    */
+    l_int32             *pending;   /*!< 1 if the pixc data is not yet made */
+};
+typedef struct L_PixacCache L_PIXAC_CACHE;
+
 
 /*-------------------------------------------------------------------------*
  *                         Access and storage flags                        *
@@ -1140,6 +1161,19 @@ enum {
 };
 
 
+/*-------------------------------------------------------------------------*
+ *                  Local threshold binarization methods                   *
+ *-------------------------------------------------------------------------*/
+
+/*! Local threshold binarization methods */
+enum {
+    L_SAUVOLA_THRESH = 1,    /*!< t = m * (1 - k * (1 - s / 128))          */
+    L_NIBLACK_THRESH = 2,    /*!< t = m - k * s                            */
+    L_WOLF_THRESH = 3,       /*!< t = m - k * (1 - s / smax) * (m - vmin)  */
+    L_BRADLEY_THRESH = 4     /*!< t = m * (1 - k)                          */
+};
+
+
 /*-------------------------------------------------------------------------*
  *             Subpixel color component ordering in LCD display            *
  *-------------------------------------------------------------------------*/
@@ -85,6 +85,23 @@
  *           l_int32   pixacompWriteStream()
  *           l_int32   pixacompWriteMem()
  *
+ *      Pixacomp cache of uncompressed pix
+ *           l_int32   pixacompSetCacheSize()
+ *           static PIX     *pixacompCacheLookup()
+ *           static void     pixacompCacheInsert()
+ *           static l_int32  pixacompCacheRemove()
+ *           static l_int32  pixacompCacheCompress()
+ *           static void     pixacompCacheDestroy()
+ *
+ *      Pixacomp indexed file I/O
+ *           PIXAC    *pixacompReadIndexed()
+ *           l_int32   pixacompWriteIndexed()
+ *           l_int32   pixacompAppendIndexed()
+ *           static PIXAC   *pixacompReadIndexedStream()
+ *           static l_int32  pixacompWriteIndexedData()
+ *           static l_int32  pixacompWriteIndexedTable()
+ *           static l_uint8 *pixacompReadIndexedData()
+ *
  *      Conversion to pdf
  *           l_int32   pixacompConvertToPdf()
  *           l_int32   pixacompConvertToPdfData()
@@ -146,12 +163,28 @@
 
 static const l_int32  INITIAL_PTR_ARRAYSIZE = 20;   /* n'import quoi */
 
+    /* Size of the last line of an indexed pixacomp file, which gives
+     * the location of the index: "Pixacomp index = %012lu\n" */
+#define  PIXACOMP_INDEX_TRAILER_SIZE   30
+
     /* These two globals are defined in writefile.c */
 extern l_int32 NumImageFileFormatExtensions;
 extern const char *ImageFileFormatExtensions[];
 
     /* Static function */
 static l_int32 pixacompExtendArray(PIXAC *pixac);
+static PIXAC *pixacompReadIndexedStream(FILE *fp, size_t *pindexloc);
+static l_int32 pixacompWriteIndexedData(FILE *fp, PIXAC *pixac,
+                                        PIXAC *pixacm);
+static l_int32 pixacompWriteIndexedTable(FILE *fp, PIXAC *pixacm);
+static l_uint8 *pixacompReadIndexedData(PIXAC *pixac, l_int32 aindex);
+static PIX *pixacompCacheLookup(PIXAC *pixac, l_int32 aindex);
+static void pixacompCacheInsert(PIXAC *pixac, l_int32 aindex, PIX *pix,
+                                l_int32 pending);
+static l_int32 pixacompCacheRemove(PIXAC *pixac, l_int32 aindex,
+                                   l_int32 compress);
+static l_int32 pixacompCacheCompress(PIXAC *pixac, l_int32 aindex);
+static void pixacompCacheDestroy(PIXAC *pixac);
 
 
 /*---------------------------------------------------------------------*
@@ -833,6 +866,9 @@ PIXAC   *pixac;
         pixcompDestroy(&pixac->pixc[i]);
     LEPT_FREE(pixac->pixc);
     boxaDestroy(&pixac->boxa);
+    if (pixac->fp) fclose(pixac->fp);
+    l_dnaDestroy(&pixac->daloc);
+    pixacompCacheDestroy(pixac);
     LEPT_FREE(pixac);
 
     *ppixac = NULL;
@@ -858,6 +894,14 @@ PIXAC   *pixac;
  *          the n-th position.
  *      (2) The pixc produced from the pix is owned by the pixac.
  *          The input pix is not affected.
+ *      (3) If the pixac has a cache (see pixacompSetCacheSize()), a copy
+ *          of the pix is put in the cache and the compression is put
+ *          off until the pix is pushed out of the cache or the pixc
+ *          is needed.
+ *      (4) Jpeg compression is lossy, so with jpeg the pix is compressed
+ *          immediately and is not cached until it is decompressed.
+ *          Then pixacompGetPix() returns the same decompressed pix
+ *          whether or not it is in the cache.
  * </pre>
  */
 l_int32
@@ -865,6 +909,7 @@ pixacompAddPix(PIXAC   *pixac,
                PIX     *pix,
                l_int32  comptype)
 {
+char    *text;
 l_int32  cmapflag, format;
 PIXC    *pixc;
 
@@ -880,6 +925,19 @@ PIXC    *pixc;
 
     cmapflag = pixGetColormap(pix) ? 1 : 0;
     pixcompDetermineFormat(comptype, pixGetDepth(pix), cmapflag, &format);
+    if (pixac->cache && format != IFF_JFIF_JPEG) {  /* compress later */
+        pixc = (PIXC *)LEPT_CALLOC(1, sizeof(PIXC));
+        pixGetDimensions(pix, &pixc->w, &pixc->h, &pixc->d);
+        pixGetResolution(pix, &pixc->xres, &pixc->yres);
+        pixc->cmapflag = cmapflag;
+        if ((text = pixGetText(pix)) != NULL)
+            pixc->text = stringNew(text);
+        pixc->comptype = format;
+        pixacompAddPixcomp(pixac, pixc, L_INSERT);
+        pixacompCacheInsert(pixac, pixac->n - 1, pixCopy(NULL, pix), 1);
+        return 0;
+    }
+
     if ((pixc = pixcompCreateFromPix(pix, format)) == NULL)
         return ERROR_INT("pixc not made", procName, 1);
     pixacompAddPixcomp(pixac, pixc, L_INSERT);
@@ -948,6 +1006,9 @@ l_int32  n;
 static l_int32
 pixacompExtendArray(PIXAC  *pixac)
 {
+size_t          oldsize;
+L_PIXAC_CACHE  *cache;
+
     PROCNAME("pixacompExtendArray");
 
     if (!pixac)
@@ -959,6 +1020,22 @@ pixacompExtendArray(PIXAC  *pixac)
         return ERROR_INT("new ptr array not returned", procName, 1);
     pixac->nalloc = 2 * pixac->nalloc;
     boxaExtendArray(pixac->boxa);
+
+    if ((cache = pixac->cache) != NULL) {
+        oldsize = cache->nalloc;
+        cache->pix = (PIX **)reallocNew((void **)&cache->pix,
+                                        sizeof(PIX *) * oldsize,
+                                        sizeof(PIX *) * pixac->nalloc);
+        cache->lastuse = (l_uint32 *)reallocNew((void **)&cache->lastuse,
+                                        sizeof(l_uint32) * oldsize,
+                                        sizeof(l_uint32) * pixac->nalloc);
+        cache->pending = (l_int32 *)reallocNew((void **)&cache->pending,
+                                        sizeof(l_int32) * oldsize,
+                                        sizeof(l_int32) * pixac->nalloc);
+        if (!cache->pix || !cache->lastuse || !cache->pending)
+            return ERROR_INT("new cache arrays not returned", procName, 1);
+        cache->nalloc = pixac->nalloc;
+    }
     return 0;
 }
 
@@ -1044,9 +1121,11 @@ PIXC    *pixct;
     if (!pixc)
         return ERROR_INT("pixc not defined", procName, 1);
 
-    pixct = pixacompGetPixcomp(pixac, index, L_NOCOPY);  /* use %index */
+    if (pixac->cache)
+        pixacompCacheRemove(pixac, aindex, 0);
+    pixct = pixac->pixc[aindex];  /* use array index */
     pixcompDestroy(&pixct);
-    pixac->pixc[aindex] = pixc;  /* replace; use array index */
+    pixac->pixc[aindex] = pixc;
 
     return 0;
 }
@@ -1114,6 +1193,9 @@ pixacompGetCount(PIXAC  *pixac)
  *          to get the actual index into the ptr array.
  *      (2) If copyflag == L_NOCOPY, the pixc is owned by %pixac; do
  *          not destroy.
+ *      (3) For a pixac read with pixacompReadIndexed(), the compressed
+ *          data is read from the file the first time the pixc is
+ *          requested, and is then kept in %pixac.
  * </pre>
  */
 PIXC *
@@ -1122,6 +1204,7 @@ pixacompGetPixcomp(PIXAC   *pixac,
                    l_int32  copyflag)
 {
 l_int32  aindex;
+PIXC    *pixc;
 
     PROCNAME("pixacompGetPixcomp");
 
@@ -1133,10 +1216,20 @@ l_int32  aindex;
     if (aindex < 0 || aindex >= pixac->n)
         return (PIXC *)ERROR_PTR("array index not valid", procName, NULL);
 
+    pixc = pixac->pixc[aindex];
+    if (!pixc->data && pixac->cache && pixac->cache->pending[aindex]) {
+        if (pixacompCacheCompress(pixac, aindex))
+            return (PIXC *)ERROR_PTR("pixc data not made", procName, NULL);
+    }
+    if (!pixc->data && pixac->fp) {
+        if ((pixc->data = pixacompReadIndexedData(pixac, aindex)) == NULL)
+            return (PIXC *)ERROR_PTR("data not read", procName, NULL);
+    }
+
     if (copyflag == L_NOCOPY)
-        return pixac->pixc[aindex];
+        return pixc;
     else  /* L_COPY */
-        return pixcompCopy(pixac->pixc[aindex]);
+        return pixcompCopy(pixc);
 }
 
 
@@ -1151,6 +1244,10 @@ l_int32  aindex;
  * Notes:
  *      (1) The %index includes the offset, which must be subtracted
  *          to get the actual index into the ptr array.
+ *      (2) For a pixac read with pixacompReadIndexed(), only the data
+ *          for this pix is read from the file, and it is not kept.
+ *      (3) If the pixac has a cache, a cached pix is copied rather than
+ *          decompressed, and a decompressed pix is added to the cache.
  * </pre>
  */
 PIX *
@@ -1158,7 +1255,9 @@ pixacompGetPix(PIXAC   *pixac,
                l_int32  index)
 {
 l_int32  aindex;
+PIX     *pix;
 PIXC    *pixc;
+PIXC     pixct;
 
     PROCNAME("pixacompGetPix");
 
@@ -1168,8 +1267,22 @@ PIXC    *pixc;
     if (aindex < 0 || aindex >= pixac->n)
         return (PIX *)ERROR_PTR("array index not valid", procName, NULL);
 
-    pixc = pixacompGetPixcomp(pixac, index, L_NOCOPY);
-    return pixCreateFromPixcomp(pixc);
+    if (pixac->cache && (pix = pixacompCacheLookup(pixac, aindex)) != NULL)
+        return pixCopy(NULL, pix);
+
+    pixc = pixac->pixc[aindex];
+    if (!pixc->data && pixac->fp) {  /* decode without caching the data */
+        pixct = *pixc;
+        if ((pixct.data = pixacompReadIndexedData(pixac, aindex)) == NULL)
+            return (PIX *)ERROR_PTR("data not read", procName, NULL);
+        pix = pixCreateFromPixcomp(&pixct);
+        LEPT_FREE(pixct.data);
+    } else {
+        pix = pixCreateFromPixcomp(pixc);
+    }
+    if (pix && pixac->cache)
+        pixacompCacheInsert(pixac, aindex, pixCopy(NULL, pix), 0);
+    return pix;
 }
 
 
@@ -1858,6 +1971,651 @@ FILE    *fp;
 }
 
 
+/*--------------------------------------------------------------------*
+ *                Pixacomp cache of uncompressed pix                  *
+ *--------------------------------------------------------------------*/
+/*!
+ * \brief   pixacompSetCacheSize()
+ *
+ * \param[in]    pixac
+ * \param[in]    maxbytes limit on the memory for uncompressed pix;
+ *                        use 0 to remove the cache
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) With a cache, the most recently added or accessed pix are
+ *          kept uncompressed, up to a total of %maxbytes of pix data.
+ *          When the limit is exceeded, the least recently used pix
+ *          are removed from the cache.
+ *      (2) pixacompAddPix() puts a copy of the pix in the cache, and
+ *          compresses it only when it is removed from the cache, or
+ *          when the pixc is needed, as in pixacompGetPixcomp() and the
+ *          serialization functions.  A pix that is taken from the
+ *          array again before it is removed is never compressed and
+ *          decompressed.  This is not done for lossy jpeg compression;
+ *          see pixacompAddPix().
+ *      (3) pixacompGetPix() returns a copy of a cached pix, which is
+ *          much faster than decompression.  A pix that must be
+ *          decompressed is added to the cache.
+ *      (4) Setting %maxbytes = 0 compresses any pix that are only in
+ *          the cache, and removes the cache.  If any of them can't be
+ *          compressed, the cache is kept and an error is returned.
+ * </pre>
+ */
+l_int32
+pixacompSetCacheSize(PIXAC   *pixac,
+                     size_t   maxbytes)
+{
+l_int32         i, ret, lru;
+l_uint32        minuse;
+L_PIXAC_CACHE  *cache;
+
+    PROCNAME("pixacompSetCacheSize");
+
+    if (!pixac)
+        return ERROR_INT("pixac not defined", procName, 1);
+
+    if (maxbytes == 0) {
+        if ((cache = pixac->cache) == NULL)
+            return 0;
+        ret = 0;
+        for (i = 0; i < pixac->n; i++)
+            ret |= pixacompCacheRemove(pixac, i, 1);
+        if (ret)  /* keep the cache; it holds the only copy of some pix */
+            return ERROR_INT("pixc not made for all pix", procName, 1);
+        pixacompCacheDestroy(pixac);
+        return 0;
+    }
+
+    if ((cache = pixac->cache) == NULL) {
+        cache = (L_PIXAC_CACHE *)LEPT_CALLOC(1, sizeof(L_PIXAC_CACHE));
+        cache->nalloc = pixac->nalloc;
+        cache->pix = (PIX **)LEPT_CALLOC(cache->nalloc, sizeof(PIX *));
+        cache->lastuse = (l_uint32 *)LEPT_CALLOC(cache->nalloc,
+                                                 sizeof(l_uint32));
+        cache->pending = (l_int32 *)LEPT_CALLOC(cache->nalloc,
+                                                sizeof(l_int32));
+        if (!cache->pix || !cache->lastuse || !cache->pending) {
+            pixac->cache = cache;
+            pixacompCacheDestroy(pixac);
+            return ERROR_INT("cache arrays not made", procName, 1);
+        }
+        pixac->cache = cache;
+    }
+    cache->maxbytes = maxbytes;
+
+        /* Remove the least recently used pix until within the limit */
+    while (cache->nbytes > cache->maxbytes) {
+        lru = -1;
+        minuse = 0;
+        for (i = 0; i < pixac->n; i++) {
+            if (cache->pix[i] && (lru < 0 || cache->lastuse[i] < minuse)) {
+                lru = i;
+                minuse = cache->lastuse[i];
+            }
+        }
+        if (lru < 0) break;
+        if (pixacompCacheRemove(pixac, lru, 1))
+            return ERROR_INT("cache not reduced to maxbytes", procName, 1);
+    }
+    return 0;
+}
+
+
+/*!
+ * \brief   pixacompCacheLookup()
+ *
+ * \param[in]    pixac with cache
+ * \param[in]    aindex array index
+ * \return  cached pix, not a copy, or NULL if not in the cache
+ */
+static PIX *
+pixacompCacheLookup(PIXAC   *pixac,
+                    l_int32  aindex)
+{
+L_PIXAC_CACHE  *cache;
+
+    cache = pixac->cache;
+    if (!cache->pix[aindex])
+        return NULL;
+    cache->lastuse[aindex] = ++cache->clock;
+    return cache->pix[aindex];
+}
+
+
+/*!
+ * \brief   pixacompCacheInsert()
+ *
+ * \param[in]    pixac with cache
+ * \param[in]    aindex array index
+ * \param[in]    pix inserted; owned by the cache
+ * \param[in]    pending 1 if the pixc data has not been made
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) After insertion, least recently used pix are removed until
+ *          the cache is within its limit.
+ *      (2) A pix that is larger than the limit is not kept; if its
+ *          pixc data is pending, it is made immediately.  A pending
+ *          pix is kept if its pixc data can't be made.
+ * </pre>
+ */
+static void
+pixacompCacheInsert(PIXAC   *pixac,
+                    l_int32  aindex,
+                    PIX     *pix,
+                    l_int32  pending)
+{
+size_t          nbytes;
+L_PIXAC_CACHE  *cache;
+
+    PROCNAME("pixacompCacheInsert");
+
+    if (!pix) {
+        L_ERROR("pix not defined\n", procName);
+        return;
+    }
+    cache = pixac->cache;
+    if (pixacompCacheRemove(pixac, aindex, 1)) {
+        L_ERROR("pix not inserted\n", procName);
+        pixDestroy(&pix);
+        return;
+    }
+    cache->pix[aindex] = pix;
+    cache->pending[aindex] = pending;
+    cache->lastuse[aindex] = ++cache->clock;
+    nbytes = (size_t)4 * pixGetWpl(pix) * pixGetHeight(pix);
+    cache->nbytes += nbytes;
+    if (nbytes > cache->maxbytes)
+        pixacompCacheRemove(pixac, aindex, 1);
+    else if (cache->nbytes > cache->maxbytes)
+        pixacompSetCacheSize(pixac, cache->maxbytes);
+    return;
+}
+
+
+/*!
+ * \brief   pixacompCacheRemove()
+ *
+ * \param[in]    pixac with cache
+ * \param[in]    aindex array index
+ * \param[in]    compress 1 to make the pixc data if it is pending;
+ *                        0 if the pixc is to be discarded
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) If the pending pixc data can't be made, the pix is the only
+ *          copy of the image, so it is left in the cache, still pending.
+ * </pre>
+ */
+static l_int32
+pixacompCacheRemove(PIXAC   *pixac,
+                    l_int32  aindex,
+                    l_int32  compress)
+{
+PIX            *pix;
+L_PIXAC_CACHE  *cache;
+
+    PROCNAME("pixacompCacheRemove");
+
+    cache = pixac->cache;
+    if ((pix = cache->pix[aindex]) == NULL)
+        return 0;
+    if (compress && cache->pending[aindex] &&
+        pixacompCacheCompress(pixac, aindex) != 0)
+        return ERROR_INT("pixc not made; pix kept", procName, 1);
+    cache->nbytes -= (size_t)4 * pixGetWpl(pix) * pixGetHeight(pix);
+    cache->pending[aindex] = 0;
+    pixDestroy(&cache->pix[aindex]);
+    return 0;
+}
+
+
+/*!
+ * \brief   pixacompCacheCompress()
+ *
+ * \param[in]    pixac with cache
+ * \param[in]    aindex array index of a pixc whose data is pending
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This makes the pixc data from the cached pix.  The pix
+ *          stays in the cache.
+ * </pre>
+ */
+static l_int32
+pixacompCacheCompress(PIXAC   *pixac,
+                      l_int32  aindex)
+{
+PIXC           *pixc, *pixct;
+L_PIXAC_CACHE  *cache;
+
+    PROCNAME("pixacompCacheCompress");
+
+    cache = pixac->cache;
+    if (!cache->pending[aindex])
+        return 0;
+    pixc = pixac->pixc[aindex];
+    if ((pixct = pixcompCreateFromPix(cache->pix[aindex],
+                                      pixc->comptype)) == NULL)
+        return ERROR_INT("pixc not made", procName, 1);
+    pixc->data = pixct->data;
+    pixc->size = pixct->size;
+    pixct->data = NULL;
+    pixcompDestroy(&pixct);
+    cache->pending[aindex] = 0;
+    return 0;
+}
+
+
+/*!
+ * \brief   pixacompCacheDestroy()
+ *
+ * \param[in]    pixac
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Any pixc whose data is pending should be compressed first.
+ * </pre>
+ */
+static void
+pixacompCacheDestroy(PIXAC  *pixac)
+{
+l_int32         i;
+L_PIXAC_CACHE  *cache;
+
+    if ((cache = pixac->cache) == NULL)
+        return;
+    for (i = 0; i < cache->nalloc; i++)
+        pixDestroy(&cache->pix[i]);
+    LEPT_FREE(cache->pix);
+    LEPT_FREE(cache->lastuse);
+    LEPT_FREE(cache->pending);
+    LEPT_FREE(cache);
+    pixac->cache = NULL;
+    return;
+}
+
+
+/*--------------------------------------------------------------------*
+ *                     Pixacomp indexed file I/O                      *
+ *--------------------------------------------------------------------*/
+/*!
+ * \brief   pixacompReadIndexed()
+ *
+ * \param[in]    filename indexed pixacomp file
+ * \return  pixac, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The indexed pixacomp file has a header line, followed by the
+ *          compressed data of each pixcomp, followed by an index that
+ *          gives the location, size and format of the data for each
+ *          pixcomp, and the boxa.  The last line of the file gives
+ *          the location of the index.
+ *      (2) Only the index is read.  The returned pixac keeps the file
+ *          open, and the data for a pixcomp is read from the file when
+ *          it is needed: pixacompGetPix() reads and decodes the data
+ *          for one pix without keeping it, and pixacompGetPixcomp()
+ *          reads the data and keeps it in the pixac.  The time to get
+ *          any pix is independent of its index and of the file size.
+ *      (3) The file is closed by pixacompDestroy().
+ * </pre>
+ */
+PIXAC *
+pixacompReadIndexed(const char  *filename)
+{
+size_t  indexloc;
+FILE   *fp;
+PIXAC  *pixac;
+
+    PROCNAME("pixacompReadIndexed");
+
+    if (!filename)
+        return (PIXAC *)ERROR_PTR("filename not defined", procName, NULL);
+    if ((fp = fopenReadStream(filename)) == NULL)
+        return (PIXAC *)ERROR_PTR("stream not opened", procName, NULL);
+
+    if ((pixac = pixacompReadIndexedStream(fp, &indexloc)) == NULL) {
+        fclose(fp);
+        return (PIXAC *)ERROR_PTR("pixac not read", procName, NULL);
+    }
+    pixac->fp = fp;
+    return pixac;
+}
+
+
+/*!
+ * \brief   pixacompWriteIndexed()
+ *
+ * \param[in]    filename
+ * \param[in]    pixac
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Writes %pixac as an indexed pixacomp file.  See
+ *          pixacompReadIndexed() for the format.
+ *      (2) As with pixacompWrite(), the compressed data is written
+ *          without decoding, so no imaging libraries are required.
+ * </pre>
+ */
+l_int32
+pixacompWriteIndexed(const char  *filename,
+                     PIXAC       *pixac)
+{
+l_int32  ret;
+FILE    *fp;
+PIXAC   *pixacm;
+
+    PROCNAME("pixacompWriteIndexed");
+
+    if (!filename)
+        return ERROR_INT("filename not defined", procName, 1);
+    if (!pixac)
+        return ERROR_INT("pixacomp not defined", procName, 1);
+
+    if ((fp = fopenWriteStream(filename, "wb")) == NULL)
+        return ERROR_INT("stream not opened", procName, 1);
+    fprintf(fp, "\nPixacomp Indexed Version %d\n", PIXACOMP_INDEXED_VERSION);
+
+        /* Write the data, then an index with the data locations */
+    pixacm = pixacompCreate(pixac->n);
+    pixacm->daloc = l_dnaCreate(pixac->n);
+    pixacompSetOffset(pixacm, pixac->offset);
+    ret = pixacompWriteIndexedData(fp, pixac, pixacm);
+    boxaJoin(pixacm->boxa, pixac->boxa, 0, -1);
+    if (!ret)
+        ret = pixacompWriteIndexedTable(fp, pixacm);
+    fclose(fp);
+    pixacompDestroy(&pixacm);
+    if (ret)
+        return ERROR_INT("pixacomp not written to file", procName, 1);
+    return 0;
+}
+
+
+/*!
+ * \brief   pixacompAppendIndexed()
+ *
+ * \param[in]    filename existing indexed pixacomp file
+ * \param[in]    pixac to be appended
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The data of each pixcomp in %pixac is written over the old
+ *          index of the file, and a new index is written after it.
+ *          Nothing else in the file is read or rewritten, so the
+ *          time to append does not depend on the size of the file.
+ *      (2) The boxes of %pixac are appended to the boxa in the file.
+ *          The offset of the file is not changed.
+ *      (3) The file must already exist; make it with
+ *          pixacompWriteIndexed(), which can write an empty pixac.
+ *      (4) Do not append to a file that is held open by a pixac
+ *          from pixacompReadIndexed().
+ * </pre>
+ */
+l_int32
+pixacompAppendIndexed(const char  *filename,
+                      PIXAC       *pixac)
+{
+l_int32  ret;
+size_t   indexloc;
+FILE    *fp;
+PIXAC   *pixacm;
+
+    PROCNAME("pixacompAppendIndexed");
+
+    if (!filename)
+        return ERROR_INT("filename not defined", procName, 1);
+    if (!pixac)
+        return ERROR_INT("pixacomp not defined", procName, 1);
+
+    if ((fp = fopenWriteStream(filename, "r+b")) == NULL)
+        return ERROR_INT("stream not opened", procName, 1);
+    if ((pixacm = pixacompReadIndexedStream(fp, &indexloc)) == NULL) {
+        fclose(fp);
+        return ERROR_INT("index not read", procName, 1);
+    }
+
+    if (fseek(fp, indexloc, SEEK_SET) != 0) {
+        ret = 1;
+    } else {
+        ret = pixacompWriteIndexedData(fp, pixac, pixacm);
+        boxaJoin(pixacm->boxa, pixac->boxa, 0, -1);
+        if (!ret)
+            ret = pixacompWriteIndexedTable(fp, pixacm);
+    }
+    fclose(fp);
+    pixacompDestroy(&pixacm);
+    if (ret)
+        return ERROR_INT("pixacomp not appended to file", procName, 1);
+    return 0;
+}
+
+
+/*!
+ * \brief   pixacompReadIndexedStream()
+ *
+ * \param[in]    fp stream of indexed pixacomp file
+ * \param[out]   pindexloc location of the index in the file
+ * \return  pixac, without compressed data, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each pixcomp in the returned pixac has all fields except
+ *          the data, and pixac->daloc holds the location of the data
+ *          in the file.
+ * </pre>
+ */
+static PIXAC *
+pixacompReadIndexedStream(FILE    *fp,
+                          size_t  *pindexloc)
+{
+char           buf[64];
+l_int32        i, n, offset, version, ignore;
+l_int32        w, h, d, comptype, cmapflag, xres, yres;
+unsigned long  loc, indexloc, size;
+BOXA          *boxa;
+PIXC          *pixc;
+PIXAC         *pixac;
+
+    PROCNAME("pixacompReadIndexedStream");
+
+    *pindexloc = 0;
+    rewind(fp);
+    if (fscanf(fp, "\nPixacomp Indexed Version %d\n", &version) != 1)
+        return (PIXAC *)ERROR_PTR("not an indexed pixacomp file",
+                                  procName, NULL);
+    if (version != PIXACOMP_INDEXED_VERSION)
+        return (PIXAC *)ERROR_PTR("invalid pixacomp version", procName, NULL);
+
+        /* The last line gives the location of the index */
+    if (fseek(fp, -PIXACOMP_INDEX_TRAILER_SIZE, SEEK_END) != 0 ||
+        fread(buf, 1, PIXACOMP_INDEX_TRAILER_SIZE, fp) !=
+            PIXACOMP_INDEX_TRAILER_SIZE)
+        return (PIXAC *)ERROR_PTR("index location not read", procName, NULL);
+    buf[PIXACOMP_INDEX_TRAILER_SIZE] = '\0';
+    if (sscanf(buf, "Pixacomp index = %lu", &indexloc) != 1)
+        return (PIXAC *)ERROR_PTR("index location not found", procName, NULL);
+    if (fseek(fp, indexloc, SEEK_SET) != 0)
+        return (PIXAC *)ERROR_PTR("invalid index location", procName, NULL);
+
+    if (fscanf(fp, "Number of pixcomp = %d\n", &n) != 1 || n < 0)
+        return (PIXAC *)ERROR_PTR("number not read", procName, NULL);
+    if (fscanf(fp, "Offset of index into array = %d\n", &offset) != 1)
+        return (PIXAC *)ERROR_PTR("offset not read", procName, NULL);
+
+    pixac = pixacompCreate(n);
+    pixac->daloc = l_dnaCreate(n);
+    pixacompSetOffset(pixac, offset);
+    for (i = 0; i < n; i++) {
+        if (fscanf(fp, "  [%d]: loc = %lu, size = %lu, w = %d, h = %d, "
+                   "d = %d\n", &ignore, &loc, &size, &w, &h, &d) != 6 ||
+            fscanf(fp, "  comptype = %d, cmapflag = %d, xres = %d, "
+                   "yres = %d\n", &comptype, &cmapflag, &xres, &yres) != 4) {
+            pixacompDestroy(&pixac);
+            return (PIXAC *)ERROR_PTR("index entry not read", procName, NULL);
+        }
+        pixc = (PIXC *)LEPT_CALLOC(1, sizeof(PIXC));
+        pixc->w = w;
+        pixc->h = h;
+        pixc->d = d;
+        pixc->xres = xres;
+        pixc->yres = yres;
+        pixc->comptype = comptype;
+        pixc->cmapflag = cmapflag;
+        pixc->size = size;
+        pixacompAddPixcomp(pixac, pixc, L_INSERT);
+        l_dnaAddNumber(pixac->daloc, loc);
+    }
+    if ((boxa = boxaReadStream(fp)) == NULL) {
+        pixacompDestroy(&pixac);
+        return (PIXAC *)ERROR_PTR("boxa not read", procName, NULL);
+    }
+    boxaDestroy(&pixac->boxa);
+    pixac->boxa = boxa;
+
+    *pindexloc = indexloc;
+    return pixac;
+}
+
+
+/*!
+ * \brief   pixacompWriteIndexedData()
+ *
+ * \param[in]    fp stream, positioned where the data is to be written
+ * \param[in]    pixac source of the compressed data
+ * \param[in]    pixacm index, to which an entry is added for each pixcomp
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+pixacompWriteIndexedData(FILE   *fp,
+                         PIXAC  *pixac,
+                         PIXAC  *pixacm)
+{
+l_uint8  *data;
+l_int32   i, n;
+long      loc;
+PIXC     *pixc, *pixcm;
+
+    PROCNAME("pixacompWriteIndexedData");
+
+    n = pixacompGetCount(pixac);
+    for (i = 0; i < n; i++) {
+        pixc = pixac->pixc[i];
+        if (!pixc->data && pixac->cache && pixac->cache->pending[i])
+            pixacompCacheCompress(pixac, i);
+        data = pixc->data;
+        if (!data && pixac->fp)  /* read, but don't keep */
+            data = pixacompReadIndexedData(pixac, i);
+        if (!data)
+            return ERROR_INT("data not found", procName, 1);
+        loc = ftell(fp);
+        if (fwrite(data, 1, pixc->size, fp) != pixc->size) {
+            if (data != pixc->data) LEPT_FREE(data);
+            return ERROR_INT("data not written", procName, 1);
+        }
+        fputc('\n', fp);
+        if (data != pixc->data) LEPT_FREE(data);
+
+        pixcm = (PIXC *)LEPT_CALLOC(1, sizeof(PIXC));
+        pixcm->w = pixc->w;
+        pixcm->h = pixc->h;
+        pixcm->d = pixc->d;
+        pixcm->xres = pixc->xres;
+        pixcm->yres = pixc->yres;
+        pixcm->comptype = pixc->comptype;
+        pixcm->cmapflag = pixc->cmapflag;
+        pixcm->size = pixc->size;
+        pixacompAddPixcomp(pixacm, pixcm, L_INSERT);
+        l_dnaAddNumber(pixacm->daloc, loc);
+    }
+    return 0;
+}
+
+
+/*!
+ * \brief   pixacompWriteIndexedTable()
+ *
+ * \param[in]    fp stream, positioned after the data
+ * \param[in]    pixacm index, with data locations in pixacm->daloc
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+pixacompWriteIndexedTable(FILE   *fp,
+                          PIXAC  *pixacm)
+{
+l_int32    i, n;
+l_float64  loc;
+long       indexloc;
+PIXC      *pixc;
+
+    PROCNAME("pixacompWriteIndexedTable");
+
+    if ((indexloc = ftell(fp)) < 0)
+        return ERROR_INT("stream location not found", procName, 1);
+    n = pixacompGetCount(pixacm);
+    fprintf(fp, "Number of pixcomp = %d\n", n);
+    fprintf(fp, "Offset of index into array = %d\n", pixacm->offset);
+    for (i = 0; i < n; i++) {
+        pixc = pixacm->pixc[i];
+        l_dnaGetDValue(pixacm->daloc, i, &loc);
+        fprintf(fp, "  [%d]: loc = %lu, size = %lu, w = %d, h = %d, d = %d\n",
+                i, (unsigned long)loc, (unsigned long)pixc->size,
+                pixc->w, pixc->h, pixc->d);
+        fprintf(fp, "  comptype = %d, cmapflag = %d, xres = %d, yres = %d\n",
+                pixc->comptype, pixc->cmapflag, pixc->xres, pixc->yres);
+    }
+    boxaWriteStream(fp, pixacm->boxa);
+    fprintf(fp, "\nPixacomp index = %012lu\n", (unsigned long)indexloc);
+    if (fflush(fp) != 0)
+        return ERROR_INT("index not written", procName, 1);
+    return 0;
+}
+
+
+/*!
+ * \brief   pixacompReadIndexedData()
+ *
+ * \param[in]    pixac read with pixacompReadIndexed()
+ * \param[in]    aindex array index of the pixcomp
+ * \return  compressed data, or NULL on error
+ */
+static l_uint8 *
+pixacompReadIndexedData(PIXAC   *pixac,
+                        l_int32  aindex)
+{
+l_uint8   *data;
+l_float64  loc;
+PIXC      *pixc;
+
+    PROCNAME("pixacompReadIndexedData");
+
+    if (!pixac->fp || !pixac->daloc ||
+        aindex >= l_dnaGetCount(pixac->daloc))
+        return (l_uint8 *)ERROR_PTR("data not in file", procName, NULL);
+
+    pixc = pixac->pixc[aindex];
+    l_dnaGetDValue(pixac->daloc, aindex, &loc);
+    if (fseek(pixac->fp, (long)loc, SEEK_SET) != 0)
+        return (l_uint8 *)ERROR_PTR("invalid data location", procName, NULL);
+    if ((data = (l_uint8 *)LEPT_CALLOC(pixc->size + 1, 1)) == NULL)
+        return (l_uint8 *)ERROR_PTR("data not made", procName, NULL);
+    if (fread(data, 1, pixc->size, pixac->fp) != pixc->size) {
+        LEPT_FREE(data);
+        return (l_uint8 *)ERROR_PTR("data not read", procName, NULL);
+    }
+    return data;
+}
+
+
 /*--------------------------------------------------------------------*
  *                         Conversion to pdf                          *
  *--------------------------------------------------------------------*/
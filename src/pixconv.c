@@ -740,6 +740,8 @@ pixConvertRGBToLuminance(PIX *pixs)
  * <pre>
  * Notes:
  *      (1) Use a weighted average of the RGB values.
+ *      (2) The conversion is done in fixed-point, a row at a time,
+ *          by convertRGBLineToGray().
  * </pre>
  */
 PIX *
@@ -748,8 +750,7 @@ pixConvertRGBToGray(PIX       *pixs,
                     l_float32  gwt,
                     l_float32  bwt)
 {
-l_int32    i, j, w, h, wpls, wpld, val;
-l_uint32   word;
+l_int32    i, w, h, wpls, wpld;
 l_uint32  *datas, *lines, *datad, *lined;
 l_float32  sum;
 PIX       *pixd;
@@ -791,13 +792,7 @@ PIX       *pixd;
     for (i = 0; i < h; i++) {
         lines = datas + i * wpls;
         lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            word = *(lines + j);
-            val = (l_int32)(rwt * ((word >> L_RED_SHIFT) & 0xff) +
-                            gwt * ((word >> L_GREEN_SHIFT) & 0xff) +
-                            bwt * ((word >> L_BLUE_SHIFT) & 0xff) + 0.5);
-            SET_DATA_BYTE(lined, j, val);
-        }
+        convertRGBLineToGray(lines, w, rwt, gwt, bwt, lined);
     }
 
     return pixd;
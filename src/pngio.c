@@ -30,6 +30,7 @@
  *
  *    Read png from file
  *          PIX        *pixReadStreamPng()
+ *          static PIX *pixReadPngGeneric()
  *          l_int32     readHeaderPng()
  *          l_int32     freadHeaderPng()
  *          l_int32     readHeaderMemPng()
@@ -40,6 +41,7 @@
  *    Write png to file
  *          l_int32     pixWritePng()  [ special top level ]
  *          l_int32     pixWriteStreamPng()
+ *          static l_int32  pixWritePngGeneric()
  *          l_int32     pixSetZlibCompression()
  *
  *    Setting flag for special read mode
@@ -48,6 +50,9 @@
  *    Read/write to memory
  *          PIX        *pixReadMemPng()
  *          l_int32     pixWriteMemPng()
+ *          static void pngReadMemFunc()
+ *          static void pngWriteMemFunc()
+ *          static void pngFlushMemFunc()
  *
  *    Documentation: libpng.txt and example.c
  *
@@ -95,10 +100,10 @@
  *    Note: results can be non-deterministic if used with
  *    multi-threaded applications.
  *
- *    On systems like windows without fmemopen() and open_memstream(),
- *    we write data to a temp file and read it back for operations
- *    between pix and compressed-data, such as pixReadMemPng() and
- *    pixWriteMemPng().
+ *    Reading and writing png in memory, with pixReadMemPng() and
+ *    pixWriteMemPng(), uses libpng read and write callbacks on the
+ *    caller's buffer.  No stream or temp file is involved, so this
+ *    works the same way on all platforms.
  * </pre>
  */
 
@@ -132,6 +137,28 @@ static l_int32   var_PNG_STRIP_16_TO_8 = 1;
 #define  DEBUG_WRITE    0
 #endif  /* ~NO_CONSOLE_IO */
 
+static void pngConvertLine(l_uint32 *lined, l_uint32 *lines, l_int32 wpl,
+                           l_int32 invert);
+
+    /*! Memory source or sink for png data, used in place of a stream */
+typedef struct L_PngMemIO
+{
+    const l_uint8  *cdata;    /*!< encoded data being read                */
+    l_uint8        *data;     /*!< encoded data being written             */
+    size_t          size;     /*!< bytes to be read, or bytes written     */
+    size_t          nalloc;   /*!< allocated size of the write buffer     */
+    size_t          pos;      /*!< current location for reading           */
+} L_PNG_MEMIO;
+
+static PIX *pixReadPngGeneric(FILE *fp, L_PNG_MEMIO *mio);
+static l_int32 pixWritePngGeneric(FILE *fp, L_PNG_MEMIO *mio, PIX *pix,
+                                  l_float32 gamma);
+static void pngReadMemFunc(png_structp png_ptr, png_bytep outdata,
+                           png_size_t nbytes);
+static void pngWriteMemFunc(png_structp png_ptr, png_bytep indata,
+                            png_size_t nbytes);
+static void pngFlushMemFunc(png_structp png_ptr);
+
 
 /*---------------------------------------------------------------------*
  *                              Reading png                            *
@@ -158,41 +185,63 @@ static l_int32   var_PNG_STRIP_16_TO_8 = 1;
  *              Transparency is usually associated with the white background.
  *          (c) spp = 1, d = 8 with colormap and alpha in the trans array.
  *              Each color in the colormap has a separate transparency value.
- *      (4) We use the high level png interface, where the transforms are set
- *          up in advance and the header and image are read with a single
- *          call.  The more complicated interface, where the header is
- *          read first and the buffers for the raster image are user-
- *          allocated before reading the image, works for single images,
- *          but I could not get it to work properly for the successive
- *          png reads that are required by pixaReadStream().
+ *      (4) We use the progressive png interface: the header is read
+ *          first, the transforms are set up so that libpng delivers
+ *          each row in the layout of the pix raster, and the rows are
+ *          decoded one at a time directly into the pix.  There is no
+ *          intermediate copy of the image held by libpng, so the peak
+ *          memory is about the size of the pix.  Interlaced images are
+ *          decoded the same way, with each pass combined into the pix.
  * </pre>
  */
 PIX *
 pixReadStreamPng(FILE  *fp)
 {
-l_uint8      byte;
-l_int32      rval, gval, bval;
-l_int32      i, j, k, index, ncolors, bitval;
-l_int32      wpl, d, spp, cindex, tRNS;
-l_uint32     png_transforms;
-l_uint32    *data, *line, *ppixel;
-int          num_palette, num_text, num_trans;
-png_byte     bit_depth, color_type, channels;
-png_uint_32  w, h, rowbytes;
-png_uint_32  xres, yres;
-png_bytep    rowptr, trans;
-png_bytep   *row_pointers;
-png_structp  png_ptr;
-png_infop    info_ptr, end_info;
-png_colorp   palette;
-png_textp    text_ptr;  /* ptr to text_chunk */
-PIX         *pix, *pixt;
-PIXCMAP     *cmap;
-
     PROCNAME("pixReadStreamPng");
 
     if (!fp)
         return (PIX *)ERROR_PTR("fp not defined", procName, NULL);
+    return pixReadPngGeneric(fp, NULL);
+}
+
+
+/*!
+ * \brief   pixReadPngGeneric()
+ *
+ * \param[in]    fp [optional] file stream
+ * \param[in]    mio [optional] memory source; use if %fp is null
+ * \return  pix, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The png data is taken from %fp or, for reading from memory,
+ *          directly from the caller's buffer through a libpng read
+ *          callback.  See pixReadStreamPng() for the decoding.
+ * </pre>
+ */
+static PIX *
+pixReadPngGeneric(FILE         *fp,
+                  L_PNG_MEMIO  *mio)
+{
+l_int32       i, pass, npasses, wpl, d, spp, tRNS, invert, swap;
+l_int32       rval, gval, bval, cindex;
+l_uint32     *data, *line;
+int           num_palette, num_text;
+png_byte      bit_depth, color_type;
+png_uint_32   w, h, rowbytes;
+png_uint_32   xres, yres;
+png_structp   png_ptr;
+png_infop     info_ptr, end_info;
+png_colorp    palette;
+png_textp     text_ptr;  /* ptr to text_chunk */
+PIX *volatile pix;  /* must survive a longjmp from libpng */
+PIX          *pixt;
+PIXCMAP      *cmap;
+
+    PROCNAME("pixReadPngGeneric");
+
+    if (!fp && !mio)
+        return (PIX *)ERROR_PTR("no source defined", procName, NULL);
     pix = NULL;
 
         /* Allocate the 3 data structures */
@@ -212,55 +261,93 @@ PIXCMAP     *cmap;
 
         /* Set up png setjmp error handling */
     if (setjmp(png_jmpbuf(png_ptr))) {
+        pixt = pix;
+        pixDestroy(&pixt);
         png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
         return (PIX *)ERROR_PTR("internal png error", procName, NULL);
     }
 
-    png_init_io(png_ptr, fp);
+    if (fp)
+        png_init_io(png_ptr, fp);
+    else
+        png_set_read_fn(png_ptr, mio, pngReadMemFunc);
+    png_read_info(png_ptr, info_ptr);
+    bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+    color_type = png_get_color_type(png_ptr, info_ptr);
+    tRNS = png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS) ? 1 : 0;
 
         /* ---------------------------------------------------------- *
-         *  Set the transforms flags.  Whatever happens here,
-         *  NEVER invert 1 bpp using PNG_TRANSFORM_INVERT_MONO.
-         *  Also, do not use PNG_TRANSFORM_EXPAND, which would
-         *  expand all images with bpp < 8 to 8 bpp.
+         *  Set the transforms, so that libpng delivers each row in
+         *  the layout of the pix raster.  Whatever happens here,
+         *  NEVER invert 1 bpp using png_set_invert_mono().
+         *  Also, do not use png_set_expand() on gray or opaque
+         *  palette images, which would expand all images with
+         *  bpp < 8 to 8 bpp.
          * ---------------------------------------------------------- */
-        /* To strip 16 --> 8 bit depth, use PNG_TRANSFORM_STRIP_16 */
+        /* To strip 16 --> 8 bit depth, use png_set_strip_16() */
     if (var_PNG_STRIP_16_TO_8 == 1) {  /* our default */
-        png_transforms = PNG_TRANSFORM_STRIP_16;
+        if (bit_depth == 16) {
+            png_set_strip_16(png_ptr);
+            bit_depth = 8;
+        }
     } else {
-        png_transforms = PNG_TRANSFORM_IDENTITY;
         L_INFO("not stripping 16 --> 8 in png reading\n", procName);
     }
 
-        /* Read it */
-    png_read_png(png_ptr, info_ptr, png_transforms, NULL);
-
-    row_pointers = png_get_rows(png_ptr, info_ptr);
-    w = png_get_image_width(png_ptr, info_ptr);
-    h = png_get_image_height(png_ptr, info_ptr);
-    bit_depth = png_get_bit_depth(png_ptr, info_ptr);
-    rowbytes = png_get_rowbytes(png_ptr, info_ptr);
-    color_type = png_get_color_type(png_ptr, info_ptr);
-    channels = png_get_channels(png_ptr, info_ptr);
-    spp = channels;
-    tRNS = png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS) ? 1 : 0;
-
-    if (spp == 1) {
-        d = bit_depth;
-    } else {  /* spp == 2 (gray + alpha), spp == 3 (rgb), spp == 4 (rgba) */
-        d = 4 * bit_depth;
-    }
-
         /* Remove if/when this is implemented for all bit_depths */
-    if (spp == 3 && bit_depth != 8) {
-        fprintf(stderr, "Help: spp = 3 and depth = %d != 8\n!!", bit_depth);
+    if ((color_type & PNG_COLOR_MASK_COLOR ||
+         color_type & PNG_COLOR_MASK_ALPHA) && bit_depth != 8 &&
+         color_type != PNG_COLOR_TYPE_PALETTE) {
+        fprintf(stderr, "Help: color or alpha with depth = %d != 8\n!!",
+                bit_depth);
         png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
         return (PIX *)ERROR_PTR("not implemented for this depth",
             procName, NULL);
     }
 
-    if (color_type == PNG_COLOR_TYPE_PALETTE ||
-        color_type == PNG_COLOR_MASK_PALETTE) {   /* generate a colormap */
+        /* Any image with alpha is read into a 32 bpp RGBA pix, and
+         * any rgb image into a 32 bpp pix.  The samples are ordered
+         * so that each pixel is a single 32 bit word in the raster. */
+    if (color_type == PNG_COLOR_TYPE_PALETTE && tRNS) {
+        L_INFO("converting (cmap + alpha) ==> RGBA\n", procName);
+        png_set_palette_to_rgb(png_ptr);
+        png_set_tRNS_to_alpha(png_ptr);
+        spp = 4;
+    } else if (color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
+        L_INFO("converting (gray + alpha) ==> RGBA\n", procName);
+        png_set_gray_to_rgb(png_ptr);
+        spp = 4;
+    } else if (color_type == PNG_COLOR_TYPE_RGB_ALPHA) {
+        spp = 4;
+    } else if (color_type == PNG_COLOR_TYPE_RGB) {
+        spp = 3;
+    } else {  /* gray or palette, with one sample/pixel */
+        spp = 1;
+    }
+    if (spp == 3) {
+#ifdef L_BIG_ENDIAN
+        png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
+#else
+        png_set_bgr(png_ptr);
+        png_set_filler(png_ptr, 0, PNG_FILLER_BEFORE);
+#endif  /* L_BIG_ENDIAN */
+    } else if (spp == 4) {
+#ifndef L_BIG_ENDIAN
+        png_set_bgr(png_ptr);
+        png_set_swap_alpha(png_ptr);
+#endif  /* ~L_BIG_ENDIAN */
+    }
+
+        /* Interlaced images are read in 7 passes over the raster */
+    npasses = png_set_interlace_handling(png_ptr);
+    png_read_update_info(png_ptr, info_ptr);
+    w = png_get_image_width(png_ptr, info_ptr);
+    h = png_get_image_height(png_ptr, info_ptr);
+    rowbytes = png_get_rowbytes(png_ptr, info_ptr);
+    d = (spp == 1 && !tRNS) ? bit_depth : 32;
+
+    if (color_type == PNG_COLOR_TYPE_PALETTE && !tRNS) {
+            /* Generate a colormap */
         png_get_PLTE(png_ptr, info_ptr, &palette, &num_palette);
         cmap = pixcmapCreate(d);  /* spp == 1 */
         for (cindex = 0; cindex < num_palette; cindex++) {
@@ -274,6 +361,7 @@ PIXCMAP     *cmap;
     }
 
     if ((pix = pixCreate(w, h, d)) == NULL) {
+        pixcmapDestroy(&cmap);
         png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
         return (PIX *)ERROR_PTR("pix not made", procName, NULL);
     }
@@ -281,158 +369,49 @@ PIXCMAP     *cmap;
     wpl = pixGetWpl(pix);
     data = pixGetData(pix);
     pixSetColormap(pix, cmap);
-    pixSetSpp(pix, spp);
+    pixSetSpp(pix, (spp == 1 && tRNS) ? 4 : spp);
+    if (rowbytes > 4 * wpl) {
+        pixt = pix;
+        pixDestroy(&pixt);
+        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+        return (PIX *)ERROR_PTR("png row exceeds pix line", procName, NULL);
+    }
 
-    if (spp == 1 && !tRNS) {  /* copy straight from buffer to pix */
+        /* Decode each row directly into its line in the pix.  Packed
+         * 1 spp rows are in png byte order and are put into pix word
+         * order after the last pass.  For bpp = 1, if there is no
+         * colormap, the image must be inverted because png stores
+         * black pixels as 0.  Note that we cannot use the
+         * PNG_TRANSFORM_INVERT_MONO flag to do the inversion, because
+         * that flag (since version 1.0.9) inverts 8 bpp grayscale
+         * as well, which we don't want to do.  (It also doesn't
+         * work if there is a colormap.) */
+    swap = (d < 32) ? 1 : 0;
+    invert = (d == 1 && !cmap) ? 1 : 0;
+    for (pass = 0; pass < npasses; pass++) {
         for (i = 0; i < h; i++) {
             line = data + i * wpl;
-            rowptr = row_pointers[i];
-            for (j = 0; j < rowbytes; j++) {
-                    SET_DATA_BYTE(line, j, rowptr[j]);
-            }
-        }
-    } else if (spp == 2) {  /* grayscale + alpha; convert to RGBA */
-        L_INFO("converting (gray + alpha) ==> RGBA\n", procName);
-        for (i = 0; i < h; i++) {
-            ppixel = data + i * wpl;
-            rowptr = row_pointers[i];
-            for (j = k = 0; j < w; j++) {
-                    /* Copy gray value into r, g and b */
-                SET_DATA_BYTE(ppixel, COLOR_RED, rowptr[k]);
-                SET_DATA_BYTE(ppixel, COLOR_GREEN, rowptr[k]);
-                SET_DATA_BYTE(ppixel, COLOR_BLUE, rowptr[k++]);
-                SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL, rowptr[k++]);
-                ppixel++;
-            }
-        }
-        pixSetSpp(pix, 4);  /* we do not support 2 spp pix */
-    } else if (spp == 3 || spp == 4) {
-        for (i = 0; i < h; i++) {
-            ppixel = data + i * wpl;
-            rowptr = row_pointers[i];
-            for (j = k = 0; j < w; j++) {
-                SET_DATA_BYTE(ppixel, COLOR_RED, rowptr[k++]);
-                SET_DATA_BYTE(ppixel, COLOR_GREEN, rowptr[k++]);
-                SET_DATA_BYTE(ppixel, COLOR_BLUE, rowptr[k++]);
-                if (spp == 4)
-                    SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL, rowptr[k++]);
-                ppixel++;
-            }
+            png_read_row(png_ptr, (png_bytep)line, NULL);
+            if (pass < npasses - 1)
+                continue;
+            if (swap)
+                pngConvertLine(line, line, wpl, invert);
         }
     }
+    png_read_end(png_ptr, info_ptr);
+    if (invert)
+        pixSetPadBits(pix, 0);
 
-        /* Special spp == 1 cases with transparency:
-         *    (1) 8 bpp without colormap; assume full transparency
-         *    (2) 1 bpp with colormap + trans array (for alpha)
-         *    (3) 8 bpp with colormap + trans array (for alpha)
-         * These all require converting to RGBA */
+        /* Special case: spp == 1, no colormap, with transparency.
+         * Convention is to make a fully transparent RGBA image. */
     if (spp == 1 && tRNS) {
-        if (!cmap) {
-                /* Case 1: make fully transparent RGBA image */
-            L_INFO("transparency, 1 spp, no colormap, no transparency array: "
-                   "convention is fully transparent image\n", procName);
-            L_INFO("converting (fully transparent 1 spp) ==> RGBA\n", procName);
-            pixDestroy(&pix);
-            pix = pixCreate(w, h, 32);  /* init to alpha = 0 (transparent) */
-            pixSetSpp(pix, 4);
-        } else {
-            L_INFO("converting (cmap + alpha) ==> RGBA\n", procName);
-
-                /* Grab the transparency array */
-            png_get_tRNS(png_ptr, info_ptr, &trans, &num_trans, NULL);
-            if (!trans) {  /* invalid png file */
-                pixDestroy(&pix);
-                png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
-                return (PIX *)ERROR_PTR("cmap, tRNS, but no transparency array",
-                                        procName, NULL);
-            }
-
-                /* Save the cmap and destroy the pix */
-            cmap = pixcmapCopy(pixGetColormap(pix));
-            ncolors = pixcmapGetCount(cmap);
-            pixDestroy(&pix);
-
-                /* Start over with 32 bit RGBA */
-            pix = pixCreate(w, h, 32);
-            wpl = pixGetWpl(pix);
-            data = pixGetData(pix);
-            pixSetSpp(pix, 4);
-
-#if DEBUG_READ
-            fprintf(stderr, "ncolors = %d, num_trans = %d\n",
-                    ncolors, num_trans);
-            for (i = 0; i < ncolors; i++) {
-                pixcmapGetColor(cmap, i, &rval, &gval, &bval);
-                if (i < num_trans) {
-                    fprintf(stderr, "(r,g,b,a) = (%d,%d,%d,%d)\n",
-                            rval, gval, bval, trans[i]);
-                } else {
-                    fprintf(stderr, "(r,g,b,a) = (%d,%d,%d,<<255>>)\n",
-                            rval, gval, bval);
-                }
-            }
-#endif  /* DEBUG_READ */
-
-                /* Extract the data and convert to RGBA */
-            if (d == 1) {
-                    /* Case 2: 1 bpp with transparency (usually) behind white */
-                L_INFO("converting 1 bpp cmap with alpha ==> RGBA\n", procName);
-                if (num_trans == 1)
-                    L_INFO("num_trans = 1; second color opaque by default\n",
-                           procName);
-                for (i = 0; i < h; i++) {
-                    ppixel = data + i * wpl;
-                    rowptr = row_pointers[i];
-                    for (j = 0, index = 0; j < rowbytes; j++) {
-                        byte = rowptr[j];
-                        for (k = 0; k < 8 && index < w; k++, index++) {
-                            bitval = (byte >> (7 - k)) & 1;
-                            pixcmapGetColor(cmap, bitval, &rval, &gval, &bval);
-                            composeRGBPixel(rval, gval, bval, ppixel);
-                            SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL,
-                                      bitval < num_trans ? trans[bitval] : 255);
-                            ppixel++;
-                        }
-                    }
-                }
-            } else if (d == 8) {
-                    /* Case 3: 8 bpp with cmap and associated transparency */
-                L_INFO("converting 8 bpp cmap with alpha ==> RGBA\n", procName);
-                for (i = 0; i < h; i++) {
-                    ppixel = data + i * wpl;
-                    rowptr = row_pointers[i];
-                    for (j = 0; j < w; j++) {
-                        index = rowptr[j];
-                        pixcmapGetColor(cmap, index, &rval, &gval, &bval);
-                        composeRGBPixel(rval, gval, bval, ppixel);
-                            /* Assume missing entries to be 255 (opaque)
-                             * according to the spec:
-                             * http://www.w3.org/TR/PNG/#11tRNS */
-                        SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL,
-                                      index < num_trans ? trans[index] : 255);
-                        ppixel++;
-                    }
-                }
-            } else {
-                L_ERROR("spp == 1, cmap, trans array, invalid depth: %d\n",
-                        procName, d);
-            }
-            pixcmapDestroy(&cmap);
-        }
-    }
-
-#if  DEBUG_READ
-    if (cmap) {
-        for (i = 0; i < 16; i++) {
-            fprintf(stderr, "[%d] = %d\n", i,
-                   ((l_uint8 *)(cmap->array))[i]);
-        }
+        L_INFO("transparency, 1 spp, no colormap, no transparency array: "
+               "convention is fully transparent image\n", procName);
+        L_INFO("converting (fully transparent 1 spp) ==> RGBA\n", procName);
+        pixClearAll(pix);  /* alpha = 0 (transparent) */
     }
-#endif  /* DEBUG_READ */
 
-        /* Final adjustments for bpp = 1.
-         *   + If there is no colormap, the image must be inverted because
-         *     png stores black pixels as 0.
+        /* Final adjustment for bpp = 1.
          *   + We have already handled the case of cmapped, 1 bpp pix
          *     with transparency, where the output pix is 32 bpp RGBA.
          *     If there is no transparency but the pix has a colormap,
@@ -441,25 +420,11 @@ PIXCMAP     *cmap;
          *   + The colormap must be removed in such a way that the pixel
          *     values are not changed.  If the values are only black and
          *     white, we return a 1 bpp image; if gray, return an 8 bpp pix;
-         *     otherwise, return a 32 bpp rgb pix.
-         *
-         * Note that we cannot use the PNG_TRANSFORM_INVERT_MONO flag
-         * to do the inversion, because that flag (since version 1.0.9)
-         * inverts 8 bpp grayscale as well, which we don't want to do.
-         * (It also doesn't work if there is a colormap.)
-         *
-         * Note that if the input png is a 1-bit with colormap and
-         * transparency, it has already been rendered as a 32 bpp,
-         * spp = 4 rgba pix.
-         */
-    if (pixGetDepth(pix) == 1) {
-        if (!cmap) {
-            pixInvert(pix, pix);
-        } else {
-            pixt = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC);
-            pixDestroy(&pix);
-            pix = pixt;
-        }
+         *     otherwise, return a 32 bpp rgb pix. */
+    if (pixGetDepth(pix) == 1 && cmap) {
+        pixt = pix;
+        pix = pixRemoveColormap(pixt, REMOVE_CMAP_BASED_ON_SRC);
+        pixDestroy(&pixt);
     }
 
     xres = png_get_x_pixels_per_meter(png_ptr, info_ptr);
@@ -987,10 +952,42 @@ l_int32
 pixWriteStreamPng(FILE      *fp,
                   PIX       *pix,
                   l_float32  gamma)
+{
+    PROCNAME("pixWriteStreamPng");
+
+    if (!fp)
+        return ERROR_INT("stream not open", procName, 1);
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 1);
+    return pixWritePngGeneric(fp, NULL, pix, gamma);
+}
+
+
+/*!
+ * \brief   pixWritePngGeneric()
+ *
+ * \param[in]    fp [optional] file stream
+ * \param[in]    mio [optional] memory sink; use if %fp is null
+ * \param[in]    pix
+ * \param[in]    gamma use 0.0 if gamma is not defined
+ * \return  0 if OK; 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The png data is written to %fp or, for writing to memory,
+ *          appended by a libpng write callback to a buffer that is
+ *          returned to the caller.  See pixWriteStreamPng() for usage.
+ * </pre>
+ */
+static l_int32
+pixWritePngGeneric(FILE         *fp,
+                   L_PNG_MEMIO  *mio,
+                   PIX          *pix,
+                   l_float32     gamma)
 {
 char         commentstring[] = "Comment";
-l_int32      i, j, k;
-l_int32      wpl, d, spp, cmflag, opaque;
+l_int32      i;
+l_int32      wpl, d, spp, cmflag, opaque, invert, lastbits;
 l_int32      ncolors, compval;
 l_int32     *rmap, *gmap, *bmap, *amap;
 l_uint32    *data, *ppixel;
@@ -998,19 +995,17 @@ png_byte     bit_depth, color_type;
 png_byte     alpha[256];
 png_uint_32  w, h;
 png_uint_32  xres, yres;
-png_bytep   *row_pointers;
 png_bytep    rowbuffer;
 png_structp  png_ptr;
 png_infop    info_ptr;
 png_colorp   palette;
-PIX         *pixt;
 PIXCMAP     *cmap;
 char        *text;
 
-    PROCNAME("pixWriteStreamPng");
+    PROCNAME("pixWritePngGeneric");
 
-    if (!fp)
-        return ERROR_INT("stream not open", procName, 1);
+    if (!fp && !mio)
+        return ERROR_INT("no sink defined", procName, 1);
     if (!pix)
         return ERROR_INT("pix not defined", procName, 1);
 
@@ -1030,7 +1025,10 @@ char        *text;
         return ERROR_INT("internal png error", procName, 1);
     }
 
-    png_init_io(png_ptr, fp);
+    if (fp)
+        png_init_io(png_ptr, fp);
+    else
+        png_set_write_fn(png_ptr, mio, pngWriteMemFunc, pngFlushMemFunc);
 
         /* With best zlib compression (9), get between 1 and 10% improvement
          * over default (6), but the compression is 3 to 10 times slower.
@@ -1134,47 +1132,15 @@ char        *text;
         /* Write header and palette info */
     png_write_info(png_ptr, info_ptr);
 
-    if ((d != 32) && (d != 24)) {  /* not rgb color */
-            /* Generate a temporary pix with bytes swapped.
-             * For writing a 1 bpp image as png:
-             *    ~ if no colormap, invert the data, because png writes
-             *      black as 0
-             *    ~ if colormapped, do not invert the data; the two RGBA
-             *      colors can have any value.  */
-        if (d == 1 && !cmap) {
-            pixt = pixInvert(NULL, pix);
-            pixEndianByteSwap(pixt);
-        } else {
-            pixt = pixEndianByteSwapNew(pix);
-        }
-        if (!pixt) {
-            png_destroy_write_struct(&png_ptr, &info_ptr);
-            return ERROR_INT("pixt not made", procName, 1);
-        }
-
-            /* Make and assign array of image row pointers */
-        if ((row_pointers = (png_bytep *)LEPT_CALLOC(h, sizeof(png_bytep)))
-            == NULL)
-            return ERROR_INT("row-pointers not made", procName, 1);
-        wpl = pixGetWpl(pixt);
-        data = pixGetData(pixt);
-        for (i = 0; i < h; i++)
-            row_pointers[i] = (png_bytep)(data + i * wpl);
-        png_set_rows(png_ptr, info_ptr, row_pointers);
-
-            /* Transfer the data */
-        png_write_image(png_ptr, row_pointers);
-        png_write_end(png_ptr, info_ptr);
-
-        if (cmflag)
-            LEPT_FREE(palette);
-        LEPT_FREE(row_pointers);
-        pixDestroy(&pixt);
-        png_destroy_write_struct(&png_ptr, &info_ptr);
-        return 0;
-    }
-
-        /* For rgb, compose and write a row at a time */
+        /* The raster is streamed a row at a time.  Rgb and rgba
+         * rows are handed to libpng straight from the pix, and it
+         * drops or reorders the samples.  Other rows are converted to
+         * png byte order in a single line buffer.  For writing a 1 bpp
+         * image as png:
+         *    ~ if no colormap, invert the data, because png writes
+         *      black as 0
+         *    ~ if colormapped, do not invert the data; the two RGBA
+         *      colors can have any value.  */
     data = pixGetData(pix);
     wpl = pixGetWpl(pix);
     if (d == 24) {  /* See note 7 above: special case of 24 bpp rgb */
@@ -1182,22 +1148,35 @@ char        *text;
             ppixel = data + i * wpl;
             png_write_rows(png_ptr, (png_bytepp)&ppixel, 1);
         }
-    } else {  /* 32 bpp rgb and rgba.  Write out the alpha channel if either
-             * the pix has 4 spp or writing it is requested anyway */
-        if ((rowbuffer = (png_bytep)LEPT_CALLOC(w, 4)) == NULL)
+    } else if (d == 32) {  /* 32 bpp rgb and rgba.  Write out the alpha
+                            * channel only if the pix has 4 spp */
+        if (spp == 4) {
+#ifndef L_BIG_ENDIAN
+            png_set_swap_alpha(png_ptr);
+            png_set_bgr(png_ptr);
+#endif  /* ~L_BIG_ENDIAN */
+        } else {
+#ifdef L_BIG_ENDIAN
+            png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
+#else
+            png_set_filler(png_ptr, 0, PNG_FILLER_BEFORE);
+            png_set_bgr(png_ptr);
+#endif  /* L_BIG_ENDIAN */
+        }
+        for (i = 0; i < h; i++)
+            png_write_row(png_ptr, (png_bytep)(data + i * wpl));
+    } else {  /* not rgb color */
+        invert = (d == 1 && !cmap) ? 1 : 0;
+        if ((rowbuffer = (png_bytep)LEPT_CALLOC(wpl, 4)) == NULL) {
+            png_destroy_write_struct(&png_ptr, &info_ptr);
             return ERROR_INT("rowbuffer not made", procName, 1);
+        }
+        lastbits = (w * d) % 8;  /* clear the png pad bits after these */
         for (i = 0; i < h; i++) {
-            ppixel = data + i * wpl;
-            for (j = k = 0; j < w; j++) {
-                rowbuffer[k++] = GET_DATA_BYTE(ppixel, COLOR_RED);
-                rowbuffer[k++] = GET_DATA_BYTE(ppixel, COLOR_GREEN);
-                rowbuffer[k++] = GET_DATA_BYTE(ppixel, COLOR_BLUE);
-                if (spp == 4)
-                    rowbuffer[k++] = GET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL);
-                ppixel++;
-            }
-
-            png_write_rows(png_ptr, &rowbuffer, 1);
+            pngConvertLine((l_uint32 *)rowbuffer, data + i * wpl, wpl, invert);
+            if (lastbits)
+                rowbuffer[(w * d) / 8] &= 0xff << (8 - lastbits);
+            png_write_row(png_ptr, rowbuffer);
         }
         LEPT_FREE(rowbuffer);
     }
@@ -1280,25 +1259,26 @@ l_pngSetReadStrip16To8(l_int32  flag)
  *
  * <pre>
  * Notes:
- *      (1) The %size byte of %data must be a null character.
+ *      (1) libpng reads the encoded data directly from %data, through
+ *          a read callback.  No stream or temp file is used.
  * </pre>
  */
 PIX *
 pixReadMemPng(const l_uint8  *data,
               size_t          size)
 {
-FILE  *fp;
-PIX   *pix;
+L_PNG_MEMIO  mio;
+PIX         *pix;
 
     PROCNAME("pixReadMemPng");
 
     if (!data)
         return (PIX *)ERROR_PTR("cdata not defined", procName, NULL);
 
-    if ((fp = fopenReadFromMemory(data, size)) == NULL)
-        return (PIX *)ERROR_PTR("stream not opened", procName, NULL);
-    pix = pixReadStreamPng(fp);
-    fclose(fp);
+    memset(&mio, 0, sizeof(L_PNG_MEMIO));
+    mio.cdata = data;
+    mio.size = size;
+    pix = pixReadPngGeneric(NULL, &mio);
     if (!pix) L_ERROR("pix not read\n", procName);
     return pix;
 }
@@ -1307,7 +1287,7 @@ PIX   *pix;
 /*!
  * \brief   pixWriteMemPng()
  *
- * \param[out]   pdata data of tiff compressed image
+ * \param[out]   pdata data of png compressed image
  * \param[out]   psize size of returned data
  * \param[in]    pix
  * \param[in]    gamma use 0.0 if gamma is not defined
@@ -1317,6 +1297,9 @@ PIX   *pix;
  * Notes:
  *      (1) See pixWriteStreamPng() for usage.  This version writes to
  *          memory instead of to a file stream.
+ *      (2) libpng hands the encoded data to a write callback, which
+ *          appends it to a buffer that grows by doubling.  The buffer
+ *          is returned without copying.  No stream or temp file is used.
  * </pre>
  */
 l_int32
@@ -1325,8 +1308,7 @@ pixWriteMemPng(l_uint8  **pdata,
                PIX       *pix,
                l_float32  gamma)
 {
-l_int32  ret;
-FILE    *fp;
+L_PNG_MEMIO  mio;
 
     PROCNAME("pixWriteMemPng");
 
@@ -1339,25 +1321,133 @@ FILE    *fp;
     if (!pix)
         return ERROR_INT("&pix not defined", procName, 1 );
 
-#if HAVE_FMEMOPEN
-    if ((fp = open_memstream((char **)pdata, psize)) == NULL)
-        return ERROR_INT("stream not opened", procName, 1);
-    ret = pixWriteStreamPng(fp, pix, gamma);
-#else
-    L_INFO("work-around: writing to a temp file\n", procName);
-  #ifdef _WIN32
-    if ((fp = fopenWriteWinTempfile()) == NULL)
-        return ERROR_INT("tmpfile stream not opened", procName, 1);
-  #else
-    if ((fp = tmpfile()) == NULL)
-        return ERROR_INT("tmpfile stream not opened", procName, 1);
-  #endif  /* _WIN32 */
-    ret = pixWriteStreamPng(fp, pix, gamma);
-    rewind(fp);
-    *pdata = l_binaryReadStream(fp, psize);
-#endif  /* HAVE_FMEMOPEN */
-    fclose(fp);
-    return ret;
+    memset(&mio, 0, sizeof(L_PNG_MEMIO));
+    if (pixWritePngGeneric(NULL, &mio, pix, gamma)) {
+        LEPT_FREE(mio.data);
+        return ERROR_INT("png data not written", procName, 1);
+    }
+    *pdata = mio.data;
+    *psize = mio.size;
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                           Static helpers                            *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   pngConvertLine()
+ *
+ * \param[in]    lined dest line; can be the same as lines
+ * \param[in]    lines src line
+ * \param[in]    wpl number of 32 bit words in the line
+ * \param[in]    invert 1 to invert the bits; 0 otherwise
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Converts a line of packed samples between pix word order
+ *          and png byte order, in either direction.  The bytes in
+ *          each word are swapped on little-endian platforms.
+ *      (2) The inversion is for 1 bpp without a colormap, where png
+ *          stores black pixels as 0.
+ * </pre>
+ */
+static void
+pngConvertLine(l_uint32  *lined,
+               l_uint32  *lines,
+               l_int32    wpl,
+               l_int32    invert)
+{
+l_int32   j;
+l_uint32  word, mask;
+
+    mask = (invert) ? 0xffffffff : 0;
+    for (j = 0; j < wpl; j++) {
+        word = lines[j] ^ mask;
+#ifndef L_BIG_ENDIAN
+        word = (word >> 24) |
+               ((word >> 8) & 0x0000ff00) |
+               ((word << 8) & 0x00ff0000) |
+               (word << 24);
+#endif  /* ~L_BIG_ENDIAN */
+        lined[j] = word;
+    }
+}
+
+
+/*!
+ * \brief   pngReadMemFunc()
+ *
+ * \param[in]    png_ptr
+ * \param[in]    outdata destination for the png data
+ * \param[in]    nbytes number of bytes requested by libpng
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) libpng read callback for pixReadMemPng().  Reading past the
+ *          end of the data is a png error, which longjmps back to
+ *          pixReadPngGeneric().
+ * </pre>
+ */
+static void
+pngReadMemFunc(png_structp  png_ptr,
+               png_bytep    outdata,
+               png_size_t   nbytes)
+{
+L_PNG_MEMIO  *mio;
+
+    mio = (L_PNG_MEMIO *)png_get_io_ptr(png_ptr);
+    if (nbytes > mio->size - mio->pos)
+        png_error(png_ptr, "read beyond end of data");
+    memcpy(outdata, mio->cdata + mio->pos, nbytes);
+    mio->pos += nbytes;
+}
+
+
+/*!
+ * \brief   pngWriteMemFunc()
+ *
+ * \param[in]    png_ptr
+ * \param[in]    indata png data to be appended
+ * \param[in]    nbytes number of bytes in %indata
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) libpng write callback for pixWriteMemPng().  The buffer is
+ *          at least doubled each time it fills up.
+ * </pre>
+ */
+static void
+pngWriteMemFunc(png_structp  png_ptr,
+                png_bytep    indata,
+                png_size_t   nbytes)
+{
+size_t        nalloc;
+l_uint8      *data;
+L_PNG_MEMIO  *mio;
+
+    mio = (L_PNG_MEMIO *)png_get_io_ptr(png_ptr);
+    if (mio->size + nbytes > mio->nalloc) {
+        nalloc = L_MAX(2 * mio->nalloc, 4096);
+        while (nalloc < mio->size + nbytes)
+            nalloc *= 2;
+        if ((data = (l_uint8 *)LEPT_REALLOC(mio->data, nalloc)) == NULL)
+            png_error(png_ptr, "write buffer not extended");
+        mio->data = data;
+        mio->nalloc = nalloc;
+    }
+    memcpy(mio->data + mio->size, indata, nbytes);
+    mio->size += nbytes;
+}
+
+
+    /* libpng flush callback for pixWriteMemPng(); nothing to do */
+static void
+pngFlushMemFunc(png_structp  png_ptr)
+{
 }
 
 /* --------------------------------------------*/
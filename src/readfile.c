@@ -38,6 +38,8 @@
  *
  *      Read header information from file
  *           l_int32    pixReadHeader()
+ *           l_int32    pixReadHeadersSA()
+ *           static l_int32  freadHeaderInfo()
  *
  *      Format finders
  *           l_int32    findFileFormat()
@@ -94,6 +96,11 @@ static const char *FILE_GIF  =  "/tmp/lept/format/file.gif";
 static const char *FILE_WEBP =  "/tmp/lept/format/file.webp";
 static const char *FILE_JP2K =  "/tmp/lept/format/file.jp2";
 
+static l_int32 freadHeaderInfo(FILE *fp, l_int32 *pformat, l_int32 *pw,
+                               l_int32 *ph, l_int32 *pbps, l_int32 *pspp,
+                               l_int32 *piscmap, l_int32 *pres,
+                               l_int32 *pnpages);
+
 static const unsigned char JP2K_CODESTREAM[4] = { 0xff, 0x4f, 0xff, 0x51 };
 static const unsigned char JP2K_IMAGE_DATA[12] = { 0x00, 0x00, 0x00, 0x0C,
                                                    0x6A, 0x50, 0x20, 0x20,
@@ -424,9 +431,9 @@ PIX      *pix;
  *
  * <pre>
  * Notes:
- *      (1) This reads the actual headers for jpeg, png, tiff and pnm.
- *          For bmp and gif, we cheat and read the entire file into a pix,
- *          from which we extract the "header" information.
+ *      (1) This opens the file once, and reads only the headers.
+ *          For bmp and gif, the header fields are parsed directly
+ *          and the image data is never decoded.
  * </pre>
  */
 l_int32
@@ -438,10 +445,8 @@ pixReadHeader(const char  *filename,
               l_int32     *pspp,
               l_int32     *piscmap)
 {
-l_int32  format, ret, w, h, d, bps, spp, iscmap;
-l_int32  type;  /* ignored */
+l_int32  ret;
 FILE    *fp;
-PIX     *pix;
 
     PROCNAME("pixReadHeader");
 
@@ -451,39 +456,198 @@ PIX     *pix;
     if (pspp) *pspp = 0;
     if (piscmap) *piscmap = 0;
     if (pformat) *pformat = 0;
-    iscmap = 0;  /* init to false */
     if (!filename)
         return ERROR_INT("filename not defined", procName, 1);
 
     if ((fp = fopenReadStream(filename)) == NULL)
         return ERROR_INT("image file not found", procName, 1);
-    findFileFormatStream(fp, &format);
+    ret = freadHeaderInfo(fp, pformat, pw, ph, pbps, pspp, piscmap,
+                          NULL, NULL);
     fclose(fp);
+    if (ret)
+        L_ERROR("no header info read from file %s\n", procName, filename);
+    return ret;
+}
+
+
+/*!
+ * \brief   pixReadHeadersSA()
+ *
+ * \param[in]    sa array of full pathnames
+ * \param[out]   pnaformat [optional] file formats
+ * \param[out]   pnaw, pnah [optional] widths and heights
+ * \param[out]   pnad [optional] depths
+ * \param[out]   pnares [optional] x resolutions, in ppi
+ * \param[out]   pnapages [optional] number of images in each file
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This gathers the header metadata for a large set of image
+ *          files without decoding any of them.  Each file is opened
+ *          once and only the bytes holding the headers are read.
+ *          The result is returned in columns: entry i of each numa
+ *          is for file i in %sa.
+ *      (2) The depth is bps for spp == 1, and 32 otherwise.  This is
+ *          the depth of the pix that pixRead() makes, except for png,
+ *          where 16 bps is stripped to 8 bps by default and a colormap
+ *          with transparency gives a 32 bpp rgba pix.
+ *      (3) The resolution is 0 if it is not stored in the header.
+ *          The page count is found for tiff; it is 1 for all other
+ *          formats, because only the first image is read from them.
+ *      (4) A file that cannot be opened or whose header cannot be read
+ *          gets zeros in every column except the format, which is
+ *          IFF_UNKNOWN unless the format was identified.  This is not
+ *          an error for the batch.
+ * </pre>
+ */
+l_int32
+pixReadHeadersSA(SARRAY  *sa,
+                 NUMA   **pnaformat,
+                 NUMA   **pnaw,
+                 NUMA   **pnah,
+                 NUMA   **pnad,
+                 NUMA   **pnares,
+                 NUMA   **pnapages)
+{
+char    *fname;
+l_int32  i, n, ret, format, w, h, bps, spp, res, npages;
+FILE    *fp;
+NUMA    *naformat, *naw, *nah, *nad, *nares, *napages;
+
+    PROCNAME("pixReadHeadersSA");
+
+    if (pnaformat) *pnaformat = NULL;
+    if (pnaw) *pnaw = NULL;
+    if (pnah) *pnah = NULL;
+    if (pnad) *pnad = NULL;
+    if (pnares) *pnares = NULL;
+    if (pnapages) *pnapages = NULL;
+    if (!pnaformat && !pnaw && !pnah && !pnad && !pnares && !pnapages)
+        return ERROR_INT("no output requested", procName, 1);
+    if (!sa)
+        return ERROR_INT("sa not defined", procName, 1);
+
+    n = sarrayGetCount(sa);
+    naformat = (pnaformat) ? numaCreate(n) : NULL;
+    naw = (pnaw) ? numaCreate(n) : NULL;
+    nah = (pnah) ? numaCreate(n) : NULL;
+    nad = (pnad) ? numaCreate(n) : NULL;
+    nares = (pnares) ? numaCreate(n) : NULL;
+    napages = (pnapages) ? numaCreate(n) : NULL;
+    for (i = 0; i < n; i++) {
+        fname = sarrayGetString(sa, i, L_NOCOPY);
+        format = IFF_UNKNOWN;
+        ret = 1;
+        if ((fp = fopenReadStream(fname)) != NULL) {
+            ret = freadHeaderInfo(fp, &format, &w, &h, &bps, &spp, NULL,
+                                  (nares) ? &res : NULL,
+                                  (napages) ? &npages : NULL);
+            fclose(fp);
+        }
+        if (ret) {
+            L_ERROR("no header info read from file %s\n", procName, fname);
+            w = h = bps = spp = res = npages = 0;
+        }
+        if (naformat) numaAddNumber(naformat, format);
+        if (naw) numaAddNumber(naw, w);
+        if (nah) numaAddNumber(nah, h);
+        if (nad) numaAddNumber(nad, (spp > 1) ? 32 : bps);
+        if (nares) numaAddNumber(nares, res);
+        if (napages) numaAddNumber(napages, npages);
+    }
+
+    if (pnaformat) *pnaformat = naformat;
+    if (pnaw) *pnaw = naw;
+    if (pnah) *pnah = nah;
+    if (pnad) *pnad = nad;
+    if (pnares) *pnares = nares;
+    if (pnapages) *pnapages = napages;
+    return 0;
+}
+
+
+/*!
+ * \brief   freadHeaderInfo()
+ *
+ * \param[in]    fp file stream opened for read
+ * \param[out]   pformat [optional] file format
+ * \param[out]   pw, ph [optional] width and height
+ * \param[out]   pbps [optional] bits/sample
+ * \param[out]   pspp [optional] samples/pixel 1, 3 or 4
+ * \param[out]   piscmap [optional] 1 if cmap exists; 0 otherwise
+ * \param[out]   pres [optional] x resolution in ppi; 0 if not known
+ * \param[out]   pnpages [optional] number of images in the file
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) All header reads are done on the single open stream, which
+ *          is rewound before each of them.  The resolution and the
+ *          page count are only found if requested.
+ *      (2) %format is returned even if the header cannot be read.
+ * </pre>
+ */
+static l_int32
+freadHeaderInfo(FILE     *fp,
+                l_int32  *pformat,
+                l_int32  *pw,
+                l_int32  *ph,
+                l_int32  *pbps,
+                l_int32  *pspp,
+                l_int32  *piscmap,
+                l_int32  *pres,
+                l_int32  *pnpages)
+{
+l_uint8  data[100];  /* webp header is expected within 100 bytes */
+l_int32  format, ret, w, h, d, bps, spp, iscmap, xres, yres, npages;
+l_int32  type;  /* ignored */
+size_t   nbytes;
+
+    PROCNAME("freadHeaderInfo");
+
+    if (pw) *pw = 0;
+    if (ph) *ph = 0;
+    if (pbps) *pbps = 0;
+    if (pspp) *pspp = 0;
+    if (piscmap) *piscmap = 0;
+    if (pres) *pres = 0;
+    if (pnpages) *pnpages = 0;
+    if (pformat) *pformat = IFF_UNKNOWN;
+    if (!fp)
+        return ERROR_INT("stream not defined", procName, 1);
+
+    findFileFormatStream(fp, &format);
+    if (pformat) *pformat = format;
+    w = h = bps = spp = 0;
+    iscmap = 0;  /* init to false */
+    xres = yres = 0;
+    npages = 1;
+    ret = 0;
 
     switch (format)
     {
-    case IFF_BMP:  /* cheating: reading the entire file */
-        if ((pix = pixRead(filename)) == NULL)
-            return ERROR_INT( "bmp: pix not read", procName, 1);
-        pixGetDimensions(pix, &w, &h, &d);
-        if (pixGetColormap(pix))
-            iscmap = 1;
-        pixDestroy(&pix);
-        bps = (d == 32) ? 8 : d;
-        spp = (d == 32) ? 3 : 1;
+    case IFF_BMP:
+        ret = freadHeaderBmp(fp, &w, &h, &bps, &spp, &xres, &iscmap);
+        if (ret)
+            return ERROR_INT( "bmp: no header info returned", procName, 1);
         break;
 
     case IFF_JFIF_JPEG:
-        ret = readHeaderJpeg(filename, &w, &h, &spp, NULL, NULL);
+        ret = freadHeaderJpeg(fp, &w, &h, &spp, NULL, NULL);
         bps = 8;
         if (ret)
             return ERROR_INT( "jpeg: no header info returned", procName, 1);
+        if (pres)
+            fgetJpegResolution(fp, &xres, &yres);
         break;
 
     case IFF_PNG:
-        ret = readHeaderPng(filename, &w, &h, &bps, &spp, &iscmap);
+        ret = freadHeaderPng(fp, &w, &h, &bps, &spp, &iscmap);
         if (ret)
             return ERROR_INT( "png: no header info returned", procName, 1);
+        if (pres)
+            fgetPngResolution(fp, &xres, &yres);
         break;
 
     case IFF_TIFF:
@@ -494,56 +658,59 @@ PIX     *pix;
     case IFF_TIFF_LZW:
     case IFF_TIFF_ZIP:
             /* Reading page 0 by default; possibly redefine format */
-        ret = readHeaderTiff(filename, 0, &w, &h, &bps, &spp, NULL, &iscmap,
-                             &format);
+        ret = freadHeaderTiff(fp, 0, &w, &h, &bps, &spp, &xres, &iscmap,
+                              &format);
         if (ret)
             return ERROR_INT( "tiff: no header info returned", procName, 1);
+        if (pformat) *pformat = format;
+        if (pnpages) {
+            rewind(fp);
+            tiffGetCount(fp, &npages);
+        }
         break;
 
     case IFF_PNM:
-        ret = readHeaderPnm(filename, &w, &h, &d, &type, &bps, &spp);
+        ret = freadHeaderPnm(fp, &w, &h, &d, &type, &bps, &spp);
         if (ret)
             return ERROR_INT( "pnm: no header info returned", procName, 1);
         break;
 
-    case IFF_GIF:  /* cheating: reading the entire file */
-        if ((pix = pixRead(filename)) == NULL)
-            return ERROR_INT( "gif: pix not read", procName, 1);
-        pixGetDimensions(pix, &w, &h, &d);
-        pixDestroy(&pix);
-        iscmap = 1;  /* always colormapped; max 256 colors */
-        spp = 1;
-        bps = d;
+    case IFF_GIF:
+        ret = freadHeaderGif(fp, &w, &h, &bps, &spp, &iscmap);
+        if (ret)
+            return ERROR_INT( "gif: no header info returned", procName, 1);
         break;
 
     case IFF_JP2:
-        ret = readHeaderJp2k(filename, &w, &h, &bps, &spp);
+        ret = freadHeaderJp2k(fp, &w, &h, &bps, &spp);
+        if (ret)
+            return ERROR_INT( "jp2: no header info returned", procName, 1);
+        if (pres)
+            fgetJp2kResolution(fp, &xres, &yres);
         break;
 
     case IFF_WEBP:
-        if (readHeaderWebP(filename, &w, &h, &spp))
+        nbytes = fread(data, 1, sizeof(data), fp);
+        if (readHeaderMemWebP(data, nbytes, &w, &h, &spp))
             return ERROR_INT( "webp: no header info returned", procName, 1);
         bps = 8;
         break;
 
     case IFF_PS:
-        if (pformat) *pformat = format;
         return ERROR_INT("PostScript reading is not supported\n", procName, 1);
 
     case IFF_LPDF:
-        if (pformat) *pformat = format;
         return ERROR_INT("Pdf reading is not supported\n", procName, 1);
 
     case IFF_SPIX:
-        ret = readHeaderSpix(filename, &w, &h, &bps, &spp, &iscmap);
+        ret = freadHeaderSpix(fp, &w, &h, &bps, &spp, &iscmap);
         if (ret)
             return ERROR_INT( "spix: no header info returned", procName, 1);
         break;
 
     case IFF_UNKNOWN:
-        L_ERROR("unknown format in file %s\n", procName, filename);
-        return 1;
-        break;
+    default:
+        return ERROR_INT("unknown format", procName, 1);
     }
 
     if (pw) *pw = w;
@@ -551,7 +718,8 @@ PIX     *pix;
     if (pbps) *pbps = bps;
     if (pspp) *pspp = spp;
     if (piscmap) *piscmap = iscmap;
-    if (pformat) *pformat = format;
+    if (pres) *pres = xres;
+    if (pnpages) *pnpages = npages;
     return 0;
 }
 
@@ -935,8 +1103,8 @@ PIX     *pix;
  *
  * <pre>
  * Notes:
- *      (1) This reads the actual headers for jpeg, png, tiff, jp2k and pnm.
- *          For bmp and gif, we cheat and read all the data into a pix,
+ *      (1) This reads the actual headers for jpeg, png, tiff, jp2k, bmp
+ *          and pnm.  For gif, we cheat and read all the data into a pix,
  *          from which we extract the "header" information.
  *      (2) The amount of data required depends on the format.  For
  *          png, it requires less than 30 bytes, but for jpeg it can
@@ -978,13 +1146,10 @@ PIX     *pix;
 
     switch (format)
     {
-    case IFF_BMP:  /* cheating: read the pix */
-        if ((pix = pixReadMemBmp(data, size)) == NULL)
-            return ERROR_INT( "bmp: pix not read", procName, 1);
-        pixGetDimensions(pix, &w, &h, &d);
-        pixDestroy(&pix);
-        bps = (d == 32) ? 8 : d;
-        spp = (d == 32) ? 3 : 1;
+    case IFF_BMP:
+        ret = readHeaderMemBmp(data, size, &w, &h, &bps, &spp, NULL, &iscmap);
+        if (ret)
+            return ERROR_INT( "bmp: no header info returned", procName, 1);
         break;
 
     case IFF_JFIF_JPEG:
@@ -36,6 +36,8 @@
  *
  *      90-degree rotation (both directions)
  *            PIX             *pixRotate90()
+ *            static void      rotate90BinaryLow()
+ *            static void      transposeBitBlock32()
  *
  *      Left-right flip
  *            PIX             *pixFlipLR()
@@ -53,6 +55,10 @@
 #include <string.h>
 #include "allheaders.h"
 
+static void rotate90BinaryLow(l_uint32 *datad, l_int32 wpld, l_uint32 *datas,
+                              l_int32 wpls, l_int32 wd, l_int32 hd,
+                              l_int32 direction);
+static void transposeBitBlock32(l_uint32 *a);
 static l_uint8 *makeReverseByteTab1(void);
 static l_uint8 *makeReverseByteTab2(void);
 static l_uint8 *makeReverseByteTab4(void);
@@ -164,8 +170,8 @@ pixRotate90(PIX     *pixs,
             l_int32  direction)
 {
 l_int32    wd, hd, d, wpls, wpld;
-l_int32    i, j, k, m, iend, nswords;
-l_uint32   val, word;
+l_int32    i, j;
+l_uint32   val;
 l_uint32  *lines, *datas, *lined, *datad;
 PIX       *pixd;
 
@@ -249,30 +255,7 @@ PIX       *pixd;
                 }
                 break;
             case 1:
-                nswords = hd / 32;
-                for (j = 0; j < wd; j++) {
-                    lined = datad;
-                    lines = datas + (wd - 1 - j) * wpls;
-                    for (k = 0; k < nswords; k++) {
-                        word = lines[k];
-                        if (!word) {
-                            lined += 32 * wpld;
-                            continue;
-                        } else {
-                            iend = 32 * (k + 1);
-                            for (m = 0, i = 32 * k; i < iend; i++, m++) {
-                                if ((word << m) & 0x80000000)
-                                    SET_DATA_BIT(lined, j);
-                                lined += wpld;
-                            }
-                        }
-                    }
-                    for (i = 32 * nswords; i < hd; i++) {
-                        if (GET_DATA_BIT(lines, i))
-                            SET_DATA_BIT(lined, j);
-                        lined += wpld;
-                    }
-                }
+                rotate90BinaryLow(datad, wpld, datas, wpls, wd, hd, 1);
                 break;
             default:
                 pixDestroy(&pixd);
@@ -337,30 +320,7 @@ PIX       *pixd;
                 }
                 break;
             case 1:
-                nswords = hd / 32;
-                for (j = 0; j < wd; j++) {
-                    lined = datad + (hd - 1) * wpld;
-                    lines = datas + (wd - 1 - j) * wpls;
-                    for (k = 0; k < nswords; k++) {
-                        word = lines[k];
-                        if (!word) {
-                            lined -= 32 * wpld;
-                            continue;
-                        } else {
-                            iend = 32 * (k + 1);
-                            for (m = 0, i = 32 * k; i < iend; i++, m++) {
-                                if ((word << m) & 0x80000000)
-                                    SET_DATA_BIT(lined, wd - 1 - j);
-                                lined -= wpld;
-                            }
-                        }
-                    }
-                    for (i = 32 * nswords; i < hd; i++) {
-                        if (GET_DATA_BIT(lines, i))
-                            SET_DATA_BIT(lined, wd - 1 - j);
-                        lined -= wpld;
-                    }
-                }
+                rotate90BinaryLow(datad, wpld, datas, wpls, wd, hd, -1);
                 break;
             default:
                 pixDestroy(&pixd);
@@ -373,6 +333,105 @@ PIX       *pixd;
 }
 
 
+/*!
+ * \brief   rotate90BinaryLow()
+ *
+ * \param[in]    datad, wpld  dest data and wpl; dest initialized to 0
+ * \param[in]    datas, wpls  src data and wpl
+ * \param[in]    wd, hd  dest width and height
+ * \param[in]    direction 1 = clockwise,  -1 = counter-clockwise
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) For 1 bpp, the rotation is done on blocks of 32 x 32 pixels.
+ *          Each block is made of one word from each of 32 src lines,
+ *          is transposed in registers, and is written as one word
+ *          in each of 32 dest lines.  Blocks that are all 0 are skipped.
+ *      (2) The dest lines correspond to the src columns, reversed
+ *          for ccw rotation; the dest columns correspond to the
+ *          src lines, reversed for cw rotation.
+ * </pre>
+ */
+static void
+rotate90BinaryLow(l_uint32  *datad,
+                  l_int32    wpld,
+                  l_uint32  *datas,
+                  l_int32    wpls,
+                  l_int32    wd,
+                  l_int32    hd,
+                  l_int32    direction)
+{
+l_int32   i, j, k, m, n, nblocksd, nblockss;
+l_uint32  any;
+l_uint32  a[32];
+
+    nblocksd = (wd + 31) / 32;  /* word columns in dest */
+    nblockss = (hd + 31) / 32;  /* word columns in src */
+    for (j = 0; j < nblocksd; j++) {
+        for (k = 0; k < nblockss; k++) {
+                /* Gather the src words; src line for dest column
+                 * 32 * j + m, or 0 beyond the end of the dest line */
+            any = 0;
+            for (m = 0; m < 32; m++) {
+                n = 32 * j + m;
+                if (n >= wd)
+                    a[m] = 0;
+                else if (direction == 1)
+                    a[m] = datas[(wd - 1 - n) * wpls + k];
+                else
+                    a[m] = datas[n * wpls + k];
+                any |= a[m];
+            }
+            if (!any) continue;
+
+                /* Transpose and write to the dest lines for the
+                 * src columns 32 * k + n */
+            transposeBitBlock32(a);
+            for (n = 0; n < 32; n++) {
+                i = 32 * k + n;
+                if (i >= hd) break;
+                if (direction == -1)
+                    i = hd - 1 - i;
+                datad[i * wpld + j] = a[n];
+            }
+        }
+    }
+    return;
+}
+
+
+/*!
+ * \brief   transposeBitBlock32()
+ *
+ * \param[in,out]    a  array of 32 words, each a row of 32 pixels
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This transposes in place a 32 x 32 bit matrix, with the
+ *          MSB of each word as the first column, by swapping
+ *          successively smaller off-diagonal blocks.
+ * </pre>
+ */
+static void
+transposeBitBlock32(l_uint32  *a)
+{
+l_int32   j, k;
+l_uint32  m, t;
+
+    m = 0x0000ffff;
+    for (j = 16; j != 0; j >>= 1, m ^= (m << j)) {
+        for (k = 0; k < 32; k = (k + j + 1) & ~j) {
+            t = (a[k] ^ (a[k + j] >> j)) & m;
+            a[k] ^= t;
+            a[k + j] ^= (t << j);
+        }
+    }
+    return;
+}
+
+
 /*------------------------------------------------------------------*
  *                            Left-right flip                       *
  *------------------------------------------------------------------*/
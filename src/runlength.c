@@ -30,8 +30,10 @@
  *
  *     Label pixels by membership in runs
  *           PIX         *pixStrokeWidthTransform()
- *           static PIX  *pixFindMinRunsOrthogonal()
+ *           static l_int32  pixFindMinRunsOrthogonal()
+ *           static l_int32  makeShearShiftTab()
  *           PIX         *pixRunlengthTransform()
+ *           static PIX  *pixRunlengthTransformLow()
  *
  *     Find runs along horizontal and vertical lines
  *           l_int32      pixFindHorizontalRuns()
@@ -60,7 +62,12 @@
 #include <math.h>
 #include "allheaders.h"
 
-static PIX *pixFindMinRunsOrthogonal(PIX *pixs, l_float32 angle, l_int32 depth);
+static l_int32 pixFindMinRunsOrthogonal(PIX *pixs, PIX *pixd,
+                                        l_float32 angle, l_int32 depth);
+static l_int32 makeShearShiftTab(l_int32 n, l_int32 loc, l_float32 radang,
+                                 l_int32 *tab);
+static PIX *pixRunlengthTransformLow(PIX *pixs, l_int32 depth, l_int32 horiz,
+                                     l_int32 vert);
 
 
 /*-----------------------------------------------------------------------*
@@ -102,7 +109,7 @@ pixStrokeWidthTransform(PIX     *pixs,
                         l_int32  nangles)
 {
 l_float32  angle, pi;
-PIX       *pixh, *pixv, *pixt, *pixg1, *pixg2, *pixg3, *pixg4;
+PIX       *pixt, *pixd;
 
     PROCNAME("pixStrokeWidthTransform");
 
@@ -120,51 +127,38 @@ PIX       *pixh, *pixv, *pixt, *pixg1, *pixg2, *pixg3, *pixg4;
         pixt = pixClone(pixs);
 
         /* Find min length at 0 and 90 degrees */
-    pixh = pixRunlengthTransform(pixt, 1, L_HORIZONTAL_RUNS, depth);
-    pixv = pixRunlengthTransform(pixt, 1, L_VERTICAL_RUNS, depth);
-    pixg1 = pixMinOrMax(NULL, pixh, pixv, L_CHOOSE_MIN);
-    pixDestroy(&pixh);
-    pixDestroy(&pixv);
+    pixd = pixRunlengthTransformLow(pixt, depth, 1, 1);
 
-    pixg2 = pixg3 = pixg4 = NULL;
+        /* Lower it with the min lengths in the other directions */
     pi = 3.1415926535;
     if (nangles == 4 || nangles == 8) {
             /* Find min length at +45 and -45 degrees */
         angle = pi / 4.0;
-        pixg2 = pixFindMinRunsOrthogonal(pixt, angle, depth);
+        pixFindMinRunsOrthogonal(pixt, pixd, angle, depth);
     }
 
     if (nangles == 6) {
             /* Find min length at +30 and -60 degrees */
         angle = pi / 6.0;
-        pixg2 = pixFindMinRunsOrthogonal(pixt, angle, depth);
+        pixFindMinRunsOrthogonal(pixt, pixd, angle, depth);
 
             /* Find min length at +60 and -30 degrees */
         angle = pi / 3.0;
-        pixg3 = pixFindMinRunsOrthogonal(pixt, angle, depth);
+        pixFindMinRunsOrthogonal(pixt, pixd, angle, depth);
     }
 
     if (nangles == 8) {
             /* Find min length at +22.5 and -67.5 degrees */
         angle = pi / 8.0;
-        pixg3 = pixFindMinRunsOrthogonal(pixt, angle, depth);
+        pixFindMinRunsOrthogonal(pixt, pixd, angle, depth);
 
             /* Find min length at +67.5 and -22.5 degrees */
         angle = 3.0 * pi / 8.0;
-        pixg4 = pixFindMinRunsOrthogonal(pixt, angle, depth);
+        pixFindMinRunsOrthogonal(pixt, pixd, angle, depth);
     }
-    pixDestroy(&pixt);
 
-    if (nangles > 2)
-        pixMinOrMax(pixg1, pixg1, pixg2, L_CHOOSE_MIN);
-    if (nangles > 4)
-        pixMinOrMax(pixg1, pixg1, pixg3, L_CHOOSE_MIN);
-    if (nangles > 6)
-        pixMinOrMax(pixg1, pixg1, pixg4, L_CHOOSE_MIN);
-    pixDestroy(&pixg2);
-    pixDestroy(&pixg3);
-    pixDestroy(&pixg4);
-    return pixg1;
+    pixDestroy(&pixt);
+    return pixd;
 }
 
 
@@ -172,39 +166,57 @@ PIX       *pixh, *pixv, *pixt, *pixg1, *pixg2, *pixg3, *pixg4;
  * \brief   pixFindMinRunsOrthogonal()
  *
  * \param[in]     pixs 1 bpp
+ * \param[in]     pixd 8 or 16 bpp, same size as pixs; modified in place
  * \param[in]     angle in radians
  * \param[in]     depth of pixd: 8 or 16 bpp
- * \return   pixd 8 or 16 bpp, or NULL on error
+ * \return   0 if OK; 1 on error
  *
  * <pre>
  * Notes:
  *      (1) This computes, for each fg pixel in pixs, the minimum of
  *          the runlengths going through that pixel in two orthogonal
- *          directions: at %angle and at (90 + %angle).
+ *          directions: at %angle and at (90 + %angle).  Where that
+ *          is smaller than the value in pixd, pixd is lowered to it.
  *      (2) We use rotation by shear because the forward and backward
  *          rotations by the same angle are exact inverse operations.
- *          As a result, the nonzero pixels in pixd correspond exactly
- *          to the fg pixels in pixs.  This is not the case with
+ *          As a result, the nonzero pixels in the result correspond
+ *          exactly to the fg pixels in pixs.  This is not the case with
  *          sampled rotation, due to spatial quantization.  Nevertheless,
  *          the result suffers from lack of exact correspondence
  *          between original and rotated pixels, also due to spatial
  *          quantization, causing some boundary pixels to be
  *          shifted from bg to fg or v.v.
+ *      (3) Rather than rotating the runlength image back, which is
+ *          slow at 8 and 16 bpp, the value for each fg pixel is read
+ *          from the location it was moved to by the rotation.  That
+ *          location is found from the shifts of the three shears in
+ *          the inverse rotation, as done by pixRotate3Shear().  A
+ *          pixel that would come from outside the image in one of
+ *          the shears would be brought in as white, the max value,
+ *          and then does not lower pixd.  The angle must be large
+ *          enough for pixRotateShear() to use 3 shears.
  * </pre>
  */
-static PIX *
+static l_int32
 pixFindMinRunsOrthogonal(PIX       *pixs,
+                         PIX       *pixd,
                          l_float32  angle,
                          l_int32    depth)
 {
-l_int32  w, h, diag, xoff, yoff;
-PIX     *pixb, *pixr, *pixh, *pixv, *pixg1, *pixg2, *pixd;
-BOX     *box;
+l_int32    i, j, w, h, diag, xoff, yoff, wpls, wpld, wplg;
+l_int32    x, y, x1, y1, y2, val, valg;
+l_int32   *vtab, *htab;
+l_uint32   word;
+l_uint32  *datas, *datad, *datag, *lines, *lined, *lineg;
+l_float32  hangle;
+PIX       *pixb, *pixr, *pixg;
 
     PROCNAME("pixFindMinRunsOrthogonal");
 
     if (!pixs || pixGetDepth(pixs) != 1)
-        return (PIX *)ERROR_PTR("pixs undefined or not 1 bpp", procName, NULL);
+        return ERROR_INT("pixs undefined or not 1 bpp", procName, 1);
+    if (!pixd || pixGetDepth(pixd) != depth)
+        return ERROR_INT("pixd undefined or wrong depth", procName, 1);
 
         /* Rasterop into the center of a sufficiently large image
          * so we don't lose pixels for any rotation angle. */
@@ -215,24 +227,126 @@ BOX     *box;
     pixb = pixCreate(diag, diag, 1);
     pixRasterop(pixb, xoff, yoff, w, h, PIX_SRC, pixs, 0, 0);
 
-        /* Rotate about the 'center', get the min of orthogonal transforms,
-         * rotate back, and crop the part corresponding to pixs.  */
+        /* Rotate about the 'center' and get the min of orthogonal
+         * transforms */
     pixr = pixRotateShear(pixb, diag / 2, diag / 2, angle, L_BRING_IN_WHITE);
-    pixh = pixRunlengthTransform(pixr, 1, L_HORIZONTAL_RUNS, depth);
-    pixv = pixRunlengthTransform(pixr, 1, L_VERTICAL_RUNS, depth);
-    pixg1 = pixMinOrMax(NULL, pixh, pixv, L_CHOOSE_MIN);
-    pixg2 = pixRotateShear(pixg1, diag / 2, diag / 2, -angle, L_BRING_IN_WHITE);
-    box = boxCreate(xoff, yoff, w, h);
-    pixd = pixClipRectangle(pixg2, box, NULL);
-
+    pixg = pixRunlengthTransformLow(pixr, depth, 1, 1);
     pixDestroy(&pixb);
     pixDestroy(&pixr);
-    pixDestroy(&pixh);
-    pixDestroy(&pixv);
-    pixDestroy(&pixg1);
-    pixDestroy(&pixg2);
-    boxDestroy(&box);
-    return pixd;
+
+        /* Shifts of the shears that rotate back by -angle */
+    vtab = (l_int32 *)LEPT_CALLOC(diag, sizeof(l_int32));
+    htab = (l_int32 *)LEPT_CALLOC(diag, sizeof(l_int32));
+    hangle = atan(sin(-angle));
+    makeShearShiftTab(diag, diag / 2, -angle / 2., vtab);
+    makeShearShiftTab(diag, diag / 2, hangle, htab);
+
+        /* For each fg pixel, trace back through the vertical,
+         * horizontal and vertical shears to its rotated location */
+    datas = pixGetData(pixs);
+    wpls = pixGetWpl(pixs);
+    datad = pixGetData(pixd);
+    wpld = pixGetWpl(pixd);
+    datag = pixGetData(pixg);
+    wplg = pixGetWpl(pixg);
+    for (i = 0; i < h; i++) {
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        y = i + yoff;
+        for (j = 0; j < w; j++) {
+            if ((j & 31) == 0 && lines[j >> 5] == 0) {
+                j += 31;
+                continue;
+            }
+            word = lines[j >> 5];
+            if (!(word & (0x80000000 >> (j & 31))))
+                continue;
+            x = j + xoff;
+            y2 = y - vtab[x];
+            if (y2 < 0 || y2 >= diag) continue;
+            x1 = x + htab[y2];
+            if (x1 < 0 || x1 >= diag) continue;
+            y1 = y2 - vtab[x1];
+            if (y1 < 0 || y1 >= diag) continue;
+            lineg = datag + y1 * wplg;
+            if (depth == 8) {
+                valg = GET_DATA_BYTE(lineg, x1);
+                val = GET_DATA_BYTE(lined, j);
+                if (valg < val)
+                    SET_DATA_BYTE(lined, j, valg);
+            } else {
+                valg = GET_DATA_TWO_BYTES(lineg, x1);
+                val = GET_DATA_TWO_BYTES(lined, j);
+                if (valg < val)
+                    SET_DATA_TWO_BYTES(lined, j, valg);
+            }
+        }
+    }
+
+    pixDestroy(&pixg);
+    LEPT_FREE(vtab);
+    LEPT_FREE(htab);
+    return 0;
+}
+
+
+/*!
+ * \brief   makeShearShiftTab()
+ *
+ * \param[in]     n size of the image in the direction of the shear line
+ * \param[in]     loc location of the invariant line
+ * \param[in]     radang angle in radians
+ * \param[in]     tab array of size n, for the shift of each row or column
+ * \return   0 if OK; 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This gives the shift of each band in pixVShear() and
+ *          pixHShear(), using the same arithmetic, for an angle that
+ *          is not changed by normalization.
+ *      (2) For a vertical shear, column x is moved down by tab[x];
+ *          for a horizontal shear, row y is moved left by tab[y].
+ * </pre>
+ */
+static l_int32
+makeShearShiftTab(l_int32    n,
+                  l_int32    loc,
+                  l_float32  radang,
+                  l_int32   *tab)
+{
+l_int32    sign, i, k, incr, initincr, shift;
+l_float32  tanangle, invangle;
+
+    PROCNAME("makeShearShiftTab");
+
+    if (!tab)
+        return ERROR_INT("tab not defined", procName, 1);
+
+    memset(tab, 0, n * sizeof(l_int32));
+    if (radang == 0.0 || tan(radang) == 0.0)
+        return 0;
+
+    sign = L_SIGN(radang);
+    tanangle = tan(radang);
+    invangle = L_ABS(1. / tanangle);
+    initincr = (l_int32)(invangle / 2.);
+    for (shift = 1, i = loc + initincr; i < n; shift++) {
+        incr = (l_int32)(invangle * (shift + 0.5) + 0.5) - (i - loc);
+        if (n - i < incr)  /* reduce for last one if req'd */
+            incr = n - i;
+        for (k = i; k < i + incr; k++)
+            tab[k] = sign * shift;
+        i += incr;
+    }
+    for (shift = -1, i = loc - initincr; i > 0; shift--) {
+        incr = (i - loc) - (l_int32)(invangle * (shift - 0.5) + 0.5);
+        if (i < incr)  /* reduce for last one if req'd */
+            incr = i;
+        for (k = i - incr; k < i; k++)
+            tab[k] = sign * shift;
+        i -= incr;
+    }
+    return 0;
 }
 
 
@@ -264,10 +378,7 @@ pixRunlengthTransform(PIX     *pixs,
                       l_int32  direction,
                       l_int32  depth)
 {
-l_int32    i, j, w, h, wpld, bufsize, maxsize, n;
-l_int32   *start, *end, *buffer;
-l_uint32  *datad, *lined;
-PIX       *pixt, *pixd;
+PIX  *pixt, *pixd;
 
     PROCNAME("pixRunlengthTransform");
 
@@ -277,27 +388,8 @@ PIX       *pixt, *pixd;
         return (PIX *)ERROR_PTR("pixs not 1 bpp", procName, NULL);
     if (depth != 8 && depth != 16)
         return (PIX *)ERROR_PTR("depth must be 8 or 16 bpp", procName, NULL);
-
-    pixGetDimensions(pixs, &w, &h, NULL);
-    if (direction == L_HORIZONTAL_RUNS)
-        maxsize = 1 + w / 2;
-    else if (direction == L_VERTICAL_RUNS)
-        maxsize = 1 + h / 2;
-    else
+    if (direction != L_HORIZONTAL_RUNS && direction != L_VERTICAL_RUNS)
         return (PIX *)ERROR_PTR("invalid direction", procName, NULL);
-    bufsize = L_MAX(w, h);
-
-    if ((pixd = pixCreate(w, h, depth)) == NULL)
-        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
-    datad = pixGetData(pixd);
-    wpld = pixGetWpl(pixd);
-
-    if ((start = (l_int32 *)LEPT_CALLOC(maxsize, sizeof(l_int32))) == NULL)
-        return (PIX *)ERROR_PTR("start not made", procName, NULL);
-    if ((end = (l_int32 *)LEPT_CALLOC(maxsize, sizeof(l_int32))) == NULL)
-        return (PIX *)ERROR_PTR("end not made", procName, NULL);
-    if ((buffer = (l_int32 *)LEPT_CALLOC(bufsize, sizeof(l_int32))) == NULL)
-        return (PIX *)ERROR_PTR("buffer not made", procName, NULL);
 
         /* Use fg runs for evaluation */
     if (color == 0)
@@ -305,41 +397,156 @@ PIX       *pixt, *pixd;
     else
         pixt = pixClone(pixs);
 
-    if (direction == L_HORIZONTAL_RUNS) {
+    pixd = pixRunlengthTransformLow(pixt, depth,
+                                    direction == L_HORIZONTAL_RUNS,
+                                    direction == L_VERTICAL_RUNS);
+    pixDestroy(&pixt);
+    return pixd;
+}
+
+
+/*!
+ * \brief   pixRunlengthTransformLow()
+ *
+ * \param[in]     pixs 1 bpp
+ * \param[in]     depth 8 or 16 bpp
+ * \param[in]     horiz 1 to use horizontal runs
+ * \param[in]     vert 1 to use vertical runs
+ * \return   pixd 8 or 16 bpp, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This labels each fg pixel with the length of the fg run
+ *          through it, clipped to the max pixel value.  If both
+ *          directions are used, the label is the minimum of the
+ *          horizontal and vertical run lengths.
+ *      (2) The image is traversed only along raster lines:
+ *           ~ Going down, each pixel is labelled with the length of
+ *             the vertical run up to and including it, so that the
+ *             last pixel in each run is labelled with the run length.
+ *           ~ Going up, that length is propagated to the rest of
+ *             the run, and the horizontal runs on each line are
+ *             found and combined with it.
+ *          Words that are all bg or all fg are handled 32 pixels
+ *          at a time.
+ * </pre>
+ */
+static PIX *
+pixRunlengthTransformLow(PIX     *pixs,
+                         l_int32  depth,
+                         l_int32  horiz,
+                         l_int32  vert)
+{
+l_int32    i, j, k, w, h, wpls, wpld, max, start, len, val, lastrow;
+l_int32   *hbuf, *vbuf;
+l_uint32   word;
+l_uint32  *datas, *datad, *lines, *lined, *linesb;
+PIX       *pixd;
+
+    PROCNAME("pixRunlengthTransformLow");
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    if ((pixd = pixCreate(w, h, depth)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    datas = pixGetData(pixs);
+    wpls = pixGetWpl(pixs);
+    datad = pixGetData(pixd);
+    wpld = pixGetWpl(pixd);
+    max = (depth == 8) ? 0xff : 0xffff;
+    hbuf = (l_int32 *)LEPT_CALLOC(w + 32, sizeof(l_int32));
+    vbuf = (l_int32 *)LEPT_CALLOC(w + 32, sizeof(l_int32));
+
+        /* Going down, label with the vertical run length so far */
+    if (vert) {
         for (i = 0; i < h; i++) {
-            pixFindHorizontalRuns(pixt, i, start, end, &n);
-            runlengthMembershipOnLine(buffer, w, depth, start, end, n);
+            lines = datas + i * wpls;
             lined = datad + i * wpld;
-            if (depth == 8) {
-                for (j = 0; j < w; j++)
-                    SET_DATA_BYTE(lined, j, buffer[j]);
-            } else {  /* depth == 16 */
-                for (j = 0; j < w; j++)
-                    SET_DATA_TWO_BYTES(lined, j, buffer[j]);
+            for (j = 0; j < w; j += 32) {
+                if ((word = lines[j >> 5]) == 0) {
+                    memset(vbuf + j, 0, 32 * sizeof(l_int32));
+                    continue;
+                }
+                for (k = j; k < j + 32 && k < w; k++) {
+                    if (word & (0x80000000 >> (k & 31))) {
+                        val = L_MIN(vbuf[k] + 1, max);
+                        vbuf[k] = val;
+                        if (depth == 8)
+                            SET_DATA_BYTE(lined, k, val);
+                        else
+                            SET_DATA_TWO_BYTES(lined, k, val);
+                    } else {
+                        vbuf[k] = 0;
+                    }
+                }
             }
         }
-    } else {  /* L_VERTICAL_RUNS */
-        for (j = 0; j < w; j++) {
-            pixFindVerticalRuns(pixt, j, start, end, &n);
-            runlengthMembershipOnLine(buffer, h, depth, start, end, n);
-            if (depth == 8) {
-                for (i = 0; i < h; i++) {
-                    lined = datad + i * wpld;
-                    SET_DATA_BYTE(lined, j, buffer[i]);
+        memset(vbuf, 0, w * sizeof(l_int32));
+    }
+
+        /* Going up, finish the vertical runs and combine with
+         * the horizontal runs on each line */
+    for (i = h - 1; i >= 0; i--) {
+        lines = datas + i * wpls;
+        lined = datad + i * wpld;
+        lastrow = (i == h - 1);
+        linesb = lines + wpls;  /* not used on the last row */
+
+        if (horiz) {  /* find the horizontal runs on this line */
+            for (j = 0; j < w; ) {
+                if ((j & 31) == 0 && lines[j >> 5] == 0) {
+                    j += 32;
+                    continue;
+                }
+                if (!GET_DATA_BIT(lines, j)) {
+                    j++;
+                    continue;
                 }
-            } else {  /* depth == 16 */
-                for (i = 0; i < h; i++) {
-                    lined = datad + i * wpld;
-                    SET_DATA_TWO_BYTES(lined, j, buffer[i]);
+                start = j;
+                while (j < w) {
+                    if ((j & 31) == 0 && j + 32 <= w &&
+                        lines[j >> 5] == 0xffffffff)
+                        j += 32;
+                    else if (GET_DATA_BIT(lines, j))
+                        j++;
+                    else
+                        break;
                 }
+                len = L_MIN(j - start, max);
+                for (k = start; k < j; k++)
+                    hbuf[k] = len;
+            }
+        }
+
+        for (j = 0; j < w; j += 32) {
+            if ((word = lines[j >> 5]) == 0) {
+                if (vert)
+                    memset(vbuf + j, 0, 32 * sizeof(l_int32));
+                continue;
+            }
+            for (k = j; k < j + 32 && k < w; k++) {
+                if (!(word & (0x80000000 >> (k & 31)))) {
+                    vbuf[k] = 0;
+                    continue;
+                }
+                if (vert) {
+                    if (lastrow || !GET_DATA_BIT(linesb, k)) {
+                        vbuf[k] = (depth == 8) ? GET_DATA_BYTE(lined, k) :
+                                  GET_DATA_TWO_BYTES(lined, k);
+                    }
+                    val = (horiz) ? L_MIN(vbuf[k], hbuf[k]) : vbuf[k];
+                } else {
+                    val = hbuf[k];
+                }
+                if (depth == 8)
+                    SET_DATA_BYTE(lined, k, val);
+                else
+                    SET_DATA_TWO_BYTES(lined, k, val);
             }
         }
     }
 
-    pixDestroy(&pixt);
-    LEPT_FREE(start);
-    LEPT_FREE(end);
-    LEPT_FREE(buffer);
+    LEPT_FREE(hbuf);
+    LEPT_FREE(vbuf);
     return pixd;
 }
 
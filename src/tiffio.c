@@ -38,7 +38,12 @@
  *     Reading tiff:
  *             PIX       *pixReadTiff()             [ special top level ]
  *             PIX       *pixReadStreamTiff()
+ *             PIX       *pixReadTiffRegion()
  *      static PIX       *pixReadFromTiffStream()
+ *      static l_int32    tiffSetPixFields()
+ *      static l_int32    tiffIsNativeDecodable()
+ *      static l_int32    tiffReadBlocksToPix()
+ *      static void       tiffBlockToPixOrder()
  *
  *     Writing tiff:
  *             l_int32    pixWriteTiff()            [ special top level ]
@@ -51,13 +56,17 @@
  *     Reading and writing multipage tiff
  *             PIX       *pixReadFromMultipageTiff()
  *             PIXA      *pixaReadMultipageTiff()   [ special top level ]
+ *             PIXA      *pixaReadMultipageTiffIndexed()
  *             l_int32    pixaWriteMultipageTiff()  [ special top level ]
  *             l_int32    writeMultipageTiff()      [ special top level ]
  *             l_int32    writeMultipageTiffSA()
+ *      static l_int32    writeMultipageTiffPage()
  *
  *     Information about tiff file
  *             l_int32    fprintTiffInfo()
  *             l_int32    tiffGetCount()
+ *             l_int32    tiffGetPageOffsets()
+ *      static l_uint64   tiffGetUnsigned()
  *             l_int32    getTiffResolution()
  *      static l_int32    getTiffStreamResolution()
  *             l_int32    readHeaderTiff()
@@ -117,6 +126,13 @@ static const l_int32  MANY_PAGES_IN_TIFF_FILE = 3000;  /* warn if big */
 
     /* All functions with TIFF interfaces are static. */
 static PIX      *pixReadFromTiffStream(TIFF *tif);
+static l_int32   tiffSetPixFields(TIFF *tif, PIX *pix);
+static l_int32   tiffIsNativeDecodable(TIFF *tif);
+static l_int32   tiffReadBlocksToPix(TIFF *tif, PIX *pixd, l_int32 x0,
+                                     l_int32 y0);
+static void      tiffBlockToPixOrder(l_uint32 *data, l_int32 wpl, l_int32 w,
+                                     l_int32 nrows, l_int32 tiffbpl,
+                                     l_int32 d, l_int32 spp);
 static l_int32   getTiffStreamResolution(TIFF *tif, l_int32 *pxres,
                                          l_int32 *pyres);
 static l_int32   tiffReadHeaderTiff(TIFF *tif, l_int32 *pwidth,
@@ -126,6 +142,9 @@ static l_int32   tiffReadHeaderTiff(TIFF *tif, l_int32 *pwidth,
 static l_int32   writeCustomTiffTags(TIFF *tif, NUMA *natags,
                                      SARRAY *savals, SARRAY  *satypes,
                                      NUMA *nasizes);
+static l_int32   writeMultipageTiffPage(TIFF *tif, PIX *pix);
+static l_uint64  tiffGetUnsigned(const l_uint8 *data, l_int32 nbytes,
+                                 l_int32 bigend);
 static l_int32   pixWriteToTiffStream(TIFF *tif, PIX *pix, l_int32 comptype,
                                       NUMA *natags, SARRAY *savals,
                                       SARRAY *satypes, NUMA *nasizes);
@@ -423,6 +442,91 @@ TIFF    *tif;
     return pix;
 }
 
+/*!
+ * \brief   pixReadTiffRegion()
+ *
+ * \param[in]    filename
+ * \param[in]    n page number: 0 based
+ * \param[in]    box region of the page to be read
+ * \return  pix, or NULL on error or if the box does not intersect the page
+ *
+ * <pre>
+ * Notes:
+ *      (1) This reads the part of a tiff page within %box, decoding
+ *          only the strips or tiles that intersect it.  For a large
+ *          tiled image, that is a small fraction of the page.
+ *      (2) The box is clipped to the page, in its top-left orientation.
+ *          Images in other than the top-left orientation, and images
+ *          that are not decoded directly (e.g., rgba or jpeg compressed
+ *          rgb), are read in full and then clipped.
+ *      (3) The result is the same as clipping the full page with
+ *          pixClipRectangle().
+ * </pre>
+ */
+PIX *
+pixReadTiffRegion(const char  *filename,
+                  l_int32      n,
+                  BOX         *box)
+{
+l_uint16  spp, bps, orientation;
+l_int32   bx, by, bw, bh;
+l_uint32  w, h;
+BOX      *boxc;
+PIX      *pix, *pixd;
+TIFF     *tif;
+
+    PROCNAME("pixReadTiffRegion");
+
+    if (!filename)
+        return (PIX *)ERROR_PTR("filename not defined", procName, NULL);
+    if (!box)
+        return (PIX *)ERROR_PTR("box not defined", procName, NULL);
+
+    if ((tif = openTiff(filename, "r")) == NULL)
+        return (PIX *)ERROR_PTR("tif not opened", procName, NULL);
+    if (TIFFSetDirectory(tif, n) == 0) {
+        TIFFClose(tif);
+        return (PIX *)ERROR_PTR("page not found", procName, NULL);
+    }
+
+        /* Fall back to reading the full page and clipping it.  The
+         * page is in the top-left orientation after it is read, so the
+         * box is clipped to the oriented page, not to the stored one. */
+    if (!tiffIsNativeDecodable(tif) ||
+        (TIFFGetField(tif, TIFFTAG_ORIENTATION, &orientation) &&
+         orientation != ORIENTATION_TOPLEFT)) {
+        pix = pixReadFromTiffStream(tif);
+        TIFFClose(tif);
+        if (!pix)
+            return (PIX *)ERROR_PTR("pix not read", procName, NULL);
+        pixd = pixClipRectangle(pix, box, NULL);
+        pixDestroy(&pix);
+        if (!pixd)
+            return (PIX *)ERROR_PTR("box outside page", procName, NULL);
+        return pixd;
+    }
+
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
+    if ((boxc = boxClipToRectangle(box, w, h)) == NULL) {
+        TIFFClose(tif);
+        return (PIX *)ERROR_PTR("box outside page", procName, NULL);
+    }
+    boxGetGeometry(boxc, &bx, &by, &bw, &bh);
+    boxDestroy(&boxc);
+
+    TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bps);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &spp);
+    pixd = pixCreate(bw, bh, (spp == 1) ? bps : 32);
+    if (!pixd || tiffReadBlocksToPix(tif, pixd, bx, by) ||
+        tiffSetPixFields(tif, pixd)) {
+        pixDestroy(&pixd);
+        L_ERROR("region not read\n", procName);
+    }
+    TIFFClose(tif);
+    return pixd;
+}
+
 
 /*!
  * \brief   pixReadFromTiffStream()
@@ -460,16 +564,12 @@ TIFF    *tif;
 static PIX *
 pixReadFromTiffStream(TIFF  *tif)
 {
-l_uint8   *linebuf, *data;
-l_uint16   spp, bps, bpp, photometry, tiffcomp, orientation;
-l_uint16  *redmap, *greenmap, *bluemap;
-l_int32    d, wpl, bpl, comptype, i, j, ncolors, rval, gval, bval;
-l_int32    xres, yres;
-l_uint32   w, h, tiffbpl, tiffword;
+l_uint16   spp, bps, bpp, orientation;
+l_int32    d, i, j, wpl, rval, gval, bval;
+l_uint32   w, h, tiffword;
 l_uint32  *line, *ppixel, *tiffdata;
 l_uint32   read_oriented;
 PIX       *pix;
-PIXCMAP   *cmap;
 
     PROCNAME("pixReadFromTiffStream");
 
@@ -494,37 +594,22 @@ PIXCMAP   *cmap;
 
     TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
     TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
-    tiffbpl = TIFFScanlineSize(tif);
-
     if ((pix = pixCreate(w, h, d)) == NULL)
         return (PIX *)ERROR_PTR("pix not made", procName, NULL);
     pixSetInputFormat(pix, IFF_TIFF);
-    data = (l_uint8 *)pixGetData(pix);
     wpl = pixGetWpl(pix);
-    bpl = 4 * wpl;
 
-        /* Read the data */
-    if (spp == 1) {
-        if ((linebuf = (l_uint8 *)LEPT_CALLOC(tiffbpl + 1, sizeof(l_uint8)))
-            == NULL)
-            return (PIX *)ERROR_PTR("calloc fail for linebuf", procName, NULL);
-
-        for (i = 0 ; i < h ; i++) {
-            if (TIFFReadScanline(tif, linebuf, i, 0) < 0) {
-                LEPT_FREE(linebuf);
-                pixDestroy(&pix);
-                return (PIX *)ERROR_PTR("line read fail", procName, NULL);
-            }
-            memcpy((char *)data, (char *)linebuf, tiffbpl);
-            data += bpl;
+        /* Read the data.  Strips or tiles with 1 spp, and with 8 bps
+         * rgb, are decoded directly into the pix raster. */
+    if (tiffIsNativeDecodable(tif)) {
+        if (tiffReadBlocksToPix(tif, pix, 0, 0)) {
+            pixDestroy(&pix);
+            return (PIX *)ERROR_PTR("block read fail", procName, NULL);
         }
-        if (bps <= 8)
-            pixEndianByteSwap(pix);
-        else   /* bps == 16 */
-            pixEndianTwoByteSwap(pix);
-        LEPT_FREE(linebuf);
-    }
-    else {  /* rgb */
+    } else if (spp == 1) {
+        pixDestroy(&pix);
+        return (PIX *)ERROR_PTR("invalid bps for 1 spp", procName, NULL);
+    } else {  /* rgb */
         if ((tiffdata = (l_uint32 *)LEPT_CALLOC(w * h, sizeof(l_uint32)))
             == NULL) {
             pixDestroy(&pix);
@@ -555,6 +640,63 @@ PIXCMAP   *cmap;
         LEPT_FREE(tiffdata);
     }
 
+    if (tiffSetPixFields(tif, pix)) {
+        pixDestroy(&pix);
+        return (PIX *)ERROR_PTR("invalid tiff fields", procName, NULL);
+    }
+
+    if (TIFFGetField(tif, TIFFTAG_ORIENTATION, &orientation)) {
+        if (orientation >= 1 && orientation <= 8) {
+            struct tiff_transform *transform = (read_oriented) ?
+                &tiff_partial_orientation_transforms[orientation - 1] :
+                &tiff_orientation_transforms[orientation - 1];
+            if (transform->vflip) pixFlipTB(pix, pix);
+            if (transform->hflip) pixFlipLR(pix, pix);
+            if (transform->rotate) {
+                PIX *oldpix = pix;
+                pix = pixRotate90(oldpix, transform->rotate);
+                pixDestroy(&oldpix);
+            }
+        }
+    }
+
+    return pix;
+}
+
+
+/*!
+ * \brief   tiffSetPixFields()
+ *
+ * \param[in]    tif TIFF handle, set to the image directory
+ * \param[in]    pix decoded from the image, in the stored orientation
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This sets the resolution, input format and colormap of the
+ *          pix from the tiff fields, and inverts the pix if the
+ *          photometry requires it.
+ *      (2) The pix can be either the full image or a region of it.
+ * </pre>
+ */
+static l_int32
+tiffSetPixFields(TIFF  *tif,
+                 PIX   *pix)
+{
+l_uint16   bps, photometry, tiffcomp;
+l_uint16  *redmap, *greenmap, *bluemap;
+l_int32    d, i, ncolors, comptype, xres, yres;
+PIXCMAP   *cmap;
+
+    PROCNAME("tiffSetPixFields");
+
+    if (!tif)
+        return ERROR_INT("tif not defined", procName, 1);
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 1);
+
+    TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bps);
+    d = pixGetDepth(pix);
     if (getTiffStreamResolution(tif, &xres, &yres) == 0) {
         pixSetXRes(pix, xres);
         pixSetYRes(pix, yres);
@@ -570,14 +712,10 @@ PIXCMAP   *cmap;
              * tiff colormap components are 16 bit unsigned,
              * and go from black (0) to white (0xffff), the
              * the pix cmap takes the most significant byte. */
-        if (bps > 8) {
-            pixDestroy(&pix);
-            return (PIX *)ERROR_PTR("invalid bps; > 8", procName, NULL);
-        }
-        if ((cmap = pixcmapCreate(bps)) == NULL) {
-            pixDestroy(&pix);
-            return (PIX *)ERROR_PTR("cmap not made", procName, NULL);
-        }
+        if (bps > 8)
+            return ERROR_INT("invalid bps; > 8", procName, 1);
+        if ((cmap = pixcmapCreate(bps)) == NULL)
+            return ERROR_INT("cmap not made", procName, 1);
         ncolors = 1 << bps;
         for (i = 0; i < ncolors; i++)
             pixcmapAddColor(cmap, redmap[i] >> 8, greenmap[i] >> 8,
@@ -600,23 +738,232 @@ PIXCMAP   *cmap;
             (d == 8 && photometry == PHOTOMETRIC_MINISWHITE))
             pixInvert(pix, pix);
     }
+    return 0;
+}
 
-    if (TIFFGetField(tif, TIFFTAG_ORIENTATION, &orientation)) {
-        if (orientation >= 1 && orientation <= 8) {
-            struct tiff_transform *transform = (read_oriented) ?
-                &tiff_partial_orientation_transforms[orientation - 1] :
-                &tiff_orientation_transforms[orientation - 1];
-            if (transform->vflip) pixFlipTB(pix, pix);
-            if (transform->hflip) pixFlipLR(pix, pix);
-            if (transform->rotate) {
-                PIX *oldpix = pix;
-                pix = pixRotate90(oldpix, transform->rotate);
-                pixDestroy(&oldpix);
+
+/*!
+ * \brief   tiffIsNativeDecodable()
+ *
+ * \param[in]    tif TIFF handle, set to the image directory
+ * \return  1 if the strips or tiles can be decoded directly into a pix;
+ *              0 otherwise
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is true for 1 spp with bps in {1, 2, 4, 8, 16}, and for
+ *          3 spp rgb with 8 bps, contiguous samples and no jpeg
+ *          compression.  Everything else goes through the libtiff
+ *          RGBA interface.
+ * </pre>
+ */
+static l_int32
+tiffIsNativeDecodable(TIFF  *tif)
+{
+l_uint16  spp, bps, photometry, planar, tiffcomp;
+
+    TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bps);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &spp);
+    if (spp == 1)
+        return (bps == 1 || bps == 2 || bps == 4 || bps == 8 || bps == 16);
+    if (spp != 3 || bps != 8)
+        return 0;
+    TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &planar);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_COMPRESSION, &tiffcomp);
+    if (!TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &photometry))
+        return 0;
+    return (photometry == PHOTOMETRIC_RGB && planar == PLANARCONFIG_CONTIG &&
+            tiffcomp != COMPRESSION_JPEG && tiffcomp != COMPRESSION_OJPEG);
+}
+
+
+/*!
+ * \brief   tiffReadBlocksToPix()
+ *
+ * \param[in]    tif TIFF handle, set to the image directory
+ * \param[in]    pixd covering a rectangle of the image; d = bps for
+ *                    1 spp and 32 for rgb
+ * \param[in]    x0, y0 UL corner of the rectangle in the image
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Only the strips or tiles that intersect the rectangle are
+ *          decoded, with TIFFReadEncodedStrip() or TIFFReadEncodedTile().
+ *      (2) A strip that lies entirely within the rectangle, when the
+ *          rectangle spans the full image width, is decoded in place
+ *          into the pixd raster.  Any other strip or tile is decoded
+ *          into a block-sized pix and blitted into pixd.
+ *      (3) The caller must check tiffIsNativeDecodable() first.
+ * </pre>
+ */
+static l_int32
+tiffReadBlocksToPix(TIFF    *tif,
+                    PIX     *pixd,
+                    l_int32  x0,
+                    l_int32  y0)
+{
+l_uint16   spp;
+l_int32    tiled, direct, ret, wd, hd, d, wpld, wplt, bx, by, nrows;
+l_uint32   w, h, tw, th, block;
+l_uint32  *datad, *data;
+tsize_t    blockbpl, blocksize, nbytes;
+PIX       *pixt;
+
+    PROCNAME("tiffReadBlocksToPix");
+
+    if (!tif)
+        return ERROR_INT("tif not defined", procName, 1);
+    if (!pixd)
+        return ERROR_INT("pixd not defined", procName, 1);
+
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &spp);
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
+    pixGetDimensions(pixd, &wd, &hd, &d);
+    if (x0 < 0 || y0 < 0 || (l_uint32)(x0 + wd) > w ||
+        (l_uint32)(y0 + hd) > h)
+        return ERROR_INT("rectangle not within image", procName, 1);
+
+    if ((tiled = TIFFIsTiled(tif)) != 0) {
+        TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tw);
+        TIFFGetField(tif, TIFFTAG_TILELENGTH, &th);
+        blockbpl = TIFFTileRowSize(tif);
+        blocksize = TIFFTileSize(tif);
+    } else {
+        tw = w;
+        TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &th);
+        th = L_MIN(th, h);
+        blockbpl = TIFFScanlineSize(tif);
+        blocksize = th * blockbpl;
+    }
+    if (tw == 0 || th == 0 || blockbpl <= 0)
+        return ERROR_INT("invalid block size", procName, 1);
+    datad = pixGetData(pixd);
+    wpld = pixGetWpl(pixd);
+
+        /* A strip that lies entirely within the region is decoded
+         * directly into pixd.  Other blocks are decoded into pixt,
+         * which is made when it is first needed. */
+    pixt = NULL;
+    wplt = 0;
+    ret = 0;
+    for (by = (y0 / th) * th; by < y0 + hd && !ret; by += th) {
+        nrows = L_MIN(th, h - by);
+        for (bx = (x0 / tw) * tw; bx < x0 + wd; bx += tw) {
+            direct = (!tiled && (l_uint32)wd == w && by >= y0 &&
+                      by + nrows <= y0 + hd);
+            if (!direct && !pixt) {
+                if ((pixt = pixCreateNoInit(tw, th, d)) == NULL) {
+                    L_ERROR("pixt not made\n", procName);
+                    ret = 1;
+                    break;
+                }
+                wplt = pixGetWpl(pixt);
+                if (blocksize > 4 * wplt * th) {
+                    L_ERROR("block larger than pixt\n", procName);
+                    ret = 1;
+                    break;
+                }
+            }
+            if (tiled) {
+                block = TIFFComputeTile(tif, bx, by, 0, 0);
+                nbytes = TIFFReadEncodedTile(tif, block, pixGetData(pixt),
+                                             blocksize);
+            } else {
+                block = TIFFComputeStrip(tif, by, 0);
+                data = (direct) ? datad + (by - y0) * wpld : pixGetData(pixt);
+                nbytes = TIFFReadEncodedStrip(tif, block, data,
+                                              nrows * blockbpl);
+            }
+            if (nbytes < 0) {
+                L_ERROR("read fail for block at (%d, %d)\n", procName, bx, by);
+                ret = 1;
+                break;
+            }
+            if (direct) {
+                tiffBlockToPixOrder(datad + (by - y0) * wpld, wpld, wd,
+                                    nrows, blockbpl, d, spp);
+            } else {
+                tiffBlockToPixOrder(pixGetData(pixt), wplt, tw, nrows,
+                                    blockbpl, d, spp);
+                pixRasterop(pixd, bx - x0, by - y0, tw, nrows, PIX_SRC,
+                            pixt, 0, 0);
             }
         }
     }
 
-    return pix;
+    pixDestroy(&pixt);
+    return ret;
+}
+
+
+/*!
+ * \brief   tiffBlockToPixOrder()
+ *
+ * \param[in]    data start of the decoded block, in tiff order
+ * \param[in]    wpl words/line of the pix raster holding the block
+ * \param[in]    w width of the block in pixels
+ * \param[in]    nrows number of rows in the block
+ * \param[in]    tiffbpl bytes/row of the decoded block
+ * \param[in]    d pix depth
+ * \param[in]    spp 1 or 3
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The rows of a decoded block are packed, at tiffbpl bytes
+ *          apart.  This spreads them in place to the pix row stride,
+ *          starting with the last row, and converts them to pix order:
+ *          1 spp samples are byte swapped (two-byte swapped for 16 bpp)
+ *          on little-endian platforms, and 3 spp samples are composed
+ *          into rgb pixels.
+ *      (2) The bytes after the samples in each 1 spp row are cleared,
+ *          so that the pad bits in the pix are 0.
+ * </pre>
+ */
+static void
+tiffBlockToPixOrder(l_uint32  *data,
+                    l_int32    wpl,
+                    l_int32    w,
+                    l_int32    nrows,
+                    l_int32    tiffbpl,
+                    l_int32    d,
+                    l_int32    spp)
+{
+l_uint8   *bytes, *src;
+l_int32    i, j, bpl;
+l_uint32   word;
+l_uint32  *line;
+
+    bytes = (l_uint8 *)data;
+    bpl = 4 * wpl;
+    for (i = nrows - 1; i >= 0; i--) {
+        src = bytes + i * tiffbpl;
+        line = data + i * wpl;
+        if (spp == 3) {
+            for (j = w - 1; j >= 0; j--)
+                composeRGBPixel(src[3 * j], src[3 * j + 1], src[3 * j + 2],
+                                line + j);
+            continue;
+        }
+        if (i > 0)
+            memmove(line, src, tiffbpl);
+        if (tiffbpl < bpl)
+            memset((l_uint8 *)line + tiffbpl, 0, bpl - tiffbpl);
+#ifndef L_BIG_ENDIAN
+        for (j = 0; j < wpl; j++) {
+            word = line[j];
+            if (d == 16)
+                line[j] = (word << 16) | (word >> 16);
+            else
+                line[j] = (word >> 24) |
+                          ((word >> 8) & 0x0000ff00) |
+                          ((word << 8) & 0x00ff0000) |
+                          (word << 24);
+        }
+#endif  /* ~L_BIG_ENDIAN */
+    }
 }
 
 
@@ -1262,6 +1609,87 @@ TIFF    *tif;
 }
 
 
+/*!
+ * \brief   pixaReadMultipageTiffIndexed()
+ *
+ * \param[in]    filename input tiff file
+ * \param[in]    da [optional] page offsets from tiffGetPageOffsets();
+ *                  use NULL to make them here
+ * \param[in]    first index of first page to read
+ * \param[in]    nread number of pages to read; use 0 to read to the end
+ * \return  pixa of page images, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This reads a range of pages from a multipage tiff file,
+ *          jumping directly to each page with its directory offset
+ *          instead of stepping through all the preceding directories.
+ *      (2) Each call opens its own tiff handle, so that a large file
+ *          can be split into page ranges that are read independently;
+ *          e.g., by separate threads or processes that share one
+ *          page index made by tiffGetPageOffsets().
+ * </pre>
+ */
+PIXA *
+pixaReadMultipageTiffIndexed(const char  *filename,
+                             L_DNA       *da,
+                             l_int32      first,
+                             l_int32      nread)
+{
+l_int32    i, last, npages;
+l_float64  dval;
+FILE      *fp;
+L_DNA     *da1;
+PIX       *pix;
+PIXA      *pixa;
+TIFF      *tif;
+
+    PROCNAME("pixaReadMultipageTiffIndexed");
+
+    if (!filename)
+        return (PIXA *)ERROR_PTR("filename not defined", procName, NULL);
+
+    if (da) {
+        da1 = l_dnaClone(da);
+    } else {
+        if ((fp = fopenReadStream(filename)) == NULL)
+            return (PIXA *)ERROR_PTR("stream not opened", procName, NULL);
+        tiffGetPageOffsets(fp, &da1);
+        fclose(fp);
+        if (!da1)
+            return (PIXA *)ERROR_PTR("page offsets not made", procName, NULL);
+    }
+    npages = l_dnaGetCount(da1);
+    if (first < 0 || first >= npages) {
+        l_dnaDestroy(&da1);
+        return (PIXA *)ERROR_PTR("invalid first page", procName, NULL);
+    }
+    last = (nread <= 0) ? npages - 1 : L_MIN(npages - 1, first + nread - 1);
+
+    if ((tif = openTiff(filename, "r")) == NULL) {
+        l_dnaDestroy(&da1);
+        return (PIXA *)ERROR_PTR("tif not opened", procName, NULL);
+    }
+
+    pixa = pixaCreate(last - first + 1);
+    for (i = first; i <= last; i++) {
+        l_dnaGetDValue(da1, i, &dval);
+        if (TIFFSetSubDirectory(tif, (l_uint64)dval) == 0) {
+            L_WARNING("directory not found for page %d\n", procName, i);
+            continue;
+        }
+        if ((pix = pixReadFromTiffStream(tif)) != NULL)
+            pixaAddPix(pixa, pix, L_INSERT);
+        else
+            L_WARNING("pix not read for page %d\n", procName, i);
+    }
+
+    TIFFClose(tif);
+    l_dnaDestroy(&da1);
+    return pixa;
+}
+
+
 /*!
  * \brief   pixaWriteMultipageTiff()
  *
@@ -1271,18 +1699,21 @@ TIFF    *tif;
  *
  * <pre>
  * Notes:
- *      (1) The tiff directory overhead is O(n^2).  I have not been
- *          able to reduce it to O(n).  The overhead for n = 2000 is
- *          about 1 second.
+ *      (1) All pages are written through a single tiff handle, with
+ *          a directory written after each page.  The cost is linear
+ *          in the number of pages.  Appending each page with
+ *          pixWriteTiff() in "a" mode is quadratic, because every
+ *          append must walk the existing directory chain.
+ *      (2) Images with 1 bpp are encoded g4; the rest are encoded zip.
  * </pre>
  */
 l_int32
 pixaWriteMultipageTiff(const char  *fname,
                        PIXA        *pixa)
 {
-const char  *modestr;
-l_int32      i, n;
-PIX         *pix1, *pix2;
+l_int32  i, n, ret;
+PIX     *pix;
+TIFF    *tif;
 
     PROCNAME("pixaWriteMultipageTiff");
 
@@ -1291,25 +1722,20 @@ PIX         *pix1, *pix2;
     if (!pixa)
         return ERROR_INT("pixa not defined", procName, 1);
 
+    if ((tif = openTiff(fname, "w")) == NULL)
+        return ERROR_INT("tif not opened", procName, 1);
     n = pixaGetCount(pixa);
+    ret = 0;
     for (i = 0; i < n; i++) {
-        modestr = (i == 0) ? "w" : "a";
-        pix1 = pixaGetPix(pixa, i, L_CLONE);
-        if (pixGetDepth(pix1) == 1) {
-            pixWriteTiff(fname, pix1, IFF_TIFF_G4, modestr);
-        } else {
-            if (pixGetColormap(pix1)) {
-                pix2 = pixRemoveColormap(pix1, REMOVE_CMAP_BASED_ON_SRC);
-            } else {
-                pix2 = pixClone(pix1);
-            }
-            pixWriteTiff(fname, pix2, IFF_TIFF_ZIP, modestr);
-            pixDestroy(&pix2);
+        pix = pixaGetPix(pixa, i, L_CLONE);
+        if (writeMultipageTiffPage(tif, pix)) {
+            L_ERROR("page %d not written\n", procName, i);
+            ret = 1;
         }
-        pixDestroy(&pix1);
+        pixDestroy(&pix);
     }
-
-    return 0;
+    TIFFClose(tif);
+    return ret;
 }
 
 
@@ -1332,9 +1758,8 @@ PIX         *pix1, *pix2;
  *          encoded 'g4'.  The rest are encoded as 'zip' (flate encoding).
  *          Because it is lossless, this is an expensive method for
  *          saving most rgb images.
- *      (4) The tiff directory overhead is quadratic in the number of
- *          images.  To avoid this for very large numbers of images to be
- *          written, apply the method used in pixaWriteMultipageTiff().
+ *      (4) The pages are written through a single tiff handle, so the
+ *          tiff directory overhead is linear in the number of images.
  * </pre>
  */
 l_int32
@@ -1377,10 +1802,10 @@ l_int32
 writeMultipageTiffSA(SARRAY      *sa,
                      const char  *fileout)
 {
-char        *fname;
-const char  *op;
-l_int32      i, nfiles, firstfile, format;
-PIX         *pix, *pix1;
+char     *fname;
+l_int32   i, nfiles, format, ret;
+PIX      *pix;
+TIFF     *tif;
 
     PROCNAME("writeMultipageTiffSA");
 
@@ -1390,9 +1815,9 @@ PIX         *pix, *pix1;
         return ERROR_INT("fileout not defined", procName, 1);
 
     nfiles = sarrayGetCount(sa);
-    firstfile = TRUE;
+    tif = NULL;
+    ret = 0;
     for (i = 0; i < nfiles; i++) {
-        op = (firstfile) ? "w" : "a";
         fname = sarrayGetString(sa, i, L_NOCOPY);
         findFileFormat(fname, &format);
         if (format == IFF_UNKNOWN) {
@@ -1404,22 +1829,66 @@ PIX         *pix, *pix1;
             L_WARNING("pix not made for file: %s\n", procName, fname);
             continue;
         }
-        if (pixGetDepth(pix) == 1) {
-            pixWriteTiff(fileout, pix, IFF_TIFF_G4, op);
-        } else {
-            if (pixGetColormap(pix)) {
-                pix1 = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC);
-            } else {
-                pix1 = pixClone(pix);
-            }
-            pixWriteTiff(fileout, pix1, IFF_TIFF_ZIP, op);
-            pixDestroy(&pix1);
+        if (!tif && (tif = openTiff(fileout, "w")) == NULL) {
+            pixDestroy(&pix);
+            return ERROR_INT("tif not opened", procName, 1);
+        }
+        if (writeMultipageTiffPage(tif, pix)) {
+            L_ERROR("page for %s not written\n", procName, fname);
+            ret = 1;
         }
-        firstfile = FALSE;
         pixDestroy(&pix);
     }
 
-    return 0;
+    if (tif) TIFFClose(tif);
+    return ret;
+}
+
+
+/*!
+ * \brief   writeMultipageTiffPage()
+ *
+ * \param[in]    tif handle opened for write
+ * \param[in]    pix any depth; colormap will be removed
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This writes one page of a multipage tiff and then writes its
+ *          directory, leaving the handle ready for the next page.
+ *      (2) Images with 1 bpp are encoded g4.  Images with a colormap
+ *          have the colormap removed, and the rest are encoded zip.
+ * </pre>
+ */
+static l_int32
+writeMultipageTiffPage(TIFF  *tif,
+                       PIX   *pix)
+{
+l_int32  ret;
+PIX     *pix1;
+
+    PROCNAME("writeMultipageTiffPage");
+
+    if (!tif)
+        return ERROR_INT("tif not defined", procName, 1);
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 1);
+
+    if (pixGetDepth(pix) == 1) {
+        ret = pixWriteToTiffStream(tif, pix, IFF_TIFF_G4, NULL, NULL,
+                                   NULL, NULL);
+    } else {
+        if (pixGetColormap(pix))
+            pix1 = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC);
+        else
+            pix1 = pixClone(pix);
+        ret = pixWriteToTiffStream(tif, pix1, IFF_TIFF_ZIP, NULL, NULL,
+                                   NULL, NULL);
+        pixDestroy(&pix1);
+    }
+    if (TIFFWriteDirectory(tif) == 0)
+        ret = 1;
+    return ret;
 }
 
 
@@ -1470,8 +1939,7 @@ l_int32
 tiffGetCount(FILE     *fp,
              l_int32  *pn)
 {
-l_int32  i;
-TIFF    *tif;
+L_DNA  *da;
 
     PROCNAME("tiffGetCount");
 
@@ -1481,23 +1949,141 @@ TIFF    *tif;
         return ERROR_INT("&n not defined", procName, 1);
     *pn = 0;
 
-    if ((tif = fopenTiff(fp, "r")) == NULL)
+    if (tiffGetPageOffsets(fp, &da))
         return ERROR_INT("tif not open for read", procName, 1);
+    *pn = l_dnaGetCount(da);
+    if (*pn > MANY_PAGES_IN_TIFF_FILE) {
+        L_WARNING("big file: more than %d pages\n", procName,
+                  MANY_PAGES_IN_TIFF_FILE);
+    }
+    l_dnaDestroy(&da);
+    return 0;
+}
 
-    for (i = 1; ; i++) {
-        if (TIFFReadDirectory(tif) == 0)
+
+/*!
+ * \brief   tiffGetPageOffsets()
+ *
+ * \param[in]    fp file stream opened for read
+ * \param[out]   pda byte offset of the directory for each page
+ * \return  0 if OK; 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This walks the chain of image file directories once, reading
+ *          only the entry count and the link to the next directory for
+ *          each page.  No tags are parsed and no image data is read,
+ *          so it is much faster than stepping with TIFFReadDirectory().
+ *      (2) The offsets are an index for random access to the pages;
+ *          e.g., with pixReadFromMultipageTiff() or
+ *          pixaReadMultipageTiffIndexed().
+ *      (3) Both classic and big tiff are handled.  A directory link
+ *          that points outside the file ends the chain with a warning.
+ *      (4) The stream is rewound on return.
+ * </pre>
+ */
+l_int32
+tiffGetPageOffsets(FILE    *fp,
+                   L_DNA  **pda)
+{
+l_uint8   buf[16];
+l_int32   bigend, bigtiff, countsize, entrysize, linksize;
+l_uint64  offset, nentries, filesize, maxpages, pos;
+L_DNA    *da;
+
+    PROCNAME("tiffGetPageOffsets");
+
+    if (!pda)
+        return ERROR_INT("&da not defined", procName, 1);
+    *pda = NULL;
+    if (!fp)
+        return ERROR_INT("stream not defined", procName, 1);
+
+        /* Use the large file wrappers for the size and seeks */
+    rewind(fp);
+    if ((filesize = lept_size_proc((thandle_t)fp)) == (toff_t)-1)
+        return ERROR_INT("file size not found", procName, 1);
+    if (fread(buf, 1, 8, fp) != 8)
+        return ERROR_INT("header not read", procName, 1);
+    if (buf[0] == 'M' && buf[1] == 'M')
+        bigend = 1;
+    else if (buf[0] == 'I' && buf[1] == 'I')
+        bigend = 0;
+    else
+        return ERROR_INT("not tiff byte order", procName, 1);
+
+    bigtiff = (tiffGetUnsigned(buf + 2, 2, bigend) == 43);
+    if (bigtiff) {  /* 8 byte offsets follow the 2 byte offset size field */
+        if (fread(buf + 8, 1, 8, fp) != 8)
+            return ERROR_INT("big tiff header not read", procName, 1);
+        offset = tiffGetUnsigned(buf + 8, 8, bigend);
+        countsize = 8;
+        entrysize = 20;
+        linksize = 8;
+    } else if (tiffGetUnsigned(buf + 2, 2, bigend) == 42) {
+        offset = tiffGetUnsigned(buf + 4, 4, bigend);
+        countsize = 2;
+        entrysize = 12;
+        linksize = 4;
+    } else {
+        return ERROR_INT("invalid tiff version", procName, 1);
+    }
+
+        /* A loop in the chain would never end; the number of
+         * directories that can fit in the file bounds the count */
+    maxpages = filesize / (countsize + linksize);
+    da = l_dnaCreate(0);
+    while (offset != 0) {
+        if (offset + countsize > filesize ||
+            (l_uint64)l_dnaGetCount(da) >= maxpages) {
+            L_WARNING("invalid directory chain; stopping\n", procName);
             break;
-        if (i == MANY_PAGES_IN_TIFF_FILE + 1) {
-            L_WARNING("big file: more than %d pages\n", procName,
-                      MANY_PAGES_IN_TIFF_FILE);
         }
+        if (lept_seek_proc((thandle_t)fp, offset, SEEK_SET) != offset ||
+            fread(buf, 1, countsize, fp) != (size_t)countsize)
+            break;
+        l_dnaAddNumber(da, (l_float64)offset);
+        nentries = tiffGetUnsigned(buf, countsize, bigend);
+        pos = offset + countsize + nentries * entrysize;
+        if (lept_seek_proc((thandle_t)fp, pos, SEEK_SET) != pos ||
+            fread(buf, 1, linksize, fp) != (size_t)linksize)
+            break;
+        offset = tiffGetUnsigned(buf, linksize, bigend);
     }
-    *pn = i;
-    TIFFCleanup(tif);
+
+    rewind(fp);
+    *pda = da;
     return 0;
 }
 
 
+/*!
+ * \brief   tiffGetUnsigned()
+ *
+ * \param[in]    data bytes of an unsigned value in the file
+ * \param[in]    nbytes 2, 4 or 8
+ * \param[in]    bigend 1 for big-endian (MM) file byte order; 0 otherwise
+ * \return  value
+ */
+static l_uint64
+tiffGetUnsigned(const l_uint8  *data,
+                l_int32         nbytes,
+                l_int32         bigend)
+{
+l_int32   i;
+l_uint64  val;
+
+    val = 0;
+    for (i = 0; i < nbytes; i++) {
+        if (bigend)
+            val = (val << 8) | data[i];
+        else
+            val |= (l_uint64)data[i] << (8 * i);
+    }
+    return val;
+}
+
+
 /*--------------------------------------------------------------*
  *                   Get resolution from tif                    *
  *--------------------------------------------------------------*/
@@ -2558,15 +3144,17 @@ PIXA   *pixa;
 /*!
  * \brief   pixaWriteMemMultipageTiff()
  *
- * \param[in]    cdata     const; tiff-encoded
- * \param[in]    size      size of cdata
+ * \param[out]   pdata     data of tiff compressed images
+ * \param[out]   psize     size of returned data
  * \param[in]    pixa      any depth; colormap will be removed
  * \return  0 if OK, 1 on error
  *
  * <pre>
  * Notes:
- *      (1) fopenTiffMemstream() does not work in append mode, so we
- *          must work-around with a temporary file.
+ *      (1) fopenTiffMemstream() does not work in append mode, but that
+ *          is not needed: as in pixaWriteMultipageTiff(), all pages are
+ *          written through a single handle, directly to memory.
+ *      (2) Use TIFFClose(); TIFFCleanup() doesn't free internal memstream.
  * </pre>
  */
 l_int32
@@ -2574,48 +3162,35 @@ pixaWriteMemMultipageTiff(l_uint8  **pdata,
                           size_t    *psize,
                           PIXA      *pixa)
 {
-const char  *modestr;
-l_int32  i, n;
-FILE    *fp;
-PIX     *pix1, *pix2;
+l_int32  i, n, ret;
+PIX     *pix;
+TIFF    *tif;
 
     PROCNAME("pixaWriteMemMultipageTiff");
 
+    if (pdata) *pdata = NULL;
+    if (psize) *psize = 0;
     if (!pdata)
         return ERROR_INT("pdata not defined", procName, 1);
+    if (!psize)
+        return ERROR_INT("psize not defined", procName, 1);
     if (!pixa)
         return ERROR_INT("pixa not defined", procName, 1);
 
-#ifdef _WIN32
-    if ((fp = fopenWriteWinTempfile()) == NULL)
-        return ERROR_INT("tmpfile stream not opened", procName, 1);
-#else
-    if ((fp = tmpfile()) == NULL)
-        return ERROR_INT("tmpfile stream not opened", procName, 1);
-#endif  /* _WIN32 */
-
+    if ((tif = fopenTiffMemstream("tifferror", "w", pdata, psize)) == NULL)
+        return ERROR_INT("tiff stream not opened", procName, 1);
     n = pixaGetCount(pixa);
+    ret = 0;
     for (i = 0; i < n; i++) {
-        modestr = (i == 0) ? "w" : "a";
-        pix1 = pixaGetPix(pixa, i, L_CLONE);
-        if (pixGetDepth(pix1) == 1) {
-            pixWriteStreamTiffWA(fp, pix1, IFF_TIFF_G4, modestr);
-        } else {
-            if (pixGetColormap(pix1)) {
-                pix2 = pixRemoveColormap(pix1, REMOVE_CMAP_BASED_ON_SRC);
-            } else {
-                pix2 = pixClone(pix1);
-            }
-            pixWriteStreamTiffWA(fp, pix2, IFF_TIFF_ZIP, modestr);
-            pixDestroy(&pix2);
+        pix = pixaGetPix(pixa, i, L_CLONE);
+        if (writeMultipageTiffPage(tif, pix)) {
+            L_ERROR("page %d not written\n", procName, i);
+            ret = 1;
         }
-        pixDestroy(&pix1);
+        pixDestroy(&pix);
     }
-
-    rewind(fp);
-    *pdata = l_binaryReadStream(fp, psize);
-    fclose(fp);
-    return 0;
+    TIFFClose(tif);
+    return ret;
 }
 
 
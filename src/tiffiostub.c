@@ -56,6 +56,13 @@ PIX * pixReadStreamTiff(FILE *fp, l_int32 n)
 
 /* ----------------------------------------------------------------------*/
 
+PIX * pixReadTiffRegion(const char *filename, l_int32 n, BOX *box)
+{
+    return (PIX *)ERROR_PTR("function not present", "pixReadTiffRegion", NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 pixWriteTiff(const char *filename, PIX *pix, l_int32 comptype,
                      const char *modestring)
 {
@@ -104,6 +111,15 @@ PIXA * pixaReadMultipageTiff(const char *filename)
 
 /* ----------------------------------------------------------------------*/
 
+PIXA * pixaReadMultipageTiffIndexed(const char *filename, L_DNA *da,
+                                    l_int32 first, l_int32 nread)
+{
+    return (PIXA *)ERROR_PTR("function not present",
+                             "pixaReadMultipageTiffIndexed", NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 pixaWriteMultipageTiff(const char *filename, PIXA *pixa)
 {
     return ERROR_INT("function not present", "pixaWriteMultipageTiff", 1);
@@ -140,6 +156,13 @@ l_int32 tiffGetCount(FILE *fp, l_int32 *pn)
 
 /* ----------------------------------------------------------------------*/
 
+l_int32 tiffGetPageOffsets(FILE *fp, L_DNA **pda)
+{
+    return ERROR_INT("function not present", "tiffGetPageOffsets", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 l_int32 getTiffResolution(FILE *fp, l_int32 *pxres, l_int32 *pyres)
 {
     return ERROR_INT("function not present", "getTiffResolution", 1);